@@ -0,0 +1,616 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// DicomRtImportExport includes
+#include "vtkPlanarContourToBinaryLabelmapConversionRule.h"
+#include "vtkPlanarContourToClosedSurfaceConversionRule.h"
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkCalculateOversamplingFactor.h"
+#include "vtkClosedSurfaceToBinaryLabelmapConversionRule.h"
+
+// VTK includes
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <vtkMatrix4x4.h>
+#include <vtkVariant.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+//----------------------------------------------------------------------------
+vtkSegmentationConverterRuleNewMacro(vtkPlanarContourToBinaryLabelmapConversionRule);
+
+//----------------------------------------------------------------------------
+/// Maximum distance of contour points from the mean K of their contour (in output voxels) for the contour to be
+/// considered parallel to the labelmap slices. Also used as tolerance for grouping contours into planes.
+static const double PLANAR_CONTOUR_K_TOLERANCE = 0.1;
+
+//----------------------------------------------------------------------------
+/// Index of the first sample at or after a continuous IJK coordinate along one axis. The samples of voxel n are
+/// placed at n - 0.5 + (s + 0.5) / samplesPerAxis, and are indexed from the first voxel (minimumIndex) of the extent.
+static int vtkFirstSampleNotBefore(double coordinate, int minimumIndex, int samplesPerAxis)
+{
+  return (int)ceil((coordinate - minimumIndex + 0.5) * samplesPerAxis - 0.5);
+}
+
+//----------------------------------------------------------------------------
+/// Computes the crossings of the contour edges with the sampled rows for each contour plane in parallel
+class vtkPlanarContourRowCrossingFunctor
+{
+public:
+  std::vector<vtkPlanarContourToBinaryLabelmapConversionRule::ContourPlane>* Planes;
+  int MinimumJ;
+  int NumberOfSampleRows;
+  int SamplesPerAxis;
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType planeIndex = begin; planeIndex < end; ++planeIndex)
+    {
+      vtkPlanarContourToBinaryLabelmapConversionRule::ContourPlane& plane = (*this->Planes)[planeIndex];
+      const std::vector<double>& edges = plane.Edges;
+      size_t numberOfEdges = edges.size() / 4;
+
+      // Count the crossings of each row first so that all crossings of the plane can be stored in one array.
+      // An edge crosses the rows with J in [minimum J, maximum J) of the edge, so that a vertex shared by two
+      // edges is counted once if the contour passes through the row, and zero or two times if it touches it.
+      plane.RowCrossingOffsets.assign(this->NumberOfSampleRows + 1, 0);
+      for (size_t edgeIndex = 0; edgeIndex < numberOfEdges; ++edgeIndex)
+      {
+        int firstRow = 0;
+        int lastRow = -1;
+        this->GetEdgeRowRange(&edges[4*edgeIndex], firstRow, lastRow);
+        for (int row = firstRow; row <= lastRow; ++row)
+        {
+          plane.RowCrossingOffsets[row+1]++;
+        }
+      }
+      for (int row = 0; row < this->NumberOfSampleRows; ++row)
+      {
+        plane.RowCrossingOffsets[row+1] += plane.RowCrossingOffsets[row];
+      }
+
+      // Store the I coordinate of the crossings, then sort them within each row for the even-odd fill
+      plane.RowCrossings.resize(plane.RowCrossingOffsets[this->NumberOfSampleRows]);
+      std::vector<int> nextCrossingIndex(plane.RowCrossingOffsets.begin(), plane.RowCrossingOffsets.end() - 1);
+      for (size_t edgeIndex = 0; edgeIndex < numberOfEdges; ++edgeIndex)
+      {
+        const double* edge = &edges[4*edgeIndex];
+        int firstRow = 0;
+        int lastRow = -1;
+        this->GetEdgeRowRange(edge, firstRow, lastRow);
+        for (int row = firstRow; row <= lastRow; ++row)
+        {
+          double rowJ = this->MinimumJ - 0.5 + (row + 0.5) / this->SamplesPerAxis;
+          plane.RowCrossings[nextCrossingIndex[row]++] = edge[0] + (rowJ - edge[1]) * (edge[2] - edge[0]) / (edge[3] - edge[1]);
+        }
+      }
+      for (int row = 0; row < this->NumberOfSampleRows; ++row)
+      {
+        std::sort(plane.RowCrossings.begin() + plane.RowCrossingOffsets[row], plane.RowCrossings.begin() + plane.RowCrossingOffsets[row+1]);
+      }
+    }
+  }
+
+  /// Get the range of sampled rows crossed by an edge (I0,J0,I1,J1). Horizontal edges cross no rows.
+  void GetEdgeRowRange(const double* edge, int& firstRow, int& lastRow)
+  {
+    firstRow = 0;
+    lastRow = -1;
+    if (edge[1] == edge[3])
+    {
+      return;
+    }
+    firstRow = std::max(0, vtkFirstSampleNotBefore(std::min(edge[1], edge[3]), this->MinimumJ, this->SamplesPerAxis));
+    lastRow = std::min(this->NumberOfSampleRows - 1, vtkFirstSampleNotBefore(std::max(edge[1], edge[3]), this->MinimumJ, this->SamplesPerAxis) - 1);
+  }
+};
+
+//----------------------------------------------------------------------------
+/// Fills the labelmap slices in parallel. Each voxel is set to the background value plus the number of its samples
+/// that are inside the contours of the contour plane nearest to the sample.
+template <class T>
+class vtkPlanarContourSliceFillFunctor
+{
+public:
+  const std::vector<vtkPlanarContourToBinaryLabelmapConversionRule::ContourPlane>* Planes;
+  int* Extent;
+  int SamplesPerAxis;
+  int BackgroundValue;
+  T* Output;
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    int numberOfColumns = this->Extent[1] - this->Extent[0] + 1;
+    int numberOfRows = this->Extent[3] - this->Extent[2] + 1;
+    int numberOfSampleColumns = numberOfColumns * this->SamplesPerAxis;
+    int numberOfSampleRows = numberOfRows * this->SamplesPerAxis;
+    std::vector<unsigned short> sampleCounts(numberOfColumns * numberOfRows);
+
+    for (vtkIdType k = begin; k < end; ++k)
+    {
+      std::fill(sampleCounts.begin(), sampleCounts.end(), 0);
+      for (int sampleK = 0; sampleK < this->SamplesPerAxis; ++sampleK)
+      {
+        const vtkPlanarContourToBinaryLabelmapConversionRule::ContourPlane* plane =
+          this->FindPlane(k - 0.5 + (sampleK + 0.5) / this->SamplesPerAxis);
+        if (!plane)
+        {
+          continue;
+        }
+
+        for (int sampleRow = 0; sampleRow < numberOfSampleRows; ++sampleRow)
+        {
+          unsigned short* rowCounts = &sampleCounts[(sampleRow / this->SamplesPerAxis) * numberOfColumns];
+          int firstCrossing = plane->RowCrossingOffsets[sampleRow];
+          int endCrossing = plane->RowCrossingOffsets[sampleRow+1];
+          // Even-odd rule: samples between each pair of crossings are inside. An unpaired last crossing
+          // (only possible for contours that are not closed) is ignored.
+          for (int crossing = firstCrossing; crossing + 1 < endCrossing; crossing += 2)
+          {
+            int firstColumn = std::max(0,
+              vtkFirstSampleNotBefore(plane->RowCrossings[crossing], this->Extent[0], this->SamplesPerAxis));
+            int lastColumn = std::min(numberOfSampleColumns - 1,
+              vtkFirstSampleNotBefore(plane->RowCrossings[crossing+1], this->Extent[0], this->SamplesPerAxis) - 1);
+            for (int sampleColumn = firstColumn; sampleColumn <= lastColumn; ++sampleColumn)
+            {
+              rowCounts[sampleColumn / this->SamplesPerAxis]++;
+            }
+          }
+        }
+      }
+
+      T* outputSlice = this->Output + (k - this->Extent[4]) * numberOfColumns * numberOfRows;
+      for (size_t voxelIndex = 0; voxelIndex < sampleCounts.size(); ++voxelIndex)
+      {
+        outputSlice[voxelIndex] = static_cast<T>(this->BackgroundValue + sampleCounts[voxelIndex]);
+      }
+    }
+  }
+
+  /// Find the contour plane whose slab contains the given K coordinate. NULL if there is none.
+  const vtkPlanarContourToBinaryLabelmapConversionRule::ContourPlane* FindPlane(double k)
+  {
+    // Slabs are sorted and do not overlap, so find the last plane with slab starting at or before k
+    int lower = 0;
+    int upper = (int)this->Planes->size();
+    while (upper - lower > 1)
+    {
+      int middle = (lower + upper) / 2;
+      if ((*this->Planes)[middle].SlabMinimumK <= k)
+      {
+        lower = middle;
+      }
+      else
+      {
+        upper = middle;
+      }
+    }
+    const vtkPlanarContourToBinaryLabelmapConversionRule::ContourPlane& plane = (*this->Planes)[lower];
+    if (k < plane.SlabMinimumK || k >= plane.SlabMaximumK)
+    {
+      return NULL;
+    }
+    return &plane;
+  }
+};
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkPlanarContourFillSlices(T* output, const std::vector<vtkPlanarContourToBinaryLabelmapConversionRule::ContourPlane>& planes,
+  int extent[6], int samplesPerAxis, int backgroundValue)
+{
+  vtkPlanarContourSliceFillFunctor<T> sliceFillFunctor;
+  sliceFillFunctor.Planes = &planes;
+  sliceFillFunctor.Extent = extent;
+  sliceFillFunctor.SamplesPerAxis = samplesPerAxis;
+  sliceFillFunctor.BackgroundValue = backgroundValue;
+  sliceFillFunctor.Output = output;
+  vtkSMPTools::For(extent[4], extent[5] + 1, 1, sliceFillFunctor);
+}
+
+//----------------------------------------------------------------------------
+vtkPlanarContourToBinaryLabelmapConversionRule::vtkPlanarContourToBinaryLabelmapConversionRule()
+{
+  // Same parameters as the closed surface to binary labelmap rule, so that the values set on the segmentation apply to both
+  this->ConversionParameters[vtkSegmentationConverter::GetReferenceImageGeometryParameterName()] = std::make_pair("",
+    "Image geometry description string determining the geometry of the labelmap that is created in course of conversion.");
+  this->ConversionParameters[vtkClosedSurfaceToBinaryLabelmapConversionRule::GetOversamplingFactorParameterName()] = std::make_pair("1",
+    "Determines the oversampling of the reference image geometry. If it's a number, then all segments are oversampled with the same value (value of 1 means no oversampling). If it has the value \"A\", then automatic oversampling is calculated from the size of the structure.");
+}
+
+//----------------------------------------------------------------------------
+vtkPlanarContourToBinaryLabelmapConversionRule::~vtkPlanarContourToBinaryLabelmapConversionRule()
+{
+}
+
+//----------------------------------------------------------------------------
+unsigned int vtkPlanarContourToBinaryLabelmapConversionRule::GetConversionCost(vtkDataObject* vtkNotUsed(sourceRepresentation)/*=NULL*/, vtkDataObject* vtkNotUsed(targetRepresentation)/*=NULL*/)
+{
+  // Rough input-independent guess (ms)
+  return 200;
+}
+
+//----------------------------------------------------------------------------
+vtkDataObject* vtkPlanarContourToBinaryLabelmapConversionRule::ConstructRepresentationObjectByRepresentation(std::string representationName)
+{
+  if (!representationName.compare(this->GetSourceRepresentationName()))
+  {
+    return (vtkDataObject*)vtkPolyData::New();
+  }
+  else if (!representationName.compare(this->GetTargetRepresentationName()))
+  {
+    return (vtkDataObject*)vtkOrientedImageData::New();
+  }
+  else
+  {
+    return NULL;
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkDataObject* vtkPlanarContourToBinaryLabelmapConversionRule::ConstructRepresentationObjectByClass(std::string className)
+{
+  if (!className.compare("vtkPolyData"))
+  {
+    return (vtkDataObject*)vtkPolyData::New();
+  }
+  else if (!className.compare("vtkOrientedImageData"))
+  {
+    return (vtkDataObject*)vtkOrientedImageData::New();
+  }
+  else
+  {
+    return NULL;
+  }
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlanarContourToBinaryLabelmapConversionRule::Convert(vtkDataObject* sourceRepresentation, vtkDataObject* targetRepresentation)
+{
+  // Check validity of source and target representation objects
+  vtkPolyData* planarContourPolyData = vtkPolyData::SafeDownCast(sourceRepresentation);
+  if (!planarContourPolyData)
+  {
+    vtkErrorMacro("Convert: Source representation is not a poly data!");
+    return false;
+  }
+  vtkOrientedImageData* labelmap = vtkOrientedImageData::SafeDownCast(targetRepresentation);
+  if (!labelmap)
+  {
+    vtkErrorMacro("Convert: Target representation is not an oriented image data!");
+    return false;
+  }
+  if (planarContourPolyData->GetNumberOfPoints() < 3 || !planarContourPolyData->GetLines() || planarContourPolyData->GetLines()->GetNumberOfCells() < 1)
+  {
+    vtkErrorMacro("Convert: Cannot create labelmap from planar contours with number of points: " << planarContourPolyData->GetNumberOfPoints()
+      << " and number of contours: " << (planarContourPolyData->GetLines() ? planarContourPolyData->GetLines()->GetNumberOfCells() : 0));
+    return false;
+  }
+
+  // Compute output lattice
+  vtkSmartPointer<vtkOrientedImageData> geometryImageData = vtkSmartPointer<vtkOrientedImageData>::New();
+  double oversamplingFactor = 1.0;
+  if (!this->CalculateOutputGeometry(planarContourPolyData, geometryImageData, oversamplingFactor))
+  {
+    vtkErrorMacro("Convert: Failed to calculate output geometry");
+    return false;
+  }
+
+  // Group contours into planes in IJK coordinates of the lattice. A single plane is extended by half of the
+  // reference slice thickness in both directions, which is the oversampling factor in output voxels.
+  vtkSmartPointer<vtkMatrix4x4> worldToImageMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  geometryImageData->GetWorldToImageMatrix(worldToImageMatrix);
+  std::vector<ContourPlane> planes;
+  if (!this->ComputeContourPlanes(planarContourPolyData, worldToImageMatrix, 0.5 * oversamplingFactor, planes))
+  {
+    // Contours that are not parallel to the slices of the lattice cannot be filled slice by slice
+    vtkDebugMacro("Convert: Contours are not parallel to the slices of the reference image geometry, converting through closed surface");
+    return this->ConvertThroughClosedSurface(planarContourPolyData, labelmap);
+  }
+  if (planes.empty())
+  {
+    vtkErrorMacro("Convert: No valid contours found in planar contour representation");
+    return false;
+  }
+
+  // Output extent contains all voxels that have samples within the bounds of the contours
+  double minimumI = VTK_DOUBLE_MAX;
+  double maximumI = VTK_DOUBLE_MIN;
+  double minimumJ = VTK_DOUBLE_MAX;
+  double maximumJ = VTK_DOUBLE_MIN;
+  for (std::vector<ContourPlane>::iterator planeIt = planes.begin(); planeIt != planes.end(); ++planeIt)
+  {
+    for (size_t edgeValueIndex = 0; edgeValueIndex < planeIt->Edges.size(); edgeValueIndex += 2)
+    {
+      minimumI = std::min(minimumI, planeIt->Edges[edgeValueIndex]);
+      maximumI = std::max(maximumI, planeIt->Edges[edgeValueIndex]);
+      minimumJ = std::min(minimumJ, planeIt->Edges[edgeValueIndex+1]);
+      maximumJ = std::max(maximumJ, planeIt->Edges[edgeValueIndex+1]);
+    }
+  }
+  int extent[6] =
+  {
+    (int)floor(minimumI + 0.5), (int)ceil(maximumI + 0.5) - 1,
+    (int)floor(minimumJ + 0.5), (int)ceil(maximumJ + 0.5) - 1,
+    (int)floor(planes.front().SlabMinimumK + 0.5), (int)ceil(planes.back().SlabMaximumK + 0.5) - 1
+  };
+
+  // Compute where the contour edges cross the sampled rows
+  int samplesPerAxis = this->GetNumberOfSamplesPerAxis();
+  vtkPlanarContourRowCrossingFunctor rowCrossingFunctor;
+  rowCrossingFunctor.Planes = &planes;
+  rowCrossingFunctor.MinimumJ = extent[2];
+  rowCrossingFunctor.NumberOfSampleRows = (extent[3] - extent[2] + 1) * samplesPerAxis;
+  rowCrossingFunctor.SamplesPerAxis = samplesPerAxis;
+  vtkSMPTools::For(0, (vtkIdType)planes.size(), 1, rowCrossingFunctor);
+
+  // Create output labelmap and fill slices
+  labelmap->Initialize();
+  labelmap->CopyDirections(geometryImageData);
+  labelmap->SetOrigin(geometryImageData->GetOrigin());
+  labelmap->SetSpacing(geometryImageData->GetSpacing());
+  labelmap->SetExtent(extent);
+  labelmap->AllocateScalars(this->GetOutputScalarType(), 1);
+
+  switch (labelmap->GetScalarType())
+  {
+    vtkTemplateMacro(vtkPlanarContourFillSlices(static_cast<VTK_TT*>(labelmap->GetScalarPointer()),
+      planes, extent, samplesPerAxis, this->GetOutputBackgroundValue()));
+    default:
+      vtkErrorMacro("Convert: Unsupported labelmap scalar type " << labelmap->GetScalarType());
+      return false;
+  }
+
+  this->AddLabelmapFieldData(labelmap);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlanarContourToBinaryLabelmapConversionRule::CalculateOutputGeometry(vtkPolyData* planarContourPolyData, vtkOrientedImageData* geometryImageData, double& oversamplingFactor)
+{
+  if (!planarContourPolyData || !geometryImageData)
+  {
+    vtkErrorMacro("CalculateOutputGeometry: Invalid inputs!");
+    return false;
+  }
+
+  // Use reference image geometry if specified
+  std::string geometryString = this->ConversionParameters[vtkSegmentationConverter::GetReferenceImageGeometryParameterName()].first;
+  if (geometryString.empty())
+  {
+    double bounds[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    planarContourPolyData->GetBounds(bounds);
+    double maximumSize = std::max(bounds[1] - bounds[0], std::max(bounds[3] - bounds[2], bounds[5] - bounds[4]));
+    double spacing = (maximumSize > 0.0 ? maximumSize / 100.0 : 1.0);
+    geometryImageData->SetOrigin(bounds[0], bounds[2], bounds[4]);
+    geometryImageData->SetSpacing(spacing, spacing, spacing);
+  }
+  else
+  {
+    vtkSmartPointer<vtkMatrix4x4> geometryMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    int geometryExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    if (!vtkSegmentationConverter::DeserializeImageGeometry(geometryString, geometryMatrix, geometryExtent))
+    {
+      vtkErrorMacro("CalculateOutputGeometry: Failed to get reference image geometry");
+      return false;
+    }
+    geometryImageData->SetGeometryFromImageToWorldMatrix(geometryMatrix);
+    geometryImageData->SetExtent(geometryExtent);
+  }
+
+  // Determine oversampling factor
+  oversamplingFactor = 1.0;
+  std::string oversamplingString = this->ConversionParameters[vtkClosedSurfaceToBinaryLabelmapConversionRule::GetOversamplingFactorParameterName()].first;
+  if (!oversamplingString.compare("A"))
+  {
+    // Automatic oversampling based on the relative structure size (volume of the structure in reference voxels).
+    // The complexity measure of the closed surface based automatic oversampling is not used, as there is no surface.
+    vtkSmartPointer<vtkMatrix4x4> worldToImageMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    geometryImageData->GetWorldToImageMatrix(worldToImageMatrix);
+    std::vector<ContourPlane> planes;
+    this->ComputeContourPlanes(planarContourPolyData, worldToImageMatrix, 0.5, planes);
+    double relativeStructureSize = 0.0;
+    for (std::vector<ContourPlane>::iterator planeIt = planes.begin(); planeIt != planes.end(); ++planeIt)
+    {
+      relativeStructureSize += planeIt->Area * (planeIt->SlabMaximumK - planeIt->SlabMinimumK);
+    }
+    if (relativeStructureSize < 1000.0)
+    {
+      oversamplingFactor = 4.0;
+    }
+    else if (relativeStructureSize < 10000.0)
+    {
+      oversamplingFactor = 2.0;
+    }
+    vtkDebugMacro("CalculateOutputGeometry: Automatic oversampling factor " << oversamplingFactor << " for relative structure size " << relativeStructureSize);
+  }
+  else if (!oversamplingString.empty())
+  {
+    bool valid = false;
+    oversamplingFactor = vtkVariant(oversamplingString).ToDouble(&valid);
+    if (!valid || oversamplingFactor <= 0.0)
+    {
+      vtkErrorMacro("CalculateOutputGeometry: Invalid oversampling factor: " << oversamplingString);
+      return false;
+    }
+  }
+
+  if (oversamplingFactor != 1.0)
+  {
+    vtkCalculateOversamplingFactor::ApplyOversamplingOnImageGeometry(geometryImageData, oversamplingFactor);
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlanarContourToBinaryLabelmapConversionRule::ComputeContourPlanes(vtkPolyData* planarContourPolyData, vtkMatrix4x4* worldToImageMatrix,
+  double singlePlaneHalfThickness, std::vector<ContourPlane>& planes)
+{
+  planes.clear();
+  vtkPoints* points = planarContourPolyData->GetPoints();
+  vtkCellArray* lines = planarContourPolyData->GetLines();
+  if (!points || !lines)
+  {
+    return true;
+  }
+
+  // Transform points to IJK coordinates
+  vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  std::vector<double> imagePoints(3 * numberOfPoints);
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+  {
+    double point[4] = { 0.0, 0.0, 0.0, 1.0 };
+    points->GetPoint(pointId, point);
+    worldToImageMatrix->MultiplyPoint(point, point);
+    imagePoints[3*pointId] = point[0];
+    imagePoints[3*pointId+1] = point[1];
+    imagePoints[3*pointId+2] = point[2];
+  }
+
+  // Collect contours with their mean K coordinate
+  std::vector<vtkIdType> contourPointIds;
+  std::vector<vtkIdType> contourOffsets(1, 0);
+  std::vector<std::pair<double, int> > contourKs;
+  vtkIdType numberOfContourPoints = 0;
+  vtkIdType* pointIds = NULL;
+  lines->InitTraversal();
+  while (lines->GetNextCell(numberOfContourPoints, pointIds))
+  {
+    if (numberOfContourPoints < 3)
+    {
+      continue;
+    }
+    double meanK = 0.0;
+    for (vtkIdType index = 0; index < numberOfContourPoints; ++index)
+    {
+      meanK += imagePoints[3*pointIds[index]+2];
+    }
+    meanK /= numberOfContourPoints;
+    for (vtkIdType index = 0; index < numberOfContourPoints; ++index)
+    {
+      if (fabs(imagePoints[3*pointIds[index]+2] - meanK) > PLANAR_CONTOUR_K_TOLERANCE)
+      {
+        planes.clear();
+        return false;
+      }
+    }
+    contourKs.push_back(std::make_pair(meanK, (int)contourOffsets.size() - 1));
+    contourPointIds.insert(contourPointIds.end(), pointIds, pointIds + numberOfContourPoints);
+    contourOffsets.push_back((vtkIdType)contourPointIds.size());
+  }
+  std::sort(contourKs.begin(), contourKs.end());
+
+  // Group contours into planes. The edges of all contours of a plane are filled together with the even-odd rule,
+  // so holes (contours inside other contours) are left empty without the need to determine which contour is a hole.
+  double planeFirstK = 0.0;
+  int numberOfPlaneContours = 0;
+  for (std::vector<std::pair<double, int> >::iterator contourIt = contourKs.begin(); contourIt != contourKs.end(); ++contourIt)
+  {
+    if (planes.empty() || contourIt->first - planeFirstK > PLANAR_CONTOUR_K_TOLERANCE)
+    {
+      planes.push_back(ContourPlane());
+      planes.back().K = 0.0;
+      planes.back().Area = 0.0;
+      planeFirstK = contourIt->first;
+      numberOfPlaneContours = 0;
+    }
+    ContourPlane& plane = planes.back();
+    plane.K = (plane.K * numberOfPlaneContours + contourIt->first) / (numberOfPlaneContours + 1);
+    numberOfPlaneContours++;
+
+    // Add closed polygon edges. If the contour repeats its first point at the end, then the closing edge has zero length.
+    vtkIdType firstIndex = contourOffsets[contourIt->second];
+    vtkIdType endIndex = contourOffsets[contourIt->second + 1];
+    double doubleSignedArea = 0.0;
+    for (vtkIdType index = firstIndex; index < endIndex; ++index)
+    {
+      const double* point0 = &imagePoints[3*contourPointIds[index]];
+      const double* point1 = &imagePoints[3*contourPointIds[index + 1 < endIndex ? index + 1 : firstIndex]];
+      plane.Edges.push_back(point0[0]);
+      plane.Edges.push_back(point0[1]);
+      plane.Edges.push_back(point1[0]);
+      plane.Edges.push_back(point1[1]);
+      doubleSignedArea += point0[0] * point1[1] - point1[0] * point0[1];
+    }
+    plane.Area += fabs(doubleSignedArea) / 2.0;
+  }
+
+  // Each plane fills the slab extending half way to the neighboring planes, but at most half the typical (median)
+  // plane spacing, so that gaps between separate parts of the structure are not filled. Planes without neighbor
+  // on one side (such as the outermost planes) extend by half the typical spacing, as the closed surface end caps.
+  int numberOfPlanes = (int)planes.size();
+  double maximumHalfThickness = singlePlaneHalfThickness;
+  if (numberOfPlanes > 1)
+  {
+    std::vector<double> planeSpacings(numberOfPlanes - 1);
+    for (int planeIndex = 0; planeIndex < numberOfPlanes - 1; ++planeIndex)
+    {
+      planeSpacings[planeIndex] = planes[planeIndex+1].K - planes[planeIndex].K;
+    }
+    std::nth_element(planeSpacings.begin(), planeSpacings.begin() + planeSpacings.size() / 2, planeSpacings.end());
+    maximumHalfThickness = planeSpacings[planeSpacings.size() / 2] / 2.0;
+  }
+  for (int planeIndex = 0; planeIndex < numberOfPlanes; ++planeIndex)
+  {
+    double halfThicknessBelow = maximumHalfThickness;
+    double halfThicknessAbove = maximumHalfThickness;
+    if (planeIndex > 0)
+    {
+      halfThicknessBelow = std::min(halfThicknessBelow, (planes[planeIndex].K - planes[planeIndex-1].K) / 2.0);
+    }
+    if (planeIndex < numberOfPlanes - 1)
+    {
+      halfThicknessAbove = std::min(halfThicknessAbove, (planes[planeIndex+1].K - planes[planeIndex].K) / 2.0);
+    }
+    planes[planeIndex].SlabMinimumK = planes[planeIndex].K - halfThicknessBelow;
+    planes[planeIndex].SlabMaximumK = planes[planeIndex].K + halfThicknessAbove;
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlanarContourToBinaryLabelmapConversionRule::ConvertThroughClosedSurface(vtkPolyData* planarContourPolyData, vtkOrientedImageData* labelmap)
+{
+  vtkSmartPointer<vtkPolyData> closedSurfacePolyData = vtkSmartPointer<vtkPolyData>::New();
+  vtkSmartPointer<vtkPlanarContourToClosedSurfaceConversionRule> closedSurfaceRule = vtkSmartPointer<vtkPlanarContourToClosedSurfaceConversionRule>::New();
+  if (!closedSurfaceRule->Convert(planarContourPolyData, closedSurfacePolyData))
+  {
+    vtkErrorMacro("ConvertThroughClosedSurface: Failed to convert planar contours to closed surface");
+    return false;
+  }
+
+  vtkSmartPointer<vtkSegmentationConverterRule> labelmapRule = vtkSmartPointer<vtkSegmentationConverterRule>::Take(
+    this->CreateClosedSurfaceToLabelmapRule() );
+  labelmapRule->SetConversionParameter(vtkSegmentationConverter::GetReferenceImageGeometryParameterName(),
+    this->ConversionParameters[vtkSegmentationConverter::GetReferenceImageGeometryParameterName()].first);
+  labelmapRule->SetConversionParameter(vtkClosedSurfaceToBinaryLabelmapConversionRule::GetOversamplingFactorParameterName(),
+    this->ConversionParameters[vtkClosedSurfaceToBinaryLabelmapConversionRule::GetOversamplingFactorParameterName()].first);
+  return labelmapRule->Convert(closedSurfacePolyData, labelmap);
+}
+
+//----------------------------------------------------------------------------
+vtkSegmentationConverterRule* vtkPlanarContourToBinaryLabelmapConversionRule::CreateClosedSurfaceToLabelmapRule()
+{
+  return vtkClosedSurfaceToBinaryLabelmapConversionRule::New();
+}
@@ -0,0 +1,141 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkPlanarContourToBinaryLabelmapConversionRule_h
+#define __vtkPlanarContourToBinaryLabelmapConversionRule_h
+
+// SegmentationCore includes
+#include "vtkSegmentationConverterRule.h"
+#include "vtkSegmentationConverter.h"
+
+#include "vtkSlicerDicomRtImportExportConversionRulesExport.h"
+
+// STD includes
+#include <vector>
+
+class vtkMatrix4x4;
+class vtkOrientedImageData;
+class vtkPolyData;
+
+/// \ingroup DicomRtImportImportExportConversionRules
+/// \brief Convert planar contour representation (vtkPolyData type) to binary
+///   labelmap representation (vtkOrientedImageData type) without creating a closed surface.
+///   The contours are rasterized directly into the reference image geometry using an even-odd
+///   scanline polygon fill, so holes and keyhole contours are handled without triangulation.
+///   Each labelmap slice is filled from the nearest contour plane (within half the distance to
+///   the neighboring planes), and the slices are filled in parallel.
+///
+///   The reference image geometry and oversampling factor conversion parameters are the same as
+///   of \sa vtkClosedSurfaceToBinaryLabelmapConversionRule, so that the labelmaps are created on the
+///   same lattice regardless of the conversion path.
+class VTK_SLICER_DICOMRTIMPORTEXPORT_CONVERSIONRULES_EXPORT vtkPlanarContourToBinaryLabelmapConversionRule
+  : public vtkSegmentationConverterRule
+{
+public:
+  static vtkPlanarContourToBinaryLabelmapConversionRule* New();
+  vtkTypeMacro(vtkPlanarContourToBinaryLabelmapConversionRule, vtkSegmentationConverterRule);
+  virtual vtkSegmentationConverterRule* CreateRuleInstance();
+
+  /// Constructs representation object from representation name for the supported representation classes
+  /// (typically source and target representation VTK classes, subclasses of vtkDataObject)
+  /// Note: Need to take ownership of the created object! For example using vtkSmartPointer<vtkDataObject>::Take
+  virtual vtkDataObject* ConstructRepresentationObjectByRepresentation(std::string representationName);
+
+  /// Constructs representation object from class name for the supported representation classes
+  /// (typically source and target representation VTK classes, subclasses of vtkDataObject)
+  /// Note: Need to take ownership of the created object! For example using vtkSmartPointer<vtkDataObject>::Take
+  virtual vtkDataObject* ConstructRepresentationObjectByClass(std::string className);
+
+  /// Update the target representation based on the source representation
+  virtual bool Convert(vtkDataObject* sourceRepresentation, vtkDataObject* targetRepresentation);
+
+  /// Get the cost of the conversion.
+  virtual unsigned int GetConversionCost(vtkDataObject* sourceRepresentation=NULL, vtkDataObject* targetRepresentation=NULL);
+
+  /// Human-readable name of the converter rule
+  virtual const char* GetName() { return "Planar contour to binary labelmap"; };
+
+  /// Human-readable name of the source representation
+  virtual const char* GetSourceRepresentationName() { return vtkSegmentationConverter::GetSegmentationPlanarContourRepresentationName(); };
+
+  /// Human-readable name of the target representation
+  virtual const char* GetTargetRepresentationName() { return vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(); };
+
+public:
+  /// Contours of one contour plane in continuous IJK coordinates of the output lattice
+  struct ContourPlane
+  {
+    /// Mean K coordinate of the contour points
+    double K;
+    /// Range of K coordinates filled from this plane (minimum inclusive, maximum exclusive)
+    double SlabMinimumK;
+    double SlabMaximumK;
+    /// Total area of the contours in the plane (in IJK units)
+    double Area;
+    /// Contour edges as (I0,J0,I1,J1) tuples
+    std::vector<double> Edges;
+    /// I coordinates where the edges cross the sampled rows, sorted within each row
+    std::vector<double> RowCrossings;
+    /// Start index of the crossings of each sampled row in \sa RowCrossings (number of rows + 1 elements)
+    std::vector<int> RowCrossingOffsets;
+  };
+
+protected:
+  /// Number of samples along each axis of a voxel. The output voxel value is the background value plus the number
+  /// of samples inside the contours. Binary labelmaps use one sample at the voxel center.
+  virtual int GetNumberOfSamplesPerAxis() { return 1; };
+
+  /// Scalar type of the output labelmap
+  virtual int GetOutputScalarType() { return VTK_UNSIGNED_CHAR; };
+
+  /// Value of voxels that have no samples inside the contours
+  virtual int GetOutputBackgroundValue() { return 0; };
+
+  /// Add field data describing the contents of the created labelmap. Binary labelmaps need none.
+  virtual void AddLabelmapFieldData(vtkOrientedImageData* vtkNotUsed(labelmap)) { };
+
+  /// Calculate output lattice from the reference image geometry and oversampling factor conversion parameters.
+  /// If reference geometry is not specified then an axis-aligned lattice is created with spacing of one hundredth
+  /// of the largest dimension of the contours.
+  /// Automatic oversampling is determined from the volume of the structure relative to the reference voxel size.
+  /// \param planarContourPolyData Input planar contours
+  /// \param geometryImageData Output image data containing the lattice geometry (extent is not used)
+  /// \param oversamplingFactor Output argument for the applied oversampling factor
+  bool CalculateOutputGeometry(vtkPolyData* planarContourPolyData, vtkOrientedImageData* geometryImageData, double& oversamplingFactor);
+
+  /// Transform contours to IJK coordinates and group them into contour planes sorted by K.
+  /// The slab of each plane extends half way to its neighboring planes, at most by half the median plane spacing
+  /// \param planarContourPolyData Input planar contours
+  /// \param worldToImageMatrix Transform from world to IJK coordinates of the lattice
+  /// \param singlePlaneHalfThickness Half thickness of the slab in case there is only one contour plane
+  /// \param planes Output contour planes with edges, areas and slab ranges computed
+  /// \return False if a contour is not parallel to the slices of the lattice
+  bool ComputeContourPlanes(vtkPolyData* planarContourPolyData, vtkMatrix4x4* worldToImageMatrix,
+    double singlePlaneHalfThickness, std::vector<ContourPlane>& planes);
+
+  /// Convert through closed surface representation. Used if the contours are not parallel to the slices of the lattice.
+  bool ConvertThroughClosedSurface(vtkPolyData* planarContourPolyData, vtkOrientedImageData* labelmap);
+
+  /// Create the closed surface to labelmap rule used by \sa ConvertThroughClosedSurface. The caller takes ownership.
+  virtual vtkSegmentationConverterRule* CreateClosedSurfaceToLabelmapRule();
+
+protected:
+  vtkPlanarContourToBinaryLabelmapConversionRule();
+  ~vtkPlanarContourToBinaryLabelmapConversionRule();
+  void operator=(const vtkPlanarContourToBinaryLabelmapConversionRule&);
+};
+
+#endif // __vtkPlanarContourToBinaryLabelmapConversionRule_h
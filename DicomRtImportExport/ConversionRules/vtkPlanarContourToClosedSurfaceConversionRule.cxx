@@ -42,10 +42,9 @@
 #include <vtkPriorityQueue.h>
 #include <vtkMatrix4x4.h>
 #include <vtkTextureMapToPlane.h>
-#include <vtkExtractCells.h>
 #include <vtkTransform.h>
 #include <vtkTransformPolyDataFilter.h>
-#include <vtkUnstructuredGrid.h>
+#include <vtkSMPTools.h>
 
 // STD includes
 #include <algorithm>
@@ -53,6 +52,229 @@
 //----------------------------------------------------------------------------
 vtkSegmentationConverterRuleNewMacro(vtkPlanarContourToClosedSurfaceConversionRule);
 
+//----------------------------------------------------------------------------
+/// Triangulates consecutive contour plane pairs in parallel. Each plane pair writes its triangles in its own list.
+class vtkPlanarContourPlanePairFunctor
+{
+public:
+  vtkPlanarContourToClosedSurfaceConversionRule* Rule;
+  const vtkPlanarContourToClosedSurfaceConversionRule::ContourSet* Contours;
+  std::vector<char>* LineTriangulatedToAbove;
+  std::vector<char>* LineTriangulatedToBelow;
+  std::vector<std::vector<vtkIdType> >* PlanePairTriangles;
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType planePairIndex = begin; planePairIndex < end; ++planePairIndex)
+      {
+      this->Rule->TriangulatePlanePair(*this->Contours, planePairIndex,
+        *this->LineTriangulatedToAbove, *this->LineTriangulatedToBelow, (*this->PlanePairTriangles)[planePairIndex]);
+      }
+  }
+};
+
+//----------------------------------------------------------------------------
+/// Compares contour point tree entries (point ID, contour index) by one coordinate of the points
+class vtkPlanarContourPointCoordinateLess
+{
+public:
+  vtkPlanarContourPointCoordinateLess(const std::vector<double>& points, int axis)
+    : Points(points)
+    , Axis(axis)
+  {
+  }
+
+  bool operator()(const std::pair<vtkIdType, vtkIdType>& point1, const std::pair<vtkIdType, vtkIdType>& point2) const
+  {
+    return this->Points[3*point1.first+this->Axis] < this->Points[3*point2.first+this->Axis];
+  }
+
+  const std::vector<double>& Points;
+  int Axis;
+};
+
+//----------------------------------------------------------------------------
+vtkPlanarContourToClosedSurfaceConversionRule::ContourSet::ContourSet()
+{
+  this->ContourOffsets.push_back(0);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlanarContourToClosedSurfaceConversionRule::ContourSet::ClearContours()
+{
+  this->PointIds.clear();
+  this->ContourOffsets.clear();
+  this->ContourOffsets.push_back(0);
+  this->ContourBounds.clear();
+  this->PlaneOffsets.clear();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlanarContourToClosedSurfaceConversionRule::ContourSet::Swap(ContourSet& other)
+{
+  this->Points.swap(other.Points);
+  this->PointIds.swap(other.PointIds);
+  this->ContourOffsets.swap(other.ContourOffsets);
+  this->ContourBounds.swap(other.ContourBounds);
+  this->PlaneOffsets.swap(other.PlaneOffsets);
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkPlanarContourToClosedSurfaceConversionRule::ContourSet::AddContour(const vtkIdType* pointIds, vtkIdType numberOfPointIds)
+{
+  double bounds[6] = { VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX };
+  for (vtkIdType pointIndex = 0; pointIndex < numberOfPointIds; ++pointIndex)
+    {
+    const double* point = this->GetPoint(pointIds[pointIndex]);
+    for (int i = 0; i < 3; ++i)
+      {
+      bounds[2*i] = std::min(bounds[2*i], point[i]);
+      bounds[2*i+1] = std::max(bounds[2*i+1], point[i]);
+      }
+    }
+  if (numberOfPointIds == 0)
+    {
+    std::fill(bounds, bounds+6, 0.0);
+    }
+
+  this->PointIds.insert(this->PointIds.end(), pointIds, pointIds + numberOfPointIds);
+  this->ContourOffsets.push_back((vtkIdType)this->PointIds.size());
+  this->ContourBounds.insert(this->ContourBounds.end(), bounds, bounds + 6);
+  return this->GetNumberOfContours() - 1;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkPlanarContourToClosedSurfaceConversionRule::ContourSet::AddPoint(const double point[3])
+{
+  vtkIdType pointId = (vtkIdType)(this->Points.size() / 3);
+  this->Points.insert(this->Points.end(), point, point + 3);
+  return pointId;
+}
+
+//----------------------------------------------------------------------------
+vtkPlanarContourToClosedSurfaceConversionRule::ContourPointTree::ContourPointTree()
+  : FirstContourIndex(0)
+  , NumberOfContours(0)
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkPlanarContourToClosedSurfaceConversionRule::ContourPointTree::Build(const ContourSet& contours, vtkIdType firstContourIndex, vtkIdType numberOfContours)
+{
+  this->FirstContourIndex = firstContourIndex;
+  this->NumberOfContours = numberOfContours;
+
+  vtkIdType numberOfPoints = contours.ContourOffsets[firstContourIndex+numberOfContours] - contours.ContourOffsets[firstContourIndex];
+  this->Points.clear();
+  this->Points.reserve(numberOfPoints);
+  for (vtkIdType contourIndex = firstContourIndex; contourIndex < firstContourIndex+numberOfContours; ++contourIndex)
+    {
+    const vtkIdType* pointIds = contours.GetContourPointIds(contourIndex);
+    for (vtkIdType pointIndex = 0; pointIndex < contours.GetNumberOfPointsInContour(contourIndex); ++pointIndex)
+      {
+      this->Points.push_back(std::make_pair(pointIds[pointIndex], contourIndex));
+      }
+    }
+  this->SplitAxes.assign(numberOfPoints, 0);
+
+  this->BuildNode(contours, 0, numberOfPoints);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlanarContourToClosedSurfaceConversionRule::ContourPointTree::BuildNode(const ContourSet& contours, vtkIdType begin, vtkIdType end)
+{
+  if (end - begin <= 1)
+    {
+    return;
+    }
+
+  // Split along the axis of the largest extent of the points
+  double bounds[6] = { VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX };
+  for (vtkIdType index = begin; index < end; ++index)
+    {
+    const double* point = contours.GetPoint(this->Points[index].first);
+    for (int i = 0; i < 3; ++i)
+      {
+      bounds[2*i] = std::min(bounds[2*i], point[i]);
+      bounds[2*i+1] = std::max(bounds[2*i+1], point[i]);
+      }
+    }
+  int splitAxis = 0;
+  for (int i = 1; i < 3; ++i)
+    {
+    if (bounds[2*i+1] - bounds[2*i] > bounds[2*splitAxis+1] - bounds[2*splitAxis])
+      {
+      splitAxis = i;
+      }
+    }
+
+  // Partition the points around the median
+  vtkIdType middle = (begin + end) / 2;
+  vtkPlanarContourPointCoordinateLess pointCoordinateLess(contours.Points, splitAxis);
+  std::nth_element(this->Points.begin() + begin, this->Points.begin() + middle, this->Points.begin() + end, pointCoordinateLess);
+  this->SplitAxes[middle] = (char)splitAxis;
+
+  this->BuildNode(contours, begin, middle);
+  this->BuildNode(contours, middle+1, end);
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkPlanarContourToClosedSurfaceConversionRule::ContourPointTree::FindClosestContour(const ContourSet& contours, const double* point, const std::vector<char>& contourMask) const
+{
+  double closestDistanceSquared = VTK_DOUBLE_MAX;
+  vtkIdType closestContourIndex = -1;
+  this->FindClosestContourInNode(contours, point, contourMask, 0, (vtkIdType)this->Points.size(), closestDistanceSquared, closestContourIndex);
+  return closestContourIndex;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlanarContourToClosedSurfaceConversionRule::ContourPointTree::FindClosestContourInNode(const ContourSet& contours, const double* point,
+  const std::vector<char>& contourMask, vtkIdType begin, vtkIdType end, double& closestDistanceSquared, vtkIdType& closestContourIndex) const
+{
+  if (begin >= end)
+    {
+    return;
+    }
+
+  vtkIdType middle = (begin + end) / 2;
+  const double* nodePoint = contours.GetPoint(this->Points[middle].first);
+  vtkIdType nodeContourIndex = this->Points[middle].second;
+  if (contourMask[nodeContourIndex - this->FirstContourIndex])
+    {
+    // Points at equal distance are resolved to the lowest contour index
+    double distanceSquared = vtkMath::Distance2BetweenPoints(point, nodePoint);
+    if (distanceSquared < closestDistanceSquared || (distanceSquared == closestDistanceSquared && nodeContourIndex < closestContourIndex))
+      {
+      closestDistanceSquared = distanceSquared;
+      closestContourIndex = nodeContourIndex;
+      }
+    }
+  if (end - begin == 1)
+    {
+    return;
+    }
+
+  // Search the side of the split containing the point first, then the other side if it may contain a point that is not farther
+  int splitAxis = this->SplitAxes[middle];
+  double splitDistance = point[splitAxis] - nodePoint[splitAxis];
+  if (splitDistance < 0)
+    {
+    this->FindClosestContourInNode(contours, point, contourMask, begin, middle, closestDistanceSquared, closestContourIndex);
+    if (splitDistance*splitDistance <= closestDistanceSquared)
+      {
+      this->FindClosestContourInNode(contours, point, contourMask, middle+1, end, closestDistanceSquared, closestContourIndex);
+      }
+    }
+  else
+    {
+    this->FindClosestContourInNode(contours, point, contourMask, middle+1, end, closestDistanceSquared, closestContourIndex);
+    if (splitDistance*splitDistance <= closestDistanceSquared)
+      {
+      this->FindClosestContourInNode(contours, point, contourMask, begin, middle, closestDistanceSquared, closestContourIndex);
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 vtkPlanarContourToClosedSurfaceConversionRule::vtkPlanarContourToClosedSurfaceConversionRule()
 {
@@ -67,6 +289,8 @@ vtkPlanarContourToClosedSurfaceConversionRule::vtkPlanarContourToClosedSurfaceCo
   this->ImagePadding[1] = 4;
   this->ImagePadding[2] = 0;
 
+  this->ConcurrentTriangulation = true;
+
   //this->ConversionParameters[GetXYParameterName()] = std::make_pair("value", "description");
 }
 
@@ -126,9 +350,6 @@ bool vtkPlanarContourToClosedSurfaceConversionRule::Convert(vtkDataObject* sourc
     return false;
     }
 
-  // Copy the contours so that we can make modifications without affecting the original
-  vtkSmartPointer<vtkPolyData> inputContoursCopy = vtkSmartPointer<vtkPolyData>::New();
-  
   vtkSmartPointer<vtkMatrix4x4> contourToRASMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
   this->CalculateContourTransform(planarContoursPolyData, contourToRASMatrix);
 
@@ -138,170 +359,96 @@ bool vtkPlanarContourToClosedSurfaceConversionRule::Convert(vtkDataObject* sourc
   transformRASToContoursFilter->SetInputData(planarContoursPolyData);
   transformRASToContoursFilter->SetTransform(transformRASToContours);
   transformRASToContoursFilter->Update();
-  inputContoursCopy->DeepCopy(transformRASToContoursFilter->GetOutput());
+  vtkPolyData* inputContours = transformRASToContoursFilter->GetOutput();
+
+  // Copy the contours to the flat representation so that we can make modifications without affecting the original,
+  // and without creating VTK objects for each contour in the steps of the algorithm
+  ContourSet contours;
+  this->ReadContours(inputContours, contours);
 
   // Make sure the contours are in the right order.
-  this->SortContours(inputContoursCopy);
+  this->SortContours(contours);
 
   // remove keyholes from the lines
-  this->FixKeyholes(inputContoursCopy, 0.001, 3);
+  this->FixKeyholes(contours, 0.001, 3);
 
   // set all lines to be counter-clockwise
-  this->SetLinesCounterClockwise(inputContoursCopy);
-
-  vtkSmartPointer<vtkPoints> outputPoints = inputContoursCopy->GetPoints();
-  vtkSmartPointer<vtkCellArray> outputLines = inputContoursCopy->GetLines();
-  vtkSmartPointer<vtkCellArray> outputPolygons = vtkSmartPointer<vtkCellArray>::New(); // Triangles should be added to this
+  this->SetLinesCounterClockwise(contours);
 
   // Total number of lines in the contours
-  int numberOfLines = inputContoursCopy->GetNumberOfLines();
+  vtkIdType numberOfLines = contours.GetNumberOfContours();
+
+  double spacing = this->GetSpacingBetweenLines(contours);
 
-  double spacing = this->GetSpacingBetweenLines(inputContoursCopy);
+  // Determine the first line of each contour plane
+  this->ComputeContourPlanes(contours, spacing);
 
-  std::vector<vtkSmartPointer<vtkPointLocator> > pointLocators(numberOfLines);
-  std::vector<vtkSmartPointer<vtkIdList> > linePointIdLists(numberOfLines);
-  for(int lineIndex = 0; lineIndex < numberOfLines; ++lineIndex)
+  // Flags to determine which lines are triangulated from above and from below.
+  // Stored as char instead of bool so that the flags of different lines can be set from different threads.
+  std::vector<char> lineTriangulatedToAbove(numberOfLines, 0);
+  std::vector<char> lineTriangulatedToBelow(numberOfLines, 0);
+
+  // Triangulate consecutive plane pairs (in parallel, unless disabled). The pairs only read the contours, and each line is flagged
+  // as triangulated to above only by the pair it is the lower plane of, and to below only by the pair it is the upper plane of.
+  int numberOfPlanePairs = std::max(0, contours.GetNumberOfPlanes() - 1);
+  std::vector<std::vector<vtkIdType> > planePairTriangles(numberOfPlanePairs);
+  vtkPlanarContourPlanePairFunctor planePairFunctor;
+  planePairFunctor.Rule = this;
+  planePairFunctor.Contours = &contours;
+  planePairFunctor.LineTriangulatedToAbove = &lineTriangulatedToAbove;
+  planePairFunctor.LineTriangulatedToBelow = &lineTriangulatedToBelow;
+  planePairFunctor.PlanePairTriangles = &planePairTriangles;
+  if (this->ConcurrentTriangulation)
     {
-    vtkSmartPointer<vtkLine> currentLine = vtkSmartPointer<vtkLine>::New();
-    currentLine->DeepCopy(inputContoursCopy->GetCell(lineIndex));
-    linePointIdLists[lineIndex] = currentLine->GetPointIds();
-    vtkSmartPointer<vtkPolyData> linePolyData = vtkSmartPointer<vtkPolyData>::New();
-    linePolyData->SetPoints(currentLine->GetPoints());
-    pointLocators[lineIndex] = vtkSmartPointer<vtkPointLocator>::New();
-    pointLocators[lineIndex]->SetDataSet(linePolyData);
-    pointLocators[lineIndex]->BuildLocator();
+    vtkSMPTools::For(0, numberOfPlanePairs, 1, planePairFunctor);
     }
-
-  // Vector of booleans to determine which lines are triangulated from above and from below.
-  std::vector< bool > lineTriganulatedToAbove(numberOfLines);
-  std::vector< bool > lineTriganulatedToBelow(numberOfLines);
-  for (int i=0; i<numberOfLines; ++i)
+  else
     {
-    lineTriganulatedToAbove[i] = false;
-    lineTriganulatedToBelow[i] = false;
+    planePairFunctor(0, numberOfPlanePairs);
     }
 
-  // Get two consecutive planes.
-  vtkIdType firstLineOnPlane1Index = 0; // pointer to first line on plane 1.
-  int numberOfLinesInPlane1 = this->GetNumberOfLinesOnPlane(inputContoursCopy, 0, spacing);
-
-  // Loop through all of the contours in the polydata
-  while (firstLineOnPlane1Index + numberOfLinesInPlane1 < numberOfLines)
+  // Merge the triangles of the plane pairs in plane order, so that the output does not depend on the number of threads
+  std::vector<vtkIdType> outputTriangles;
+  size_t numberOfTrianglePointIds = 0;
+  for (int planePairIndex = 0; planePairIndex < numberOfPlanePairs; ++planePairIndex)
     {
-    vtkIdType firstLineOnPlane2Index = firstLineOnPlane1Index + numberOfLinesInPlane1; // pointer to first line on plane 2
-    int numberOfLinesInPlane2 = this->GetNumberOfLinesOnPlane(inputContoursCopy, firstLineOnPlane2Index, spacing); // number of lines on plane 2
-
-    // initialize overlaps lists. - list of list
-    // Each internal list represents a line from the plane and will store the pointers to the overlap lines
-
-    // List of Overlaps for lines from plane 1
-    std::vector< std::vector< vtkIdType > > plane1Overlaps;
-    for (int line1Index = 0; line1Index < numberOfLinesInPlane1; ++line1Index)
-      {
-      std::vector< vtkIdType > temp;
-      plane1Overlaps.push_back(temp);
-      }
-
-    // overlaps for lines from plane 2
-    std::vector< std::vector< vtkIdType > > plane2Overlaps;
-    for (int line2Index=0; line2Index < numberOfLinesInPlane2; ++line2Index)
-      {
-      std::vector< vtkIdType > temp;
-      plane2Overlaps.push_back(temp);
-      }
-
-    // Loop through the lines in the first plane
-    for (int line1Index=0; line1Index < numberOfLinesInPlane1; ++line1Index)
-      {
-      vtkSmartPointer<vtkLine> line1 = vtkSmartPointer<vtkLine>::New();
-      line1->DeepCopy(inputContoursCopy->GetCell(firstLineOnPlane1Index+line1Index));
-
-      // Loop through the lines in the second plane
-      for (int line2Index=0; line2Index < numberOfLinesInPlane2; ++line2Index)
-        {
-        vtkSmartPointer<vtkLine> line2 = vtkSmartPointer<vtkLine>::New();
-        line2->DeepCopy(inputContoursCopy->GetCell(firstLineOnPlane2Index+line2Index));
-
-        // If the two lines overlap, then add them to the lists
-        if (this->DoLinesOverlap(line1, line2))
-          {
-          // line from plane 1 overlaps with line from plane 2
-          plane1Overlaps[line1Index].push_back(firstLineOnPlane2Index+line2Index);
-          plane2Overlaps[line2Index].push_back(firstLineOnPlane1Index+line1Index);
-          }
-        }
-      }
-
-    // Loop through all of the lines in the first plane
-    for (int line1Index = firstLineOnPlane1Index; line1Index < firstLineOnPlane1Index+numberOfLinesInPlane1; ++line1Index)
-      {
-      vtkSmartPointer<vtkLine> line1 = vtkSmartPointer<vtkLine>::New();
-      line1->DeepCopy(inputContoursCopy->GetCell(line1Index));
-
-      bool intersects = false;
-
-      std::vector<vtkSmartPointer<vtkPointLocator> > overlap1PointLocators(plane1Overlaps[line1Index-firstLineOnPlane1Index].size());
-      std::vector<vtkSmartPointer<vtkIdList> > overlap1PointIds(plane1Overlaps[line1Index-firstLineOnPlane1Index].size());
-
-      // Loop through all of the lines in the second plane that overlap with the current line in the first plane
-      for (int overlapIndex = 0; overlapIndex < plane1Overlaps[line1Index-firstLineOnPlane1Index].size(); ++overlapIndex) // lines on plane 2 that overlap with line 1
-        {
-        int j = plane1Overlaps[line1Index-firstLineOnPlane1Index][overlapIndex];
-        overlap1PointLocators[overlapIndex] = (pointLocators[j]);
-        overlap1PointIds[overlapIndex] = (linePointIdLists[j]);
-        }
-
-      // Loop through all of the lines in the second plane that overlap with the current line in the first plane
-      for (int overlapIndex = 0; overlapIndex < plane1Overlaps[line1Index-firstLineOnPlane1Index].size(); ++overlapIndex) // lines on plane 2 that overlap with line 1
-        {
-        int line2Index = plane1Overlaps[line1Index-firstLineOnPlane1Index][overlapIndex];
-
-        vtkSmartPointer<vtkLine> line2 = vtkSmartPointer<vtkLine>::New();
-        line2->DeepCopy(inputContoursCopy->GetCell(line2Index));
-
-        std::vector<vtkSmartPointer<vtkPointLocator> > overlap2PointLocators(plane2Overlaps[line2Index-firstLineOnPlane2Index].size());
-        std::vector<vtkSmartPointer<vtkIdList> > overlap2PointIds(plane2Overlaps[line2Index-firstLineOnPlane2Index].size());
-
-        for (int i=0; i<plane2Overlaps[line2Index-firstLineOnPlane2Index].size(); ++i)
-          {
-          int j = plane2Overlaps[line2Index-firstLineOnPlane2Index][i];
-          overlap2PointLocators[i] = (pointLocators[j]);
-          overlap2PointIds[i] = (linePointIdLists[j]);
-          }
-
-        // Get the portion of line 1 that is close to line 2,
-        vtkSmartPointer<vtkLine> dividedLine1 = vtkSmartPointer<vtkLine>::New();
-        this->Branch(inputContoursCopy, line1, line2Index, plane1Overlaps[line1Index-firstLineOnPlane1Index], overlap1PointLocators, overlap1PointIds, dividedLine1);
-        vtkSmartPointer<vtkIdList> dividedPointsInLine1 = dividedLine1->GetPointIds();
-        int numberOfdividedPointsInLine1 = dividedLine1->GetNumberOfPoints();
-
-        // Get the portion of line 2 that is close to line 1.
-        vtkSmartPointer<vtkLine> dividedLine2 = vtkSmartPointer<vtkLine>::New();
-        this->Branch(inputContoursCopy, line2, line1Index, plane2Overlaps[line2Index-firstLineOnPlane2Index], overlap2PointLocators, overlap2PointIds, dividedLine2);
-        vtkSmartPointer<vtkIdList> dividedPointsInLine2 = dividedLine2->GetPointIds();
-        int numberOfdividedPointsInLine2 = dividedLine2->GetNumberOfPoints();
-
-        if (numberOfdividedPointsInLine1 > 1 && numberOfdividedPointsInLine2 > 1)
-          {
-          lineTriganulatedToAbove[line1Index] = true;
-          lineTriganulatedToBelow[line2Index] = true;
-          this->TriangulateContours(inputContoursCopy, dividedPointsInLine1, dividedPointsInLine2, outputPolygons);
-          }
-
-        }
-      }
-
-    // Advance the points
-    firstLineOnPlane1Index = firstLineOnPlane2Index;
-    numberOfLinesInPlane1 = numberOfLinesInPlane2;
+    numberOfTrianglePointIds += planePairTriangles[planePairIndex].size();
+    }
+  outputTriangles.reserve(numberOfTrianglePointIds);
+  for (int planePairIndex = 0; planePairIndex < numberOfPlanePairs; ++planePairIndex)
+    {
+    outputTriangles.insert(outputTriangles.end(), planePairTriangles[planePairIndex].begin(), planePairTriangles[planePairIndex].end());
+    std::vector<vtkIdType>().swap(planePairTriangles[planePairIndex]);
     }
 
   // Triangulate all contours which are exposed.
-  this->EndCapping( inputContoursCopy, outputPolygons, lineTriganulatedToAbove, lineTriganulatedToBelow);
+  this->EndCapping(contours, spacing, lineTriangulatedToAbove, lineTriangulatedToBelow, outputTriangles);
 
   // Initialize the output data.
+  // Points are stored with the precision of the input points.
+  vtkSmartPointer<vtkPoints> outputPoints = vtkSmartPointer<vtkPoints>::New();
+  if (inputContours->GetPoints())
+    {
+    outputPoints->SetDataType(inputContours->GetPoints()->GetDataType());
+    }
+  vtkIdType numberOfPoints = (vtkIdType)(contours.Points.size() / 3);
+  outputPoints->SetNumberOfPoints(numberOfPoints);
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+    {
+    outputPoints->SetPoint(pointId, contours.GetPoint(pointId));
+    }
+
+  vtkSmartPointer<vtkCellArray> outputPolygons = vtkSmartPointer<vtkCellArray>::New();
+  vtkIdType numberOfTriangles = (vtkIdType)(outputTriangles.size() / 3);
+  outputPolygons->Allocate(4*numberOfTriangles);
+  for (vtkIdType triangleIndex = 0; triangleIndex < numberOfTriangles; ++triangleIndex)
+    {
+    outputPolygons->InsertNextCell(3, &outputTriangles[3*triangleIndex]);
+    }
+
+  closedSurfacePolyData->Initialize();
   closedSurfacePolyData->SetPoints(outputPoints);
-  //closedSurfacePolyData->SetLines(outputLines); // Do not include lines in poly data for nicer visualization
+  // Do not include lines in poly data for nicer visualization
   closedSurfacePolyData->SetPolys(outputPolygons);
 
   vtkSmartPointer<vtkTransform> transformContoursToRAS = vtkSmartPointer<vtkTransform>::New();
@@ -318,54 +465,152 @@ bool vtkPlanarContourToClosedSurfaceConversionRule::Convert(vtkDataObject* sourc
 }
 
 //----------------------------------------------------------------------------
-void vtkPlanarContourToClosedSurfaceConversionRule::TriangulateContours(vtkPolyData* inputROIPoints, vtkIdList* pointsInLine1, vtkIdList* pointsInLine2, vtkCellArray* outputPolygons)
+void vtkPlanarContourToClosedSurfaceConversionRule::ReadContours(vtkPolyData* inputROIPoints, ContourSet& contours)
 {
+  contours.Points.clear();
+  contours.ClearContours();
   if (!inputROIPoints)
     {
-    vtkErrorMacro("TriangulateContours: Invalid vtkPolyData!");
+    vtkErrorMacro("ReadContours: Invalid vtkPolyData!");
     return;
     }
 
-  if (!pointsInLine1)
+  vtkPoints* points = inputROIPoints->GetPoints();
+  vtkIdType numberOfPoints = (points ? points->GetNumberOfPoints() : 0);
+  contours.Points.resize(3*numberOfPoints);
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+    {
+    points->GetPoint(pointId, &contours.Points[3*pointId]);
+    }
+
+  vtkCellArray* lines = inputROIPoints->GetLines();
+  if (!lines)
     {
-    vtkErrorMacro("TriangulateContours: Invalid vtkIdList!");
     return;
     }
+  contours.PointIds.reserve(lines->GetNumberOfConnectivityEntries());
+  contours.ContourOffsets.reserve(lines->GetNumberOfCells()+1);
+  contours.ContourBounds.reserve(6*lines->GetNumberOfCells());
+  vtkIdType numberOfLinePoints = 0;
+  vtkIdType* linePointIds = NULL;
+  for (lines->InitTraversal(); lines->GetNextCell(numberOfLinePoints, linePointIds); )
+    {
+    contours.AddContour(linePointIds, numberOfLinePoints);
+    }
+}
 
-  if (!pointsInLine2)
+//----------------------------------------------------------------------------
+void vtkPlanarContourToClosedSurfaceConversionRule::TriangulatePlanePair(const ContourSet& contours, int planePairIndex,
+  std::vector<char>& lineTriangulatedToAbove, std::vector<char>& lineTriangulatedToBelow, std::vector<vtkIdType>& outputTriangles)
+{
+  vtkIdType firstLineOnPlane1Index = contours.PlaneOffsets[planePairIndex];
+  vtkIdType numberOfLinesInPlane1 = contours.PlaneOffsets[planePairIndex+1] - firstLineOnPlane1Index;
+  vtkIdType firstLineOnPlane2Index = contours.PlaneOffsets[planePairIndex+1];
+  vtkIdType numberOfLinesInPlane2 = contours.PlaneOffsets[planePairIndex+2] - firstLineOnPlane2Index;
+
+  // initialize overlaps lists. - list of list
+  // Each internal list represents a line from the plane and will store the indices of the overlap lines
+
+  // List of Overlaps for lines from plane 1
+  std::vector< std::vector< vtkIdType > > plane1Overlaps(numberOfLinesInPlane1);
+
+  // overlaps for lines from plane 2
+  std::vector< std::vector< vtkIdType > > plane2Overlaps(numberOfLinesInPlane2);
+
+  // The pairs are sorted, so the overlap lists are in increasing line index order
+  std::vector<std::pair<vtkIdType, vtkIdType> > overlappingLinePairs;
+  this->FindOverlappingLines(contours, planePairIndex, planePairIndex+1, overlappingLinePairs);
+  for (size_t pairIndex = 0; pairIndex < overlappingLinePairs.size(); ++pairIndex)
     {
-   vtkErrorMacro("TriangulateContours: Invalid vtkIdList!");
-   return;
+    // line from plane 1 overlaps with line from plane 2
+    plane1Overlaps[overlappingLinePairs[pairIndex].first-firstLineOnPlane1Index].push_back(overlappingLinePairs[pairIndex].second);
+    plane2Overlaps[overlappingLinePairs[pairIndex].second-firstLineOnPlane2Index].push_back(overlappingLinePairs[pairIndex].first);
+    }
+
+  // Find the closest branch of each point of the lines that overlap with multiple lines.
+  // The point trees of the planes are only built if there is branching.
+  ContourPointTree plane1PointTree;
+  ContourPointTree plane2PointTree;
+  std::vector< std::vector< vtkIdType > > plane1ClosestBranchIds(numberOfLinesInPlane1);
+  std::vector< std::vector< vtkIdType > > plane2ClosestBranchIds(numberOfLinesInPlane2);
+  for (vtkIdType line1Index = 0; line1Index < numberOfLinesInPlane1; ++line1Index)
+    {
+    if (plane1Overlaps[line1Index].size() > 1)
+      {
+      if (plane2PointTree.Points.empty())
+        {
+        plane2PointTree.Build(contours, firstLineOnPlane2Index, numberOfLinesInPlane2);
+        }
+      this->GetClosestBranches(contours, firstLineOnPlane1Index+line1Index, plane2PointTree, plane1Overlaps[line1Index], plane1ClosestBranchIds[line1Index]);
+      }
+    }
+  for (vtkIdType line2Index = 0; line2Index < numberOfLinesInPlane2; ++line2Index)
+    {
+    if (plane2Overlaps[line2Index].size() > 1)
+      {
+      if (plane1PointTree.Points.empty())
+        {
+        plane1PointTree.Build(contours, firstLineOnPlane1Index, numberOfLinesInPlane1);
+        }
+      this->GetClosestBranches(contours, firstLineOnPlane2Index+line2Index, plane1PointTree, plane2Overlaps[line2Index], plane2ClosestBranchIds[line2Index]);
+      }
     }
 
-  if (pointsInLine1->GetNumberOfIds() == 0 || pointsInLine2->GetNumberOfIds() == 0)
+  // The divided lines are reused for all line pairs to avoid allocations
+  std::vector<vtkIdType> dividedPointsInLine1;
+  std::vector<vtkIdType> dividedPointsInLine2;
+
+  // Loop through all of the overlapping line pairs
+  for (size_t pairIndex = 0; pairIndex < overlappingLinePairs.size(); ++pairIndex)
     {
+    vtkIdType line1Index = overlappingLinePairs[pairIndex].first;
+    vtkIdType line2Index = overlappingLinePairs[pairIndex].second;
+
+    // Get the portion of line 1 that is close to line 2,
+    this->Branch(contours, line1Index, line2Index, plane1ClosestBranchIds[line1Index-firstLineOnPlane1Index], dividedPointsInLine1);
+
+    // Get the portion of line 2 that is close to line 1.
+    this->Branch(contours, line2Index, line1Index, plane2ClosestBranchIds[line2Index-firstLineOnPlane2Index], dividedPointsInLine2);
+
+    if (dividedPointsInLine1.size() > 1 && dividedPointsInLine2.size() > 1)
+      {
+      lineTriangulatedToAbove[line1Index] = 1;
+      lineTriangulatedToBelow[line2Index] = 1;
+      this->TriangulateContours(contours, &dividedPointsInLine1[0], (vtkIdType)dividedPointsInLine1.size(),
+        &dividedPointsInLine2[0], (vtkIdType)dividedPointsInLine2.size(), outputTriangles);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlanarContourToClosedSurfaceConversionRule::TriangulateContours(const ContourSet& contours, const vtkIdType* pointsInLine1, vtkIdType numberOfPointsInLine1,
+  const vtkIdType* pointsInLine2, vtkIdType numberOfPointsInLine2, std::vector<vtkIdType>& outputTriangles)
+{
+  if (!pointsInLine1 || !pointsInLine2)
+    {
+    vtkErrorMacro("TriangulateContours: Invalid point ID list!");
     return;
     }
 
-  int numberOfPointsInLine1 = pointsInLine1->GetNumberOfIds();
-  int numberOfPointsInLine2 = pointsInLine2->GetNumberOfIds();
+  if (numberOfPointsInLine1 == 0 || numberOfPointsInLine2 == 0)
+    {
+    return;
+    }
 
   // Pre-calculate and store the closest points.
 
   // Closest point from line 1 to line 2
-  std::vector< int > closestPointFromLine1ToLine2Ids;
-  for (int line1PointIndex = 0; line1PointIndex < numberOfPointsInLine1; ++line1PointIndex)
+  std::vector< vtkIdType > closestPointFromLine1ToLine2Ids(numberOfPointsInLine1);
+  for (vtkIdType line1PointIndex = 0; line1PointIndex < numberOfPointsInLine1; ++line1PointIndex)
     {
-    double line1Point[3] = {0,0,0};
-    inputROIPoints->GetPoint(pointsInLine1->GetId(line1PointIndex), line1Point);
-
-    closestPointFromLine1ToLine2Ids.push_back(this->GetClosestPoint(inputROIPoints, line1Point, pointsInLine2));
+    closestPointFromLine1ToLine2Ids[line1PointIndex] = this->GetClosestPoint(contours, contours.GetPoint(pointsInLine1[line1PointIndex]), pointsInLine2, numberOfPointsInLine2);
     }
 
   // Closest from line 2 to line 1
-  std::vector< int > closestPointFromLine2ToLine1Ids;
-  for (int line2PointIndex = 0; line2PointIndex < numberOfPointsInLine2; ++line2PointIndex)
+  std::vector< vtkIdType > closestPointFromLine2ToLine1Ids(numberOfPointsInLine2);
+  for (vtkIdType line2PointIndex = 0; line2PointIndex < numberOfPointsInLine2; ++line2PointIndex)
     {
-    double line2Point[3] = {0,0,0};
-    inputROIPoints->GetPoint(pointsInLine2->GetId(line2PointIndex),line2Point);
-
-    closestPointFromLine2ToLine1Ids.push_back(this->GetClosestPoint(inputROIPoints, line2Point, pointsInLine1));
+    closestPointFromLine2ToLine1Ids[line2PointIndex] = this->GetClosestPoint(contours, contours.GetPoint(pointsInLine2[line2PointIndex]), pointsInLine1, numberOfPointsInLine1);
     }
 
   // Orient loops.
@@ -373,69 +618,54 @@ void vtkPlanarContourToClosedSurfaceConversionRule::TriangulateContours(vtkPolyD
   vtkIdType startLine1PointId = 0;
   vtkIdType startLine2PointId = closestPointFromLine1ToLine2Ids[0];
 
-  double firstPointLine1[3] = {0,0,0}; // first point on line 1;
-  inputROIPoints->GetPoint(pointsInLine1->GetId(startLine1PointId),firstPointLine1);
-
-  double firstPointLine2[3] = {0,0,0}; // first point on line 2;
-  inputROIPoints->GetPoint(pointsInLine2->GetId(startLine2PointId), firstPointLine2);
+  const double* firstPointLine1 = contours.GetPoint(pointsInLine1[startLine1PointId]); // first point on line 1
+  const double* firstPointLine2 = contours.GetPoint(pointsInLine2[startLine2PointId]); // first point on line 2
 
   // Determine if the loops are closed.
   // A loop is closed if the first point is repeated as the last point.
-  bool line1Closed = (pointsInLine1->GetId(0) == pointsInLine1->GetId(numberOfPointsInLine1-1));
-  bool line2Closed = (pointsInLine2->GetId(0) == pointsInLine2->GetId(numberOfPointsInLine2-1));
+  bool line1Closed = (pointsInLine1[0] == pointsInLine1[numberOfPointsInLine1-1]);
+  bool line2Closed = (pointsInLine2[0] == pointsInLine2[numberOfPointsInLine2-1]);
 
   // Determine the ending points.
-  int line1EndPoint = this->GetEndLoop(startLine1PointId, numberOfPointsInLine1, line1Closed);
-  int line2EndPoint = this->GetEndLoop(startLine2PointId, numberOfPointsInLine2, line2Closed);
+  vtkIdType line1EndPoint = this->GetEndLoop(startLine1PointId, numberOfPointsInLine1, line1Closed);
+  vtkIdType line2EndPoint = this->GetEndLoop(startLine2PointId, numberOfPointsInLine2, line2Closed);
 
   // for backtracking
-  int left = -1;
-  int up = 1;
+  const char left = -1;
+  const char up = 1;
 
   // Initialize the Dynamic Programming table.
-  // Rows represent line 1. Columns represent line 2.
+  // Rows represent line 1. Columns represent line 2. The tables are stored row by row in contiguous arrays.
 
   // Initialize the score table.
-  std::vector< std::vector< double > > scoreTable( numberOfPointsInLine1, std::vector< double >( numberOfPointsInLine2 ) );
-  double distanceBetweenPoints = vtkMath::Distance2BetweenPoints(firstPointLine1, firstPointLine2);
-  scoreTable[0][0] = distanceBetweenPoints;
+  std::vector< double > scoreTable(numberOfPointsInLine1*numberOfPointsInLine2, 0.0);
+  scoreTable[0] = vtkMath::Distance2BetweenPoints(firstPointLine1, firstPointLine2);
 
-  std::vector< std::vector< int > > backtrackTable( numberOfPointsInLine1, std::vector< int >( numberOfPointsInLine2 ) );
-  backtrackTable[0][0] = 0;
+  std::vector< char > backtrackTable(numberOfPointsInLine1*numberOfPointsInLine2, up);
+  backtrackTable[0] = 0;
 
   // Initialize the first row in the table.
   vtkIdType currentPointIdLine2 = this->GetNextLocation(startLine2PointId, numberOfPointsInLine2, line2Closed);
-  for (int line2PointIndex = 1; line2PointIndex < numberOfPointsInLine2; ++line2PointIndex)
+  for (vtkIdType line2PointIndex = 1; line2PointIndex < numberOfPointsInLine2; ++line2PointIndex)
     {
-    double currentPointLine2[3] = {0,0,0}; // current point on line 2
-    inputROIPoints->GetPoint(pointsInLine2->GetId(currentPointIdLine2),currentPointLine2);
-
     // Use the distance between first point on line 1 and current point on line 2.
-    double distance = vtkMath::Distance2BetweenPoints(firstPointLine1, currentPointLine2);
+    double distance = vtkMath::Distance2BetweenPoints(firstPointLine1, contours.GetPoint(pointsInLine2[currentPointIdLine2]));
 
-    scoreTable[0][line2PointIndex] = scoreTable[0][line2PointIndex-1]+distance;
-    backtrackTable[0][line2PointIndex] = left;
+    scoreTable[line2PointIndex] = scoreTable[line2PointIndex-1]+distance;
+    backtrackTable[line2PointIndex] = left;
 
     currentPointIdLine2 = this->GetNextLocation(currentPointIdLine2, numberOfPointsInLine2, line2Closed);
     }
 
   // Initialize the first column in the table.
   vtkIdType currentPointIdLine1 = this->GetNextLocation(startLine1PointId, numberOfPointsInLine2, line1Closed);
-  for( int line1PointIndex=1; line1PointIndex < numberOfPointsInLine1; ++line1PointIndex)
+  for (vtkIdType line1PointIndex = 1; line1PointIndex < numberOfPointsInLine1; ++line1PointIndex)
     {
-    double currentPointLine1[3] = {0,0,0}; // current point on line 1
-    inputROIPoints->GetPoint(pointsInLine1->GetId(currentPointIdLine1), currentPointLine1);
-
     // Use the distance between first point on line 2 and current point on line 1.
-    double distance = vtkMath::Distance2BetweenPoints(currentPointLine1, firstPointLine2);
+    double distance = vtkMath::Distance2BetweenPoints(contours.GetPoint(pointsInLine1[currentPointIdLine1]), firstPointLine2);
 
-    scoreTable[line1PointIndex][0] = scoreTable[line1PointIndex-1][0]+distance;
-    backtrackTable[line1PointIndex][0] = up;
-    for(int line2PointIndex = 1; line2PointIndex < numberOfPointsInLine2; ++line2PointIndex)
-      {
-      scoreTable[line1PointIndex][line2PointIndex] = 0;
-      backtrackTable[line1PointIndex][line2PointIndex] = up;
-      }
+    scoreTable[line1PointIndex*numberOfPointsInLine2] = scoreTable[(line1PointIndex-1)*numberOfPointsInLine2]+distance;
+    backtrackTable[line1PointIndex*numberOfPointsInLine2] = up;
 
     currentPointIdLine1 = this->GetNextLocation(currentPointIdLine1, numberOfPointsInLine1, line1Closed);
     }
@@ -451,38 +681,35 @@ void vtkPlanarContourToClosedSurfaceConversionRule::TriangulateContours(vtkPolyD
   vtkIdType line2PointIndex=1;
   for (line1PointIndex = 1; line1PointIndex < numberOfPointsInLine1; ++line1PointIndex)
     {
-    double pointOnLine1[3] = {0,0,0};
-    inputROIPoints->GetPoint(pointsInLine1->GetId(currentPointIdLine1), pointOnLine1);
+    const double* pointOnLine1 = contours.GetPoint(pointsInLine1[currentPointIdLine1]);
+    double* scoreRow = &scoreTable[line1PointIndex*numberOfPointsInLine2];
+    const double* previousScoreRow = scoreRow - numberOfPointsInLine2;
+    char* backtrackRow = &backtrackTable[line1PointIndex*numberOfPointsInLine2];
 
     for (line2PointIndex = 1; line2PointIndex < numberOfPointsInLine2; ++line2PointIndex)
       {
-      double pointOnLine2[3] = {0,0,0};
-      inputROIPoints->GetPoint(pointsInLine2->GetId(currentPointIdLine2), pointOnLine2);
-
-      double distance = vtkMath::Distance2BetweenPoints(pointOnLine1, pointOnLine2);
+      double distance = vtkMath::Distance2BetweenPoints(pointOnLine1, contours.GetPoint(pointsInLine2[currentPointIdLine2]));
 
       // Use the pre-calculated closest point.
       if (currentPointIdLine1 == closestPointFromLine2ToLine1Ids[previousLine2])
         {
-        scoreTable[line1PointIndex][line2PointIndex] = scoreTable[line1PointIndex][line2PointIndex-1]+distance;
-        backtrackTable[line1PointIndex][line2PointIndex] = left;
+        scoreRow[line2PointIndex] = scoreRow[line2PointIndex-1]+distance;
+        backtrackRow[line2PointIndex] = left;
         }
       else if (currentPointIdLine2 == closestPointFromLine1ToLine2Ids[previousLine1])
         {
-        scoreTable[line1PointIndex][line2PointIndex] = scoreTable[line1PointIndex-1][line2PointIndex]+distance;
-        backtrackTable[line1PointIndex][line2PointIndex] = up;
-
+        scoreRow[line2PointIndex] = previousScoreRow[line2PointIndex]+distance;
+        backtrackRow[line2PointIndex] = up;
         }
-      else if (scoreTable[line1PointIndex][line2PointIndex-1] <= scoreTable[line1PointIndex-1][line2PointIndex])
+      else if (scoreRow[line2PointIndex-1] <= previousScoreRow[line2PointIndex])
         {
-        scoreTable[line1PointIndex][line2PointIndex] = scoreTable[line1PointIndex][line2PointIndex-1]+distance;
-        backtrackTable[line1PointIndex][line2PointIndex] = left;
-
+        scoreRow[line2PointIndex] = scoreRow[line2PointIndex-1]+distance;
+        backtrackRow[line2PointIndex] = left;
         }
       else
         {
-        scoreTable[line1PointIndex][line2PointIndex] = scoreTable[line1PointIndex-1][line2PointIndex]+distance;
-        backtrackTable[line1PointIndex][line2PointIndex] = up;
+        scoreRow[line2PointIndex] = previousScoreRow[line2PointIndex]+distance;
+        backtrackRow[line2PointIndex] = up;
         }
 
       // Advance the pointers
@@ -500,27 +727,13 @@ void vtkPlanarContourToClosedSurfaceConversionRule::TriangulateContours(vtkPolyD
   --line2PointIndex;
   while (line1PointIndex > 0  || line2PointIndex > 0)
     {
-    double line1Point[3] = {0,0,0}; // current point on line 1
-    inputROIPoints->GetPoint(pointsInLine1->GetId(currentPointIdLine1), line1Point);
-
-    double line2Point[3] = {0,0,0}; // current point on line 2
-    inputROIPoints->GetPoint(pointsInLine2->GetId(currentPointIdLine2), line2Point);
-
-    double distanceBetweenPoints = vtkMath::Distance2BetweenPoints(line1Point, line2Point);
-
-    if (backtrackTable[line1PointIndex][line2PointIndex] == left)
+    if (backtrackTable[line1PointIndex*numberOfPointsInLine2+line2PointIndex] == left)
       {
       vtkIdType previousPointIndexLine2 = this->GetPreviousLocation(currentPointIdLine2, numberOfPointsInLine2, line2Closed);
 
-      vtkIdType currentTriangle[3] = {0,0,0};
-      currentTriangle[0] = pointsInLine1->GetId(currentPointIdLine1);
-      currentTriangle[1] = pointsInLine2->GetId(currentPointIdLine2);
-      currentTriangle[2] = pointsInLine2->GetId(previousPointIndexLine2);
-
-      outputPolygons->InsertNextCell(3);
-      outputPolygons->InsertCellPoint(currentTriangle[0]);
-      outputPolygons->InsertCellPoint(currentTriangle[1]);
-      outputPolygons->InsertCellPoint(currentTriangle[2]);
+      outputTriangles.push_back(pointsInLine1[currentPointIdLine1]);
+      outputTriangles.push_back(pointsInLine2[currentPointIdLine2]);
+      outputTriangles.push_back(pointsInLine2[previousPointIndexLine2]);
 
       line2PointIndex -= 1;
       currentPointIdLine2 = previousPointIndexLine2;
@@ -529,15 +742,9 @@ void vtkPlanarContourToClosedSurfaceConversionRule::TriangulateContours(vtkPolyD
       {
       vtkIdType previousPointIndexLine1 = this->GetPreviousLocation(currentPointIdLine1, numberOfPointsInLine1, line1Closed);
 
-      vtkIdType currentTriangle[3] = {0,0,0};
-      currentTriangle[0] = pointsInLine1->GetId(currentPointIdLine1);
-      currentTriangle[1] = pointsInLine2->GetId(currentPointIdLine2);
-      currentTriangle[2] = pointsInLine1->GetId(previousPointIndexLine1);
-
-      outputPolygons->InsertNextCell(3);
-      outputPolygons->InsertCellPoint(currentTriangle[0]);
-      outputPolygons->InsertCellPoint(currentTriangle[1]);
-      outputPolygons->InsertCellPoint(currentTriangle[2]);
+      outputTriangles.push_back(pointsInLine1[currentPointIdLine1]);
+      outputTriangles.push_back(pointsInLine2[currentPointIdLine2]);
+      outputTriangles.push_back(pointsInLine1[previousPointIndexLine1]);
 
       line1PointIndex -= 1;
       currentPointIdLine1 = previousPointIndexLine1;
@@ -563,34 +770,22 @@ vtkIdType vtkPlanarContourToClosedSurfaceConversionRule::GetEndLoop(vtkIdType st
 }
 
 //----------------------------------------------------------------------------
-vtkIdType vtkPlanarContourToClosedSurfaceConversionRule::GetClosestPoint(vtkPolyData* inputROIPoints, double* originalPoint, vtkIdList* linePointIds)
+vtkIdType vtkPlanarContourToClosedSurfaceConversionRule::GetClosestPoint(const ContourSet& contours, const double* originalPoint,
+  const vtkIdType* linePointIds, vtkIdType numberOfPointsInLine)
 {
-  if (!inputROIPoints)
-    {
-    vtkErrorMacro("inputROIPoints: Invalid vtkPolyData!");
-    return 0;
-    }
-
-  if (!linePointIds)
+  if (!linePointIds || numberOfPointsInLine == 0)
     {
-    vtkErrorMacro("GetClosestPoint: Invalid vtkIdList!");
+    vtkErrorMacro("GetClosestPoint: Invalid point ID list!");
     return 0;
     }
 
-  double pointOnLine[3] = {0,0,0}; // point from the given line
-  inputROIPoints->GetPoint(linePointIds->GetId(0), pointOnLine);
-
-  double minimumDistance = vtkMath::Distance2BetweenPoints(originalPoint, pointOnLine); // minimum distance from the point to the line
-  double closestPointIndex = 0;
-
-  int numberOfPoints = linePointIds->GetNumberOfIds();
+  double minimumDistance = vtkMath::Distance2BetweenPoints(originalPoint, contours.GetPoint(linePointIds[0])); // minimum distance from the point to the line
+  vtkIdType closestPointIndex = 0;
 
   // Loop through all of the points in the current line
-  for (int currentPointIndex = 1; currentPointIndex < numberOfPoints; ++currentPointIndex)
+  for (vtkIdType currentPointIndex = 1; currentPointIndex < numberOfPointsInLine; ++currentPointIndex)
     {
-    inputROIPoints->GetPoint(linePointIds->GetId(currentPointIndex), pointOnLine);
-
-    double distanceBetweenPoints = vtkMath::Distance2BetweenPoints(originalPoint, pointOnLine);
+    double distanceBetweenPoints = vtkMath::Distance2BetweenPoints(originalPoint, contours.GetPoint(linePointIds[currentPointIndex]));
     if (distanceBetweenPoints < minimumDistance)
       {
       minimumDistance = distanceBetweenPoints;
@@ -602,289 +797,258 @@ vtkIdType vtkPlanarContourToClosedSurfaceConversionRule::GetClosestPoint(vtkPoly
 }
 
 //----------------------------------------------------------------------------
-void vtkPlanarContourToClosedSurfaceConversionRule::SortContours(vtkPolyData* inputROIPoints)
+void vtkPlanarContourToClosedSurfaceConversionRule::SortContours(ContourSet& contours)
 {
-  if (!inputROIPoints)
-    {
-    vtkErrorMacro("inputROIPoints: Invalid vtkPolyData!");
-    return;
-    }
-  int numberOfLines = inputROIPoints->GetNumberOfLines();
+  vtkIdType numberOfLines = contours.GetNumberOfContours();
 
-  vtkSmartPointer<vtkLine> originalLine;
-  std::vector<std::pair<double, vtkIdType> > lineZIdPairs;
+  std::vector<std::pair<double, vtkIdType> > lineZIdPairs(numberOfLines);
 
   // Loop through all of the lines
   for (vtkIdType currentLineID = 0; currentLineID < numberOfLines; ++currentLineID)
     {
-    vtkSmartPointer<vtkCell> currentLine = inputROIPoints->GetCell(currentLineID);
-
     // Calculate the average Z value of the line based on the bounds
-    double averageZ = (currentLine->GetBounds()[4] + currentLine->GetBounds()[5])/2.0;
+    const double* bounds = contours.GetContourBounds(currentLineID);
+    double averageZ = (bounds[4] + bounds[5])/2.0;
 
     // Add the pair as: (average Z :: line id)
-    lineZIdPairs.push_back(std::make_pair(averageZ, currentLineID));
+    lineZIdPairs[currentLineID] = std::make_pair(averageZ, currentLineID);
     }
   std::sort(lineZIdPairs.begin(), lineZIdPairs.end());
 
-  vtkSmartPointer<vtkCellArray> outputLines = vtkSmartPointer<vtkCellArray>::New();
-  outputLines->Initialize();
-  inputROIPoints->DeleteCells();
-
-  // Loop through all of the lines
+  // Rebuild the contours in the sorted order
+  ContourSet sortedContours;
+  sortedContours.PointIds.reserve(contours.PointIds.size());
+  sortedContours.ContourOffsets.reserve(numberOfLines+1);
+  sortedContours.ContourBounds.reserve(6*numberOfLines);
+  sortedContours.Points.swap(contours.Points);
   for (vtkIdType currentLineID = 0; currentLineID < numberOfLines; ++currentLineID)
     {
-    outputLines->InsertNextCell(inputROIPoints->GetCell(lineZIdPairs[currentLineID].second));
+    vtkIdType lineID = lineZIdPairs[currentLineID].second;
+    sortedContours.AddContour(contours.GetContourPointIds(lineID), contours.GetNumberOfPointsInContour(lineID));
     }
-  inputROIPoints->SetLines(outputLines);
-  inputROIPoints->BuildCells();
+  contours.Swap(sortedContours);
 }
 
 //----------------------------------------------------------------------------
-void vtkPlanarContourToClosedSurfaceConversionRule::FixKeyholes(vtkPolyData* inputROIPoints, double epsilon, int minimumSeperation)
+void vtkPlanarContourToClosedSurfaceConversionRule::FixKeyholes(ContourSet& contours, double epsilon, int minimumSeperation)
 {
-  if (!inputROIPoints)
-    {
-    vtkErrorMacro("inputROIPoints: Invalid vtkPolyData!");
-    return;
-    }
-
-  vtkSmartPointer<vtkLine> originalLine;
-  std::vector<vtkSmartPointer<vtkLine> > newLines;
-  int pointsOfSeperation;
-
-  int numberOfLines = inputROIPoints->GetNumberOfLines();
+  vtkIdType numberOfLines = contours.GetNumberOfContours();
+  double epsilonSquared = epsilon*epsilon;
+
+  // The lines are rebuilt into a new contour set. Points are shared.
+  ContourSet fixedContours;
+  fixedContours.PointIds.reserve(contours.PointIds.size());
+  fixedContours.Points.swap(contours.Points);
+
+  // Work arrays are reused for all lines to avoid allocations
+  std::vector< vtkIdType > flags;
+  std::vector< std::pair<double, vtkIdType> > pointsSortedByX;
+  std::vector< vtkIdType > sortedIndicesOfPoints;
+  std::vector< vtkIdType > pointsWithinRadius;
+  std::vector< std::vector< vtkIdType > > newLinesPointIds;
+  std::vector< size_t > rawLineIndices;
 
   // Loop through all of the lines
   for (vtkIdType currentLineId = 0; currentLineId < numberOfLines; ++currentLineId)
     {
-    originalLine = vtkSmartPointer<vtkLine>::New();
-    originalLine->DeepCopy(inputROIPoints->GetCell(currentLineId));
-
-    vtkSmartPointer<vtkPoints> originalLinePoints = originalLine->GetPoints();
-    int numberOfPointsInLine = originalLine->GetNumberOfPoints();
-
-    vtkSmartPointer<vtkPolyData> linePolyData = vtkSmartPointer<vtkPolyData>::New();
-    linePolyData->SetPoints(originalLinePoints);
+    const vtkIdType* originalLinePointIds = contours.GetContourPointIds(currentLineId);
+    vtkIdType numberOfPointsInLine = contours.GetNumberOfPointsInContour(currentLineId);
 
-    vtkSmartPointer<vtkPointLocator> pointLocator = vtkSmartPointer<vtkPointLocator>::New();
-    pointLocator->SetDataSet(linePolyData);
-    pointLocator->BuildLocator();
+    // Sort the points of the line by their X coordinate, so that the points within the radius of a point
+    // can be found by only checking the points in the window of +/- epsilon in X
+    pointsSortedByX.resize(numberOfPointsInLine);
+    for (vtkIdType pointIndex = 0; pointIndex < numberOfPointsInLine; ++pointIndex)
+      {
+      pointsSortedByX[pointIndex] = std::make_pair(fixedContours.GetPoint(originalLinePointIds[pointIndex])[0], pointIndex);
+      }
+    std::sort(pointsSortedByX.begin(), pointsSortedByX.end());
+    sortedIndicesOfPoints.resize(numberOfPointsInLine);
+    for (vtkIdType sortedPointIndex = 0; sortedPointIndex < numberOfPointsInLine; ++sortedPointIndex)
+      {
+      sortedIndicesOfPoints[pointsSortedByX[sortedPointIndex].second] = sortedPointIndex;
+      }
 
     bool keyHoleExists = false;
 
     // If the value of flags[i] is -1, the point is not part of a keyhole
     // If the value of flags[i] is >= 0, it represents a point that is
     // close enough that it could be considered part of a keyhole.
-    std::vector< int > flags(numberOfPointsInLine);
+    flags.assign(numberOfPointsInLine, -1);
 
-    // Loop through and initialize the list of flags to -1.
-    for (int i=0; i<numberOfPointsInLine; ++i)
+    // The points are visited in index order, as the flags are overwritten by later points.
+    // The sorted points are only used to find the window of the neighbors of a point.
+    for (vtkIdType point1Id = 0; point1Id < numberOfPointsInLine; ++point1Id)
       {
-      flags[i] = -1;
-      }
-
-    for (int point1Id = 0; point1Id < numberOfPointsInLine; ++point1Id)
-      {
-      double point1[3] = {0,0,0};
-      originalLinePoints->GetPoint(point1Id, point1);
+      vtkIdType sortedPoint1Index = sortedIndicesOfPoints[point1Id];
+      const double* point1 = fixedContours.GetPoint(originalLinePointIds[point1Id]);
 
-      vtkSmartPointer<vtkIdList> pointsWithinRadius = vtkSmartPointer<vtkIdList>::New();
-      pointsWithinRadius->Initialize();
-      pointLocator->FindPointsWithinRadius(epsilon, point1, pointsWithinRadius);
+      // Collect the points within the radius, including the point itself
+      pointsWithinRadius.clear();
+      for (vtkIdType sortedPoint2Index = sortedPoint1Index; sortedPoint2Index >= 0 && point1[0] - pointsSortedByX[sortedPoint2Index].first <= epsilon; --sortedPoint2Index)
+        {
+        vtkIdType point2Id = pointsSortedByX[sortedPoint2Index].second;
+        if (vtkMath::Distance2BetweenPoints(point1, fixedContours.GetPoint(originalLinePointIds[point2Id])) <= epsilonSquared)
+          {
+          pointsWithinRadius.push_back(point2Id);
+          }
+        }
+      for (vtkIdType sortedPoint2Index = sortedPoint1Index+1; sortedPoint2Index < numberOfPointsInLine && pointsSortedByX[sortedPoint2Index].first - point1[0] <= epsilon; ++sortedPoint2Index)
+        {
+        vtkIdType point2Id = pointsSortedByX[sortedPoint2Index].second;
+        if (vtkMath::Distance2BetweenPoints(point1, fixedContours.GetPoint(originalLinePointIds[point2Id])) <= epsilonSquared)
+          {
+          pointsWithinRadius.push_back(point2Id);
+          }
+        }
+      // Process the neighbors in index order so that the result does not depend on the sorting
+      std::sort(pointsWithinRadius.begin(), pointsWithinRadius.end());
 
-      for (vtkIdType currentPointIndex = 0; currentPointIndex < pointsWithinRadius->GetNumberOfIds(); ++currentPointIndex)
+      for (size_t currentPointIndex = 0; currentPointIndex < pointsWithinRadius.size(); ++currentPointIndex)
         {
-        int point2Id = pointsWithinRadius->GetId(currentPointIndex);
+        vtkIdType point2Id = pointsWithinRadius[currentPointIndex];
 
         // Make sure the points are not too close together on the line index-wise
-        pointsOfSeperation = std::min( point2Id - point1Id,  numberOfPointsInLine - 1 - point2Id + point1Id );
+        vtkIdType pointsOfSeperation = std::min( point2Id - point1Id,  numberOfPointsInLine - 1 - point2Id + point1Id );
         if (pointsOfSeperation > minimumSeperation)
           {
           keyHoleExists = true;
           flags[point1Id] = point2Id;
           flags[point2Id] = point1Id;
           }
-
         }
       }
 
     if (!keyHoleExists)
       {
-      newLines.push_back(originalLine);
-      }
-    else
-      {
-      int currentLayer = 0;
-      bool pointInChannel = false;
-
-      std::vector<vtkSmartPointer<vtkIdList> > rawLinePointIds;
-      std::vector<vtkSmartPointer<vtkIdList> > finishedLinePointIds;
-
-      // Loop through all of the points in the line
-      for (int currentPointIndex = 0; currentPointIndex < numberOfPointsInLine; ++currentPointIndex)
+      if (numberOfPointsInLine > 1)
         {
+        fixedContours.AddContour(originalLinePointIds, numberOfPointsInLine);
+        }
+      continue;
+      }
 
-        // Add a new line if necessary
-        if (currentLayer == rawLinePointIds.size())
-          {
-          vtkSmartPointer<vtkLine> newLine = vtkSmartPointer<vtkLine>::New();
-          newLine->GetPoints()->SetData(originalLinePoints->GetData());
+    // Point IDs of the lines the current line is split into, in the order of creation
+    newLinesPointIds.clear();
+    // Indices of the lines in newLinesPointIds that are still being built
+    rawLineIndices.clear();
 
-          vtkSmartPointer<vtkIdList> newLineIds = newLine->GetPointIds();
-          newLineIds->Initialize();
+    size_t currentLayer = 0;
+    bool pointInChannel = false;
 
-          newLines.push_back(newLine);
-          rawLinePointIds.push_back(newLineIds);
-          }
+    // Loop through all of the points in the line
+    for (vtkIdType currentPointIndex = 0; currentPointIndex < numberOfPointsInLine; ++currentPointIndex)
+      {
+      // Add a new line if necessary
+      if (currentLayer == rawLineIndices.size())
+        {
+        newLinesPointIds.push_back(std::vector<vtkIdType>());
+        rawLineIndices.push_back(newLinesPointIds.size()-1);
+        }
 
-        int currentPointId = originalLine->GetPointId(currentPointIndex);
+      vtkIdType currentPointId = originalLinePointIds[currentPointIndex];
 
-        // If the current point is not part of a keyhole, add it to the current line
-        if (flags[currentPointIndex] == -1)
-          {
-          rawLinePointIds[currentLayer]->InsertNextId(currentPointId);
-          pointInChannel = false;
-          }
-        else
+      // If the current point is not part of a keyhole, add it to the current line
+      if (flags[currentPointIndex] == -1)
+        {
+        newLinesPointIds[rawLineIndices[currentLayer]].push_back(currentPointId);
+        pointInChannel = false;
+        }
+      else
+        {
+        // If the current point is the start of a keyhole add the point to the line,
+        // increment the layer, and start the channel.
+        if (flags[currentPointIndex] > currentPointIndex && !pointInChannel)
           {
-          // If the current point is the start of a keyhole add the point to the line,
-          // increment the layer, and start the channel.
-          if (flags[currentPointIndex] > currentPointIndex && !pointInChannel)
-            {
-            rawLinePointIds[currentLayer]->InsertNextId(currentPointId);
-            ++currentLayer;
-            pointInChannel = true;
-
-            }
-          // If the current point is the end of a volume in the keyhole, add the point
-          // to the line, remove the current line from the working list, deincrement
-          // the layer, add the current line to the finished lines and start the,
-          // channel.
-          else if (flags[currentPointIndex] < currentPointIndex && !pointInChannel)
+          newLinesPointIds[rawLineIndices[currentLayer]].push_back(currentPointId);
+          ++currentLayer;
+          pointInChannel = true;
+          }
+        // If the current point is the end of a volume in the keyhole, add the point
+        // to the line, remove the current line from the working list, deincrement
+        // the layer, and start the channel.
+        else if (flags[currentPointIndex] < currentPointIndex && !pointInChannel)
+          {
+          newLinesPointIds[rawLineIndices[currentLayer]].push_back(currentPointId);
+          rawLineIndices.pop_back();
+          if (currentLayer > 0)
             {
-            rawLinePointIds[currentLayer]->InsertNextId(currentPointId);
-            finishedLinePointIds.push_back(rawLinePointIds[currentLayer]);
-            rawLinePointIds.pop_back();
-            if (currentLayer > 0)
-              {
-              --currentLayer;
-              }
-            pointInChannel = true;
+            --currentLayer;
             }
+          pointInChannel = true;
           }
         }
+      }
 
-      // Add the remaining line to the finished list.
-      for (int remainingLineId=0; remainingLineId < rawLinePointIds.size(); ++remainingLineId)
+    // Make sure that the completed lines are closed, and add the ones that have more than one point
+    for (size_t newLineIndex = 0; newLineIndex < newLinesPointIds.size(); ++newLineIndex)
+      {
+      std::vector<vtkIdType>& newLinePointIds = newLinesPointIds[newLineIndex];
+      if (!newLinePointIds.empty() && newLinePointIds.front() != newLinePointIds.back())
         {
-        finishedLinePointIds.push_back(rawLinePointIds[remainingLineId]);
+        newLinePointIds.push_back(newLinePointIds.front());
         }
-
-      // Loop through the completed lines and make sure that they are closed
-      for (int finishedLineId = 0; finishedLineId < finishedLinePointIds.size(); ++finishedLineId)
+      if (newLinePointIds.size() > 1)
         {
-        if ( finishedLinePointIds[finishedLineId]->GetNumberOfIds() > 0
-          && finishedLinePointIds[finishedLineId]->GetId(0) != finishedLinePointIds[finishedLineId]->GetId(finishedLinePointIds[finishedLineId]->GetNumberOfIds()-1) )
-          {
-          finishedLinePointIds[finishedLineId]->InsertNextId(finishedLinePointIds[finishedLineId]->GetId(0));
-          }
+        fixedContours.AddContour(&newLinePointIds[0], (vtkIdType)newLinePointIds.size());
         }
-
       }
     }
 
-  vtkSmartPointer<vtkCellArray> outputLines = vtkSmartPointer<vtkCellArray>::New();
-  outputLines->Initialize();
-  inputROIPoints->DeleteCells();
-  for (int currentLineIndex = 0; currentLineIndex < newLines.size(); ++currentLineIndex)
+  contours.Swap(fixedContours);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlanarContourToClosedSurfaceConversionRule::SetLinesCounterClockwise(ContourSet& contours)
+{
+  vtkIdType numberOfLines = contours.GetNumberOfContours();
+  for (vtkIdType currentLineId = 0; currentLineId < numberOfLines; ++currentLineId)
     {
-    // Only add the lines if they have more than 2 points
-    if (newLines[currentLineIndex]->GetNumberOfPoints() > 1)
+    if (this->IsLineClockwise(contours, contours.GetContourPointIds(currentLineId), contours.GetNumberOfPointsInContour(currentLineId)))
       {
-      outputLines->InsertNextCell(newLines[currentLineIndex]);
+      // Reverse the line in place
+      std::reverse(contours.PointIds.begin() + contours.ContourOffsets[currentLineId], contours.PointIds.begin() + contours.ContourOffsets[currentLineId+1]);
       }
     }
-  inputROIPoints->SetLines(outputLines);
-  inputROIPoints->BuildCells();
 }
 
 //----------------------------------------------------------------------------
-void vtkPlanarContourToClosedSurfaceConversionRule::SetLinesCounterClockwise(vtkPolyData* inputROIPoints)
+bool vtkPlanarContourToClosedSurfaceConversionRule::IsLineClockwise(const ContourSet& contours, const vtkIdType* linePointIds, vtkIdType numberOfPointsInLine)
 {
-  if (!inputROIPoints)
-    {
-    vtkErrorMacro("inputROIPoints: Invalid vtkPolyData!");
-    return;
-    }
-
-  int numberOfLines = inputROIPoints->GetNumberOfLines();
-
-  std::vector<vtkSmartPointer<vtkLine> > newLines;
+  // Calculate twice the area of the line.
+  double areaSum = 0;
 
-  for(int currentLineId=0 ; currentLineId < numberOfLines; ++currentLineId)
+  for (vtkIdType currentPointId = 0; currentPointId < numberOfPointsInLine-1; ++currentPointId)
     {
-    vtkSmartPointer<vtkLine> currentLine = vtkSmartPointer<vtkLine>::New();
-    currentLine->DeepCopy(inputROIPoints->GetCell(currentLineId));
-
-    vtkSmartPointer<vtkPoints> currentPoints = currentLine->GetPoints();
-
-    if (IsLineClockwise(inputROIPoints, currentLine))
-      {
-      vtkSmartPointer<vtkLine> newLine = vtkSmartPointer<vtkLine>::New();
-      vtkSmartPointer<vtkIdList> newLineIds = newLine->GetPointIds();
-      newLineIds->Initialize();
-
-      this->ReverseLine(currentLine, newLine);
-      newLines.push_back(newLine);
-
-      }
-    else
-      {
-      newLines.push_back(currentLine);
-      }
-    }
+    const double* point1 = contours.GetPoint(linePointIds[currentPointId]);
+    const double* point2 = contours.GetPoint(linePointIds[currentPointId + 1]);
 
-  // Replace the lines in the input data with the modified lines.
-  vtkSmartPointer<vtkCellArray> outputLines = vtkSmartPointer<vtkCellArray>::New();
-  outputLines->Initialize();
-  inputROIPoints->DeleteCells();
-  for (int currentLineIndex = 0; currentLineIndex < newLines.size(); ++currentLineIndex)
-    {
-    outputLines->InsertNextCell(newLines[currentLineIndex]);
+    areaSum += (point2[0] - point1[0]) * (point2[1] + point1[1]);
     }
-  inputROIPoints->SetLines(outputLines);
-  inputROIPoints->BuildCells();
 
+  // If the area is positive, the contour is clockwise,
+  // If it is negative, the contour is counter-clockwise.
+  return areaSum > 0;
 }
 
 //----------------------------------------------------------------------------
-bool vtkPlanarContourToClosedSurfaceConversionRule::IsLineClockwise(vtkPolyData* inputROIPoints, vtkLine* line)
+bool vtkPlanarContourToClosedSurfaceConversionRule::IsLineClockwise(vtkPoints* points, const vtkIdType* linePointIds, vtkIdType numberOfPointsInLine)
 {
-  if (!inputROIPoints)
-    {
-    vtkErrorMacro("IsLineClockwise: Invalid vtkPolyData!");
-    return false;
-    }
-
-  if (!line)
+  if (!points)
     {
-    vtkErrorMacro("IsLineClockwise: Invalid vtkLine!");
+    vtkErrorMacro("IsLineClockwise: Invalid vtkPoints!");
     return false;
     }
 
-  int numberOfPoints = line->GetNumberOfPoints();
-
   // Calculate twice the area of the line.
   double areaSum = 0;
 
-  for (int currentPointId=0; currentPointId < numberOfPoints-1; ++currentPointId)
+  for (vtkIdType currentPointId = 0; currentPointId < numberOfPointsInLine-1; ++currentPointId)
     {
     double point1[3];
-    inputROIPoints->GetPoint(line->GetPointId(currentPointId), point1);
+    points->GetPoint(linePointIds[currentPointId], point1);
 
     double point2[3];
-    inputROIPoints->GetPoint(line->GetPointId(currentPointId + 1), point2);
+    points->GetPoint(linePointIds[currentPointId + 1], point2);
 
     areaSum += (point2[0] - point1[0]) * (point2[1] + point1[1]);
     }
@@ -895,110 +1059,141 @@ bool vtkPlanarContourToClosedSurfaceConversionRule::IsLineClockwise(vtkPolyData*
 }
 
 //----------------------------------------------------------------------------
-void vtkPlanarContourToClosedSurfaceConversionRule::ReverseLine(vtkLine* originalLine, vtkLine* newLine)
+void vtkPlanarContourToClosedSurfaceConversionRule::ComputeContourPlanes(ContourSet& contours, double spacing)
 {
-  if (!originalLine)
-    {
-    vtkErrorMacro("ReverseLine: Invalid vtkLine!");
-    return;
-    }
+  contours.PlaneOffsets.clear();
 
-  if (!newLine)
-    {
-    vtkErrorMacro("ReverseLine: Invalid vtkLine!");
-    return;
-    }
-
-  int numberOfPoints = originalLine->GetNumberOfPoints();
-
-  vtkSmartPointer<vtkIdList> newPoints = newLine->GetPointIds();
+  vtkIdType numberOfLines = contours.GetNumberOfContours();
+  double contourPlaneThreshold = 0.1*spacing;
 
-  // Loop through the points in the original line in reverse
-  for (int currentPointIndex = numberOfPoints-1; currentPointIndex >= 0; currentPointIndex--)
+  vtkIdType currentLineId = 0;
+  while (currentLineId < numberOfLines)
     {
-    vtkIdType currentPointId = originalLine->GetPointId(currentPointIndex);
-    newPoints->InsertNextId(currentPointId);
+    // Start a new plane with the current line
+    contours.PlaneOffsets.push_back(currentLineId);
+    const double* planeBounds = contours.GetContourBounds(currentLineId);
+    double lineZ = (planeBounds[4] + planeBounds[5])/2.0; // z-value
+    ++currentLineId;
+
+    // Add the following lines to the plane while they are close enough in z
+    while (currentLineId < numberOfLines)
+      {
+      const double* currentLineBounds = contours.GetContourBounds(currentLineId);
+      double currentLineZDifference = std::abs(0.5*(currentLineBounds[4] + currentLineBounds[5]) - lineZ);
+      if (currentLineZDifference >= contourPlaneThreshold)
+        {
+        break;
+        }
+      ++currentLineId;
+      }
     }
+  contours.PlaneOffsets.push_back(numberOfLines);
 }
 
 //----------------------------------------------------------------------------
-int vtkPlanarContourToClosedSurfaceConversionRule::GetNumberOfLinesOnPlane(vtkPolyData* inputROIPoints, vtkIdType originalLineIndex, double spacing)
+bool vtkPlanarContourToClosedSurfaceConversionRule::DoLinesOverlap(const double* bounds1, const double* bounds2)
 {
-  if (!inputROIPoints)
-    {
-    vtkErrorMacro("GetNumberOfLinesOnPlane: Invalid vtkPolyData!");
-    return 0;
-    }
-
-  int numberOfLines = inputROIPoints->GetNumberOfLines();
+  return bounds1[0] < bounds2[1] &&
+         bounds1[1] > bounds2[0] &&
+         bounds1[2] < bounds2[3] &&
+         bounds1[3] > bounds2[2];
+}
 
-  double contourPlaneThreshold = 0.1*spacing;
-  double lineZ = (inputROIPoints->GetCell(originalLineIndex)->GetBounds()[4] + inputROIPoints->GetCell(originalLineIndex)->GetBounds()[5])/2.0; // z-value
-  vtkIdType currentLineId = originalLineIndex+1;
+//----------------------------------------------------------------------------
+void vtkPlanarContourToClosedSurfaceConversionRule::FindOverlappingLines(const ContourSet& contours, int plane1Index, int plane2Index,
+  std::vector<std::pair<vtkIdType, vtkIdType> >& overlappingLinePairs)
+{
+  overlappingLinePairs.clear();
 
-  while (currentLineId < numberOfLines)
+  // Sort the lines of both planes by the minimum X of their bounds. The plane of each line is stored with the line index.
+  std::vector<std::pair<double, std::pair<int, vtkIdType> > > sortedLines;
+  int planeIndices[2] = { plane1Index, plane2Index };
+  for (int plane = 0; plane < 2; ++plane)
     {
-    double currentLineZDifference = std::abs(0.5*(inputROIPoints->GetCell(currentLineId)->GetBounds()[4] + inputROIPoints->GetCell(currentLineId)->GetBounds()[5]) - lineZ);
-    if (currentLineZDifference < contourPlaneThreshold)
+    for (vtkIdType lineIndex = contours.PlaneOffsets[planeIndices[plane]]; lineIndex < contours.PlaneOffsets[planeIndices[plane]+1]; ++lineIndex)
       {
-      currentLineId++;
+      sortedLines.push_back(std::make_pair(contours.GetContourBounds(lineIndex)[0], std::make_pair(plane, lineIndex)));
       }
-    else
+    }
+  std::sort(sortedLines.begin(), sortedLines.end());
+
+  // Sweep along the X axis. When a line starts, it is compared to the active lines of the other plane,
+  // and the lines that ended before the start are removed from the active lists.
+  std::vector<vtkIdType> activeLines[2];
+  for (size_t sortedLineIndex = 0; sortedLineIndex < sortedLines.size(); ++sortedLineIndex)
+    {
+    double lineStartX = sortedLines[sortedLineIndex].first;
+    int plane = sortedLines[sortedLineIndex].second.first;
+    vtkIdType lineIndex = sortedLines[sortedLineIndex].second.second;
+    const double* lineBounds = contours.GetContourBounds(lineIndex);
+
+    std::vector<vtkIdType>& otherActiveLines = activeLines[1-plane];
+    size_t numberOfRemainingLines = 0;
+    for (size_t activeLineIndex = 0; activeLineIndex < otherActiveLines.size(); ++activeLineIndex)
       {
-      break;
+      vtkIdType otherLineIndex = otherActiveLines[activeLineIndex];
+      const double* otherLineBounds = contours.GetContourBounds(otherLineIndex);
+      if (otherLineBounds[1] <= lineStartX)
+        {
+        // The other line ends before the current line, so it cannot overlap with any of the following lines
+        continue;
+        }
+      otherActiveLines[numberOfRemainingLines++] = otherLineIndex;
+
+      bool overlap = (plane == 0 ? this->DoLinesOverlap(lineBounds, otherLineBounds) : this->DoLinesOverlap(otherLineBounds, lineBounds));
+      if (overlap)
+        {
+        overlappingLinePairs.push_back(plane == 0 ? std::make_pair(lineIndex, otherLineIndex) : std::make_pair(otherLineIndex, lineIndex));
+        }
       }
+    otherActiveLines.resize(numberOfRemainingLines);
+    activeLines[plane].push_back(lineIndex);
     }
-  return currentLineId-originalLineIndex;
+
+  std::sort(overlappingLinePairs.begin(), overlappingLinePairs.end());
 }
 
 //----------------------------------------------------------------------------
-bool vtkPlanarContourToClosedSurfaceConversionRule::DoLinesOverlap(vtkLine* line1, vtkLine* line2)
+void vtkPlanarContourToClosedSurfaceConversionRule::GetClosestBranches(const ContourSet& contours, vtkIdType branchingLineIndex,
+  const ContourPointTree& branchPointTree, const std::vector<vtkIdType>& overlappingLineIds, std::vector<vtkIdType>& closestBranchIds)
 {
-  if (!line1)
-    {
-    vtkErrorMacro("DoLinesOverlap: Invalid vtkLine!");
-    return false;
-    }
+  closestBranchIds.clear();
 
-  if (!line2)
+  // No need to check if there is only one overlapping line.
+  if (overlappingLineIds.size() <= 1)
     {
-    vtkErrorMacro("DoLinesOverlap: Invalid vtkLine!");
-    return false;
+    return;
     }
 
-  double bounds1[6];
-  line1->GetBounds(bounds1);
-
-  double bounds2[6];
-  line2->GetBounds(bounds2);
-
-  return bounds1[0] < bounds2[1] &&
-         bounds1[1] > bounds2[0] &&
-         bounds1[2] < bounds2[3] &&
-         bounds1[3] > bounds2[2];
-}
-// TODO: It may be possible to speed up this function by only calling the branch function once. -- need to look into this
-//----------------------------------------------------------------------------
-void vtkPlanarContourToClosedSurfaceConversionRule::Branch(vtkPolyData* inputROIPoints, vtkLine* branchingLine, vtkIdType currentLineId, std::vector< vtkIdType > overlappingLineIds, std::vector<vtkSmartPointer<vtkPointLocator> > pointLocators, std::vector<vtkSmartPointer<vtkIdList> > lineIdLists, vtkLine* outputLine)
-{
-  if (!inputROIPoints)
+  // Only consider the overlapping lines in the tree
+  std::vector<char> branchMask(branchPointTree.NumberOfContours, 0);
+  for (size_t overlapIndex = 0; overlapIndex < overlappingLineIds.size(); ++overlapIndex)
     {
-    vtkErrorMacro("Branch: Invalid vtkPolyData!");
-    return;
+    branchMask[overlappingLineIds[overlapIndex] - branchPointTree.FirstContourIndex] = 1;
     }
 
-  if (!branchingLine)
+  const vtkIdType* branchingLinePointIds = contours.GetContourPointIds(branchingLineIndex);
+  vtkIdType numberOfPointsInBranchingLine = contours.GetNumberOfPointsInContour(branchingLineIndex);
+  closestBranchIds.resize(numberOfPointsInBranchingLine);
+  for (vtkIdType pointIndex = 0; pointIndex < numberOfPointsInBranchingLine; ++pointIndex)
     {
-    vtkErrorMacro("Branch: Invalid vtkLine!");
-    return;
+    closestBranchIds[pointIndex] = branchPointTree.FindClosestContour(contours, contours.GetPoint(branchingLinePointIds[pointIndex]), branchMask);
     }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlanarContourToClosedSurfaceConversionRule::Branch(const ContourSet& contours, vtkIdType branchingLineIndex, vtkIdType currentLineId,
+  const std::vector<vtkIdType>& closestBranchIds, std::vector<vtkIdType>& outputLinePointIds)
+{
+  outputLinePointIds.clear();
 
-  vtkSmartPointer<vtkIdList> outputLinePointIds = outputLine->GetPointIds();
-  outputLinePointIds->Initialize();
+  const vtkIdType* branchingLinePointIds = contours.GetContourPointIds(branchingLineIndex);
+  vtkIdType numberOfPointsInBranchingLine = contours.GetNumberOfPointsInContour(branchingLineIndex);
 
-  if (overlappingLineIds.size() == 1)
+  // If there is only one overlapping line, then the whole line belongs to it
+  if (closestBranchIds.empty())
     {
-    outputLinePointIds->DeepCopy(branchingLine->GetPointIds());
+    outputLinePointIds.assign(branchingLinePointIds, branchingLinePointIds + numberOfPointsInBranchingLine);
     return;
     }
 
@@ -1006,17 +1201,14 @@ void vtkPlanarContourToClosedSurfaceConversionRule::Branch(vtkPolyData* inputROI
   bool prev = false;
 
   // Loop through all of the points in the current line
-  for (int currentPointIndex = 0; currentPointIndex < branchingLine->GetNumberOfPoints(); ++currentPointIndex)
+  for (vtkIdType currentPointIndex = 0; currentPointIndex < numberOfPointsInBranchingLine; ++currentPointIndex)
     {
-    vtkIdType currentPointId = branchingLine->GetPointId(currentPointIndex);
-
-    double currentPoint[3] = {0,0,0};
-    inputROIPoints->GetPoint(currentPointId, currentPoint);
+    vtkIdType currentPointId = branchingLinePointIds[currentPointIndex];
 
     // See if the point's closest branch is the input branch.
-    if (this->GetClosestBranch(inputROIPoints, currentPoint, overlappingLineIds, pointLocators, lineIdLists) == currentLineId)
+    if (closestBranchIds[currentPointIndex] == currentLineId)
       {
-      outputLinePointIds->InsertNextId(currentPointId);
+      outputLinePointIds.push_back(currentPointId);
       prev = true;
       }
     else
@@ -1024,196 +1216,108 @@ void vtkPlanarContourToClosedSurfaceConversionRule::Branch(vtkPolyData* inputROI
       if (prev)
         {
         // Add one extra point to close up the surface.
-        outputLinePointIds->InsertNextId(currentPointId);
+        outputLinePointIds.push_back(currentPointId);
         }
       prev = false;
       }
     }
-  int dividedNumberOfPoints = outputLine->GetNumberOfPoints();
-  if (dividedNumberOfPoints > 1)
+  if (outputLinePointIds.size() > 1)
     {
     // Determine if the trunk was originally a closed contour.
-    bool lineIsClosed = (branchingLine->GetPointId(0) == branchingLine->GetPointId(branchingLine->GetNumberOfPoints() - 1) );
+    bool lineIsClosed = (branchingLinePointIds[0] == branchingLinePointIds[numberOfPointsInBranchingLine - 1]);
 
-    if (lineIsClosed && (outputLinePointIds->GetId(0) != outputLinePointIds->GetId(dividedNumberOfPoints-1) ))
+    if (lineIsClosed && (outputLinePointIds.front() != outputLinePointIds.back()))
       {
       // Make the new one a closed contour as well.
-      outputLinePointIds->InsertNextId(outputLinePointIds->GetId(0) );
-      }
-    }
-}
-
-//----------------------------------------------------------------------------
-int vtkPlanarContourToClosedSurfaceConversionRule::GetClosestBranch(vtkPolyData* inputROIPoints, double* originalPoint, std::vector< vtkIdType > overlappingLineIds,  std::vector<vtkSmartPointer<vtkPointLocator> > pointLocators, std::vector<vtkSmartPointer<vtkIdList> > lineIdLists)
-{
-  if (!inputROIPoints)
-    {
-    vtkErrorMacro("GetClosestBranch: Invalid vtkPolyData!");
-    }
-
-  // No need to check if there is only one overlapping line.
-  if (overlappingLineIds.size() == 1)
-    {
-    return overlappingLineIds[0];
-    }
-
-  double minimumDistanceSquared = VTK_DOUBLE_MAX;
-  vtkIdType closestLineId = overlappingLineIds[0];
-
-  // Loop through all of the lines that overlap with the line the original point is on
-  for (int currentOverlapIndex = 0; currentOverlapIndex < overlappingLineIds.size(); ++currentOverlapIndex)
-    {
-
-    vtkIdType closestPointId = pointLocators[currentOverlapIndex]->FindClosestPoint(originalPoint);
-
-    double currentPoint[3] = {0,0,0};
-    inputROIPoints->GetPoint(lineIdLists[currentOverlapIndex]->GetId(closestPointId), currentPoint);
-
-    double currentDistanceToLineSquared = vtkMath::Distance2BetweenPoints(currentPoint, originalPoint);
-
-    if (currentDistanceToLineSquared < minimumDistanceSquared)
-      {
-      minimumDistanceSquared = currentDistanceToLineSquared;
-      closestLineId = overlappingLineIds[currentOverlapIndex];
+      outputLinePointIds.push_back(outputLinePointIds.front());
       }
-
     }
-
-  return closestLineId;
 }
 
 //----------------------------------------------------------------------------
-void vtkPlanarContourToClosedSurfaceConversionRule::EndCapping(vtkPolyData* inputROIPoints, vtkCellArray* outputPolygons, std::vector< bool > lineTriganulatedToAbove, std::vector< bool > lineTriganulatedToBelow)
+void vtkPlanarContourToClosedSurfaceConversionRule::EndCapping(ContourSet& contours, double lineSpacing,
+  const std::vector<char>& lineTriangulatedToAbove, const std::vector<char>& lineTriangulatedToBelow, std::vector<vtkIdType>& outputTriangles)
 {
-  if (!inputROIPoints)
-    {
-    vtkErrorMacro("EndCapping: Invalid input ROI points!");
-    return;
-    }
+  // End cap contours are appended to the contours, only the original ones are capped
+  vtkIdType numberOfLines = contours.GetNumberOfContours();
 
-  if (!outputPolygons)
-    {
-    vtkErrorMacro("EndCapping: Invalid output poly data!");
-    return;
-    }
-  int numberOfLines = inputROIPoints->GetNumberOfLines();
-
-  double lineSpacing = this->GetSpacingBetweenLines(inputROIPoints);
+  std::vector<std::vector<vtkIdType> > externalLinesPointIds;
+  std::vector<vtkIdType> overlapLineIds;
+  std::vector<vtkIdType> closestBranchIds;
+  std::vector<vtkIdType> dividedLinePointIds;
+  ContourPointTree externalLinesPointTree;
 
-  // Loop through all of the lines in the polydata
-  for (int currentLineIndex = 0; currentLineIndex < numberOfLines; ++currentLineIndex)
+  // Loop through all of the lines
+  for (vtkIdType currentLineIndex = 0; currentLineIndex < numberOfLines; ++currentLineIndex)
     {
-    vtkSmartPointer<vtkLine> currentLine = vtkSmartPointer<vtkLine>::New();
-    currentLine->DeepCopy(inputROIPoints->GetCell(currentLineIndex));
-
-    // If the current was not connected by a polygon to a contour above it, then it needs to be capped
-    if (!lineTriganulatedToAbove[currentLineIndex])
+    for (int capDirection = 0; capDirection < 2; ++capDirection)
       {
-      // Create a new contour that is a half-slice thickness above the line
-      vtkSmartPointer<vtkCellArray> externalLines = vtkSmartPointer<vtkCellArray>::New();
-      this->CreateEndCapContour(inputROIPoints, currentLine, externalLines, lineSpacing);
-
-      std::vector<vtkIdType> overlapLineIds;
-      std::vector<vtkSmartPointer<vtkPointLocator> > pointLocators;
-      std::vector<vtkSmartPointer<vtkIdList> >  idLists;
-
-      // Loop through all of the external lines that were created
-      for (int currentLineId = 0; currentLineId < externalLines->GetNumberOfCells(); ++currentLineId)
+      // If the current was not connected by a polygon to a contour above (below) it, then it needs to be capped
+      bool capAbove = (capDirection == 0);
+      if ((capAbove && lineTriangulatedToAbove[currentLineIndex]) || (!capAbove && lineTriangulatedToBelow[currentLineIndex]))
         {
-        overlapLineIds.push_back(currentLineId);
-
-        vtkSmartPointer<vtkIdList> lineIdList = vtkSmartPointer<vtkIdList>::New();
-        externalLines->GetNextCell(lineIdList);
-        idLists.push_back(lineIdList);
-
-        vtkIdType newLineId = inputROIPoints->InsertNextCell(VTK_LINE, lineIdList);
-        inputROIPoints->BuildCells();
-
-        vtkSmartPointer<vtkLine> newLine = vtkSmartPointer<vtkLine>::New();
-        newLine->DeepCopy(inputROIPoints->GetCell(newLineId));
-
-        this->TriangulateLine(newLine, outputPolygons, true);
-
-        vtkSmartPointer<vtkPolyData> linePolyData = vtkSmartPointer<vtkPolyData>::New();
-        linePolyData->SetPoints(newLine->GetPoints());
-
-        vtkSmartPointer<vtkPointLocator> pointLocator = vtkSmartPointer<vtkPointLocator>::New();
-        pointLocator->SetDataSet(linePolyData);
-        pointLocator->BuildLocator();
-        pointLocators.push_back(pointLocator);
-
+        continue;
         }
 
-      // Loop through all of the external lines that were created
-      for (int currentLineId=0; currentLineId < externalLines->GetNumberOfCells(); ++currentLineId)
+      // Create a new contour that is a half-slice thickness above (below) the line
+      externalLinesPointIds.clear();
+      this->CreateEndCapContour(contours, currentLineIndex, externalLinesPointIds, capAbove ? lineSpacing : -lineSpacing);
+
+      // Add the external lines that were created to the contours and triangulate their interior
+      overlapLineIds.clear();
+      for (size_t externalLineIndex = 0; externalLineIndex < externalLinesPointIds.size(); ++externalLineIndex)
         {
-        vtkSmartPointer<vtkLine> dividedLine = vtkSmartPointer<vtkLine>::New();
-        this->Branch(inputROIPoints, currentLine, currentLineId, overlapLineIds, pointLocators, idLists, dividedLine);
-        this->TriangulateContours(inputROIPoints, dividedLine->GetPointIds(), idLists[currentLineId], outputPolygons);
+        const std::vector<vtkIdType>& externalLinePointIds = externalLinesPointIds[externalLineIndex];
+        if (externalLinePointIds.empty())
+          {
+          continue;
+          }
+        overlapLineIds.push_back(contours.AddContour(&externalLinePointIds[0], (vtkIdType)externalLinePointIds.size()));
+        this->TriangulateLine(contours, &externalLinePointIds[0], (vtkIdType)externalLinePointIds.size(), outputTriangles, capAbove);
         }
-      }
-
-    // If the current was not connected by a polygon to a contour below it, then it needs to be capped
-    if (!lineTriganulatedToBelow[currentLineIndex])
-      {
-
-      // Create a new contour that is a half-slice thickness below the line
-      vtkSmartPointer<vtkCellArray> externalLines = vtkSmartPointer<vtkCellArray>::New();
-      this->CreateEndCapContour(inputROIPoints, currentLine, externalLines, -lineSpacing);
-
-      std::vector<vtkIdType> overlapLineIds;
-      std::vector<vtkSmartPointer<vtkPointLocator> > pointLocators;
-      std::vector<vtkSmartPointer<vtkIdList> >  idLists;
 
-      // Loop through all of the external lines that were created
-      for (int currentLineId = 0; currentLineId < externalLines->GetNumberOfCells(); ++currentLineId)
+      // Find the closest external line for each point of the current line.
+      // The external lines were added after each other, so they form a continuous range of contours.
+      closestBranchIds.clear();
+      if (overlapLineIds.size() > 1)
         {
-        vtkSmartPointer<vtkIdList> lineIdList = vtkSmartPointer<vtkIdList>::New();
-        externalLines->GetNextCell(lineIdList);
-
-        vtkIdType newLineId = inputROIPoints->InsertNextCell(VTK_LINE, lineIdList);
-        inputROIPoints->BuildCells();
-
-        vtkSmartPointer<vtkLine> newLine = vtkSmartPointer<vtkLine>::New();
-        newLine->DeepCopy(inputROIPoints->GetCell(newLineId));
-
-        this->TriangulateLine(newLine, outputPolygons, false);
-
-        overlapLineIds.push_back(currentLineId);
-
-        vtkSmartPointer<vtkPolyData> linePolyData = vtkSmartPointer<vtkPolyData>::New();
-        linePolyData->SetPoints(newLine->GetPoints());
-
-        vtkSmartPointer<vtkPointLocator> pointLocator = vtkSmartPointer<vtkPointLocator>::New();
-        pointLocator->SetDataSet(linePolyData);
-        pointLocator->BuildLocator();
-        pointLocators.push_back(pointLocator);
-
-        idLists.push_back(lineIdList);
+        externalLinesPointTree.Build(contours, overlapLineIds.front(), (vtkIdType)overlapLineIds.size());
+        this->GetClosestBranches(contours, currentLineIndex, externalLinesPointTree, overlapLineIds, closestBranchIds);
         }
 
-      // Loop through all of the external lines that were created
-      for (int currentLineId=0; currentLineId < externalLines->GetNumberOfCells(); ++currentLineId)
+      // Connect the current line to the external lines
+      for (size_t overlapIndex = 0; overlapIndex < overlapLineIds.size(); ++overlapIndex)
         {
-        vtkSmartPointer<vtkLine> dividedLine = vtkSmartPointer<vtkLine>::New();
-        this->Branch(inputROIPoints, currentLine, currentLineId, overlapLineIds, pointLocators, idLists, dividedLine);
-        this->TriangulateContours(inputROIPoints, idLists[currentLineId], dividedLine->GetPointIds(), outputPolygons);
+        vtkIdType externalLineId = overlapLineIds[overlapIndex];
+        this->Branch(contours, currentLineIndex, externalLineId, closestBranchIds, dividedLinePointIds);
+        if (dividedLinePointIds.empty())
+          {
+          // No point of the current line is closest to this external line
+          continue;
+          }
+        const vtkIdType* dividedPointIds = &dividedLinePointIds[0];
+        if (capAbove)
+          {
+          this->TriangulateContours(contours, dividedPointIds, (vtkIdType)dividedLinePointIds.size(),
+            contours.GetContourPointIds(externalLineId), contours.GetNumberOfPointsInContour(externalLineId), outputTriangles);
+          }
+        else
+          {
+          this->TriangulateContours(contours, contours.GetContourPointIds(externalLineId), contours.GetNumberOfPointsInContour(externalLineId),
+            dividedPointIds, (vtkIdType)dividedLinePointIds.size(), outputTriangles);
+          }
         }
       }
     }
 }
 
 //----------------------------------------------------------------------------
-double vtkPlanarContourToClosedSurfaceConversionRule::GetSpacingBetweenLines(vtkPolyData* inputROIPoints)
+double vtkPlanarContourToClosedSurfaceConversionRule::GetSpacingBetweenLines(const ContourSet& contours)
 {
-  if (!inputROIPoints)
-    {
-    vtkErrorMacro("GetSpacingBetweenLines: Invalid vtkPolyData!");
-    return 0.0;
-    }
-  if (inputROIPoints->GetNumberOfCells() < 2)
+  vtkIdType numberOfLines = contours.GetNumberOfContours();
+  if (numberOfLines < 2)
     {
-    vtkErrorMacro("GetSpacingBetweenLines: Input polydata has less than two cells! Unable to calculate spacing.");
+    vtkErrorMacro("GetSpacingBetweenLines: Input has less than two contours! Unable to calculate spacing.");
     return 0.0;
     }
 
@@ -1222,23 +1326,10 @@ double vtkPlanarContourToClosedSurfaceConversionRule::GetSpacingBetweenLines(vtk
   double distanceSum = 0.0;
 
   // Loop through all of the lines
-  vtkIdType lineId = 0;
-  while (lineId < inputROIPoints->GetNumberOfLines() - 1)
+  for (vtkIdType lineId = 0; lineId < numberOfLines - 1; ++lineId)
     {
-
-    // First line
-    vtkSmartPointer<vtkLine> line1 = vtkSmartPointer<vtkLine>::New();
-    line1->DeepCopy(inputROIPoints->GetCell(lineId));
-
-    double line1Bounds[6] = { 0, 0, 0, 0, 0, 0 };
-    line1->GetBounds( line1Bounds );
-
-    // Second line
-    vtkSmartPointer<vtkLine> line2 = vtkSmartPointer<vtkLine>::New();
-    line2->DeepCopy(inputROIPoints->GetCell(lineId + 1));
-
-    double line2Bounds[6] = { 0, 0, 0, 0, 0, 0 };
-    line2->GetBounds( line2Bounds );
+    const double* line1Bounds = contours.GetContourBounds(lineId);
+    const double* line2Bounds = contours.GetContourBounds(lineId + 1);
 
     // Calculate the distance as the difference between the z value in the middle of the bounding boxes of the two lines.
     double distance = std::abs( (line1Bounds[4]+line1Bounds[5])/2 - (line2Bounds[4]+line2Bounds[5])/2 );
@@ -1249,7 +1340,6 @@ double vtkPlanarContourToClosedSurfaceConversionRule::GetSpacingBetweenLines(vtk
       distances.push_back( distance );
       distanceSum += distance;
       }
-    ++lineId;
     }
 
   if (distances.size() == 0)
@@ -1261,7 +1351,7 @@ double vtkPlanarContourToClosedSurfaceConversionRule::GetSpacingBetweenLines(vtk
   double distanceMean = distanceSum/distances.size();
 
   distanceSum = 0;
-  int numberOfLines = 0;
+  int numberOfDistances = 0;
   for (std::vector<double>::iterator distIt = distances.begin(); distIt != distances.end(); ++distIt)
     {
     // If the distance is greater than 10% of the mean, discard it.
@@ -1272,53 +1362,46 @@ double vtkPlanarContourToClosedSurfaceConversionRule::GetSpacingBetweenLines(vtk
       }
 
     distanceSum += distance;
-    ++numberOfLines;
+    ++numberOfDistances;
     }
 
   // If the number of lines is zero, return the uncorrected mean.
-  if (numberOfLines == 0)
+  if (numberOfDistances == 0)
     {
     vtkWarningMacro("GetSpacingBetweenLines: Contour spacing is not consistent.");
     return distanceMean;
     }
-  
+
   // Recalculate the mean distance between the lines.
-  distanceMean = distanceSum/numberOfLines;
+  distanceMean = distanceSum/numberOfDistances;
 
   return distanceMean;
 }
 
 //----------------------------------------------------------------------------
-void vtkPlanarContourToClosedSurfaceConversionRule::CreateEndCapContour(vtkPolyData* inputROIPoints, vtkLine* inputLine, vtkCellArray* outputLines, double lineSpacing)
+void vtkPlanarContourToClosedSurfaceConversionRule::CreateEndCapContour(ContourSet& contours, vtkIdType inputLineIndex,
+  std::vector<std::vector<vtkIdType> >& outputLinesPointIds, double lineSpacing)
 {
-  if (!inputROIPoints)
-    {
-    vtkErrorMacro("CreateEndCapContour: invalid vtkPolyData");
-    return;
-    }
-
-  if (!inputLine)
-    {
-    vtkErrorMacro("CreateEndCapContour: invalid vtkLine");
-    return;
-    }
+  const vtkIdType* inputLinePointIds = contours.GetContourPointIds(inputLineIndex);
+  vtkIdType numberOfPointsInInputLine = contours.GetNumberOfPointsInContour(inputLineIndex);
 
-  if (!outputLines)
+  // Create a poly data containing only the points of the input line for the image stencil
+  vtkSmartPointer<vtkPoints> inputLinePoints = vtkSmartPointer<vtkPoints>::New();
+  inputLinePoints->SetNumberOfPoints(numberOfPointsInInputLine);
+  vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+  lines->InsertNextCell(numberOfPointsInInputLine);
+  for (vtkIdType pointIndex = 0; pointIndex < numberOfPointsInInputLine; ++pointIndex)
     {
-    vtkErrorMacro("CreateEndCapContour: invalid vtkCellArray");
+    inputLinePoints->SetPoint(pointIndex, contours.GetPoint(inputLinePointIds[pointIndex]));
+    lines->InsertCellPoint(pointIndex);
     }
 
-  vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
-  lines->Initialize();
-  lines->InsertNextCell(inputLine);
-
   vtkSmartPointer<vtkPolyData> linePolyData = vtkSmartPointer<vtkPolyData>::New();
-  linePolyData->Initialize();
-  linePolyData->SetPoints(inputROIPoints->GetPoints());
+  linePolyData->SetPoints(inputLinePoints);
   linePolyData->SetLines(lines);
 
   double bounds[6] = { 0, 0, 0, 0, 0, 0 };
-  linePolyData->GetBounds(bounds);
+  std::copy(contours.GetContourBounds(inputLineIndex), contours.GetContourBounds(inputLineIndex) + 6, bounds);
 
   // Calculate the spacing using alternative dimensions
   double alternativeSpacing[2] = {0, 0};
@@ -1431,143 +1514,120 @@ void vtkPlanarContourToClosedSurfaceConversionRule::CreateEndCapContour(vtkPolyD
   this->FixLines(stripper->GetOutput(), newLines);
 
   // Calculate the decimation factor with the following formula: ( # of lines in input * number of points in original line ) / number of points in input
-  double decimationFactor = (1.0 * newLines->GetNumberOfLines() * inputLine->GetNumberOfPoints() + 1 ) / newLines->GetNumberOfPoints();
+  double decimationFactor = (1.0 * newLines->GetNumberOfLines() * numberOfPointsInInputLine + 1 ) / newLines->GetNumberOfPoints();
 
   // Reduce the number of points in the line until the ration between the input and output lines meets the specified decimation factor
   this->DecimateLines(newLines, decimationFactor);
 
-  vtkSmartPointer<vtkPoints> inputPoints = inputROIPoints->GetPoints();
-
   // If a line is successfully created, the use it for end capping.
   // Otherwise, create an external line by extending the original contour by a 1/2 slice thickness in the Z direction.
   if (newLines && newLines->GetNumberOfLines() > 0 && newLines->GetNumberOfPoints() > 0)
     {
-    vtkSmartPointer<vtkPoints> points = newLines->GetPoints();
+    vtkPoints* points = newLines->GetPoints();
 
-    // Loop through all of the lines generated
-    for (int currentLineId=0; currentLineId < newLines->GetNumberOfLines(); ++currentLineId)
+    // Loop through all of the lines generated, reading the point IDs directly from the cell array
+    vtkCellArray* newLineCells = newLines->GetLines();
+    vtkIdType numberOfPointsInNewLine = 0;
+    vtkIdType* newLinePointIds = NULL;
+    for (newLineCells->InitTraversal(); newLineCells->GetNextCell(numberOfPointsInNewLine, newLinePointIds); )
       {
-      vtkSmartPointer<vtkIdList> outputLinePointIds = vtkSmartPointer<vtkIdList>::New();
-      outputLinePointIds->Initialize();
-
-      vtkSmartPointer<vtkLine> currentLine = vtkSmartPointer<vtkLine>::New();
-      currentLine->DeepCopy(newLines->GetCell(currentLineId));
-
-      vtkSmartPointer<vtkLine> newLine = vtkSmartPointer<vtkLine>::New();
-      if (this->IsLineClockwise(newLines, currentLine))
-        {
-        this->ReverseLine(currentLine, newLine);
-        }
-      else
-        {
-        newLine = currentLine;
-        }
+      outputLinesPointIds.push_back(std::vector<vtkIdType>());
+      std::vector<vtkIdType>& outputLinePointIds = outputLinesPointIds.back();
+      outputLinePointIds.reserve(numberOfPointsInNewLine + 1);
 
-      // Loop through the points in the current line
-      for (int currentPointIndex=0; currentPointIndex < newLine->GetNumberOfPoints(); ++currentPointIndex)
+      // Add the points of the current line in counter-clockwise order
+      bool reverse = this->IsLineClockwise(points, newLinePointIds, numberOfPointsInNewLine);
+      for (vtkIdType currentPointIndex = 0; currentPointIndex < numberOfPointsInNewLine; ++currentPointIndex)
         {
-        vtkIdType currentPointId = newLine->GetPointId(currentPointIndex);
+        vtkIdType currentPointId = newLinePointIds[reverse ? numberOfPointsInNewLine - 1 - currentPointIndex : currentPointIndex];
 
         double currentPoint[3] = {0,0,0};
         points->GetPoint(currentPointId, currentPoint);
         currentPoint[2] += lineSpacing/2;
 
-        vtkIdType inputPointId = inputPoints->InsertNextPoint(currentPoint);
-        outputLinePointIds->InsertNextId(inputPointId);
+        outputLinePointIds.push_back(contours.AddPoint(currentPoint));
         }
 
-      // Make sure the line is closed and add it to the output
-      if(outputLinePointIds->GetId(0) != outputLinePointIds->GetId(outputLinePointIds->GetNumberOfIds()-1))
+      // Make sure the line is closed
+      if (!outputLinePointIds.empty() && outputLinePointIds.front() != outputLinePointIds.back())
         {
-        outputLinePointIds->InsertNextId(outputLinePointIds->GetId(0));
+        outputLinePointIds.push_back(outputLinePointIds.front());
         }
-      outputLines->InsertNextCell(outputLinePointIds);
       }
     }
   // If there is something wrong with the lines generated, create an external line by extending the
   // original contour by a 1/2 slice thickness in the Z direction.
   else
     {
-    vtkSmartPointer<vtkPoints> inputLinePoints = inputLine->GetPoints();
-
-    vtkSmartPointer<vtkLine> outputLine = vtkSmartPointer<vtkLine>::New();
-    vtkSmartPointer<vtkPoints> outputLinePoints = outputLine->GetPoints();
-    outputLinePoints->Initialize();
-    vtkSmartPointer<vtkIdList> outputLinePointIds = outputLine->GetPointIds();
-    outputLinePointIds->Initialize();
-
-    int numberOfPoints = inputLine->GetNumberOfPoints();
+    outputLinesPointIds.push_back(std::vector<vtkIdType>());
+    std::vector<vtkIdType>& outputLinePointIds = outputLinesPointIds.back();
 
     // Loop through all of the points in the current line
-    for (int currentPointId=0; currentPointId < numberOfPoints-1; ++currentPointId)
+    for (vtkIdType currentPointIndex=0; currentPointIndex < numberOfPointsInInputLine-1; ++currentPointIndex)
       {
       double currentPoint[3] = {0,0,0};
-      inputLinePoints->GetPoint(currentPointId, currentPoint);
+      inputLinePoints->GetPoint(currentPointIndex, currentPoint);
       currentPoint[2] += lineSpacing/2;
 
-      vtkIdType inputPointId = inputPoints->InsertNextPoint(currentPoint);
-      outputLinePointIds->InsertNextId(inputPointId);
+      outputLinePointIds.push_back(contours.AddPoint(currentPoint));
       }
 
-    outputLinePointIds->InsertNextId(outputLinePointIds->GetId(0));
-    outputLines->InsertNextCell(outputLine);
-
+    if (!outputLinePointIds.empty())
+      {
+      outputLinePointIds.push_back(outputLinePointIds.front());
+      }
     }
 }
 
 //----------------------------------------------------------------------------
-void vtkPlanarContourToClosedSurfaceConversionRule::TriangulateLine(vtkLine* inputLine, vtkCellArray* outputPolys, bool normalsUp)
+void vtkPlanarContourToClosedSurfaceConversionRule::TriangulateLine(const ContourSet& contours, const vtkIdType* linePointIds, vtkIdType numberOfPointsInLine,
+  std::vector<vtkIdType>& outputTriangles, bool normalsUp)
 {
-  if (!inputLine)
+  if (!linePointIds || numberOfPointsInLine == 0)
     {
-   vtkErrorMacro("TriangulateLine: Invalid vtkLine!");
-   return;
-    }
-
-  if (!outputPolys)
-    {
-   vtkErrorMacro("TriangulateLine: Invalid vtkCellArray!");
-   return;
+    vtkErrorMacro("TriangulateLine: Invalid point ID list!");
+    return;
     }
 
-  vtkSmartPointer<vtkLine> line = vtkSmartPointer<vtkLine>::New();
-  line->DeepCopy(inputLine);
-
   // Make sure that the input line is not closed
   // This is required by the vtkPolygon triangulation algorithm
-  if (line->GetPointId(0) == line->GetPointId(line->GetNumberOfPoints()-1))
+  vtkIdType numberOfPolygonPoints = numberOfPointsInLine;
+  if (linePointIds[0] == linePointIds[numberOfPointsInLine-1])
     {
-    line->GetPointIds()->SetNumberOfIds(line->GetPointIds()->GetNumberOfIds()-1);
+    --numberOfPolygonPoints;
     }
 
   // Convert the line to a vtkPolygon so that it can be used in the triangulation process
   vtkSmartPointer<vtkPolygon> polygon = vtkSmartPointer<vtkPolygon>::New();
-  polygon->DeepCopy(line);
+  polygon->GetPoints()->SetNumberOfPoints(numberOfPolygonPoints);
+  polygon->GetPointIds()->SetNumberOfIds(numberOfPolygonPoints);
+  for (vtkIdType pointIndex = 0; pointIndex < numberOfPolygonPoints; ++pointIndex)
+    {
+    polygon->GetPoints()->SetPoint(pointIndex, contours.GetPoint(linePointIds[pointIndex]));
+    polygon->GetPointIds()->SetId(pointIndex, linePointIds[pointIndex]);
+    }
 
   // Triangulate the inside of the line
   vtkSmartPointer<vtkIdList> polygonIds = vtkSmartPointer<vtkIdList>::New();
   polygon->Triangulate(polygonIds);
 
   // Loop through the polygons created by the polygon triangulation
-  for (int currentPolygonIndex = 0; currentPolygonIndex < polygonIds->GetNumberOfIds();  currentPolygonIndex += 3)
+  for (vtkIdType currentPolygonIndex = 0; currentPolygonIndex + 2 < polygonIds->GetNumberOfIds(); currentPolygonIndex += 3)
     {
-    outputPolys->InsertNextCell(3);
-
     // Add the triangles to the mesh, making sure that the normals for the triangles are facing the correct direction
     if (normalsUp)
       {
-      outputPolys->InsertCellPoint(inputLine->GetPointId(polygonIds->GetId(currentPolygonIndex)));
-      outputPolys->InsertCellPoint(inputLine->GetPointId(polygonIds->GetId(currentPolygonIndex + 1)));
-      outputPolys->InsertCellPoint(inputLine->GetPointId(polygonIds->GetId(currentPolygonIndex + 2)));
+      outputTriangles.push_back(linePointIds[polygonIds->GetId(currentPolygonIndex)]);
+      outputTriangles.push_back(linePointIds[polygonIds->GetId(currentPolygonIndex + 1)]);
+      outputTriangles.push_back(linePointIds[polygonIds->GetId(currentPolygonIndex + 2)]);
       }
     else
       {
-      outputPolys->InsertCellPoint(inputLine->GetPointId(polygonIds->GetId(currentPolygonIndex + 2)));
-      outputPolys->InsertCellPoint(inputLine->GetPointId(polygonIds->GetId(currentPolygonIndex + 1)));
-      outputPolys->InsertCellPoint(inputLine->GetPointId(polygonIds->GetId(currentPolygonIndex)));
+      outputTriangles.push_back(linePointIds[polygonIds->GetId(currentPolygonIndex + 2)]);
+      outputTriangles.push_back(linePointIds[polygonIds->GetId(currentPolygonIndex + 1)]);
+      outputTriangles.push_back(linePointIds[polygonIds->GetId(currentPolygonIndex)]);
       }
     }
-
 }
 
 //----------------------------------------------------------------------------
@@ -1619,39 +1679,39 @@ void vtkPlanarContourToClosedSurfaceConversionRule::FixLines(vtkPolyData* oldLin
   vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
   lines->Initialize();
 
-  for (vtkIdType lineId = 0; lineId < oldLines->GetNumberOfLines(); ++lineId)
+  // Read the point IDs of the lines directly from the cell array
+  vtkCellArray* oldLineCells = oldLines->GetLines();
+  vtkIdType numberOfOldLines = oldLines->GetNumberOfLines();
+  vtkIdType numberOfPointsInOldLine = 0;
+  vtkIdType* oldLinePointIds = NULL;
+  for (oldLineCells->InitTraversal(); oldLineCells->GetNextCell(numberOfPointsInOldLine, oldLinePointIds); )
     {
-    vtkSmartPointer<vtkLine> oldLine = vtkSmartPointer<vtkLine>::New();
-    oldLine->DeepCopy(oldLines->GetCell(lineId));
-
     // We identified an issue with vtkMarchingSquares that caused the some of the lines generated
     // to loop back on themselves by the third point. This check causes these contours to be ignored.
     //  When there is only one contour, it is not acceptable to throw it away.
     // TODO: This method is not working well and needs to be improved.
-    if (oldLine->GetNumberOfPoints() <= 2)
+    if (numberOfPointsInOldLine <= 2)
       {
       continue;
       }
-    else if (oldLine->GetPointId(0) == oldLine->GetPointId(2) && oldLine->GetNumberOfPoints() != 3)
+    else if (oldLinePointIds[0] == oldLinePointIds[2] && numberOfPointsInOldLine != 3)
       {
 
-      if (oldLines->GetNumberOfLines() > 1)
+      if (numberOfOldLines > 1)
         {
         continue;
         }
 
-      vtkSmartPointer<vtkLine> fixedLine = vtkSmartPointer<vtkLine>::New();
-      this->FixLine(oldLine, fixedLine);
-
-      if (fixedLine->GetNumberOfPoints() > 1)
+      // Remove the first and the last point of the line
+      if (numberOfPointsInOldLine - 2 > 1)
         {
-        lines->InsertNextCell(fixedLine);
+        lines->InsertNextCell(numberOfPointsInOldLine - 2, oldLinePointIds + 1);
         }
 
       }
     else
       {
-      lines->InsertNextCell(oldLine);
+      lines->InsertNextCell(numberOfPointsInOldLine, oldLinePointIds);
       }
 
     }
@@ -1661,45 +1721,6 @@ void vtkPlanarContourToClosedSurfaceConversionRule::FixLines(vtkPolyData* oldLin
 
 }
 
-//----------------------------------------------------------------------------
-void vtkPlanarContourToClosedSurfaceConversionRule::FixLine(vtkLine* oldLine, vtkLine* newLine)
-{
-
-  if (!oldLine)
-    {
-   vtkErrorMacro("FixLine: Invalid vtkLine!");
-   return;
-    }
-
-  if (!newLine)
-    {
-   vtkErrorMacro("FixLine: Invalid vtkLine!");
-   return;
-    }
-
-  vtkSmartPointer<vtkIdList> oldIdList = oldLine->GetPointIds();
-  vtkSmartPointer<vtkPoints> oldPoints = oldLine->GetPoints();
-
-  vtkSmartPointer<vtkPoints> newPoints = newLine->GetPoints();
-  newPoints->Initialize();
-
-  vtkSmartPointer<vtkIdList> newIdList = newLine->GetPointIds();
-  newIdList->Initialize();
-
-  // Loop through the points in the original line, except the first and the last and add it to the new line
-  for (int currentIndex=1; currentIndex < oldIdList->GetNumberOfIds()-1; ++currentIndex)
-    {
-    vtkIdType oldId = oldIdList->GetId(currentIndex);
-
-    double point[3] = {0,0,0};
-    oldPoints->GetPoint(oldId, point);
-
-    // Add the point to the new line
-    newPoints->InsertPoint(oldId, point);
-    newIdList->InsertNextId(oldId);
-    }
-}
-
 //----------------------------------------------------------------------------
 void vtkPlanarContourToClosedSurfaceConversionRule::DecimateLines(vtkPolyData* inputPolyData, double decimationFactor)
 {
@@ -1717,17 +1738,16 @@ void vtkPlanarContourToClosedSurfaceConversionRule::DecimateLines(vtkPolyData* i
 
   vtkSmartPointer<vtkPriorityQueue> priorityQueue = vtkSmartPointer<vtkPriorityQueue>::New();
 
-  // Loop through all of the lines
-  for (vtkIdType inputLineId = 0; inputLineId < inputPolyData->GetNumberOfLines(); ++inputLineId)
-    {
-
-    vtkSmartPointer<vtkLine> outputLine = vtkSmartPointer<vtkLine>::New();
-    outputLine->DeepCopy(inputPolyData->GetCell(inputLineId));
+  // Point IDs of the current output line, reused for all lines
+  vtkSmartPointer<vtkIdList> outputLineIds = vtkSmartPointer<vtkIdList>::New();
 
-    vtkSmartPointer<vtkLine> inputLine =  vtkSmartPointer<vtkLine>::New();
-    inputLine->ShallowCopy(inputPolyData->GetCell(inputLineId));
-
-    vtkSmartPointer<vtkIdList> outputLineIds = outputLine->GetPointIds();
+  // Loop through all of the lines, reading the point IDs directly from the cell array
+  vtkIdType numberOfPointsInInputLine = 0;
+  vtkIdType* inputLinePointIds = NULL;
+  for (inputLines->InitTraversal(); inputLines->GetNextCell(numberOfPointsInInputLine, inputLinePointIds); )
+    {
+    outputLineIds->SetNumberOfIds(numberOfPointsInInputLine);
+    std::copy(inputLinePointIds, inputLinePointIds + numberOfPointsInInputLine, outputLineIds->GetPointer(0));
 
     // If there are less than 2 points, then just copy the line
     if (outputLineIds->GetNumberOfIds() > 2)
@@ -1747,7 +1767,7 @@ void vtkPlanarContourToClosedSurfaceConversionRule::DecimateLines(vtkPolyData* i
       // and while the ratio of the # output points / # input points is greater than the decimation factor
       while (priorityQueue->GetNumberOfItems() > 3 &&
             ((priorityQueue->GetPriority(priorityQueue->Peek()) < VTK_DBL_EPSILON) ||
-            (1.0 * outputLineIds->GetNumberOfIds() / inputLine->GetNumberOfPoints() > decimationFactor)))
+            (1.0 * outputLineIds->GetNumberOfIds() / numberOfPointsInInputLine > decimationFactor)))
         {
         // Remove the point from the outputLineIds
         this->RemovePointDecimation(outputLineIds, priorityQueue->Pop());
@@ -1790,18 +1810,19 @@ void vtkPlanarContourToClosedSurfaceConversionRule::RemovePointDecimation(vtkIdL
    return;
     }
 
-  vtkSmartPointer<vtkIdList> idList = vtkSmartPointer<vtkIdList>::New();
-  idList->Initialize();
-  for (int i=0; i < originalIdList->GetNumberOfIds(); ++i)
+  // Remove the point in place, shifting the remaining IDs
+  vtkIdType numberOfIds = originalIdList->GetNumberOfIds();
+  vtkIdType newNumberOfIds = 0;
+  for (vtkIdType i=0; i < numberOfIds; ++i)
     {
     vtkIdType id = originalIdList->GetId(i);
 
     if (pointId != id)
       {
-      idList->InsertNextId(id);
+      originalIdList->SetId(newNumberOfIds++, id);
       }
     }
-  originalIdList->DeepCopy(idList);
+  originalIdList->SetNumberOfIds(newNumberOfIds);
 
 }
 
@@ -1875,28 +1896,52 @@ void vtkPlanarContourToClosedSurfaceConversionRule::CalculateContourTransform(vt
 //----------------------------------------------------------------------------
 void vtkPlanarContourToClosedSurfaceConversionRule::CalculateContourNormal(vtkPolyData* inputPolyData, double outputNormal[3], int minimumContourSize)
 {
-
-  int numberOfLines = inputPolyData->GetNumberOfLines();
-  vtkSmartPointer<vtkIdList> currentContour = vtkSmartPointer<vtkIdList>::New();
+  vtkCellArray* lines = inputPolyData->GetLines();
+  vtkPoints* inputPoints = inputPolyData->GetPoints();
+  if (!lines || !inputPoints)
+  {
+    return;
+  }
 
   double meshNormalSum[3] = { 0, 0, 0 };
 
+  // The plane of each contour is fitted to a poly data containing only the points of the contour.
+  // The same objects are reused for all contours, so that the whole input is not copied for each contour.
+  vtkSmartPointer<vtkPoints> contourPoints = vtkSmartPointer<vtkPoints>::New();
+  contourPoints->SetDataType(inputPoints->GetDataType());
+  vtkSmartPointer<vtkCellArray> contourVertices = vtkSmartPointer<vtkCellArray>::New();
+  vtkSmartPointer<vtkPolyData> contourPolyData = vtkSmartPointer<vtkPolyData>::New();
+  vtkSmartPointer<vtkTextureMapToPlane> textureMapToPlane = vtkSmartPointer<vtkTextureMapToPlane>::New();
+  textureMapToPlane->SetInputData(contourPolyData);
+  std::vector<vtkIdType> uniquePointIds;
+
   int numberOfSmallContours = 0;
-  int currentContourIndex = 0;
-  inputPolyData->GetLines()->InitTraversal();
-  while (inputPolyData->GetLines()->GetNextCell(currentContour))
+  vtkIdType numberOfContourPoints = 0;
+  vtkIdType* contourPointIds = NULL;
+  for (lines->InitTraversal(); lines->GetNextCell(numberOfContourPoints, contourPointIds); )
   {
-    double contourNormal[3] = { 0, 0, 0 };
-
-    vtkNew<vtkExtractCells> extract;
-    extract->SetInputData(inputPolyData);
-    extract->AddCellRange(currentContourIndex, currentContourIndex);
-    extract->Update();
+    // Points used by the contour, each only once
+    uniquePointIds.assign(contourPointIds, contourPointIds + numberOfContourPoints);
+    std::sort(uniquePointIds.begin(), uniquePointIds.end());
+    uniquePointIds.erase(std::unique(uniquePointIds.begin(), uniquePointIds.end()), uniquePointIds.end());
+    vtkIdType numberOfUniquePoints = (vtkIdType)uniquePointIds.size();
+
+    if (numberOfUniquePoints > minimumContourSize)
+    {
+      contourPoints->SetNumberOfPoints(numberOfUniquePoints);
+      contourVertices->Reset();
+      contourVertices->InsertNextCell(numberOfUniquePoints);
+      for (vtkIdType pointIndex = 0; pointIndex < numberOfUniquePoints; ++pointIndex)
+      {
+        contourPoints->SetPoint(pointIndex, inputPoints->GetPoint(uniquePointIds[pointIndex]));
+        contourVertices->InsertCellPoint(pointIndex);
+      }
+      contourPoints->Modified();
+      contourPolyData->Initialize();
+      contourPolyData->SetPoints(contourPoints);
+      contourPolyData->SetVerts(contourVertices);
 
-    if (extract->GetOutput()->GetNumberOfPoints() > minimumContourSize)
-    {
-      vtkNew<vtkTextureMapToPlane> textureMapToPlane;
-      textureMapToPlane->SetInputConnection(extract->GetOutputPort());
+      double contourNormal[3] = { 0, 0, 0 };
       textureMapToPlane->Update();
       textureMapToPlane->GetNormal(contourNormal);
       vtkMath::Add(contourNormal, meshNormalSum, meshNormalSum);
@@ -1905,7 +1950,6 @@ void vtkPlanarContourToClosedSurfaceConversionRule::CalculateContourNormal(vtkPo
     {
       ++numberOfSmallContours;
     }
-    ++currentContourIndex;
   }
 
   // All contours had less than the minimum number of points.
@@ -1921,4 +1965,4 @@ void vtkPlanarContourToClosedSurfaceConversionRule::CalculateContourNormal(vtkPo
   }
   vtkMath::Normalize(outputNormal);
 
-}
\ No newline at end of file
+}
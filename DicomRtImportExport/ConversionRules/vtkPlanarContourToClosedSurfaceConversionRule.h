@@ -27,8 +27,8 @@
 
 #include "vtkSlicerDicomRtImportExportConversionRulesExport.h"
 
-// VTK includes
-#include "vtkPointLocator.h"
+// STD includes
+#include <vector>
 
 class vtkPolyData;
 class vtkIdList;
@@ -78,16 +78,100 @@ public:
   /// Human-readable name of the target representation
   virtual const char* GetTargetRepresentationName() { return vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName(); };
 
+  /// Set/get whether the contour plane pairs are triangulated on multiple threads (on by default).
+  /// Turn it off when segments are converted on multiple threads already, to avoid nested parallelism
+  vtkSetMacro(ConcurrentTriangulation, bool);
+  vtkGetMacro(ConcurrentTriangulation, bool);
+  vtkBooleanMacro(ConcurrentTriangulation, bool);
+
 protected:
   vtkPlanarContourToClosedSurfaceConversionRule();
   virtual ~vtkPlanarContourToClosedSurfaceConversionRule();
 
-  /// Construct a surface triangulation between two lines using a dynamic programming algorithm.
+  /// Flat representation of the planar contours used by the conversion algorithm.
+  /// The coordinates of all points are stored in one array, and the contours are stored as consecutive
+  /// ranges of one point ID array, so that the steps of the algorithm do not need to create VTK objects
+  /// for the individual contours.
+  /// WARNING: Adding contours may reallocate the point ID array, so pointers returned by \sa GetContourPointIds
+  ///   are only valid until the next call to \sa AddContour.
+  struct ContourSet
+  {
+    /// Coordinates of all points (3 values per point). Points created by end capping are appended
+    std::vector<double> Points;
+    /// Point IDs of all contours, one contour after the other
+    std::vector<vtkIdType> PointIds;
+    /// Index of the first point ID of each contour in PointIds, with an extra element at the end (size of PointIds)
+    std::vector<vtkIdType> ContourOffsets;
+    /// Bounds of each contour (6 values per contour)
+    std::vector<double> ContourBounds;
+    /// Index of the first contour on each contour plane, with an extra element at the end (number of contours)
+    std::vector<vtkIdType> PlaneOffsets;
+
+    ContourSet();
+
+    /// Remove all contours, keeping the points
+    void ClearContours();
+    /// Exchange the contents with another contour set
+    void Swap(ContourSet& other);
+    /// Add a contour and compute its bounds
+    /// \return Index of the new contour
+    vtkIdType AddContour(const vtkIdType* pointIds, vtkIdType numberOfPointIds);
+    /// Append a point
+    /// \return ID of the new point
+    vtkIdType AddPoint(const double point[3]);
+
+    vtkIdType GetNumberOfContours() const { return (vtkIdType)this->ContourOffsets.size() - 1; };
+    vtkIdType GetNumberOfPointsInContour(vtkIdType contourIndex) const { return this->ContourOffsets[contourIndex+1] - this->ContourOffsets[contourIndex]; };
+    const vtkIdType* GetContourPointIds(vtkIdType contourIndex) const { return this->PointIds.empty() ? NULL : &this->PointIds[0] + this->ContourOffsets[contourIndex]; };
+    const double* GetContourBounds(vtkIdType contourIndex) const { return &this->ContourBounds[6*contourIndex]; };
+    const double* GetPoint(vtkIdType pointId) const { return &this->Points[3*pointId]; };
+    int GetNumberOfPlanes() const { return (int)this->PlaneOffsets.size() - 1; };
+  };
+
+  /// KD-tree of the points of a range of contours, used to find the contour closest to a point
+  /// among a set of candidate contours. It is built once and can be queried from multiple threads.
+  struct ContourPointTree
+  {
+    /// Index of the first contour in the tree
+    vtkIdType FirstContourIndex;
+    /// Number of contours in the tree
+    vtkIdType NumberOfContours;
+    /// Point IDs and their contour indices in tree order. The node of the range [begin, end) is the point in the middle of the range
+    std::vector<std::pair<vtkIdType, vtkIdType> > Points;
+    /// Split axis of each node, stored at the node point
+    std::vector<char> SplitAxes;
+
+    ContourPointTree();
+
+    /// Build the tree from the points of the contours in the range [firstContourIndex, firstContourIndex + numberOfContours)
+    void Build(const ContourSet& contours, vtkIdType firstContourIndex, vtkIdType numberOfContours);
+
+    /// Find the contour of the point closest to the given point, considering only the contours enabled in the mask.
+    /// If several contours are at the same distance, then the one with the lowest index is returned.
+    /// \param contourMask Non-zero for the contours to consider, indexed relative to FirstContourIndex
+    /// \return Index of the closest contour, -1 if there are no points in the enabled contours
+    vtkIdType FindClosestContour(const ContourSet& contours, const double* point, const std::vector<char>& contourMask) const;
+
+  protected:
+    void BuildNode(const ContourSet& contours, vtkIdType begin, vtkIdType end);
+    void FindClosestContourInNode(const ContourSet& contours, const double* point, const std::vector<char>& contourMask,
+      vtkIdType begin, vtkIdType end, double& closestDistanceSquared, vtkIdType& closestContourIndex) const;
+  };
+
+  /// Copy the points and the lines of the input poly data to the flat contour representation.
   /// \param inputROIPoints Polydata containing all of the points and contours
-  /// \param pointsInLine1 List of points that are contained in the line to be triangulated
-  /// \param pointsInLine2 List of points that are contained in the line to be triangulated
-  /// \param Cell array that polygons are added to by the triangulation algorithm
-  void TriangulateContours(vtkPolyData* inputROIPoints, vtkIdList* pointsInLine1, vtkIdList* pointsInLine2, vtkCellArray* outputPolygons);
+  /// \param contours Output contours
+  void ReadContours(vtkPolyData* inputROIPoints, ContourSet& contours);
+
+  /// Construct a surface triangulation between two lines using a dynamic programming algorithm.
+  /// \param contours Contours containing all of the points
+  /// \param pointsInLine1 Point IDs of the first line to be triangulated
+  /// \param numberOfPointsInLine1 Number of point IDs in the first line
+  /// \param pointsInLine2 Point IDs of the second line to be triangulated
+  /// \param numberOfPointsInLine2 Number of point IDs in the second line
+  /// \param outputTriangles Point ID triplets of the triangles, appended by the triangulation algorithm
+  void TriangulateContours(const ContourSet& contours, const vtkIdType* pointsInLine1, vtkIdType numberOfPointsInLine1,
+    const vtkIdType* pointsInLine2, vtkIdType numberOfPointsInLine2, std::vector<vtkIdType>& outputTriangles);
 
   /// Find the index of the last point in a contour.
   /// \param startLoopIndex The index of the first point in the contour
@@ -97,93 +181,118 @@ protected:
   vtkIdType GetEndLoop(vtkIdType startLoopIndex, int numberOfPoints, bool loopClosed);
 
   /// Find the point on the given line that is closest to the given point.
-  /// \param inputROIPoints Polydata containing all of the points and contours
+  /// \param contours Contours containing all of the points
   /// \param originalPoint The point that is being compared to the line
-  /// \param linePointIds The line that is being compared to the point
+  /// \param linePointIds Point IDs of the line that is being compared to the point
+  /// \param numberOfPointsInLine Number of point IDs in the line
   /// \return The index of the point in the line that is closet to the specified point
-  vtkIdType GetClosestPoint(vtkPolyData* inputROIPoints, double* originalPoint, vtkIdList* linePointIds);
+  vtkIdType GetClosestPoint(const ContourSet& contours, const double* originalPoint, const vtkIdType* linePointIds, vtkIdType numberOfPointsInLine);
 
   /// Sort the contours based on Z value.
-  /// \param inputROIPoints Polydata containing all of the points and contours
-  void SortContours(vtkPolyData* inputROIPoints);
+  /// \param contours Contours to sort
+  void SortContours(ContourSet& contours);
 
   /// Remove the keyholes from the contours.
-  /// \param inputROIPoints Polydata containing all of the points and contours
+  /// \param contours Contours to fix
   /// \param The minimum distance between two points in mm before points are considered to be part of a keyhole
   /// \param The minimum number of seperation of indices between points before they can be part of a keyhole
-  void FixKeyholes(vtkPolyData* inputROIPoints, double epsilon, int minimumSeperation);
+  void FixKeyholes(ContourSet& contours, double epsilon, int minimumSeperation);
 
-  /// Set all of the lines to be oriented in the clockwise direction.
-  /// \param inputROIPoints Polydata containing all of the points and contours
-  void SetLinesCounterClockwise(vtkPolyData* inputROIPoints);
+  /// Set all of the lines to be oriented in the counter-clockwise direction.
+  /// \param contours Contours to orient
+  void SetLinesCounterClockwise(ContourSet& contours);
 
   /// Determine if a line runs in a clockwise orientation.
-  /// \param inputROIPoints Polydata containing all of the points and contours
-  /// \param line The line that is being checked
-  bool IsLineClockwise(vtkPolyData* inputROIPoints, vtkLine* line);
-
-  /// Reverse the orientation of a line from clockwise to counter-clockwise and vice versa.
-  /// \param originalLine The line that is being reversed
-  /// \param newLine The output reversed line
-  void ReverseLine(vtkLine* originalLine, vtkLine* newLine);
+  /// \param contours Contours containing all of the points
+  /// \param linePointIds Point IDs of the line that is being checked
+  /// \param numberOfPointsInLine Number of point IDs in the line
+  bool IsLineClockwise(const ContourSet& contours, const vtkIdType* linePointIds, vtkIdType numberOfPointsInLine);
 
-  /// Determine the number of contours that share the same Z-coordinates.
-  /// WARNING: This function requires that the normal vector of all contours is aligned with the Z-axis.
-  /// \param inputROIPoints Polydata containing all of the points and contours
-  /// \param originalLineIndex The index of the line that is part of the plane being checked
+  /// Determine if a line runs in a clockwise orientation.
+  /// \param points Points the line point IDs refer to
+  /// \param linePointIds Point IDs of the line that is being checked
+  /// \param numberOfPointsInLine Number of point IDs in the line
+  bool IsLineClockwise(vtkPoints* points, const vtkIdType* linePointIds, vtkIdType numberOfPointsInLine);
+
+  /// Group the contours that share the same Z-coordinates into contour planes (see \sa ContourSet::PlaneOffsets).
+  /// WARNING: This function requires that the normal vector of all contours is aligned with the Z-axis,
+  ///   and that the contours are sorted.
+  /// \param contours Contours to group
   /// \param spacing The spacing between lines
-  int GetNumberOfLinesOnPlane(vtkPolyData* inputROIPoints, vtkIdType originalLineIndex, double spacing);
-
-  /// Determine if two contours overlap in the XY axis.
-  /// \param The first line
-  /// \param The second line
-  bool DoLinesOverlap(vtkLine* line1, vtkLine* line2);
+  void ComputeContourPlanes(ContourSet& contours, double spacing);
+
+  /// Determine if two contours overlap in the XY axis based on their bounds.
+  /// \param bounds1 Bounds of the first line
+  /// \param bounds2 Bounds of the second line
+  bool DoLinesOverlap(const double* bounds1, const double* bounds2);
+
+  /// Triangulate the lines of two consecutive contour planes. Only reads the contours,
+  /// so different plane pairs can be triangulated in parallel.
+  /// \param contours Contours containing all of the points, with the contour planes computed
+  /// \param planePairIndex Index of the lower plane of the pair
+  /// \param lineTriangulatedToAbove Flags set for the lines on the lower plane that are triangulated to the upper plane
+  /// \param lineTriangulatedToBelow Flags set for the lines on the upper plane that are triangulated to the lower plane
+  /// \param outputTriangles Point ID triplets of the triangles, appended by the triangulation
+  void TriangulatePlanePair(const ContourSet& contours, int planePairIndex,
+    std::vector<char>& lineTriangulatedToAbove, std::vector<char>& lineTriangulatedToBelow, std::vector<vtkIdType>& outputTriangles);
+
+  /// Find the pairs of overlapping lines of two contour planes.
+  /// The bounding boxes of the lines are swept along the X axis, so that only the lines that overlap in X are compared.
+  /// \param contours Contours containing all of the points, with the contour planes computed
+  /// \param plane1Index Index of the first plane
+  /// \param plane2Index Index of the second plane
+  /// \param overlappingLinePairs Output pairs of overlapping lines (line on first plane, line on second plane), sorted
+  void FindOverlappingLines(const ContourSet& contours, int plane1Index, int plane2Index, std::vector<std::pair<vtkIdType, vtkIdType> >& overlappingLinePairs);
+
+  /// Find the closest overlapping line (branch) for each point of a line (trunk).
+  /// \param contours Contours containing all of the points
+  /// \param branchingLineIndex Index of the line that is being divided
+  /// \param branchPointTree Point tree containing the overlapping lines
+  /// \param overlappingLineIds List of line indices for lines that overlap with the branching line, sorted
+  /// \param closestBranchIds Output index of the closest overlapping line for each point of the branching line.
+  ///   Empty if there is only one overlapping line, as then all points belong to it.
+  void GetClosestBranches(const ContourSet& contours, vtkIdType branchingLineIndex, const ContourPointTree& branchPointTree,
+    const std::vector<vtkIdType>& overlappingLineIds, std::vector<vtkIdType>& closestBranchIds);
 
   /// Create a branching pattern for overlapping contours.
-  /// \param inputROIPoints Polydata containing all of the points and contours
-  /// \param branchingLine The orignal line that is being divided
-  /// \param currentLineId The ID of the current line in the input polydata that is being compared
-  /// \param overlappingLineIds List of line IDs for lines that overlap with the current line
-  /// \param pointLocators List of point locators for lines in the overlap list
-  /// \param lineIdLists List of vtkIdLists for all of the lines in the overlap list
-  /// \param outputLine The output branched line
-  void Branch(vtkPolyData* inputROIPoints, vtkLine* branchingLine, vtkIdType currentLineId, std::vector< vtkIdType > overlappingLineIds, std::vector<vtkSmartPointer<vtkPointLocator> > pointLocators, std::vector<vtkSmartPointer<vtkIdList> > lineIdLists, vtkLine* outputLine);
-
-  /// Find the branch closest from the point on the trunk
-  /// \param inputROIPoints Polydata containing all of the points and contours
-  /// \param originalPoint The point that is being compared
-  /// \param overlappingLineIds List of line IDs for lines that overlap with the current line
-  /// \param pointLocators List of point locators for lines in the overlap list
-  /// \param lineIdLists List of vtkIdLists for all of the lines in the overlap list
-  int GetClosestBranch(vtkPolyData* inputROIPoints, double* originalPoint, std::vector< vtkIdType > overlappingLineIds, std::vector<vtkSmartPointer<vtkPointLocator> > pointLocators, std::vector<vtkSmartPointer<vtkIdList> > lineIdLists);
+  /// \param contours Contours containing all of the points
+  /// \param branchingLineIndex Index of the orignal line that is being divided
+  /// \param currentLineId The index of the current line that is being compared
+  /// \param closestBranchIds Index of the closest overlapping line for each point of the branching line (see \sa GetClosestBranches)
+  /// \param outputLinePointIds The point IDs of the output branched line
+  void Branch(const ContourSet& contours, vtkIdType branchingLineIndex, vtkIdType currentLineId, const std::vector<vtkIdType>& closestBranchIds, std::vector<vtkIdType>& outputLinePointIds);
 
   /// Seal the exterior contours of the mesh.
-  /// \param inputROIPoints Polydata containing all of the points and contours
-  /// \param inputLines Lines
-  /// \param outputPolygons
-  /// \param lineTriganulatedToAbove
-  /// \param lineTriganulatedToBelow
-  void EndCapping(vtkPolyData* inputROIPoints, vtkCellArray* outputPolygons, std::vector< bool > lineTriganulatedToAbove, std::vector< bool > lineTriganulatedToBelow);
-
-  /// Calculate the spacing between the lines in the polydata
+  /// End cap contours are added to the contours, and their points to the points of the contours.
+  /// \param contours Contours containing all of the points
+  /// \param lineSpacing The size of the spacing between the contours
+  /// \param lineTriangulatedToAbove Flags of the lines that are triangulated to the plane above
+  /// \param lineTriangulatedToBelow Flags of the lines that are triangulated to the plane below
+  /// \param outputTriangles Point ID triplets of the triangles, appended by the end capping
+  void EndCapping(ContourSet& contours, double lineSpacing, const std::vector<char>& lineTriangulatedToAbove, const std::vector<char>& lineTriangulatedToBelow,
+    std::vector<vtkIdType>& outputTriangles);
+
+  /// Calculate the spacing between the lines
   /// WARNING: This function requires that the normal vector of all contours is aligned with the Z-axis.
-  /// \param inputROIPoints Polydata containing all of the points and contours
+  /// \param contours Contours containing all of the points
   /// \return The size of the spacing between the contours
-  double GetSpacingBetweenLines(vtkPolyData* inputROIPoints);
+  double GetSpacingBetweenLines(const ContourSet& contours);
 
   /// Create an additional contour on the exterior of the surface to compensate for slice thickness.
   /// This step is generally called end-capping.
-  /// \param inputROIPoints Polydata containing all of the points and contours
-  /// \param inputLine The original line that needs to be extended
-  /// \param outputLines Cell array containing all of the lines that are created by the algorithm
+  /// \param contours Contours containing all of the points. Points of the created lines are added to it
+  /// \param inputLineIndex Index of the original line that needs to be extended
+  /// \param outputLinesPointIds Point IDs of the lines that are created by the algorithm
   /// \param The size of the spacing between the contours. Contours created by this function will be offset by 1/2 of this amount
-  void CreateEndCapContour(vtkPolyData* inputROIPoints, vtkLine* inputLine, vtkCellArray* outputLines, double lineSpacing);
+  void CreateEndCapContour(ContourSet& contours, vtkIdType inputLineIndex, std::vector<std::vector<vtkIdType> >& outputLinesPointIds, double lineSpacing);
 
   /// Triangulate the interior of a contour on the xy plane.
-  /// \param Contour that is being triangulated
-  /// \param Cell array that the polygons are added to
+  /// \param contours Contours containing all of the points
+  /// \param linePointIds Point IDs of the contour that is being triangulated
+  /// \param numberOfPointsInLine Number of point IDs in the contour
+  /// \param outputTriangles Point ID triplets of the triangles, appended by the triangulation
   /// \param True if the normals are positive in the z direction, false if the normals are negative
-  void TriangulateLine(vtkLine* inputLine, vtkCellArray* outputPolys, bool normalsUp);
+  void TriangulateLine(const ContourSet& contours, const vtkIdType* linePointIds, vtkIdType numberOfPointsInLine, std::vector<vtkIdType>& outputTriangles, bool normalsUp);
 
   /// Find the index of the next point in the contour.
   /// \param The location of the currentId
@@ -217,14 +326,6 @@ protected:
   /// \return Distance of the specified point from the line defined by the two points on either side
   double ComputeError(vtkPoints* points, vtkIdList* lineIds, vtkIdType pointId);
 
-  /// Remove some points from the start and end of the line
-  /// TODO: This step is based on trial and error, to fix an issue from the contour generated by
-  ///       vtkMarchingSquares and vtkStripper. It will probably need to be revised when the true
-  ///       cause of the problem is found
-  /// \param inputLine The line that points are being removed from
-  /// \param outputLine The line with points removed
-  void FixLine(vtkLine* inputLine, vtkLine* outputLine);
-
   /// Attempt fix some errors in the contours generated by vtkMarchingSquares and vtkStripper.
   /// TODO: This step is based on trial and error, to fix an issue from the contour generated by
   ///       vtkMarchingSquares and vtkStripper. It will probably need to be revised when the true
@@ -255,9 +356,14 @@ protected:
   // Image padding size that is used in the end-capping process
   int ImagePadding[3];
 
+  // Flag indicating whether the contour plane pairs are triangulated on multiple threads
+  bool ConcurrentTriangulation;
+
 private:
   vtkPlanarContourToClosedSurfaceConversionRule(const vtkPlanarContourToClosedSurfaceConversionRule&); // Not implemented
   void operator=(const vtkPlanarContourToClosedSurfaceConversionRule&);               // Not implemented
+
+  friend class vtkPlanarContourPlanePairFunctor;
 };
 
 #endif
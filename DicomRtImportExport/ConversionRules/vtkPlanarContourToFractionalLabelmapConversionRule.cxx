@@ -0,0 +1,91 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// DicomRtImportExport includes
+#include "vtkPlanarContourToFractionalLabelmapConversionRule.h"
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkClosedSurfaceToFractionalLabelmapConversionRule.h"
+#include "vtkPolyDataToFractionalLabelmapFilter.h"
+
+// VTK includes
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+#include <vtkDoubleArray.h>
+#include <vtkIntArray.h>
+#include <vtkFieldData.h>
+
+//----------------------------------------------------------------------------
+vtkSegmentationConverterRuleNewMacro(vtkPlanarContourToFractionalLabelmapConversionRule);
+
+//----------------------------------------------------------------------------
+vtkPlanarContourToFractionalLabelmapConversionRule::vtkPlanarContourToFractionalLabelmapConversionRule()
+{
+}
+
+//----------------------------------------------------------------------------
+vtkPlanarContourToFractionalLabelmapConversionRule::~vtkPlanarContourToFractionalLabelmapConversionRule()
+{
+}
+
+//----------------------------------------------------------------------------
+int vtkPlanarContourToFractionalLabelmapConversionRule::GetNumberOfSamplesPerAxis()
+{
+  // 6x6x6 samples give FRACTIONAL_MAX - FRACTIONAL_MIN = 216 steps
+  return 6;
+}
+
+//----------------------------------------------------------------------------
+int vtkPlanarContourToFractionalLabelmapConversionRule::GetOutputScalarType()
+{
+  return VTK_FRACTIONAL_DATA_TYPE;
+}
+
+//----------------------------------------------------------------------------
+int vtkPlanarContourToFractionalLabelmapConversionRule::GetOutputBackgroundValue()
+{
+  return FRACTIONAL_MIN;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlanarContourToFractionalLabelmapConversionRule::AddLabelmapFieldData(vtkOrientedImageData* labelmap)
+{
+  // Specify the scalar range of values in the labelmap
+  vtkSmartPointer<vtkDoubleArray> scalarRange = vtkSmartPointer<vtkDoubleArray>::New();
+  scalarRange->SetName(vtkSegmentationConverter::GetScalarRangeFieldName());
+  scalarRange->InsertNextValue(FRACTIONAL_MIN);
+  scalarRange->InsertNextValue(FRACTIONAL_MAX);
+  labelmap->GetFieldData()->AddArray(scalarRange);
+
+  // Specify the surface threshold value for visualization
+  vtkSmartPointer<vtkDoubleArray> thresholdValue = vtkSmartPointer<vtkDoubleArray>::New();
+  thresholdValue->SetName(vtkSegmentationConverter::GetThresholdValueFieldName());
+  thresholdValue->InsertNextValue((FRACTIONAL_MIN + FRACTIONAL_MAX) / 2.0);
+  labelmap->GetFieldData()->AddArray(thresholdValue);
+
+  // Specify the interpolation type for visualization
+  vtkSmartPointer<vtkIntArray> interpolationType = vtkSmartPointer<vtkIntArray>::New();
+  interpolationType->SetName(vtkSegmentationConverter::GetInterpolationTypeFieldName());
+  interpolationType->InsertNextValue(VTK_LINEAR_INTERPOLATION);
+  labelmap->GetFieldData()->AddArray(interpolationType);
+}
+
+//----------------------------------------------------------------------------
+vtkSegmentationConverterRule* vtkPlanarContourToFractionalLabelmapConversionRule::CreateClosedSurfaceToLabelmapRule()
+{
+  return vtkClosedSurfaceToFractionalLabelmapConversionRule::New();
+}
@@ -0,0 +1,68 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkPlanarContourToFractionalLabelmapConversionRule_h
+#define __vtkPlanarContourToFractionalLabelmapConversionRule_h
+
+// DicomRtImportExport includes
+#include "vtkPlanarContourToBinaryLabelmapConversionRule.h"
+
+#include "vtkSlicerDicomRtImportExportConversionRulesExport.h"
+
+/// \ingroup DicomRtImportImportExportConversionRules
+/// \brief Convert planar contour representation (vtkPolyData type) to fractional
+///   labelmap representation (vtkOrientedImageData type). The conversion algorithm is the same
+///   as the base class \sa vtkPlanarContourToBinaryLabelmapConversionRule, but each voxel is sampled
+///   6x6x6 times, and the voxel value is the number of samples inside the contours, offset so that
+///   the values range from FRACTIONAL_MIN (outside) to FRACTIONAL_MAX (inside), the same as the closed
+///   surface to fractional labelmap conversion.
+class VTK_SLICER_DICOMRTIMPORTEXPORT_CONVERSIONRULES_EXPORT vtkPlanarContourToFractionalLabelmapConversionRule
+  : public vtkPlanarContourToBinaryLabelmapConversionRule
+{
+public:
+  static vtkPlanarContourToFractionalLabelmapConversionRule* New();
+  vtkTypeMacro(vtkPlanarContourToFractionalLabelmapConversionRule, vtkPlanarContourToBinaryLabelmapConversionRule);
+  virtual vtkSegmentationConverterRule* CreateRuleInstance();
+
+  /// Human-readable name of the converter rule
+  virtual const char* GetName() { return "Planar contour to fractional labelmap"; };
+
+  /// Human-readable name of the target representation
+  virtual const char* GetTargetRepresentationName() { return vtkSegmentationConverter::GetSegmentationFractionalLabelmapRepresentationName(); };
+
+protected:
+  /// Number of samples along each axis of a voxel, determining the number of fractional steps
+  virtual int GetNumberOfSamplesPerAxis();
+
+  /// Scalar type of the output labelmap
+  virtual int GetOutputScalarType();
+
+  /// Value of voxels that have no samples inside the contours
+  virtual int GetOutputBackgroundValue();
+
+  /// Add scalar range, threshold value and interpolation type field data used for computation and visualization
+  virtual void AddLabelmapFieldData(vtkOrientedImageData* labelmap);
+
+  /// Create the closed surface to fractional labelmap rule
+  virtual vtkSegmentationConverterRule* CreateClosedSurfaceToLabelmapRule();
+
+protected:
+  vtkPlanarContourToFractionalLabelmapConversionRule();
+  ~vtkPlanarContourToFractionalLabelmapConversionRule();
+  void operator=(const vtkPlanarContourToFractionalLabelmapConversionRule&);
+};
+
+#endif // __vtkPlanarContourToFractionalLabelmapConversionRule_h
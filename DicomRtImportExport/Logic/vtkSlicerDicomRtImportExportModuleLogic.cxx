@@ -27,9 +27,12 @@
 #include "vtkSlicerDicomRtImportExportModuleLogic.h"
 #include "vtkSlicerDicomRtReader.h"
 #include "vtkSlicerDicomRtWriter.h"
+#include "vtkSlicerDicomRtRepresentationCache.h"
 #include "vtkRibbonModelToBinaryLabelmapConversionRule.h"
 #include "vtkPlanarContourToRibbonModelConversionRule.h"
 #include "vtkPlanarContourToClosedSurfaceConversionRule.h"
+#include "vtkPlanarContourToBinaryLabelmapConversionRule.h"
+#include "vtkPlanarContourToFractionalLabelmapConversionRule.h"
 #include "vtkClosedSurfaceToFractionalLabelmapConversionRule.h"
 #include "vtkFractionalLabelmapToClosedSurfaceConversionRule.h"
 
@@ -37,6 +40,8 @@
 #include <ctkDICOMDatabase.h>
 
 // Qt includes
+#include <QDateTime>
+#include <QFileInfo>
 #include <QSettings>
 #include "qSlicerApplication.h"
 
@@ -54,6 +59,8 @@
 #include "vtkSlicerPlanarImageModuleLogic.h"
 #include "vtkSlicerBeamsModuleLogic.h"
 #include "vtkMRMLRTPlanNode.h"
+#include "vtkPolyDataMultiPlaneCutter.h"
+#include "vtkConcurrentJobPool.h"
 #include "vtkMRMLRTBeamNode.h"
 
 // Segmentations includes
@@ -65,6 +72,8 @@
 // vtkSegmentationCore includes
 #include "vtkOrientedImageDataResample.h"
 #include "vtkSegmentationConverterFactory.h"
+#include "vtkSegmentationConverter.h"
+#include "vtkSegment.h"
 
 // DCMTK includes
 #include <dcmtk/dcmdata/dcfilefo.h>
@@ -105,13 +114,19 @@
 #include <vtkObjectFactory.h>
 #include <vtkGeneralTransform.h>
 #include <vtkTransformPolyDataFilter.h>
-#include <vtkCutter.h>
-#include <vtkStripper.h>
-#include <vtkPlane.h>
+#include <vtkMath.h>
+#include <vtkMultiThreader.h>
+#include <vtkSimpleCriticalSection.h>
 
 // ITK includes
 #include <itkImage.h>
 
+// STD includes
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <sstream>
+
 // DICOMLib includes
 #include "vtkSlicerDICOMLoadable.h"
 #include "vtkSlicerDICOMExportable.h"
@@ -122,12 +137,568 @@ vtkCxxSetObjectMacro(vtkSlicerDicomRtImportExportModuleLogic, IsodoseLogic, vtkS
 vtkCxxSetObjectMacro(vtkSlicerDicomRtImportExportModuleLogic, PlanarImageLogic, vtkSlicerPlanarImageModuleLogic);
 vtkCxxSetObjectMacro(vtkSlicerDicomRtImportExportModuleLogic, BeamsLogic, vtkSlicerBeamsModuleLogic);
 
+//----------------------------------------------------------------------------
+/// Planar contour conversion jobs processed by the workers of a job pool
+class vtkPlanarContourConversionJobs
+{
+public:
+  vtkPlanarContourConversionJobs()
+    : Finished(false)
+  {
+  }
+
+  /// Set flag indicating that all jobs have been processed
+  void SetFinished()
+  {
+    this->Lock.Lock();
+    this->Finished = true;
+    this->Lock.Unlock();
+  }
+
+  /// Get flag indicating that all jobs have been processed
+  bool IsFinished()
+  {
+    this->Lock.Lock();
+    bool finished = this->Finished;
+    this->Lock.Unlock();
+    return finished;
+  }
+
+public:
+  /// Target representation name
+  std::string TargetRepresentationName;
+  /// Conversion rule selected by the converter of the segmentation, containing the conversion parameters of the segmentation
+  vtkSmartPointer<vtkSegmentationConverterRule> Rule;
+  /// Copies of \sa Rule used by the workers. Conversion rules are not shared between threads, each element is only used by its worker
+  std::vector<vtkSmartPointer<vtkSegmentationConverterRule> > WorkerRules;
+  /// Planar contour representation of the segments to convert. Only read by the workers
+  std::vector<vtkSmartPointer<vtkPolyData> > PlanarContours;
+  /// Converted representations. Each element is only written by the worker processing the job
+  std::vector<vtkSmartPointer<vtkPolyData> > ConvertedRepresentations;
+  /// Cache the converted representations are loaded from and stored in. Not used if NULL
+  vtkSmartPointer<vtkSlicerDicomRtRepresentationCache> RepresentationCache;
+  /// Keys of the converted representations in \sa RepresentationCache. Empty for segments not loaded from a structure set
+  std::vector<std::string> RepresentationCacheKeys;
+  /// Job pool processing the jobs
+  vtkSmartPointer<vtkConcurrentJobPool> JobPool;
+
+protected:
+  bool Finished;
+  vtkSimpleCriticalSection Lock;
+};
+
+//----------------------------------------------------------------------------
+static void vtkConvertPlanarContours(int jobIndex, int workerIndex, void* userData)
+{
+  vtkPlanarContourConversionJobs* jobs = static_cast<vtkPlanarContourConversionJobs*>(userData);
+  vtkSmartPointer<vtkPolyData> convertedRepresentation = vtkSmartPointer<vtkPolyData>::New();
+
+  // Use the representation converted when the structure set was loaded before, if it is in the cache
+  if ( jobs->RepresentationCache
+    && jobs->RepresentationCache->Load(jobs->RepresentationCacheKeys[jobIndex], convertedRepresentation) )
+  {
+    jobs->ConvertedRepresentations[jobIndex] = convertedRepresentation;
+    return;
+  }
+
+  if (jobs->WorkerRules[workerIndex]->Convert(jobs->PlanarContours[jobIndex], convertedRepresentation))
+  {
+    jobs->ConvertedRepresentations[jobIndex] = convertedRepresentation;
+    if (jobs->RepresentationCache)
+    {
+      jobs->RepresentationCache->Store(jobs->RepresentationCacheKeys[jobIndex], convertedRepresentation);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+/// Create the rule the converter of a segmentation uses to convert its planar contours to a target representation,
+/// and set the conversion parameters of the segmentation in it
+/// \return NULL if the converter does not convert planar contours directly to the target representation
+///   (for example if planar contour is not the master representation)
+static vtkSmartPointer<vtkSegmentationConverterRule> vtkCreatePlanarContourConversionRule(vtkSegmentation* segmentation, const std::string& targetRepresentationName)
+{
+  vtkSegmentationConverter::ConversionPathAndCostListType pathsCosts;
+  segmentation->GetPossibleConversions(targetRepresentationName, pathsCosts);
+  vtkSegmentationConverter::ConversionPathType path = vtkSegmentationConverter::GetCheapestPath(pathsCosts);
+  if ( path.size() != 1
+    || strcmp(path[0]->GetSourceRepresentationName(), vtkSegmentationConverter::GetSegmentationPlanarContourRepresentationName()) )
+  {
+    return NULL;
+  }
+
+  vtkSmartPointer<vtkSegmentationConverterRule> rule = vtkSmartPointer<vtkSegmentationConverterRule>::Take(path[0]->CreateRuleInstance());
+  vtkSegmentationConverterRule::ConversionParameterListType conversionParameters;
+  rule->GetRuleConversionParameters(conversionParameters);
+  for (vtkSegmentationConverterRule::ConversionParameterListType::iterator parameterIt = conversionParameters.begin();
+    parameterIt != conversionParameters.end(); ++parameterIt)
+  {
+    rule->SetConversionParameter(parameterIt->first, segmentation->GetConversionParameter(parameterIt->first), parameterIt->second.second);
+  }
+  return rule;
+}
+
+//----------------------------------------------------------------------------
+/// Get the key of the representation converted from the planar contours of a segment in the representation cache.
+/// The target representation and the parameters of the conversion rule identify the conversion. The size of the
+/// contours is also included, so that the representation is not used if the contours have changed since loading
+/// \return Empty string if the segment has not been loaded from a structure set
+static std::string vtkGetRepresentationCacheKey(vtkSegment* segment, vtkPolyData* planarContours, vtkSegmentationConverterRule* rule)
+{
+  std::string dicomSource("");
+  if (!segment->GetTag(SlicerRtCommon::SEGMENT_DICOM_SOURCE_TAG_NAME, dicomSource))
+  {
+    return "";
+  }
+  size_t separatorPosition = dicomSource.rfind('/');
+  if (separatorPosition == std::string::npos || separatorPosition == 0)
+  {
+    return "";
+  }
+  unsigned int roiNumber = (unsigned int)atoi(dicomSource.substr(separatorPosition + 1).c_str());
+
+  std::stringstream conversionParametersStream;
+  conversionParametersStream << rule->GetTargetRepresentationName() << ";" << planarContours->GetNumberOfPoints() << ";" << planarContours->GetNumberOfCells();
+  vtkSegmentationConverterRule::ConversionParameterListType conversionParameters;
+  rule->GetRuleConversionParameters(conversionParameters);
+  for (vtkSegmentationConverterRule::ConversionParameterListType::iterator parameterIt = conversionParameters.begin();
+    parameterIt != conversionParameters.end(); ++parameterIt)
+  {
+    conversionParametersStream << ";" << parameterIt->first << "=" << parameterIt->second.first;
+  }
+  return vtkSlicerDicomRtRepresentationCache::ComputeKey(dicomSource.substr(0, separatorPosition), roiNumber, conversionParametersStream.str());
+}
+
+//----------------------------------------------------------------------------
+/// Process all conversion jobs on the job pool. Returns when all jobs are processed
+static void vtkRunPlanarContourConversionJobs(vtkPlanarContourConversionJobs* jobs)
+{
+  int numberOfJobs = (int)jobs->PlanarContours.size();
+  jobs->ConvertedRepresentations.resize(numberOfJobs);
+
+  // Each worker converts with its own copy of the rule
+  int numberOfWorkers = jobs->JobPool->GetNumberOfWorkers(numberOfJobs);
+  vtkSegmentationConverterRule::ConversionParameterListType conversionParameters;
+  jobs->Rule->GetRuleConversionParameters(conversionParameters);
+  jobs->WorkerRules.clear();
+  for (int workerIndex = 0; workerIndex < numberOfWorkers; ++workerIndex)
+  {
+    vtkSmartPointer<vtkSegmentationConverterRule> workerRule = vtkSmartPointer<vtkSegmentationConverterRule>::Take(jobs->Rule->CreateRuleInstance());
+    for (vtkSegmentationConverterRule::ConversionParameterListType::iterator parameterIt = conversionParameters.begin();
+      parameterIt != conversionParameters.end(); ++parameterIt)
+    {
+      workerRule->SetConversionParameter(parameterIt->first, parameterIt->second.first, parameterIt->second.second);
+    }
+    // The segments are converted in parallel, so the rule itself does not need to use multiple threads
+    vtkPlanarContourToClosedSurfaceConversionRule* closedSurfaceRule = vtkPlanarContourToClosedSurfaceConversionRule::SafeDownCast(workerRule);
+    if (closedSurfaceRule && numberOfWorkers > 1)
+    {
+      closedSurfaceRule->ConcurrentTriangulationOff();
+    }
+    jobs->WorkerRules.push_back(workerRule);
+  }
+
+  jobs->JobPool->Execute(numberOfJobs, vtkConvertPlanarContours, jobs);
+
+  jobs->SetFinished();
+}
+
+//----------------------------------------------------------------------------
+/// Conversion of deferred segments of a segmentation running in a background thread.
+/// The thread converts copies of the planar contours, so that the segments can be modified during conversion
+class vtkBackgroundPlanarContourConversion
+{
+public:
+  std::string SegmentationNodeID;
+  std::vector<std::string> SegmentIDs;
+  /// Planar contour representations of the segments the copies in \sa Jobs were made of
+  std::vector<vtkSmartPointer<vtkPolyData> > SourcePlanarContours;
+  /// Modification times of \sa SourcePlanarContours when the copies were made
+  std::vector<vtkMTimeType> SourcePlanarContourMTimes;
+  vtkPlanarContourConversionJobs Jobs;
+};
+
+//----------------------------------------------------------------------------
+static VTK_THREAD_RETURN_TYPE vtkBackgroundPlanarContourConversionThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkBackgroundPlanarContourConversion* conversion = static_cast<vtkBackgroundPlanarContourConversion*>(threadInfo->UserData);
+  vtkRunPlanarContourConversionJobs(&conversion->Jobs);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+/// Closed surface slicing jobs of the structure set export processed by the workers of a job pool
+class vtkClosedSurfaceSlicingJobs
+{
+public:
+  vtkClosedSurfaceSlicingJobs()
+    : Spacing(1.0)
+    , NumberOfPlanes(0)
+    , ContourTolerance(0.0)
+    , MaximumContourDeviation(0.0)
+    , Writer(NULL)
+    , FirstPlaneSlice(0)
+    , FirstImageSlice(0)
+    , NextStructureIndex(0)
+  {
+    this->Origin[0] = this->Origin[1] = this->Origin[2] = 0.0;
+    this->Normal[0] = this->Normal[1] = this->Normal[2] = 0.0;
+  }
+
+public:
+  /// Slice planes (see \sa vtkPolyDataMultiPlaneCutter)
+  double Origin[3];
+  double Normal[3];
+  double Spacing;
+  int NumberOfPlanes;
+  /// Tolerance of the contour reduction (see \sa vtkPolyDataMultiPlaneCutter::ContourTolerance)
+  double ContourTolerance;
+  /// Largest distance of a removed contour point from its contour in the structures added to the writer
+  double MaximumContourDeviation;
+  /// Closed surfaces of the segments in world coordinates. Only read by the workers
+  std::vector<vtkSmartPointer<vtkPolyData> > ClosedSurfaces;
+  /// Cutters containing the contours of the segments. Set by the worker processing the job (see \sa SetCutter),
+  /// and released once the contours have been added to the writer
+  std::vector<vtkSmartPointer<vtkPolyDataMultiPlaneCutter> > Cutters;
+
+  /// Writer the structures are added to
+  vtkSlicerDicomRtWriter* Writer;
+  /// Names and colors of the segments, in the order of the jobs
+  std::vector<std::string> SegmentNames;
+  std::vector<double> SegmentColors;
+  /// Instance UIDs of the anatomical image slices
+  std::vector<std::string> ImageSliceUIDs;
+  /// Index of the first slice plane in the anatomical image, and the first slice in the extent of the image
+  int FirstPlaneSlice;
+  int FirstImageSlice;
+
+  /// Store the cutter of a finished job
+  void SetCutter(int jobIndex, vtkPolyDataMultiPlaneCutter* cutter)
+  {
+    this->Lock.Lock();
+    this->Cutters[jobIndex] = cutter;
+    this->Lock.Unlock();
+  }
+
+  /// Add the contours of the finished jobs to the writer in job order, and release them.
+  /// Called by each worker after finishing a job, so that copying the contours into the writer overlaps with slicing and
+  /// only the cutters of the jobs finished out of order are kept in addition to the copies in the writer.
+  void AddFinishedStructures()
+  {
+    this->WriterLock.Lock();
+    for (;;)
+    {
+      this->Lock.Lock();
+      int structureIndex = this->NextStructureIndex;
+      bool finished = (structureIndex < (int)this->Cutters.size() && this->Cutters[structureIndex].GetPointer() != NULL);
+      this->Lock.Unlock();
+      if (!finished)
+      {
+        break;
+      }
+
+      this->AddStructure(structureIndex);
+
+      this->Lock.Lock();
+      this->Cutters[structureIndex] = NULL;
+      ++this->NextStructureIndex;
+      this->Lock.Unlock();
+    }
+    this->WriterLock.Unlock();
+  }
+
+  /// Get number of structures added to the writer
+  int GetNumberOfAddedStructures()
+  {
+    return this->NextStructureIndex;
+  }
+
+protected:
+  /// Add contours of the segment sliced by the given job to the writer
+  void AddStructure(int structureIndex)
+  {
+    vtkPolyDataMultiPlaneCutter* cutter = this->Cutters[structureIndex];
+
+    // Containers to be passed to the writer
+    std::vector<int> sliceNumbers;
+    std::vector<std::string> sliceUIDs;
+    std::vector<vtkPolyData*> sliceContours;
+    for (int planeIndex=0; planeIndex<this->NumberOfPlanes; ++planeIndex)
+    {
+      vtkPolyData* sliceContour = cutter->GetPlaneContours(planeIndex);
+      if (!sliceContour)
+      {
+        // No contours on this slice
+        continue;
+      }
+
+      // Get instance UID of corresponding slice
+      int slice = this->FirstPlaneSlice + planeIndex;
+      int sliceNumber = slice - this->FirstImageSlice;
+      sliceNumbers.push_back(sliceNumber);
+      std::string sliceInstanceUID = (this->ImageSliceUIDs.size() > sliceNumber ? this->ImageSliceUIDs[sliceNumber] : "");
+      sliceUIDs.push_back(sliceInstanceUID);
+      sliceContours.push_back(sliceContour);
+    } // For each anatomical image slice
+
+    this->Writer->AddStructure(this->SegmentNames[structureIndex].c_str(), &this->SegmentColors[3*structureIndex],
+      sliceNumbers, sliceUIDs, sliceContours);
+    this->MaximumContourDeviation = std::max(this->MaximumContourDeviation, cutter->GetMaximumContourDeviation());
+  }
+
+protected:
+  /// Lock protecting \sa Cutters and \sa NextStructureIndex
+  vtkSimpleCriticalSection Lock;
+  /// Index of the next structure to add to the writer
+  int NextStructureIndex;
+  /// Lock serializing the access to the writer
+  vtkSimpleCriticalSection WriterLock;
+};
+
+//----------------------------------------------------------------------------
+static void vtkSliceClosedSurface(int jobIndex, int vtkNotUsed(workerIndex), void* userData)
+{
+  vtkClosedSurfaceSlicingJobs* jobs = static_cast<vtkClosedSurfaceSlicingJobs*>(userData);
+
+  vtkSmartPointer<vtkPolyDataMultiPlaneCutter> cutter = vtkSmartPointer<vtkPolyDataMultiPlaneCutter>::New();
+  cutter->SetInputPolyData(jobs->ClosedSurfaces[jobIndex]);
+  cutter->SetOrigin(jobs->Origin);
+  cutter->SetNormal(jobs->Normal);
+  cutter->SetSpacing(jobs->Spacing);
+  cutter->SetNumberOfPlanes(jobs->NumberOfPlanes);
+  cutter->SetContourTolerance(jobs->ContourTolerance);
+  cutter->Update();
+  cutter->SetInputPolyData(NULL);
+  // The contours are written as closed polygons, which only follow the surface if it is closed and manifold
+  if (cutter->GetNumberOfNonManifoldEdges() > 0 || cutter->GetNumberOfOpenContours() > 0)
+  {
+    vtkGenericWarningMacro("vtkSliceClosedSurface: Closed surface of segment " << jobs->SegmentNames[jobIndex] << " is not a closed manifold ("
+      << cutter->GetNumberOfNonManifoldEdges() << " non-manifold edge crossings, " << cutter->GetNumberOfOpenContours()
+      << " open contours), the exported contours may not follow the surface");
+  }
+  jobs->SetCutter(jobIndex, cutter);
+
+  // Add the contours to the writer if all the preceding structures have been added
+  jobs->AddFinishedStructures();
+}
+
+//----------------------------------------------------------------------------
+/// Binary labelmap preparation jobs of the structure set export processed by the workers of a job pool
+class vtkLabelmapExportJobs
+{
+public:
+  vtkLabelmapExportJobs()
+    : ReferenceImage(NULL)
+    , Writer(NULL)
+    , NextStructureIndex(0)
+    , Aborted(false)
+  {
+  }
+
+public:
+  /// Anatomical image that defines the geometry of the exported labelmaps. Only read by the workers
+  vtkOrientedImageData* ReferenceImage;
+  /// Binary labelmaps of the segments. Only read by the workers
+  std::vector<vtkOrientedImageData*> BinaryLabelmaps;
+  /// Transforms from segmentation to world for each job, NULL if the segmentation is not transformed.
+  /// Each job has its own transform instance so that the workers do not share transform state
+  std::vector<vtkSmartPointer<vtkGeneralTransform> > NodeToWorldTransforms;
+  /// Labelmaps in Plastimatch format resampled to the reference geometry. Set by the worker processing the job
+  /// (see \sa SetResult), and released once the labelmap has been added to the writer
+  std::vector<Plm_image::Pointer> PlmStructures;
+  /// Error message of each job, empty if the job succeeded. Set by the worker processing the job (see \sa SetResult)
+  std::vector<std::string> Errors;
+
+  /// Writer the structures are added to
+  vtkSlicerDicomRtWriter* Writer;
+  /// Names and colors of the segments, in the order of the jobs
+  std::vector<std::string> SegmentNames;
+  std::vector<double> SegmentColors;
+
+  /// Store the result of a finished job
+  void SetResult(int jobIndex, Plm_image::Pointer plmStructure, const std::string& error)
+  {
+    this->Lock.Lock();
+    this->PlmStructures[jobIndex] = plmStructure;
+    this->Errors[jobIndex] = error;
+    this->Lock.Unlock();
+  }
+
+  /// Add the labelmaps of the finished jobs to the writer in job order, and release them. Called by each worker
+  /// after finishing a job, so that only the labelmaps of the jobs finished out of order are kept in memory.
+  /// The remaining jobs are aborted when reaching a failed job, as the export fails.
+  void AddFinishedStructures()
+  {
+    this->WriterLock.Lock();
+    for (;;)
+    {
+      this->Lock.Lock();
+      int structureIndex = this->NextStructureIndex;
+      bool finished = (structureIndex < (int)this->PlmStructures.size() && this->PlmStructures[structureIndex].get() != NULL);
+      if (structureIndex < (int)this->Errors.size() && !this->Errors[structureIndex].empty())
+      {
+        this->Aborted = true;
+        for (unsigned int jobIndex = structureIndex; jobIndex < this->PlmStructures.size(); ++jobIndex)
+        {
+          this->PlmStructures[jobIndex].reset();
+        }
+      }
+      this->Lock.Unlock();
+      if (!finished)
+      {
+        break;
+      }
+
+      this->Writer->AddStructure(this->PlmStructures[structureIndex]->itk_uchar(),
+        this->SegmentNames[structureIndex].c_str(), &this->SegmentColors[3*structureIndex]);
+
+      this->Lock.Lock();
+      this->PlmStructures[structureIndex].reset();
+      ++this->NextStructureIndex;
+      this->Lock.Unlock();
+    }
+    this->WriterLock.Unlock();
+  }
+
+  /// Get flag indicating that a job failed, so the remaining jobs do not need to be processed
+  bool IsAborted()
+  {
+    this->Lock.Lock();
+    bool aborted = this->Aborted;
+    this->Lock.Unlock();
+    return aborted;
+  }
+
+  /// Get number of structures added to the writer
+  int GetNumberOfAddedStructures()
+  {
+    return this->NextStructureIndex;
+  }
+
+protected:
+  /// Lock protecting \sa PlmStructures, \sa Errors, \sa NextStructureIndex and \sa Aborted
+  vtkSimpleCriticalSection Lock;
+  /// Index of the next structure to add to the writer
+  int NextStructureIndex;
+  /// Flag set when the next structure to add to the writer failed
+  bool Aborted;
+  /// Lock serializing the access to the writer
+  vtkSimpleCriticalSection WriterLock;
+};
+
+//----------------------------------------------------------------------------
+static Plm_image::Pointer vtkPrepareLabelmapForExport(vtkLabelmapExportJobs* jobs, int jobIndex, std::string& error)
+{
+  // Temporarily copy labelmap image data as it will be probably resampled
+  vtkSmartPointer<vtkOrientedImageData> binaryLabelmapCopy = vtkSmartPointer<vtkOrientedImageData>::New();
+  binaryLabelmapCopy->DeepCopy(jobs->BinaryLabelmaps[jobIndex]);
+
+  // Apply parent transformation if necessary
+  if (jobs->NodeToWorldTransforms[jobIndex])
+  {
+    vtkOrientedImageDataResample::TransformOrientedImage(binaryLabelmapCopy, jobs->NodeToWorldTransforms[jobIndex]);
+  }
+  // Make sure the labelmap dimensions match the reference dimensions
+  if ( !vtkOrientedImageDataResample::DoGeometriesMatch(jobs->ReferenceImage, binaryLabelmapCopy)
+    || !vtkOrientedImageDataResample::DoExtentsMatch(jobs->ReferenceImage, binaryLabelmapCopy) )
+  {
+    if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(binaryLabelmapCopy, jobs->ReferenceImage, binaryLabelmapCopy))
+    {
+      error = "Failed to resample segment to match anatomical image geometry";
+      return Plm_image::Pointer();
+    }
+  }
+
+  // Convert mask to Plm image. The unsigned char image used by the writer is created here as well
+  Plm_image::Pointer plmStructure = PlmCommon::ConvertVtkOrientedImageDataToPlmImage(binaryLabelmapCopy);
+  if (!plmStructure)
+  {
+    error = "Failed to convert segment labelmap to Plastimatch image";
+    return Plm_image::Pointer();
+  }
+  plmStructure->itk_uchar();
+  return plmStructure;
+}
+
+//----------------------------------------------------------------------------
+static void vtkExportLabelmap(int jobIndex, int vtkNotUsed(workerIndex), void* userData)
+{
+  vtkLabelmapExportJobs* jobs = static_cast<vtkLabelmapExportJobs*>(userData);
+  if (jobs->IsAborted())
+  {
+    return;
+  }
+
+  std::string error("");
+  Plm_image::Pointer plmStructure = vtkPrepareLabelmapForExport(jobs, jobIndex, error);
+  jobs->SetResult(jobIndex, plmStructure, error);
+  plmStructure.reset();
+
+  // Add the labelmap to the writer if all the preceding structures have been added
+  jobs->AddFinishedStructures();
+}
+
 //----------------------------------------------------------------------------
 class vtkSlicerDicomRtImportExportModuleLogic::vtkInternal
 {
 public:
   vtkInternal(vtkSlicerDicomRtImportExportModuleLogic* external);
-  ~vtkInternal() { };
+  ~vtkInternal();
+
+  /// Result of examining a file for a loadable RT object
+  class ExamineResult
+  {
+  public:
+    ExamineResult() : ModifiedTime(0), FileSize(0), Loadable(false) { };
+    /// Modification time (milliseconds since epoch) of the file when it was examined
+    qint64 ModifiedTime;
+    /// Size of the file when it was examined
+    qint64 FileSize;
+    /// Flag indicating whether the file contains a supported RT object
+    bool Loadable;
+    /// Name of the loadable
+    std::string Name;
+    /// SOP instance UIDs referenced by the RT object
+    std::vector<std::string> ReferencedSOPInstanceUIDs;
+    /// SOP instance UID of the RT plan referenced by an RT dose. The label of the plan is added to the name
+    /// from the DICOM database when the loadable is created, so it is not part of the cached name
+    std::string ReferencedRtPlanSOPInstanceUID;
+  };
+
+  /// Files to examine by the workers of a job pool
+  class ExamineJobs
+  {
+  public:
+    ExamineJobs() : Internal(NULL), HeaderOnly(true) { };
+
+  public:
+    /// Internal object of the logic holding the examine cache
+    vtkInternal* Internal;
+    /// Only read the attributes needed for examination
+    bool HeaderOnly;
+    /// Files to examine. Only read by the workers
+    std::vector<std::string> FileNames;
+    /// Examine results. Each element is only written by the worker processing the job
+    std::vector<ExamineResult> Results;
+  };
+
+  /// Job function examining a file of an \sa ExamineJobs object
+  static void ExamineJob(int jobIndex, int workerIndex, void* jobs);
+
+  /// Get examine result of a file from the cache, or examine the file and cache its result if the file has changed
+  /// since it was last examined. Called from the examine worker threads
+  void GetExamineResult(const std::string& fileName, bool headerOnly, ExamineResult& result);
+
+  /// Examine a DICOM file and determine whether it contains a supported RT object
+  /// \param fileName Path of the file to examine
+  /// \param headerOnly Only read the attributes needed for examination (see \sa HeaderOnlyExamine)
+  /// \param result Output examine result. Modification time and file size are not set
+  void ExamineFile(const std::string& fileName, bool headerOnly, ExamineResult& result);
+
+  /// Add the labels of the referenced RT plans to the names of the RT dose examine results.
+  /// The DICOM database connection is opened once for all results, on the calling (main) thread
+  void AddReferencedRtPlanLabels(std::vector<ExamineResult>& results);
 
   /// Examine RT Dose dataset and assemble name and referenced SOP instances
   void ExamineRtDoseDataset(DcmDataset* dataset, OFString &name, std::vector<OFString> &referencedSOPInstanceUIDs);
@@ -168,8 +739,54 @@ public:
   ///    loading an RT image and when loading a beam. Sets up the RT image geometry only if both information (the image itself and the isocenter data) are available
   void SetupRtImageGeometry(vtkMRMLNode* node);
 
+  /// Determine whether a structure is hidden after loading based on its RT ROI interpreted type.
+  /// Structures not used for planning and evaluation (couch, fixation devices, markers, etc.) are hidden
+  bool IsStructureHiddenByDefault(const char* interpretedType);
+
+  /// Create job pool for planar contour conversion with the configured number of workers
+  /// (see \sa MaximumNumberOfConversionWorkers)
+  vtkSmartPointer<vtkConcurrentJobPool> CreateConversionJobPool();
+
+  /// Get the representation cache in the configured directory
+  /// \return NULL if caching is disabled (see \sa RepresentationCacheDirectory)
+  vtkSlicerDicomRtRepresentationCache* GetRepresentationCache();
+
+
+  /// Start background conversion of the deferred segments of the first segmentation in the queue,
+  /// if no background conversion is in progress
+  void StartBackgroundConversion();
+
+  /// Add the representations converted in the background to the segments if the conversion has finished
+  /// \return True if the background conversion finished and its results have been processed
+  bool FinishBackgroundConversion();
+
+  /// Request background conversion of a segmentation if any of its deferred segments is shown by a display node
+  void RequestDeferredConversionIfShown(vtkMRMLSegmentationDisplayNode* displayNode);
+
 public:
   vtkSlicerDicomRtImportExportModuleLogic* External;
+
+  /// IDs of the segmentation nodes requested for background conversion of their deferred segments
+  std::deque<std::string> RequestedDeferredSegmentations;
+
+  /// Background conversion in progress, NULL if none
+  vtkBackgroundPlanarContourConversion* BackgroundConversion;
+
+  /// Threader running the background conversion
+  vtkSmartPointer<vtkMultiThreader> BackgroundConversionThreader;
+
+  /// Thread ID of the background conversion in \sa BackgroundConversionThreader
+  int BackgroundConversionThreadID;
+
+  /// Examine results by file path. An entry is only used if the modification time and size of the file are unchanged
+  std::map<std::string, ExamineResult> ExamineCache;
+
+  /// Lock guarding \sa ExamineCache against concurrent access by the examine workers
+  vtkSimpleCriticalSection ExamineCacheLock;
+
+  /// Representation cache in the last used cache directory. Replaced instead of modified when the directory changes,
+  /// as the background conversion may still be using it
+  vtkSmartPointer<vtkSlicerDicomRtRepresentationCache> RepresentationCache;
 };
 
 //----------------------------------------------------------------------------
@@ -178,7 +795,192 @@ public:
 //----------------------------------------------------------------------------
 vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::vtkInternal(vtkSlicerDicomRtImportExportModuleLogic* external)
   : External(external)
+  , BackgroundConversion(NULL)
+  , BackgroundConversionThreadID(-1)
+{
+  this->BackgroundConversionThreader = vtkSmartPointer<vtkMultiThreader>::New();
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::~vtkInternal()
 {
+  if (this->BackgroundConversion)
+  {
+    // Wait for the background conversion to finish, as it uses the conversion object
+    this->BackgroundConversionThreader->TerminateThread(this->BackgroundConversionThreadID);
+    delete this->BackgroundConversion;
+    this->BackgroundConversion = NULL;
+  }
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineJob(int jobIndex, int vtkNotUsed(workerIndex), void* jobs)
+{
+  ExamineJobs* examineJobs = static_cast<ExamineJobs*>(jobs);
+  examineJobs->Internal->GetExamineResult(examineJobs->FileNames[jobIndex], examineJobs->HeaderOnly, examineJobs->Results[jobIndex]);
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::GetExamineResult(const std::string& fileName, bool headerOnly, ExamineResult& result)
+{
+  // Use the cached examine result if the file has not changed since it was examined
+  QFileInfo fileInfo(fileName.c_str());
+  qint64 modifiedTime = fileInfo.lastModified().toMSecsSinceEpoch();
+  qint64 fileSize = fileInfo.size();
+  this->ExamineCacheLock.Lock();
+  std::map<std::string, ExamineResult>::iterator cacheIt = this->ExamineCache.find(fileName);
+  bool cached = ( cacheIt != this->ExamineCache.end()
+    && cacheIt->second.ModifiedTime == modifiedTime && cacheIt->second.FileSize == fileSize );
+  if (cached)
+  {
+    result = cacheIt->second;
+  }
+  this->ExamineCacheLock.Unlock();
+  if (cached)
+  {
+    return;
+  }
+
+  // Parse the file outside the lock so that the workers read files in parallel
+  this->ExamineFile(fileName, headerOnly, result);
+  result.ModifiedTime = modifiedTime;
+  result.FileSize = fileSize;
+
+  this->ExamineCacheLock.Lock();
+  this->ExamineCache[fileName] = result;
+  this->ExamineCacheLock.Unlock();
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineFile(const std::string& fileName, bool headerOnly, ExamineResult& result)
+{
+  result.Loadable = false;
+  result.Name.clear();
+  result.ReferencedSOPInstanceUIDs.clear();
+  result.ReferencedRtPlanSOPInstanceUID.clear();
+
+  // Load file in DCMTK
+  DcmFileFormat fileformat;
+  OFCondition condition;
+  if (headerOnly)
+  {
+    // Only the identifiers and labels are needed, so longer values (pixel data, contour data, etc.) are not read.
+    // Parsing of structure sets stops at the ROI contour sequence, as the referenced instances are also found in
+    // the referenced frame of reference sequence preceding it
+    const Uint32 maxReadLength = 256;
+    condition = fileformat.loadFileUntilTag(fileName.c_str(), EXS_Unknown, EGL_noChange, maxReadLength,
+      ERM_autoDetect, DCM_ROIContourSequence);
+  }
+  else
+  {
+    condition = fileformat.loadFile(fileName.c_str(), EXS_Unknown);
+  }
+  if (!condition.good())
+  {
+    return; // Failed to parse this file, skip it
+  }
+
+  // Check SOP Class UID for one of the supported RT objects
+  DcmDataset *dataset = fileformat.getDataset();
+  OFString sopClass;
+  if (!dataset->findAndGetOFString(DCM_SOPClassUID, sopClass).good() || sopClass.empty())
+  {
+    return; // Failed to parse this file, skip it
+  }
+
+  // DICOM parsing is successful, now check if the object is loadable
+  OFString name("");
+  OFString seriesNumber("");
+  std::vector<OFString> referencedSOPInstanceUIDs;
+  dataset->findAndGetOFString(DCM_SeriesNumber, seriesNumber);
+  if (!seriesNumber.empty())
+  {
+    name += seriesNumber + ": ";
+  }
+
+  // RTDose
+  if (sopClass == UID_RTDoseStorage)
+  {
+    this->ExamineRtDoseDataset(dataset, name, referencedSOPInstanceUIDs);
+    if (!referencedSOPInstanceUIDs.empty())
+    {
+      // The referenced plan is the only instance referenced by a dose
+      result.ReferencedRtPlanSOPInstanceUID = referencedSOPInstanceUIDs[0].c_str();
+    }
+  }
+  // RTPlan
+  else if (sopClass == UID_RTPlanStorage)
+  {
+    this->ExamineRtPlanDataset(dataset, name, referencedSOPInstanceUIDs);
+  }
+  // RTStructureSet
+  else if (sopClass == UID_RTStructureSetStorage)
+  {
+    this->ExamineRtStructureSetDataset(dataset, name, referencedSOPInstanceUIDs);
+  }
+  // RTImage
+  else if (sopClass == UID_RTImageStorage)
+  {
+    this->ExamineRtImageDataset(dataset, name, referencedSOPInstanceUIDs);
+  }
+  /* Not yet supported
+  else if (sopClass == UID_RTTreatmentSummaryRecordStorage)
+  else if (sopClass == UID_RTIonPlanStorage)
+  else if (sopClass == UID_RTIonBeamsTreatmentRecordStorage)
+  */
+  else
+  {
+    return; // Not an RT file
+  }
+
+  result.Loadable = true;
+  result.Name = name.c_str();
+  std::vector<OFString>::iterator uidIt;
+  for (uidIt = referencedSOPInstanceUIDs.begin(); uidIt != referencedSOPInstanceUIDs.end(); ++uidIt)
+  {
+    result.ReferencedSOPInstanceUIDs.push_back(uidIt->c_str());
+  }
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::AddReferencedRtPlanLabels(std::vector<ExamineResult>& results)
+{
+  ctkDICOMDatabase* dicomDatabase = NULL;
+  std::vector<ExamineResult>::iterator resultIt;
+  for (resultIt = results.begin(); resultIt != results.end(); ++resultIt)
+  {
+    if (!resultIt->Loadable || resultIt->ReferencedRtPlanSOPInstanceUID.empty())
+    {
+      continue;
+    }
+
+    // Create and open DICOM database to perform database operations for getting RTPlan name
+    if (!dicomDatabase)
+    {
+      QSettings settings;
+      QString databaseDirectory = settings.value("DatabaseDirectory").toString();
+      QString databaseFile = databaseDirectory + vtkSlicerDicomRtReader::DICOMRTREADER_DICOM_DATABASE_FILENAME.c_str();
+      dicomDatabase = new ctkDICOMDatabase();
+      dicomDatabase->openDatabase(databaseFile, vtkSlicerDicomRtReader::DICOMRTREADER_DICOM_CONNECTION_NAME.c_str());
+    }
+
+    // Get RTPlan name to show it with the dose
+    QString rtPlanLabelTag("300a,0002");
+    QString rtPlanFileName = dicomDatabase->fileForInstance(resultIt->ReferencedRtPlanSOPInstanceUID.c_str());
+    if (!rtPlanFileName.isEmpty())
+    {
+      resultIt->Name += std::string(": ") + dicomDatabase->fileValue(rtPlanFileName,rtPlanLabelTag).toLatin1().constData();
+    }
+  }
+
+  // Close and delete DICOM database
+  if (dicomDatabase)
+  {
+    dicomDatabase->closeDatabase();
+    delete dicomDatabase;
+    QSqlDatabase::removeDatabase(vtkSlicerDicomRtReader::DICOMRTREADER_DICOM_CONNECTION_NAME.c_str());
+    QSqlDatabase::removeDatabase(QString(vtkSlicerDicomRtReader::DICOMRTREADER_DICOM_CONNECTION_NAME.c_str()) + "TagCache");
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -222,27 +1024,6 @@ void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineRtDoseDataset(
       }
     }
   }
-
-  // Create and open DICOM database to perform database operations for getting RTPlan name
-  QSettings settings;
-  QString databaseDirectory = settings.value("DatabaseDirectory").toString();
-  QString databaseFile = databaseDirectory + vtkSlicerDicomRtReader::DICOMRTREADER_DICOM_DATABASE_FILENAME.c_str();
-  ctkDICOMDatabase* dicomDatabase = new ctkDICOMDatabase();
-  dicomDatabase->openDatabase(databaseFile, vtkSlicerDicomRtReader::DICOMRTREADER_DICOM_CONNECTION_NAME.c_str());
-
-  // Get RTPlan name to show it with the dose
-  QString rtPlanLabelTag("300a,0002");
-  QString rtPlanFileName = dicomDatabase->fileForInstance(referencedSOPInstanceUID.c_str());
-  if (!rtPlanFileName.isEmpty())
-  {
-    name += OFString(": ") + OFString(dicomDatabase->fileValue(rtPlanFileName,rtPlanLabelTag).toLatin1().constData());
-  }
-
-  // Close and delete DICOM database
-  dicomDatabase->closeDatabase();
-  delete dicomDatabase;
-  QSqlDatabase::removeDatabase(vtkSlicerDicomRtReader::DICOMRTREADER_DICOM_CONNECTION_NAME.c_str());
-  QSqlDatabase::removeDatabase(QString(vtkSlicerDicomRtReader::DICOMRTREADER_DICOM_CONNECTION_NAME.c_str()) + "TagCache");
 }
 
 //-----------------------------------------------------------------------------
@@ -439,56 +1220,62 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtDose(vtkSlicerD
   const char* fileName = loadable->GetFiles()->GetValue(0);
   const char* seriesName = loadable->GetName();
 
-  // Load Volume
-  vtkSmartPointer<vtkMRMLVolumeArchetypeStorageNode> volumeStorageNode = vtkSmartPointer<vtkMRMLVolumeArchetypeStorageNode>::New();
   vtkSmartPointer<vtkMRMLScalarVolumeNode> volumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
-  volumeStorageNode->SetFileName(fileName);
-  volumeStorageNode->ResetFileNameList();
-  volumeStorageNode->SetSingleFile(1);
-
-  // Read volume from disk
-  if (!volumeStorageNode->ReadData(volumeNode))
+  if (!rtReader->GetDoseGridScaling())
   {
-    vtkErrorWithObjectMacro(this->External, "LoadRtDose: Failed to load dose volume file '" << fileName << "' (series name '" << seriesName << "')");
-    return false;
+    vtkErrorWithObjectMacro(this->External, "LoadRtDose: Empty dose unit value found for dose volume " << seriesName);
   }
+  double doseGridScaling = vtkVariant(rtReader->GetDoseGridScaling()).ToDouble();
 
-  volumeNode->SetScene(this->External->GetMRMLScene());
-  std::string volumeNodeName = scene->GenerateUniqueName(seriesName);
-  volumeNode->SetName(volumeNodeName.c_str());
-
-  // Set new spacing
-  double* initialSpacing = volumeNode->GetSpacing();
-  double* correctSpacing = rtReader->GetPixelSpacing();
-  volumeNode->SetSpacing(correctSpacing[0], correctSpacing[1], initialSpacing[2]);
-  volumeNode->SetAttribute(SlicerRtCommon::DICOMRTIMPORT_DOSE_VOLUME_IDENTIFIER_ATTRIBUTE_NAME.c_str(), "1");
-  scene->AddNode(volumeNode);
-
-  // Apply dose grid scaling
-  if (!rtReader->GetDoseGridScaling())
+  if (rtReader->GetDoseImageData())
   {
-    vtkErrorWithObjectMacro(this->External, "LoadRtDose: Empty dose unit value found for dose volume " << volumeNode->GetName());
+    // Dose has been loaded directly from the mapped pixel data with the dose grid scaling applied
+    volumeNode->SetIJKToRASMatrix(rtReader->GetDoseIJKToRASMatrix());
+    volumeNode->SetAndObserveImageData(rtReader->GetDoseImageData());
   }
-  double doseGridScaling = vtkVariant(rtReader->GetDoseGridScaling()).ToDouble();
+  else
+  {
+    // Load Volume
+    vtkSmartPointer<vtkMRMLVolumeArchetypeStorageNode> volumeStorageNode = vtkSmartPointer<vtkMRMLVolumeArchetypeStorageNode>::New();
+    volumeStorageNode->SetFileName(fileName);
+    volumeStorageNode->ResetFileNameList();
+    volumeStorageNode->SetSingleFile(1);
 
-  vtkSmartPointer<vtkImageData> floatVolumeData = vtkSmartPointer<vtkImageData>::New();
+    // Read volume from disk
+    if (!volumeStorageNode->ReadData(volumeNode))
+    {
+      vtkErrorWithObjectMacro(this->External, "LoadRtDose: Failed to load dose volume file '" << fileName << "' (series name '" << seriesName << "')");
+      return false;
+    }
 
-  vtkSmartPointer<vtkImageCast> imageCast = vtkSmartPointer<vtkImageCast>::New();
-  imageCast->SetInputData(volumeNode->GetImageData());
-  imageCast->SetOutputScalarTypeToFloat();
-  imageCast->Update();
-  floatVolumeData->DeepCopy(imageCast->GetOutput());
+    // Set new spacing
+    double* initialSpacing = volumeNode->GetSpacing();
+    double* correctSpacing = rtReader->GetPixelSpacing();
+    volumeNode->SetSpacing(correctSpacing[0], correctSpacing[1], initialSpacing[2]);
 
-  float value = 0.0;
-  float* floatPtr = (float*)floatVolumeData->GetScalarPointer();
-  for (long i=0; i<floatVolumeData->GetNumberOfPoints(); ++i)
-  {
-    value = (*floatPtr) * doseGridScaling;
-    (*floatPtr) = value;
-    ++floatPtr;
+    // Apply dose grid scaling in place on the cast volume
+    vtkSmartPointer<vtkImageCast> imageCast = vtkSmartPointer<vtkImageCast>::New();
+    imageCast->SetInputData(volumeNode->GetImageData());
+    imageCast->SetOutputScalarTypeToFloat();
+    imageCast->Update();
+    vtkSmartPointer<vtkImageData> floatVolumeData = vtkSmartPointer<vtkImageData>::New();
+    floatVolumeData->ShallowCopy(imageCast->GetOutput());
+
+    float* floatPtr = (float*)floatVolumeData->GetScalarPointer();
+    for (vtkIdType i=0; i<floatVolumeData->GetNumberOfPoints(); ++i)
+    {
+      (*floatPtr) = (*floatPtr) * doseGridScaling;
+      ++floatPtr;
+    }
+
+    volumeNode->SetAndObserveImageData(floatVolumeData);
   }
 
-  volumeNode->SetAndObserveImageData(floatVolumeData);
+  volumeNode->SetScene(this->External->GetMRMLScene());
+  std::string volumeNodeName = scene->GenerateUniqueName(seriesName);
+  volumeNode->SetName(volumeNodeName.c_str());
+  volumeNode->SetAttribute(SlicerRtCommon::DICOMRTIMPORT_DOSE_VOLUME_IDENTIFIER_ATTRIBUTE_NAME.c_str(), "1");
+  scene->AddNode(volumeNode);
 
   // Get default isodose color table and default dose color table
   vtkMRMLColorTableNode* defaultIsodoseColorTable = vtkSlicerIsodoseModuleLogic::CreateDefaultIsodoseColorTable(scene);
@@ -815,6 +1602,7 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtStructureSet(vt
   vtkIdType segmentationShItemID = vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID;
   vtkSmartPointer<vtkMRMLSegmentationNode> segmentationNode;
   vtkSmartPointer<vtkMRMLSegmentationDisplayNode> segmentationDisplayNode;
+  bool hasHiddenStructures = false;
 
   const char* fileName = loadable->GetFiles()->GetValue(0);
   const char* seriesName = loadable->GetName();
@@ -946,7 +1734,23 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtStructureSet(vt
       segment->SetName(roiLabel);
       segment->SetColor(roiColor[0], roiColor[1], roiColor[2]);
       segment->AddRepresentation(vtkSegmentationConverter::GetSegmentationPlanarContourRepresentationName(), roiPolyData);
+      if (rtReader->GetSOPInstanceUID())
+      {
+        // Identifies the converted representations of the segment in the representation cache
+        std::stringstream dicomSourceStream;
+        dicomSourceStream << rtReader->GetSOPInstanceUID() << "/" << rtReader->GetRoiNumber(internalROIIndex);
+        segment->SetTag(SlicerRtCommon::SEGMENT_DICOM_SOURCE_TAG_NAME, dicomSourceStream.str());
+      }
       segmentationNode->GetSegmentation()->AddSegment(segment);
+
+      // Hide structures not used for planning and evaluation if requested, so that their conversion can be deferred
+      std::string segmentID = segmentationNode->GetSegmentation()->GetSegmentIdBySegment(segment);
+      if ( this->External->DeferConversionOfHiddenStructures
+        && this->IsStructureHiddenByDefault(rtReader->GetRoiInterpretedType(internalROIIndex)) )
+      {
+        segmentationDisplayNode->SetSegmentVisibility(segmentID, false);
+        hasHiddenStructures = true;
+      }
     }
   } // for all ROIs
 
@@ -958,6 +1762,18 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtStructureSet(vt
     vtkDebugWithObjectMacro(this->External, "LoadRtStructureSet: Maximum number of points in a segment = " << maximumNumberOfPoints << ", Total number of points in segmentation = " << totalNumberOfPoints);
     if (maximumNumberOfPoints < 800000 && totalNumberOfPoints < 3000000)
     {
+      // Convert structures at once using multiple threads, so that the display does not need to convert them one by one.
+      // If there are hidden structures, then the whole structure set is converted in the background instead, as
+      // converting only the shown structures would leave the segmentation with a partially contained representation
+      if (hasHiddenStructures)
+      {
+        this->External->DeferPlanarContourConversion(segmentationNode, vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName());
+      }
+      else
+      {
+        this->External->ConvertPlanarContoursConcurrently(segmentationNode, vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName());
+      }
+
       segmentationDisplayNode->SetPreferredDisplayRepresentationName3D(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName());
       segmentationDisplayNode->SetPreferredDisplayRepresentationName2D(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName());
       segmentationDisplayNode->CalculateAutoOpacitiesForSegments();
@@ -1468,31 +2284,259 @@ void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::SetupRtImageGeometry(
   isocenterToRtImageRas->Concatenate(iecToLpsTransform); // LPS = IJK
   isocenterToRtImageRas->Concatenate(rtImageIjkToRtImageRasTransformMatrix);
 
-  // Transform RT image to proper position and orientation
-  rtImageVolumeNode->SetIJKToRASMatrix(isocenterToRtImageRas->GetMatrix());
+  // Transform RT image to proper position and orientation
+  rtImageVolumeNode->SetIJKToRASMatrix(isocenterToRtImageRas->GetMatrix());
+
+  // Set up outputs for the planar image display
+  vtkSmartPointer<vtkMRMLModelNode> displayedModelNode = vtkSmartPointer<vtkMRMLModelNode>::New();
+  this->External->GetMRMLScene()->AddNode(displayedModelNode);
+  std::string displayedModelNodeName = vtkMRMLPlanarImageNode::PLANARIMAGE_MODEL_NODE_NAME_PREFIX + std::string(rtImageVolumeNode->GetName());
+  displayedModelNode->SetName(displayedModelNodeName.c_str());
+  displayedModelNode->SetAttribute(vtkMRMLSubjectHierarchyConstants::GetSubjectHierarchyExcludeFromTreeAttributeName().c_str(), "1");
+
+  // Create PlanarImage parameter set node
+  std::string planarImageParameterSetNodeName;
+  planarImageParameterSetNodeName = this->External->GetMRMLScene()->GenerateUniqueName(
+    vtkMRMLPlanarImageNode::PLANARIMAGE_PARAMETER_SET_BASE_NAME_PREFIX + std::string(rtImageVolumeNode->GetName()) );
+  vtkSmartPointer<vtkMRMLPlanarImageNode> planarImageParameterSetNode = vtkSmartPointer<vtkMRMLPlanarImageNode>::New();
+  planarImageParameterSetNode->SetName(planarImageParameterSetNodeName.c_str());
+  this->External->GetMRMLScene()->AddNode(planarImageParameterSetNode);
+  planarImageParameterSetNode->SetAndObserveRtImageVolumeNode(rtImageVolumeNode);
+  planarImageParameterSetNode->SetAndObserveDisplayedModelNode(displayedModelNode);
+
+  // Create planar image model for the RT image
+  this->External->PlanarImageLogic->CreateModelForPlanarImage(planarImageParameterSetNode);
+
+  // Hide the displayed planar image model by default
+  displayedModelNode->SetDisplayVisibility(0);
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::IsStructureHiddenByDefault(const char* interpretedType)
+{
+  if (!interpretedType)
+  {
+    return false;
+  }
+  return !STRCASECMP(interpretedType, "SUPPORT")
+    || !STRCASECMP(interpretedType, "FIXATION")
+    || !STRCASECMP(interpretedType, "MARKER")
+    || !STRCASECMP(interpretedType, "REGISTRATION")
+    || !STRCASECMP(interpretedType, "CONTROL");
+}
+
+//---------------------------------------------------------------------------
+vtkSmartPointer<vtkConcurrentJobPool> vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::CreateConversionJobPool()
+{
+  vtkSmartPointer<vtkConcurrentJobPool> jobPool = vtkSmartPointer<vtkConcurrentJobPool>::New();
+  jobPool->SetMaximumNumberOfWorkers(this->External->MaximumNumberOfConversionWorkers);
+  return jobPool;
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerDicomRtRepresentationCache* vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::GetRepresentationCache()
+{
+  const char* cacheDirectory = this->External->RepresentationCacheDirectory;
+  if (!cacheDirectory || !cacheDirectory[0])
+  {
+    return NULL;
+  }
+
+  if (!this->RepresentationCache || strcmp(this->RepresentationCache->GetCacheDirectory(), cacheDirectory))
+  {
+    this->RepresentationCache = vtkSmartPointer<vtkSlicerDicomRtRepresentationCache>::New();
+    this->RepresentationCache->SetCacheDirectory(cacheDirectory);
+  }
+  this->RepresentationCache->SetMaximumCacheSizeMB(this->External->MaximumRepresentationCacheSizeMB);
+  return this->RepresentationCache;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::StartBackgroundConversion()
+{
+  // Requests made during batch processing are started when it ends
+  vtkMRMLScene* scene = this->External->GetMRMLScene();
+  if (this->BackgroundConversion || !scene || scene->IsBatchProcessing())
+  {
+    return;
+  }
+
+  while (!this->RequestedDeferredSegmentations.empty())
+  {
+    // Convert the segmentation that was requested first
+    std::string segmentationNodeID = this->RequestedDeferredSegmentations.front();
+    this->RequestedDeferredSegmentations.pop_front();
+    vtkMRMLSegmentationNode* segmentationNode = vtkMRMLSegmentationNode::SafeDownCast(scene->GetNodeByID(segmentationNodeID.c_str()));
+    if (!segmentationNode || !segmentationNode->GetSegmentation())
+    {
+      // Segmentation has been removed since the request
+      continue;
+    }
+
+    vtkBackgroundPlanarContourConversion* conversion = new vtkBackgroundPlanarContourConversion();
+    conversion->SegmentationNodeID = segmentationNodeID;
+    conversion->Jobs.RepresentationCache = this->GetRepresentationCache();
+    conversion->Jobs.JobPool = this->CreateConversionJobPool();
+    std::vector<std::string> segmentIDs;
+    segmentationNode->GetSegmentation()->GetSegmentIDs(segmentIDs);
+    for (std::vector<std::string>::iterator segmentIdIt = segmentIDs.begin(); segmentIdIt != segmentIDs.end(); ++segmentIdIt)
+    {
+      vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(*segmentIdIt);
+      vtkPolyData* planarContours = (segment ? vtkPolyData::SafeDownCast(
+        segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationPlanarContourRepresentationName()) ) : NULL);
+      std::string targetRepresentationName("");
+      if ( !planarContours || !segment->GetTag(SlicerRtCommon::SEGMENT_DEFERRED_CONVERSION_TAG_NAME, targetRepresentationName)
+        || segment->GetRepresentation(targetRepresentationName) )
+      {
+        continue;
+      }
+      if (conversion->Jobs.TargetRepresentationName.empty())
+      {
+        conversion->Jobs.TargetRepresentationName = targetRepresentationName;
+      }
+      else if (targetRepresentationName != conversion->Jobs.TargetRepresentationName)
+      {
+        // All segments of a segmentation are deferred to the same representation by DeferPlanarContourConversion
+        continue;
+      }
+
+      // The thread converts a copy, as the segment may be modified on the main thread during conversion
+      vtkSmartPointer<vtkPolyData> planarContoursCopy = vtkSmartPointer<vtkPolyData>::New();
+      planarContoursCopy->DeepCopy(planarContours);
+      conversion->Jobs.PlanarContours.push_back(planarContoursCopy);
+      conversion->SourcePlanarContours.push_back(planarContours);
+      conversion->SourcePlanarContourMTimes.push_back(planarContours->GetMTime());
+      conversion->SegmentIDs.push_back(*segmentIdIt);
+    }
+    if (conversion->SegmentIDs.empty())
+    {
+      delete conversion;
+      continue;
+    }
+
+    conversion->Jobs.Rule = vtkCreatePlanarContourConversionRule(segmentationNode->GetSegmentation(), conversion->Jobs.TargetRepresentationName);
+    if (!conversion->Jobs.Rule)
+    {
+      // The deferred segments are converted by the segmentation when the representation is queried
+      vtkWarningWithObjectMacro(this->External, "StartBackgroundConversion: Segmentation " << segmentationNode->GetName()
+        << " does not convert planar contours directly to " << conversion->Jobs.TargetRepresentationName << ", it is not converted in the background");
+      delete conversion;
+      continue;
+    }
+    for (unsigned int jobIndex = 0; jobIndex < conversion->SegmentIDs.size(); ++jobIndex)
+    {
+      vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(conversion->SegmentIDs[jobIndex]);
+      conversion->Jobs.RepresentationCacheKeys.push_back(vtkGetRepresentationCacheKey(
+        segment, conversion->SourcePlanarContours[jobIndex], conversion->Jobs.Rule ));
+    }
+
+    this->BackgroundConversion = conversion;
+    this->BackgroundConversionThreadID = this->BackgroundConversionThreader->SpawnThread(
+      vtkBackgroundPlanarContourConversionThread, conversion );
+    vtkDebugWithObjectMacro(this->External, "StartBackgroundConversion: Started converting " << conversion->SegmentIDs.size()
+      << " deferred segments of segmentation " << segmentationNodeID << " to " << conversion->Jobs.TargetRepresentationName);
+    this->External->InvokeEvent(vtkSlicerDicomRtImportExportModuleLogic::BackgroundConversionStartedEvent);
+    return;
+  }
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::FinishBackgroundConversion()
+{
+  if (!this->BackgroundConversion || !this->BackgroundConversion->Jobs.IsFinished())
+  {
+    return false;
+  }
+
+  // The thread only needs to exit after setting the finished flag
+  this->BackgroundConversionThreader->TerminateThread(this->BackgroundConversionThreadID);
+  this->BackgroundConversionThreadID = -1;
+  vtkBackgroundPlanarContourConversion* conversion = this->BackgroundConversion;
+  this->BackgroundConversion = NULL;
+
+  // The segmentation or the segments may have been removed or changed during conversion
+  vtkMRMLScene* scene = this->External->GetMRMLScene();
+  vtkMRMLSegmentationNode* segmentationNode = vtkMRMLSegmentationNode::SafeDownCast(
+    scene ? scene->GetNodeByID(conversion->SegmentationNodeID.c_str()) : NULL );
+  if (segmentationNode && segmentationNode->GetSegmentation())
+  {
+    // Add the converted representations in a single batch. Segments that have been converted in the meantime
+    // (e.g. by querying the representation) are left unchanged
+    const char* targetRepresentationName = conversion->Jobs.TargetRepresentationName.c_str();
+    int wasModifying = segmentationNode->StartModify();
+    for (unsigned int jobIndex = 0; jobIndex < conversion->SegmentIDs.size(); ++jobIndex)
+    {
+      vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(conversion->SegmentIDs[jobIndex]);
+      if (!segment || segment->GetRepresentation(targetRepresentationName))
+      {
+        continue;
+      }
+      vtkPolyData* planarContours = conversion->SourcePlanarContours[jobIndex];
+      if ( segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationPlanarContourRepresentationName()) != planarContours
+        || planarContours->GetMTime() != conversion->SourcePlanarContourMTimes[jobIndex] )
+      {
+        // Planar contours changed during conversion, the segment is converted again below
+        continue;
+      }
+      if (!conversion->Jobs.ConvertedRepresentations[jobIndex])
+      {
+        vtkErrorWithObjectMacro(this->External, "FinishBackgroundConversion: Failed to convert segment " << (segment->GetName() ? segment->GetName() : "")
+          << " to " << targetRepresentationName);
+        continue;
+      }
+      segment->AddRepresentation(targetRepresentationName, conversion->Jobs.ConvertedRepresentations[jobIndex]);
+    }
+
+    // Convert the segments that changed or were added during the background conversion in the same batch,
+    // so that the representation is contained by all segments of the segmentation
+    this->External->ConvertPlanarContoursConcurrently(segmentationNode, targetRepresentationName);
 
-  // Set up outputs for the planar image display
-  vtkSmartPointer<vtkMRMLModelNode> displayedModelNode = vtkSmartPointer<vtkMRMLModelNode>::New();
-  this->External->GetMRMLScene()->AddNode(displayedModelNode);
-  std::string displayedModelNodeName = vtkMRMLPlanarImageNode::PLANARIMAGE_MODEL_NODE_NAME_PREFIX + std::string(rtImageVolumeNode->GetName());
-  displayedModelNode->SetName(displayedModelNodeName.c_str());
-  displayedModelNode->SetAttribute(vtkMRMLSubjectHierarchyConstants::GetSubjectHierarchyExcludeFromTreeAttributeName().c_str(), "1");
+    std::vector<std::string> segmentIDs;
+    segmentationNode->GetSegmentation()->GetSegmentIDs(segmentIDs);
+    for (std::vector<std::string>::iterator segmentIdIt = segmentIDs.begin(); segmentIdIt != segmentIDs.end(); ++segmentIdIt)
+    {
+      vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(*segmentIdIt);
+      std::string deferredRepresentationName("");
+      if ( segment && segment->GetTag(SlicerRtCommon::SEGMENT_DEFERRED_CONVERSION_TAG_NAME, deferredRepresentationName)
+        && deferredRepresentationName == conversion->Jobs.TargetRepresentationName )
+      {
+        segment->RemoveTag(SlicerRtCommon::SEGMENT_DEFERRED_CONVERSION_TAG_NAME);
+      }
+    }
+    segmentationNode->EndModify(wasModifying);
+  }
 
-  // Create PlanarImage parameter set node
-  std::string planarImageParameterSetNodeName;
-  planarImageParameterSetNodeName = this->External->GetMRMLScene()->GenerateUniqueName(
-    vtkMRMLPlanarImageNode::PLANARIMAGE_PARAMETER_SET_BASE_NAME_PREFIX + std::string(rtImageVolumeNode->GetName()) );
-  vtkSmartPointer<vtkMRMLPlanarImageNode> planarImageParameterSetNode = vtkSmartPointer<vtkMRMLPlanarImageNode>::New();
-  planarImageParameterSetNode->SetName(planarImageParameterSetNodeName.c_str());
-  this->External->GetMRMLScene()->AddNode(planarImageParameterSetNode);
-  planarImageParameterSetNode->SetAndObserveRtImageVolumeNode(rtImageVolumeNode);
-  planarImageParameterSetNode->SetAndObserveDisplayedModelNode(displayedModelNode);
+  delete conversion;
+  return true;
+}
 
-  // Create planar image model for the RT image
-  this->External->PlanarImageLogic->CreateModelForPlanarImage(planarImageParameterSetNode);
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::RequestDeferredConversionIfShown(vtkMRMLSegmentationDisplayNode* displayNode)
+{
+  if (!displayNode || !displayNode->GetVisibility())
+  {
+    return;
+  }
+  vtkMRMLSegmentationNode* segmentationNode = vtkMRMLSegmentationNode::SafeDownCast(displayNode->GetDisplayableNode());
+  if (!segmentationNode || !segmentationNode->GetSegmentation())
+  {
+    return;
+  }
 
-  // Hide the displayed planar image model by default
-  displayedModelNode->SetDisplayVisibility(0);
+  // The whole segmentation is converted when any of its deferred segments is shown
+  std::vector<std::string> segmentIDs;
+  segmentationNode->GetSegmentation()->GetSegmentIDs(segmentIDs);
+  for (std::vector<std::string>::iterator segmentIdIt = segmentIDs.begin(); segmentIdIt != segmentIDs.end(); ++segmentIdIt)
+  {
+    vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(*segmentIdIt);
+    std::string targetRepresentationName("");
+    if ( segment && segment->GetTag(SlicerRtCommon::SEGMENT_DEFERRED_CONVERSION_TAG_NAME, targetRepresentationName)
+      && displayNode->GetSegmentVisibility(*segmentIdIt) )
+    {
+      this->External->RequestDeferredConversion(segmentationNode);
+      return;
+    }
+  }
 }
 
 
@@ -1509,6 +2553,14 @@ vtkSlicerDicomRtImportExportModuleLogic::vtkSlicerDicomRtImportExportModuleLogic
   this->BeamsLogic = NULL;
 
   this->BeamModelsInSeparateBranch = true;
+  this->MaximumNumberOfConversionWorkers = 0;
+  this->DeferConversionOfHiddenStructures = true;
+  this->HeaderOnlyExamine = true;
+  this->MaximumNumberOfExamineWorkers = 0;
+  this->ExportContourTolerance = 0.0;
+  this->ExportMaximumContourDeviation = 0.0;
+  this->RepresentationCacheDirectory = NULL;
+  this->MaximumRepresentationCacheSizeMB = 1024;
 }
 
 //----------------------------------------------------------------------------
@@ -1517,6 +2569,7 @@ vtkSlicerDicomRtImportExportModuleLogic::~vtkSlicerDicomRtImportExportModuleLogi
   this->SetIsodoseLogic(NULL);
   this->SetPlanarImageLogic(NULL);
   this->SetBeamsLogic(NULL);
+  this->SetRepresentationCacheDirectory(NULL);
 
   if (this->Internal)
   {
@@ -1529,6 +2582,17 @@ vtkSlicerDicomRtImportExportModuleLogic::~vtkSlicerDicomRtImportExportModuleLogi
 void vtkSlicerDicomRtImportExportModuleLogic::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "BeamModelsInSeparateBranch: " << (this->BeamModelsInSeparateBranch ? "true" : "false") << "\n";
+  os << indent << "MaximumNumberOfConversionWorkers: " << this->MaximumNumberOfConversionWorkers << "\n";
+  os << indent << "DeferConversionOfHiddenStructures: " << (this->DeferConversionOfHiddenStructures ? "true" : "false") << "\n";
+  os << indent << "HeaderOnlyExamine: " << (this->HeaderOnlyExamine ? "true" : "false") << "\n";
+  os << indent << "MaximumNumberOfExamineWorkers: " << this->MaximumNumberOfExamineWorkers << "\n";
+  os << indent << "ExportContourTolerance: " << this->ExportContourTolerance << "\n";
+  os << indent << "ExportMaximumContourDeviation: " << this->ExportMaximumContourDeviation << "\n";
+  os << indent << "RepresentationCacheDirectory: " << (this->RepresentationCacheDirectory ? this->RepresentationCacheDirectory : "NULL") << "\n";
+  os << indent << "MaximumRepresentationCacheSizeMB: " << this->MaximumRepresentationCacheSizeMB << "\n";
+  os << indent << "Number of cached examine results: " << this->Internal->ExamineCache.size() << "\n";
 }
 
 //---------------------------------------------------------------------------
@@ -1536,6 +2600,8 @@ void vtkSlicerDicomRtImportExportModuleLogic::SetMRMLSceneInternal(vtkMRMLScene
 {
   vtkSmartPointer<vtkIntArray> events = vtkSmartPointer<vtkIntArray>::New();
   events->InsertNextValue(vtkMRMLScene::EndCloseEvent);
+  events->InsertNextValue(vtkMRMLScene::EndBatchProcessEvent);
+  events->InsertNextValue(vtkMRMLScene::EndImportEvent);
   this->SetAndObserveMRMLSceneEvents(newScene, events.GetPointer());
 }
 
@@ -1547,6 +2613,51 @@ void vtkSlicerDicomRtImportExportModuleLogic::OnMRMLSceneEndClose()
     vtkErrorMacro("OnMRMLSceneEndClose: Invalid MRML scene");
     return;
   }
+
+  // Segmentations of the requested deferred segments have been removed
+  this->Internal->RequestedDeferredSegmentations.clear();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::OnMRMLSceneEndBatchProcess()
+{
+  // Start conversion of the deferred segments requested during batch processing
+  this->Internal->StartBackgroundConversion();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::OnMRMLSceneEndImport()
+{
+  vtkMRMLScene* scene = this->GetMRMLScene();
+  if (!scene)
+  {
+    vtkErrorMacro("OnMRMLSceneEndImport: Invalid MRML scene");
+    return;
+  }
+
+  // Deferred segments are saved with their tag, so they are converted when shown after loading the scene
+  std::vector<vtkMRMLNode*> segmentationNodes;
+  scene->GetNodesByClass("vtkMRMLSegmentationNode", segmentationNodes);
+  for (std::vector<vtkMRMLNode*>::iterator nodeIt = segmentationNodes.begin(); nodeIt != segmentationNodes.end(); ++nodeIt)
+  {
+    vtkMRMLSegmentationNode* segmentationNode = vtkMRMLSegmentationNode::SafeDownCast(*nodeIt);
+    if (!segmentationNode || !segmentationNode->GetSegmentation())
+    {
+      continue;
+    }
+    std::vector<std::string> segmentIDs;
+    segmentationNode->GetSegmentation()->GetSegmentIDs(segmentIDs);
+    for (std::vector<std::string>::iterator segmentIdIt = segmentIDs.begin(); segmentIdIt != segmentIDs.end(); ++segmentIdIt)
+    {
+      vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(*segmentIdIt);
+      std::string targetRepresentationName("");
+      if (segment && segment->GetTag(SlicerRtCommon::SEGMENT_DEFERRED_CONVERSION_TAG_NAME, targetRepresentationName))
+      {
+        this->ObserveDeferredSegmentation(segmentationNode);
+        break;
+      }
+    }
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -1565,6 +2676,10 @@ void vtkSlicerDicomRtImportExportModuleLogic::RegisterNodes()
     vtkSmartPointer<vtkPlanarContourToRibbonModelConversionRule>::New() );
   vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
     vtkSmartPointer<vtkPlanarContourToClosedSurfaceConversionRule>::New() );
+  vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
+    vtkSmartPointer<vtkPlanarContourToBinaryLabelmapConversionRule>::New() );
+  vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
+    vtkSmartPointer<vtkPlanarContourToFractionalLabelmapConversionRule>::New() );
 
 }
 
@@ -1577,73 +2692,44 @@ void vtkSlicerDicomRtImportExportModuleLogic::ExamineForLoad(vtkStringArray* fil
   }
   loadables->RemoveAllItems();
 
+  // Examine the files on worker threads, each taking the next file when finished with the previous one.
+  // Reading the files concurrently hides the I/O latency, which dominates when the files are on a network share
+  vtkInternal::ExamineJobs jobs;
+  jobs.Internal = this->Internal;
+  jobs.HeaderOnly = this->HeaderOnlyExamine;
   for (int fileIndex=0; fileIndex<fileList->GetNumberOfValues(); ++fileIndex)
   {
-    // Load file in DCMTK
-    DcmFileFormat fileformat;
-    vtkStdString fileName = fileList->GetValue(fileIndex);
-    OFCondition result = fileformat.loadFile(fileName.c_str(), EXS_Unknown);
-    if (!result.good())
-    {
-      continue; // Failed to parse this file, skip it
-    }
+    jobs.FileNames.push_back(fileList->GetValue(fileIndex));
+  }
+  if (jobs.FileNames.empty())
+  {
+    return;
+  }
+  jobs.Results.resize(jobs.FileNames.size());
 
-    // Check SOP Class UID for one of the supported RT objects
-    DcmDataset *dataset = fileformat.getDataset();
-    OFString sopClass;
-    if (!dataset->findAndGetOFString(DCM_SOPClassUID, sopClass).good() || sopClass.empty())
-    {
-      continue; // Failed to parse this file, skip it
-    }
+  vtkSmartPointer<vtkConcurrentJobPool> jobPool = vtkSmartPointer<vtkConcurrentJobPool>::New();
+  jobPool->SetMaximumNumberOfWorkers(this->MaximumNumberOfExamineWorkers);
+  jobPool->Execute((int)jobs.FileNames.size(), vtkInternal::ExamineJob, &jobs);
 
-    // DICOM parsing is successful, now check if the object is loadable
-    OFString name("");
-    OFString seriesNumber("");
-    std::vector<OFString> referencedSOPInstanceUIDs;
-    dataset->findAndGetOFString(DCM_SeriesNumber, seriesNumber);
-    if (!seriesNumber.empty())
-    {
-      name += seriesNumber + ": ";
-    }
+  this->Internal->AddReferencedRtPlanLabels(jobs.Results);
 
-    // RTDose
-    if (sopClass == UID_RTDoseStorage)
-    {
-      this->Internal->ExamineRtDoseDataset(dataset, name, referencedSOPInstanceUIDs);
-    }
-    // RTPlan
-    else if (sopClass == UID_RTPlanStorage)
-    {
-      this->Internal->ExamineRtPlanDataset(dataset, name, referencedSOPInstanceUIDs);
-    }
-    // RTStructureSet
-    else if (sopClass == UID_RTStructureSetStorage)
-    {
-      this->Internal->ExamineRtStructureSetDataset(dataset, name, referencedSOPInstanceUIDs);
-    }
-    // RTImage
-    else if (sopClass == UID_RTImageStorage)
-    {
-      this->Internal->ExamineRtImageDataset(dataset, name, referencedSOPInstanceUIDs);
-    }
-    /* Not yet supported
-    else if (sopClass == UID_RTTreatmentSummaryRecordStorage)
-    else if (sopClass == UID_RTIonPlanStorage)
-    else if (sopClass == UID_RTIonBeamsTreatmentRecordStorage)
-    */
-    else
+  // Create loadables in the order of the files, independently of the order the workers finished in
+  for (unsigned int fileIndex=0; fileIndex<jobs.FileNames.size(); ++fileIndex)
+  {
+    vtkInternal::ExamineResult& result = jobs.Results[fileIndex];
+    if (!result.Loadable)
     {
-      continue; // Not an RT file
+      continue; // Not a supported RT object
     }
 
     // The file is a loadable RT object, create and set up loadable
     vtkSmartPointer<vtkSlicerDICOMLoadable> loadable = vtkSmartPointer<vtkSlicerDICOMLoadable>::New();
-    loadable->SetName(name.c_str());
-    loadable->AddFile(fileName.c_str());
+    loadable->SetName(result.Name.c_str());
+    loadable->AddFile(jobs.FileNames[fileIndex].c_str());
     loadable->SetConfidence(1.0);
     loadable->SetSelected(true);
-    std::vector<OFString>::iterator uidIt;
-    for (uidIt = referencedSOPInstanceUIDs.begin(); uidIt != referencedSOPInstanceUIDs.end(); ++uidIt)
+    std::vector<std::string>::iterator uidIt;
+    for (uidIt = result.ReferencedSOPInstanceUIDs.begin(); uidIt != result.ReferencedSOPInstanceUIDs.end(); ++uidIt)
     {
       loadable->AddReferencedInstanceUID(uidIt->c_str());
     }
@@ -1651,6 +2737,22 @@ void vtkSlicerDicomRtImportExportModuleLogic::ExamineForLoad(vtkStringArray* fil
   }
 }
 
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::ClearExamineCache()
+{
+  this->Internal->ExamineCache.clear();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::ClearRepresentationCache()
+{
+  vtkSlicerDicomRtRepresentationCache* representationCache = this->Internal->GetRepresentationCache();
+  if (representationCache)
+  {
+    representationCache->Clear();
+  }
+}
+
 //---------------------------------------------------------------------------
 bool vtkSlicerDicomRtImportExportModuleLogic::LoadDicomRT(vtkSlicerDICOMLoadable* loadable)
 {
@@ -1704,6 +2806,7 @@ bool vtkSlicerDicomRtImportExportModuleLogic::LoadDicomRT(vtkSlicerDICOMLoadable
 std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkCollection* exportables)
 {
   std::string error("");
+  this->ExportMaximumContourDeviation = 0.0;
   vtkMRMLScene* mrmlScene = this->GetMRMLScene();
   if (!mrmlScene)
   {
@@ -1957,9 +3060,12 @@ std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkColle
         return error;
       }
 
-      // Export each segment in segmentation
+      // Collect binary labelmap of each segment in segmentation
       std::vector< std::string > segmentIDs;
       segmentationNode->GetSegmentation()->GetSegmentIDs(segmentIDs);
+      vtkLabelmapExportJobs jobs;
+      jobs.ReferenceImage = imageOrientedImageData;
+      jobs.Writer = rtWriter;
       for (std::vector< std::string >::const_iterator segmentIdIt = segmentIDs.begin(); segmentIdIt != segmentIDs.end(); ++segmentIdIt)
       {
         std::string segmentID = *segmentIdIt;
@@ -1974,52 +3080,42 @@ std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkColle
           vtkErrorMacro("ExportDicomRTStudy: " + error);
           return error;
         }
-        // Temporarily copy labelmap image data as it will be probably resampled
-        vtkSmartPointer<vtkOrientedImageData> binaryLabelmapCopy = vtkSmartPointer<vtkOrientedImageData>::New();
-        binaryLabelmapCopy->DeepCopy(binaryLabelmap);
+        jobs.BinaryLabelmaps.push_back(binaryLabelmap);
+        jobs.SegmentNames.push_back(segment->GetName() ? segment->GetName() : "");
+        jobs.SegmentColors.insert(jobs.SegmentColors.end(), segment->GetColor(), segment->GetColor() + 3);
 
-        // Apply parent transformation nodes if necessary
+        // Get transform from segmentation to world (RAS) if the segmentation is transformed
+        vtkSmartPointer<vtkGeneralTransform> nodeToWorldTransform;
         if (segmentationNode->GetParentTransformNode())
         {
-          if (!vtkSlicerSegmentationsModuleLogic::ApplyParentTransformToOrientedImageData(segmentationNode, binaryLabelmapCopy))
-          {
-            std::string errorMessage("Failed to apply parent transformation to exported segment");
-            vtkErrorMacro("ExportDicomRTStudy: " << errorMessage);
-            return errorMessage;
-          }
-        }
-        // Make sure the labelmap dimensions match the reference dimensions
-        if ( !vtkOrientedImageDataResample::DoGeometriesMatch(imageOrientedImageData, binaryLabelmapCopy)
-          || !vtkOrientedImageDataResample::DoExtentsMatch(imageOrientedImageData, binaryLabelmapCopy) )
-        {
-          if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(binaryLabelmapCopy, imageOrientedImageData, binaryLabelmapCopy))
-          {
-            error = "Failed to resample segment " + segmentID + " to match anatomical image geometry";
-            vtkErrorMacro("ExportDicomRTStudy: " + error);
-            return error;
-          }
-        }
-
-        // Convert mask to Plm image
-        Plm_image::Pointer plmStructure = PlmCommon::ConvertVtkOrientedImageDataToPlmImage(binaryLabelmapCopy);
-        if (!plmStructure)
-        {
-          error = "Failed to convert segment labelmap " + segmentID + " to Plastimatch image";
-          vtkErrorMacro("ExportDicomRTStudy: " + error);
-          return error;
+          nodeToWorldTransform = vtkSmartPointer<vtkGeneralTransform>::New();
+          segmentationNode->GetParentTransformNode()->GetTransformToWorld(nodeToWorldTransform);
         }
+        jobs.NodeToWorldTransforms.push_back(nodeToWorldTransform);
+      }
 
-        // Get segment properties
-        std::string segmentName = segment->GetName();
-        double* segmentColor = segment->GetColor();
-
-        rtWriter->AddStructure(plmStructure->itk_uchar(), segmentName.c_str(), segmentColor);
-      } // For each segment
+      // Transform and resample the labelmaps to the anatomical image geometry and convert them to Plastimatch format
+      // in parallel. Each labelmap is added to the writer in segment order as soon as it and the preceding ones are
+      // ready, then released, so that only the labelmaps finished out of order are kept in memory
+      jobs.PlmStructures.resize(jobs.BinaryLabelmaps.size());
+      jobs.Errors.resize(jobs.BinaryLabelmaps.size());
+      if (!jobs.BinaryLabelmaps.empty())
+      {
+        this->Internal->CreateConversionJobPool()->Execute((int)jobs.BinaryLabelmaps.size(), vtkExportLabelmap, &jobs);
+      }
+      int numberOfAddedStructures = jobs.GetNumberOfAddedStructures();
+      if (numberOfAddedStructures < (int)segmentIDs.size())
+      {
+        error = jobs.Errors[numberOfAddedStructures] + " (segment " + segmentIDs[numberOfAddedStructures] + ")";
+        vtkErrorMacro("ExportDicomRTStudy: " + error);
+        return error;
+      }
     }
     // If master representation is poly data type, then export from closed surface
     else if (segmentation->IsMasterRepresentationPolyData())
     {
-      // Make sure segmentation contains closed surface
+      // Make sure segmentation contains closed surface. Deferred segments are converted concurrently first
+      this->ConvertDeferredSegments(segmentationNode);
       if ( !segmentationNode->GetSegmentation()->CreateRepresentation(
         vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName() ) )
       {
@@ -2035,18 +3131,29 @@ std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkColle
       {
         segmentationNode->GetParentTransformNode()->GetTransformToWorld(nodeToWorldTransform);
       }
-      // Initialize poly data transformer
-      vtkSmartPointer<vtkTransformPolyDataFilter> transformPolyData = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-      transformPolyData->SetTransform(nodeToWorldTransform);
 
-      // Initialize cutting plane with normal of the Z axis of the anatomical image
+      // Slice planes are the anatomical image slices. The normal is the Z axis of the anatomical image, and the
+      // spacing is the length of that axis in the image to world matrix, which is the slice spacing
       vtkSmartPointer<vtkMatrix4x4> imageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
       imageOrientedImageData->GetImageToWorldMatrix(imageToWorldMatrix);
-      double normal[3] = { imageToWorldMatrix->GetElement(0,2), imageToWorldMatrix->GetElement(1,2), imageToWorldMatrix->GetElement(2,2) };
-      vtkSmartPointer<vtkPlane> slicePlane = vtkSmartPointer<vtkPlane>::New();
-      slicePlane->SetNormal(normal);
-
-      // Export each segment in segmentation
+      double sliceAxis[3] = { imageToWorldMatrix->GetElement(0,2), imageToWorldMatrix->GetElement(1,2), imageToWorldMatrix->GetElement(2,2) };
+      int imageExtent[6] = {0,-1,0,-1,0,-1};
+      imageOrientedImageData->GetExtent(imageExtent);
+      vtkClosedSurfaceSlicingJobs jobs;
+      for (int axis=0; axis<3; ++axis)
+      {
+        jobs.Origin[axis] = imageToWorldMatrix->GetElement(axis,3) + imageExtent[4]*sliceAxis[axis];
+        jobs.Normal[axis] = sliceAxis[axis];
+      }
+      jobs.Spacing = vtkMath::Norm(sliceAxis);
+      jobs.NumberOfPlanes = imageExtent[5] - imageExtent[4];
+      jobs.Writer = rtWriter;
+      jobs.ImageSliceUIDs = imageSliceUIDs;
+      jobs.FirstPlaneSlice = imageExtent[4];
+      jobs.FirstImageSlice = imageExtent[0];
+      jobs.ContourTolerance = this->ExportContourTolerance;
+
+      // Get closed surface of each segment in world coordinates
       std::vector< std::string > segmentIDs;
       segmentationNode->GetSegmentation()->GetSegmentIDs(segmentIDs);
       for (std::vector< std::string >::const_iterator segmentIdIt = segmentIDs.begin(); segmentIdIt != segmentIDs.end(); ++segmentIdIt)
@@ -2064,70 +3171,40 @@ std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkColle
           return error;
         }
 
-        // Initialize cutter pipeline for segment
+        vtkSmartPointer<vtkTransformPolyDataFilter> transformPolyData = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
+        transformPolyData->SetTransform(nodeToWorldTransform);
         transformPolyData->SetInputData(closedSurfacePolyData);
-        vtkSmartPointer<vtkCutter> cutter = vtkSmartPointer<vtkCutter>::New();
-        cutter->SetInputConnection(transformPolyData->GetOutputPort());
-        cutter->SetGenerateCutScalars(0);
-        vtkSmartPointer<vtkStripper> stripper = vtkSmartPointer<vtkStripper>::New();
-        stripper->SetInputConnection(cutter->GetOutputPort());
-
-        // Get segment bounding box
-        double bounds[6] = {0.0,0.0,0.0,0.0,0.0,0.0};
         transformPolyData->Update();
-        transformPolyData->GetOutput()->GetBounds(bounds);
-
-        // Containers to be passed to the writer
-        std::vector<int> sliceNumbers;
-        std::vector<std::string> sliceUIDs;
-        std::vector<vtkPolyData*> sliceContours;
-
-        // Create planar contours from closed surface based on each of the anatomical image slices
-        int imageExtent[6] = {0,-1,0,-1,0,-1};
-        imageOrientedImageData->GetExtent(imageExtent);
-        for (int slice=imageExtent[4]; slice<imageExtent[5]; ++slice)
-        {
-          // Calculate slice origin
-          double origin[3] = { imageToWorldMatrix->GetElement(0,3) + slice*normal[0],
-                               imageToWorldMatrix->GetElement(1,3) + slice*normal[1],
-                               imageToWorldMatrix->GetElement(2,3) + slice*normal[2] };
-          slicePlane->SetOrigin(origin);
-          if (origin[2] < bounds[4] || origin[2] > bounds[5])
-          {
-            // No contours outside surface bounds
-            continue;
-          }
-
-          // Cut closed surface at slice
-          cutter->SetCutFunction(slicePlane);
-
-          // Get instance UID of corresponding slice
-          int sliceNumber = slice-imageExtent[0];
-          sliceNumbers.push_back(sliceNumber);
-          std::string sliceInstanceUID = (imageSliceUIDs.size() > sliceNumber ? imageSliceUIDs[sliceNumber] : "");
-          sliceUIDs.push_back(sliceInstanceUID);
-
-          // Save slice contour
-          stripper->Update();
-          vtkPolyData* sliceContour = vtkPolyData::New();
-          sliceContour->SetPoints(stripper->GetOutput()->GetPoints());
-          sliceContour->SetPolys(stripper->GetOutput()->GetLines());
-          sliceContours.push_back(sliceContour);
-        } // For each anatomical image slice
+        jobs.ClosedSurfaces.push_back(transformPolyData->GetOutput());
 
         // Get segment properties
-        std::string segmentName = segment->GetName();
+        jobs.SegmentNames.push_back(segment->GetName() ? segment->GetName() : "");
         double* segmentColor = segment->GetColor();
+        jobs.SegmentColors.insert(jobs.SegmentColors.end(), segmentColor, segmentColor + 3);
+      }
 
-        // Add contours to writer
-        rtWriter->AddStructure(segmentName.c_str(), segmentColor, sliceNumbers, sliceUIDs, sliceContours);
-
-        // Clean up slice contours
-        for (std::vector<vtkPolyData*>::iterator contourIt=sliceContours.begin(); contourIt!=sliceContours.end(); ++contourIt)
-        {
-          (*contourIt)->Delete();
-        }
-      } // For each segment
+      // Create planar contours from the closed surfaces on each of the anatomical image slices. Each segment is sliced
+      // in a single sweep through the slices, and the segments are sliced in parallel. The contours of each segment are
+      // copied into the in-memory RT study of the writer in segment order as soon as they are available, and the cutters
+      // released. The structure set is only encoded when the study is written
+      jobs.Cutters.resize(jobs.ClosedSurfaces.size());
+      if (!jobs.ClosedSurfaces.empty())
+      {
+        this->Internal->CreateConversionJobPool()->Execute((int)jobs.ClosedSurfaces.size(), vtkSliceClosedSurface, &jobs);
+      }
+      jobs.AddFinishedStructures();
+      if (jobs.GetNumberOfAddedStructures() != (int)segmentIDs.size())
+      {
+        error = "Failed to create contours from closed surfaces of segmentation " + std::string(segmentationNode->GetName());
+        vtkErrorMacro("ExportDicomRTStudy: " + error);
+        return error;
+      }
+      this->ExportMaximumContourDeviation = jobs.MaximumContourDeviation;
+      if (this->ExportContourTolerance > 0.0)
+      {
+        vtkDebugMacro("ExportDicomRTStudy: Contours reduced with tolerance " << this->ExportContourTolerance
+          << "mm, maximum deviation of removed points is " << this->ExportMaximumContourDeviation << "mm");
+      }
     }
     else
     {
@@ -2145,6 +3222,246 @@ std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkColle
   return error;
 }
 
+//----------------------------------------------------------------------------
+int vtkSlicerDicomRtImportExportModuleLogic::ConvertPlanarContoursConcurrently(vtkMRMLSegmentationNode* segmentationNode, const char* targetRepresentationName, vtkStringArray* segmentIDs/*=NULL*/)
+{
+  if (!segmentationNode || !segmentationNode->GetSegmentation())
+  {
+    vtkErrorMacro("ConvertPlanarContoursConcurrently: Invalid segmentation node");
+    return 0;
+  }
+  if ( !targetRepresentationName
+    || ( strcmp(targetRepresentationName, vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName())
+      && strcmp(targetRepresentationName, SlicerRtCommon::SEGMENTATION_RIBBON_MODEL_REPRESENTATION_NAME) ) )
+  {
+    vtkErrorMacro("ConvertPlanarContoursConcurrently: Planar contours can only be converted to closed surface or ribbon model, requested representation is "
+      << (targetRepresentationName ? targetRepresentationName : "NULL"));
+    return 0;
+  }
+  vtkSegmentation* segmentation = segmentationNode->GetSegmentation();
+
+  std::vector<std::string> requestedSegmentIDs;
+  if (segmentIDs)
+  {
+    for (vtkIdType index = 0; index < segmentIDs->GetNumberOfValues(); ++index)
+    {
+      requestedSegmentIDs.push_back(segmentIDs->GetValue(index));
+    }
+  }
+  else
+  {
+    segmentation->GetSegmentIDs(requestedSegmentIDs);
+  }
+
+  // Convert with the rule and conversion parameters the converter of the segmentation would use
+  vtkPlanarContourConversionJobs jobs;
+  jobs.TargetRepresentationName = targetRepresentationName;
+  jobs.Rule = vtkCreatePlanarContourConversionRule(segmentation, targetRepresentationName);
+  if (!jobs.Rule)
+  {
+    vtkWarningMacro("ConvertPlanarContoursConcurrently: Segmentation " << segmentationNode->GetName()
+      << " does not convert planar contours directly to " << targetRepresentationName << ", segments are not converted");
+    return 0;
+  }
+  jobs.RepresentationCache = this->Internal->GetRepresentationCache();
+  jobs.JobPool = this->Internal->CreateConversionJobPool();
+
+  // Collect segments to convert
+  std::vector<vtkSegment*> segmentsToConvert;
+  for (std::vector<std::string>::iterator segmentIdIt = requestedSegmentIDs.begin(); segmentIdIt != requestedSegmentIDs.end(); ++segmentIdIt)
+  {
+    vtkSegment* segment = segmentation->GetSegment(*segmentIdIt);
+    if (!segment)
+    {
+      vtkErrorMacro("ConvertPlanarContoursConcurrently: Failed to find segment " << (*segmentIdIt) << " in segmentation " << segmentationNode->GetName());
+      continue;
+    }
+    vtkPolyData* planarContours = vtkPolyData::SafeDownCast(
+      segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationPlanarContourRepresentationName()) );
+    if (!planarContours || segment->GetRepresentation(targetRepresentationName))
+    {
+      continue;
+    }
+    segmentsToConvert.push_back(segment);
+    jobs.PlanarContours.push_back(planarContours);
+    jobs.RepresentationCacheKeys.push_back(vtkGetRepresentationCacheKey(segment, planarContours, jobs.Rule));
+  }
+  if (segmentsToConvert.empty())
+  {
+    return 0;
+  }
+
+  // Run the conversions on a bounded number of workers
+  vtkRunPlanarContourConversionJobs(&jobs);
+
+  // Add the converted representations in a single batch, so that observers are only notified once
+  int numberOfConvertedSegments = 0;
+  int wasModifying = segmentationNode->StartModify();
+  for (unsigned int jobIndex = 0; jobIndex < segmentsToConvert.size(); ++jobIndex)
+  {
+    if (!jobs.ConvertedRepresentations[jobIndex])
+    {
+      vtkErrorMacro("ConvertPlanarContoursConcurrently: Failed to convert segment " << (segmentsToConvert[jobIndex]->GetName() ? segmentsToConvert[jobIndex]->GetName() : "")
+        << " to " << targetRepresentationName);
+      continue;
+    }
+    segmentsToConvert[jobIndex]->AddRepresentation(targetRepresentationName, jobs.ConvertedRepresentations[jobIndex]);
+    ++numberOfConvertedSegments;
+  }
+  segmentationNode->EndModify(wasModifying);
+
+  vtkDebugMacro("ConvertPlanarContoursConcurrently: Converted " << numberOfConvertedSegments << " segments to " << targetRepresentationName << " using " << jobs.WorkerRules.size() << " workers");
+  return numberOfConvertedSegments;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::DeferPlanarContourConversion(vtkMRMLSegmentationNode* segmentationNode, const char* targetRepresentationName)
+{
+  if (!segmentationNode || !segmentationNode->GetSegmentation() || !targetRepresentationName)
+  {
+    vtkErrorMacro("DeferPlanarContourConversion: Invalid input");
+    return;
+  }
+  if ( strcmp(targetRepresentationName, vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName())
+    && strcmp(targetRepresentationName, SlicerRtCommon::SEGMENTATION_RIBBON_MODEL_REPRESENTATION_NAME) )
+  {
+    vtkErrorMacro("DeferPlanarContourConversion: Planar contours can only be converted to closed surface or ribbon model, requested representation is " << targetRepresentationName);
+    return;
+  }
+
+  // Deferring the remaining segments of a partially converted segmentation would leave it with a representation
+  // that only some of its segments contain, so convert them immediately instead
+  std::vector<std::string> segmentIDs;
+  segmentationNode->GetSegmentation()->GetSegmentIDs(segmentIDs);
+  for (std::vector<std::string>::iterator segmentIdIt = segmentIDs.begin(); segmentIdIt != segmentIDs.end(); ++segmentIdIt)
+  {
+    if (segmentationNode->GetSegmentation()->GetSegment(*segmentIdIt)->GetRepresentation(targetRepresentationName))
+    {
+      this->ConvertPlanarContoursConcurrently(segmentationNode, targetRepresentationName);
+      return;
+    }
+  }
+
+  int wasModifying = segmentationNode->StartModify();
+  for (std::vector<std::string>::iterator segmentIdIt = segmentIDs.begin(); segmentIdIt != segmentIDs.end(); ++segmentIdIt)
+  {
+    vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(*segmentIdIt);
+    if (segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationPlanarContourRepresentationName()))
+    {
+      // Only the tag is added, the target representation is created when the segmentation is shown
+      segment->SetTag(SlicerRtCommon::SEGMENT_DEFERRED_CONVERSION_TAG_NAME, targetRepresentationName);
+    }
+  }
+  segmentationNode->EndModify(wasModifying);
+
+  this->ObserveDeferredSegmentation(segmentationNode);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::ObserveDeferredSegmentation(vtkMRMLSegmentationNode* segmentationNode)
+{
+  vtkMRMLSegmentationDisplayNode* displayNode = vtkMRMLSegmentationDisplayNode::SafeDownCast(
+    segmentationNode ? segmentationNode->GetDisplayNode() : NULL );
+  if (!displayNode)
+  {
+    return;
+  }
+
+  // Observe display node to start conversion when a deferred segment is shown
+  vtkSmartPointer<vtkIntArray> events = vtkSmartPointer<vtkIntArray>::New();
+  events->InsertNextValue(vtkCommand::ModifiedEvent);
+  vtkObserveMRMLNodeEventsMacro(displayNode, events);
+
+  this->Internal->RequestDeferredConversionIfShown(displayNode);
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerDicomRtImportExportModuleLogic::ConvertDeferredSegments(vtkMRMLSegmentationNode* segmentationNode)
+{
+  if (!segmentationNode || !segmentationNode->GetSegmentation())
+  {
+    vtkErrorMacro("ConvertDeferredSegments: Invalid segmentation node");
+    return 0;
+  }
+
+  // Collect the deferred segments by target representation
+  std::map<std::string, vtkSmartPointer<vtkStringArray> > deferredSegmentIDs;
+  std::vector<std::string> segmentIDs;
+  segmentationNode->GetSegmentation()->GetSegmentIDs(segmentIDs);
+  for (std::vector<std::string>::iterator segmentIdIt = segmentIDs.begin(); segmentIdIt != segmentIDs.end(); ++segmentIdIt)
+  {
+    vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(*segmentIdIt);
+    std::string targetRepresentationName("");
+    if (!segment || !segment->GetTag(SlicerRtCommon::SEGMENT_DEFERRED_CONVERSION_TAG_NAME, targetRepresentationName))
+    {
+      continue;
+    }
+    segment->RemoveTag(SlicerRtCommon::SEGMENT_DEFERRED_CONVERSION_TAG_NAME);
+    if (!deferredSegmentIDs[targetRepresentationName])
+    {
+      deferredSegmentIDs[targetRepresentationName] = vtkSmartPointer<vtkStringArray>::New();
+    }
+    deferredSegmentIDs[targetRepresentationName]->InsertNextValue(*segmentIdIt);
+  }
+
+  int numberOfConvertedSegments = 0;
+  for (std::map<std::string, vtkSmartPointer<vtkStringArray> >::iterator targetIt = deferredSegmentIDs.begin(); targetIt != deferredSegmentIDs.end(); ++targetIt)
+  {
+    numberOfConvertedSegments += this->ConvertPlanarContoursConcurrently(segmentationNode, targetIt->first.c_str(), targetIt->second);
+  }
+  return numberOfConvertedSegments;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::RequestDeferredConversion(vtkMRMLSegmentationNode* segmentationNode)
+{
+  if (!segmentationNode || !segmentationNode->GetID())
+  {
+    vtkErrorMacro("RequestDeferredConversion: Invalid segmentation node");
+    return;
+  }
+
+  // Segments deferred while the segmentation is being converted are converted when the conversion finishes
+  std::string segmentationNodeID(segmentationNode->GetID());
+  if (std::find(this->Internal->RequestedDeferredSegmentations.begin(), this->Internal->RequestedDeferredSegmentations.end(), segmentationNodeID)
+    != this->Internal->RequestedDeferredSegmentations.end() )
+  {
+    return;
+  }
+  vtkBackgroundPlanarContourConversion* conversion = this->Internal->BackgroundConversion;
+  if (conversion && conversion->SegmentationNodeID == segmentationNodeID)
+  {
+    return;
+  }
+
+  this->Internal->RequestedDeferredSegmentations.push_back(segmentationNodeID);
+  this->Internal->StartBackgroundConversion();
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtImportExportModuleLogic::ProcessBackgroundConversions()
+{
+  if (this->Internal->FinishBackgroundConversion())
+  {
+    this->Internal->StartBackgroundConversion();
+  }
+  return (this->Internal->BackgroundConversion != NULL);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData)
+{
+  Superclass::ProcessMRMLNodesEvents(caller, event, callData);
+
+  // Request conversion of the deferred segments that have been shown. Requests made during
+  // batch processing are queued, and their conversion started when the batch processing ends
+  vtkMRMLSegmentationDisplayNode* displayNode = vtkMRMLSegmentationDisplayNode::SafeDownCast(caller);
+  if (displayNode && event == vtkCommand::ModifiedEvent)
+  {
+    this->Internal->RequestDeferredConversionIfShown(displayNode);
+  }
+}
+
 //-----------------------------------------------------------------------------
 vtkMRMLScalarVolumeNode* vtkSlicerDicomRtImportExportModuleLogic::GetReferencedVolumeByDicomForSegmentation(vtkMRMLSegmentationNode* segmentationNode)
 {
@@ -55,11 +55,26 @@ public:
   vtkTypeMacro(vtkSlicerDicomRtImportExportModuleLogic, vtkSlicerModuleLogic);
   void PrintSelf(ostream& os, vtkIndent indent);
 
-  /// Examine a list of file lists and determine what objects can be loaded from them
+  enum
+  {
+    /// Fired on the main thread when background conversion of deferred segments starts.
+    /// \sa ProcessBackgroundConversions needs to be called periodically until it returns false
+    BackgroundConversionStartedEvent = 62400
+  };
+
+  /// Examine a list of file lists and determine what objects can be loaded from them.
+  /// The files are examined concurrently (see \sa MaximumNumberOfExamineWorkers), and the loadables are added in the order of the files.
+  /// The examine results are cached for each file, and reused until the modification time or size of the file changes.
   /// \param fileList List of files to examine and generate loadables from
   /// \param loadables Collection to store generated (output) loadables
   void ExamineForLoad(vtkStringArray* fileList, vtkCollection* loadables);
 
+  /// Remove all cached examine results, so that the files are parsed again at the next examination
+  void ClearExamineCache();
+
+  /// Remove all converted segment representations from the representation cache (see \sa RepresentationCacheDirectory)
+  void ClearRepresentationCache();
+
   /// Load DICOM RT series from file name
   /// /return True if loading successful
   bool LoadDicomRT(vtkSlicerDICOMLoadable* loadable);
@@ -72,6 +87,44 @@ public:
   /// \return The reference volume for the segmentation if any, NULL otherwise
   static vtkMRMLScalarVolumeNode* GetReferencedVolumeByDicomForSegmentation(vtkMRMLSegmentationNode* segmentationNode);
 
+  /// Convert planar contour representation of multiple segments concurrently to closed surface or ribbon model.
+  /// The segments are converted with the rule the converter of the segmentation selects for the conversion, using the
+  /// conversion parameters of the segmentation. Each worker thread (see \sa MaximumNumberOfConversionWorkers) uses its
+  /// own copy of the rule, and the results are added to the segments in a single batch modification of the segmentation node.
+  /// Segments that already contain the target representation or have no planar contour are skipped. Nothing is converted
+  /// if the converter does not convert planar contours directly to the target representation.
+  /// \param segmentationNode Segmentation node containing the segments to convert
+  /// \param targetRepresentationName Closed surface or ribbon model representation name
+  /// \param segmentIDs IDs of the segments to convert. All segments are converted if NULL
+  /// \return Number of segments the target representation has been created for
+  int ConvertPlanarContoursConcurrently(vtkMRMLSegmentationNode* segmentationNode, const char* targetRepresentationName, vtkStringArray* segmentIDs=NULL);
+
+  /// Defer conversion of the planar contour representation of a segmentation until it is shown or queried.
+  /// Conversion is deferred for the whole segmentation, as the segmentation expects each of its segments to contain
+  /// the same representations (it only checks the first segment). The segments are tagged with
+  /// \sa SlicerRtCommon::SEGMENT_DEFERRED_CONVERSION_TAG_NAME, the target representation is not added, so modules
+  /// querying it convert the segmentation from the master representation as usual. When the segmentation is shown,
+  /// it is converted in the background (see \sa RequestDeferredConversion).
+  /// The segmentation is converted immediately if some of its segments already contain the target representation.
+  /// \param segmentationNode Segmentation node to defer conversion of
+  /// \param targetRepresentationName Closed surface or ribbon model representation name
+  void DeferPlanarContourConversion(vtkMRMLSegmentationNode* segmentationNode, const char* targetRepresentationName);
+
+  /// Convert the deferred segments of a segmentation immediately and remove their deferred conversion tag
+  /// \return Number of converted segments
+  int ConvertDeferredSegments(vtkMRMLSegmentationNode* segmentationNode);
+
+  /// Request background conversion of the deferred segments of a segmentation. The converted representations are
+  /// added to all segments in a single batch when the conversion finishes. Segments that changed during the conversion,
+  /// or were added since it started, are then converted on the main thread, so that each segment contains the target
+  /// representation afterwards. Requests made while the scene is batch processing are started at the end of the batch processing
+  void RequestDeferredConversion(vtkMRMLSegmentationNode* segmentationNode);
+
+  /// Add the representations converted in the background to their segments, and start conversion of the segmentations
+  /// requested in the meantime. Needs to be called periodically on the main thread, which is done by the module
+  /// \return True if background conversion is in progress
+  bool ProcessBackgroundConversions();
+
 public:
   /// Set Isodose module logic
   void SetIsodoseLogic(vtkSlicerIsodoseModuleLogic* isodoseLogic);
@@ -85,12 +138,50 @@ public:
   vtkGetMacro(BeamModelsInSeparateBranch, bool);
   vtkBooleanMacro(BeamModelsInSeparateBranch, bool);
 
+  vtkSetMacro(MaximumNumberOfConversionWorkers, int);
+  vtkGetMacro(MaximumNumberOfConversionWorkers, int);
+
+  vtkSetMacro(DeferConversionOfHiddenStructures, bool);
+  vtkGetMacro(DeferConversionOfHiddenStructures, bool);
+  vtkBooleanMacro(DeferConversionOfHiddenStructures, bool);
+
+  vtkSetMacro(HeaderOnlyExamine, bool);
+  vtkGetMacro(HeaderOnlyExamine, bool);
+  vtkBooleanMacro(HeaderOnlyExamine, bool);
+
+  vtkSetMacro(MaximumNumberOfExamineWorkers, int);
+  vtkGetMacro(MaximumNumberOfExamineWorkers, int);
+
+  vtkSetMacro(ExportContourTolerance, double);
+  vtkGetMacro(ExportContourTolerance, double);
+
+  /// Get the largest distance of a removed contour point from its reduced contour in the last
+  /// structure set export (see \sa ExportContourTolerance)
+  vtkGetMacro(ExportMaximumContourDeviation, double);
+
+  vtkSetStringMacro(RepresentationCacheDirectory);
+  vtkGetStringMacro(RepresentationCacheDirectory);
+
+  vtkSetMacro(MaximumRepresentationCacheSizeMB, int);
+  vtkGetMacro(MaximumRepresentationCacheSizeMB, int);
+
 protected:
   vtkSlicerDicomRtImportExportModuleLogic();
   virtual ~vtkSlicerDicomRtImportExportModuleLogic();
 
   virtual void SetMRMLSceneInternal(vtkMRMLScene* newScene);
   virtual void OnMRMLSceneEndClose();
+  virtual void OnMRMLSceneEndBatchProcess();
+
+  /// Observe segmentations with deferred segments loaded with a scene
+  virtual void OnMRMLSceneEndImport();
+
+  /// Handles visibility changes of segmentations with deferred segments
+  virtual void ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData);
+
+  /// Observe the display node of a segmentation containing deferred segments, and request its conversion if it is
+  /// already shown
+  void ObserveDeferredSegmentation(vtkMRMLSegmentationNode* segmentationNode);
 
   /// Register MRML Node classes to Scene. Gets called automatically when the MRMLScene is attached to this logic class.
   virtual void RegisterNodes();
@@ -116,6 +207,45 @@ private:
   /// Flag determining whether the generated beam models are arranged in a separate subject hierarchy
   /// branch, or each beam model is added under its corresponding isocenter fiducial
   bool BeamModelsInSeparateBranch;
+
+  /// Maximum number of worker threads used for concurrent planar contour conversion when loading structure sets.
+  /// The number of processor cores is used if not positive. Default is 0
+  int MaximumNumberOfConversionWorkers;
+
+  /// Flag determining whether structures not used for planning and evaluation (couch, fixation devices, markers, etc.
+  /// according to their RT ROI interpreted type) are hidden after loading, and the conversion of structure sets
+  /// containing them is deferred to a background thread (see \sa DeferPlanarContourConversion). The whole structure set
+  /// is deferred, not only its hidden structures, because a segmentation only supports representations that are
+  /// contained by every segment. True by default
+  bool DeferConversionOfHiddenStructures;
+
+  /// Flag determining whether only the attributes needed for examination are read from the files in \sa ExamineForLoad.
+  /// Long values such as pixel data and contour data are skipped, and structure sets are only parsed up to the ROI
+  /// contour sequence. True by default
+  bool HeaderOnlyExamine;
+
+  /// Maximum number of worker threads used for concurrent examination of files in \sa ExamineForLoad.
+  /// The number of processor cores is used if not positive. Default is 0
+  int MaximumNumberOfExamineWorkers;
+
+  /// Tolerance (in mm) of reducing the contours created from closed surfaces in \sa ExportDicomRTStudy.
+  /// Contour points are removed as long as they stay within the tolerance from the exported contour in the slice plane.
+  /// Contours are exported with all points if not positive. Default is 0
+  double ExportContourTolerance;
+
+  /// Largest distance of a removed contour point from its reduced contour in the last structure set export
+  double ExportMaximumContourDeviation;
+
+  /// Directory of the persistent cache of representations converted from the planar contours of loaded structure sets.
+  /// The converted representations are stored by structure set SOP instance UID, ROI number and conversion parameters,
+  /// so that reloading a structure set does not convert its structures again. Only the closed surface and ribbon model
+  /// representations are cached. Binary labelmaps are created on demand by the segmentation converter for a reference
+  /// geometry, and are not cached. Caching is disabled if empty (default)
+  char* RepresentationCacheDirectory;
+
+  /// Maximum total size of the representation cache in megabytes. The least recently used representations are
+  /// removed when exceeded. Default is 1024
+  int MaximumRepresentationCacheSizeMB;
 };
 
 #endif
@@ -26,16 +26,22 @@
 
 // SlicerRt includes
 #include "SlicerRtCommon.h"
+#include "vtkConcurrentJobPool.h"
 
 // VTK includes
 #include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkImageData.h>
 #include <vtkMath.h>
+#include <vtkMatrix4x4.h>
 #include <vtkObjectFactory.h>
 #include <vtkPoints.h>
 #include <vtkPolyData.h>
 #include <vtkSmartPointer.h>
 
 // STD includes
+#include <algorithm>
 #include <vector>
 #include <map>
 
@@ -44,6 +50,8 @@
 
 #include <dcmtk/ofstd/ofconapp.h>
 
+#include <dcmtk/dcmdata/dcxfer.h>
+
 #include <dcmtk/dcmrt/drtdose.h>
 #include <dcmtk/dcmrt/drtimage.h>
 #include <dcmtk/dcmrt/drtplan.h>
@@ -97,12 +105,33 @@ public:
     vtkPolyData* PolyData;
     std::string ReferencedSeriesUID;
     std::string ReferencedFrameOfReferenceUID;
+    std::string InterpretedType;
     std::map<int,std::string> ContourIndexToSOPInstanceUIDMap;
   };
 
   /// List of loaded contour ROIs from structure set
   std::vector<RoiEntry> RoiSequenceVector;
 
+  /// Contour data of a ROI collected from the structure set to be parsed into poly data.
+  /// Collected on the calling thread, as accessing the DICOM elements may load their values from the file.
+  class RoiContourData
+  {
+  public:
+    RoiContourData()
+      : Roi(NULL)
+    {
+    }
+
+    /// ROI entry the contours belong to
+    RoiEntry* Roi;
+    /// Contour data of each contour (backslash-separated LPS coordinates as decimal strings)
+    std::vector<OFString> ContourDataStrings;
+    /// Number of points to read from the contour data of each contour
+    std::vector<vtkIdType> NumberOfContourPoints;
+    /// Poly data parsed from the contour data
+    vtkSmartPointer<vtkPolyData> PolyData;
+  };
+
   /// Structure storing an RT structure set
   class BeamEntry
   {
@@ -149,6 +178,11 @@ public:
 public:
   /// Load RT Dose
   void LoadRTDose(DcmDataset* dataset);
+  /// Load dose voxels by memory-mapping the uncompressed pixel data of the RT Dose file, and applying
+  /// the dose grid scaling while converting the values into the output float volume in one pass.
+  /// \return False if the pixel data cannot be mapped (e.g. compressed or big endian encoding, non-uniform
+  ///   frame offsets), in which case the dose volume needs to be read by other means
+  bool LoadRTDoseVoxels(DcmDataset* dataset, double doseGridScaling);
 
   /// Load RT Plan 
   void LoadRTPlan(DcmDataset* dataset);
@@ -157,8 +191,16 @@ public:
   void LoadRTStructureSet(DcmDataset* dataset);
   /// Load contours from a structure sequence
   void LoadContoursFromRoiSequence(DRTStructureSetROISequence* roiSequence);
-  /// Load individual contour from RT Structure Set
-  vtkSlicerDicomRtReader::vtkInternal::RoiEntry* LoadContour(DRTROIContourSequence::Item &roiObject, DRTStructureSetIOD* rtStructureSetObject);
+  /// Load ROI interpreted types from RT ROI observations sequence
+  void LoadRoiObservations(DRTStructureSetIOD* rtStructureSetObject);
+  /// Load individual contour from RT Structure Set. Contour data is collected into \sa roiContourData to be parsed later.
+  vtkSlicerDicomRtReader::vtkInternal::RoiEntry* LoadContour(DRTROIContourSequence::Item &roiObject, DRTStructureSetIOD* rtStructureSetObject, RoiContourData& roiContourData);
+  /// Parse the collected contour data of a ROI into poly data. Only accesses \sa roiContourData, so ROIs can be parsed in parallel
+  static void ParseRoiContourData(RoiContourData& roiContourData);
+  /// Parse the collected contour data of the ROIs using multiple threads
+  void ParseRoiContourDataConcurrently(std::vector<RoiContourData>& roiContours);
+  /// Job function of \sa ParseRoiContourDataConcurrently parsing the ROI of the job. Each ROI is only accessed by the worker parsing it
+  static void ParseRoiContourDataJob(int jobIndex, int workerIndex, void* roiContours);
 
   /// Load RT Image
   void LoadRTImage(DcmDataset* dataset);
@@ -179,10 +221,138 @@ public:
   /// Get contour image sequence object in the referenced frame of reference sequence for a structure set
   DRTContourImageSequence* GetReferencedFrameOfReferenceContourImageSequence(DRTStructureSetIOD* rtStructureSetObject);
 
+public:
+  /// Dose volume loaded by \sa LoadRTDoseVoxels
+  vtkSmartPointer<vtkImageData> DoseImageData;
+  /// IJK to RAS matrix of \sa DoseImageData
+  vtkSmartPointer<vtkMatrix4x4> DoseIJKToRASMatrix;
+
 public:
   vtkSlicerDicomRtReader* External;
 };
 
+//----------------------------------------------------------------------------
+// Plain decimal numbers are parsed directly from the characters, as converting millions of coordinates through streams
+// is slow. The parsed value is exact if it has at most 15 significant digits and the decimal exponent is at most 22,
+// which covers the 16 character DS values. Other values are parsed by DCMTK.
+double vtkSlicerDicomRtReader::ParseDecimalStringValue(const char*& position, const char* end)
+{
+  static const double powersOfTen[23] =
+  {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  const char* valueStart = position;
+  const char* valueEnd = position;
+  while (valueEnd < end && *valueEnd != '\\')
+  {
+    ++valueEnd;
+  }
+  position = (valueEnd < end ? valueEnd + 1 : end);
+
+  const char* current = valueStart;
+  while (current < valueEnd && *current == ' ')
+  {
+    ++current;
+  }
+  bool negative = false;
+  if (current < valueEnd && (*current == '-' || *current == '+'))
+  {
+    negative = (*current == '-');
+    ++current;
+  }
+
+  // Collect significant digits into an integer mantissa, and the position of the decimal point into the exponent
+  vtkTypeUInt64 mantissa = 0;
+  int numberOfSignificantDigits = 0;
+  int numberOfDigits = 0;
+  int exponent = 0;
+  bool afterDecimalPoint = false;
+  for (; current < valueEnd; ++current)
+  {
+    if (*current >= '0' && *current <= '9')
+    {
+      if (mantissa > 0 || *current != '0')
+      {
+        ++numberOfSignificantDigits;
+      }
+      if (numberOfSignificantDigits <= 18)
+      {
+        mantissa = mantissa * 10 + (*current - '0');
+      }
+      else if (!afterDecimalPoint)
+      {
+        ++exponent;
+      }
+      if (afterDecimalPoint && numberOfSignificantDigits <= 18)
+      {
+        --exponent;
+      }
+      ++numberOfDigits;
+    }
+    else if (*current == '.' && !afterDecimalPoint)
+    {
+      afterDecimalPoint = true;
+    }
+    else
+    {
+      break;
+    }
+  }
+  if (current < valueEnd && (*current == 'e' || *current == 'E') && numberOfDigits > 0)
+  {
+    ++current;
+    bool negativeExponent = false;
+    if (current < valueEnd && (*current == '-' || *current == '+'))
+    {
+      negativeExponent = (*current == '-');
+      ++current;
+    }
+    int explicitExponent = 0;
+    int numberOfExponentDigits = 0;
+    for (; current < valueEnd && *current >= '0' && *current <= '9'; ++current)
+    {
+      explicitExponent = std::min(explicitExponent * 10 + (*current - '0'), 10000);
+      ++numberOfExponentDigits;
+    }
+    if (numberOfExponentDigits == 0)
+    {
+      numberOfDigits = 0; // Invalid exponent, use fallback
+    }
+    exponent += (negativeExponent ? -explicitExponent : explicitExponent);
+  }
+  while (current < valueEnd && *current == ' ')
+  {
+    ++current;
+  }
+
+  // Mantissa and power of ten are both exactly representable, so the result is correctly rounded
+  const vtkTypeUInt64 maximumExactMantissa = (vtkTypeUInt64)1 << 53;
+  if (current == valueEnd && numberOfDigits > 0 && mantissa <= maximumExactMantissa && exponent >= -22 && exponent <= 22)
+  {
+    double value = (exponent < 0 ? (double)mantissa / powersOfTen[-exponent] : (double)mantissa * powersOfTen[exponent]);
+    return (negative ? -value : value);
+  }
+
+  // Fall back to the locale independent parser of DCMTK for anything else
+  OFString valueString(valueStart, valueEnd - valueStart);
+  return OFStandard::atof(valueString.c_str());
+}
+
+//----------------------------------------------------------------------------
+/// Convert little endian dose grid values of the given pixel type to dose. The values are read with memcpy, as they
+/// are not necessarily aligned in the mapped file. The loop has no dependencies between iterations so that it is vectorized.
+template<class T> static void vtkScaleDoseGridValues(const unsigned char* values, vtkIdType numberOfValues, double doseGridScaling, float* doses)
+{
+  for (vtkIdType index = 0; index < numberOfValues; ++index)
+  {
+    T value;
+    memcpy(&value, values + index * sizeof(T), sizeof(T));
+    doses[index] = static_cast<float>(static_cast<double>(value) * doseGridScaling);
+  }
+}
+
 //----------------------------------------------------------------------------
 // vtkInternal methods
 
@@ -228,6 +398,7 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry::RoiEntry(const RoiEntry& src)
   this->SetPolyData(src.PolyData);
   this->ReferencedSeriesUID = src.ReferencedSeriesUID;
   this->ReferencedFrameOfReferenceUID = src.ReferencedFrameOfReferenceUID;
+  this->InterpretedType = src.InterpretedType;
   this->ContourIndexToSOPInstanceUIDMap = src.ContourIndexToSOPInstanceUIDMap;
 }
 
@@ -242,6 +413,7 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry& vtkSlicerDicomRtReader::vtkIntern
   this->SetPolyData(src.PolyData);
   this->ReferencedSeriesUID = src.ReferencedSeriesUID;
   this->ReferencedFrameOfReferenceUID = src.ReferencedFrameOfReferenceUID;
+  this->InterpretedType = src.InterpretedType;
   this->ContourIndexToSOPInstanceUIDMap = src.ContourIndexToSOPInstanceUIDMap;
 
   return (*this);
@@ -466,9 +638,177 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTDose(DcmDataset* dataset)
   // Get and store patient, study and series information
   this->External->GetAndStoreHierarchyInformation(&rtDoseObject);
 
+  // Load dose voxels directly from the file if possible
+  if (!this->LoadRTDoseVoxels(dataset, OFStandard::atof(doseGridScaling.c_str())))
+  {
+    vtkDebugWithObjectMacro(this->External, "LoadRTDose: Pixel data cannot be mapped, dose volume needs to be read separately");
+  }
+
   this->External->LoadRTDoseSuccessful = true;
 }
 
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtReader::vtkInternal::LoadRTDoseVoxels(DcmDataset* dataset, double doseGridScaling)
+{
+  this->DoseImageData = NULL;
+  this->DoseIJKToRASMatrix = NULL;
+
+  // Only native little endian pixel data can be used without conversion
+  E_TransferSyntax transferSyntax = dataset->getOriginalXfer();
+  bool explicitVr = (transferSyntax == EXS_LittleEndianExplicit);
+  if ((!explicitVr && transferSyntax != EXS_LittleEndianImplicit) || gLocalByteOrder != EBO_LittleEndian)
+  {
+    return false;
+  }
+
+  // Pixel format
+  Uint16 samplesPerPixel = 0, bitsAllocated = 0, bitsStored = 0, pixelRepresentation = 0, rows = 0, columns = 0;
+  Sint32 numberOfFrames = 1;
+  if ( dataset->findAndGetUint16(DCM_SamplesPerPixel, samplesPerPixel).bad() || samplesPerPixel != 1
+    || dataset->findAndGetUint16(DCM_BitsAllocated, bitsAllocated).bad() || (bitsAllocated != 16 && bitsAllocated != 32)
+    || dataset->findAndGetUint16(DCM_BitsStored, bitsStored).bad() || bitsStored != bitsAllocated
+    || dataset->findAndGetUint16(DCM_PixelRepresentation, pixelRepresentation).bad() || pixelRepresentation > 1
+    || dataset->findAndGetUint16(DCM_Rows, rows).bad() || rows == 0
+    || dataset->findAndGetUint16(DCM_Columns, columns).bad() || columns == 0 )
+  {
+    return false;
+  }
+  if (dataset->tagExists(DCM_NumberOfFrames) && (dataset->findAndGetSint32(DCM_NumberOfFrames, numberOfFrames).bad() || numberOfFrames < 1))
+  {
+    return false;
+  }
+  vtkIdType numberOfVoxels = (vtkIdType)rows * columns * numberOfFrames;
+  vtkIdType bytesPerVoxel = bitsAllocated / 8;
+  DcmElement* pixelDataElement = NULL;
+  if ( dataset->findAndGetElement(DCM_PixelData, pixelDataElement).bad() || !pixelDataElement
+    || (vtkIdType)pixelDataElement->getLength() != numberOfVoxels * bytesPerVoxel )
+  {
+    return false;
+  }
+
+  // Geometry. Frames are located along the normal of the image plane at the offsets in the grid frame offset vector,
+  // which need to be uniform to be represented by an IJK to RAS matrix.
+  double imagePosition[3] = {0.0, 0.0, 0.0};
+  double imageOrientation[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  for (unsigned long index = 0; index < 6; ++index)
+  {
+    if ( (index < 3 && dataset->findAndGetFloat64(DCM_ImagePositionPatient, imagePosition[index], index).bad())
+      || dataset->findAndGetFloat64(DCM_ImageOrientationPatient, imageOrientation[index], index).bad() )
+    {
+      return false;
+    }
+  }
+  double sliceSpacing = 1.0;
+  if (numberOfFrames > 1)
+  {
+    Float64 firstOffset = 0.0, secondOffset = 0.0;
+    if ( dataset->findAndGetFloat64(DCM_GridFrameOffsetVector, firstOffset, 0).bad()
+      || dataset->findAndGetFloat64(DCM_GridFrameOffsetVector, secondOffset, 1).bad() )
+    {
+      return false;
+    }
+    sliceSpacing = secondOffset - firstOffset;
+    if (fabs(sliceSpacing) < EPSILON)
+    {
+      return false;
+    }
+    for (Sint32 frameIndex = 2; frameIndex < numberOfFrames; ++frameIndex)
+    {
+      Float64 offset = 0.0;
+      if ( dataset->findAndGetFloat64(DCM_GridFrameOffsetVector, offset, frameIndex).bad()
+        || fabs(offset - firstOffset - frameIndex * sliceSpacing) > 0.001 )
+      {
+        vtkDebugWithObjectMacro(this->External, "LoadRTDoseVoxels: Grid frame offset vector is not uniform");
+        return false;
+      }
+    }
+  }
+  else
+  {
+    Float64 sliceThickness = 0.0;
+    if (dataset->findAndGetFloat64(DCM_SliceThickness, sliceThickness).good() && sliceThickness > 0.0)
+    {
+      sliceSpacing = sliceThickness;
+    }
+  }
+
+  // Pixel data is the last element of the dataset in RT Dose files, so it is found at the end of the file.
+  // Its element header is verified before mapping, so that nothing else is read as dose values.
+  QFile file(this->External->FileName);
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    return false;
+  }
+  qint64 pixelDataLength = numberOfVoxels * bytesPerVoxel;
+  qint64 elementHeaderLength = (explicitVr ? 12 : 8);
+  qint64 elementOffset = file.size() - pixelDataLength - elementHeaderLength;
+  if (elementOffset < 0)
+  {
+    return false;
+  }
+  unsigned char* element = file.map(elementOffset, elementHeaderLength + pixelDataLength);
+  if (!element)
+  {
+    return false;
+  }
+  const unsigned char* lengthField = element + elementHeaderLength - 4;
+  Uint32 elementLength = lengthField[0] | (lengthField[1] << 8) | (lengthField[2] << 16) | ((Uint32)lengthField[3] << 24);
+  if ( element[0] != 0xE0 || element[1] != 0x7F || element[2] != 0x10 || element[3] != 0x00
+    || (explicitVr && (element[4] != 'O' || (element[5] != 'W' && element[5] != 'B') || element[6] != 0 || element[7] != 0))
+    || (qint64)elementLength != pixelDataLength )
+  {
+    file.unmap(element);
+    return false;
+  }
+
+  // Convert values straight into the output volume
+  this->DoseImageData = vtkSmartPointer<vtkImageData>::New();
+  this->DoseImageData->SetExtent(0, columns-1, 0, rows-1, 0, numberOfFrames-1);
+  this->DoseImageData->AllocateScalars(VTK_FLOAT, 1);
+  const unsigned char* values = element + elementHeaderLength;
+  float* doses = static_cast<float*>(this->DoseImageData->GetScalarPointer());
+  if (bitsAllocated == 16)
+  {
+    if (pixelRepresentation)
+    {
+      vtkScaleDoseGridValues<vtkTypeInt16>(values, numberOfVoxels, doseGridScaling, doses);
+    }
+    else
+    {
+      vtkScaleDoseGridValues<vtkTypeUInt16>(values, numberOfVoxels, doseGridScaling, doses);
+    }
+  }
+  else
+  {
+    if (pixelRepresentation)
+    {
+      vtkScaleDoseGridValues<vtkTypeInt32>(values, numberOfVoxels, doseGridScaling, doses);
+    }
+    else
+    {
+      vtkScaleDoseGridValues<vtkTypeUInt32>(values, numberOfVoxels, doseGridScaling, doses);
+    }
+  }
+  file.unmap(element);
+
+  // Assemble IJK to LPS matrix from the image plane and frame offsets, then convert it to RAS
+  double rowDirection[3] = { imageOrientation[0], imageOrientation[1], imageOrientation[2] };
+  double columnDirection[3] = { imageOrientation[3], imageOrientation[4], imageOrientation[5] };
+  double sliceDirection[3] = {0.0, 0.0, 0.0};
+  vtkMath::Cross(rowDirection, columnDirection, sliceDirection);
+  this->DoseIJKToRASMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  for (int row = 0; row < 3; ++row)
+  {
+    double lpsToRas = (row < 2 ? -1.0 : 1.0);
+    this->DoseIJKToRASMatrix->SetElement(row, 0, lpsToRas * rowDirection[row] * this->External->PixelSpacing[0]);
+    this->DoseIJKToRASMatrix->SetElement(row, 1, lpsToRas * columnDirection[row] * this->External->PixelSpacing[1]);
+    this->DoseIJKToRASMatrix->SetElement(row, 2, lpsToRas * sliceDirection[row] * sliceSpacing);
+    this->DoseIJKToRASMatrix->SetElement(row, 3, lpsToRas * imagePosition[row]);
+  }
+
+  return true;
+}
+
 //----------------------------------------------------------------------------
 void vtkSlicerDicomRtReader::vtkInternal::LoadRTPlan(DcmDataset* dataset)
 {
@@ -689,6 +1029,9 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTStructureSet(DcmDataset* dataset
   DRTStructureSetROISequence* rtStructureSetROISequenceObject = new DRTStructureSetROISequence(rtStructureSetObject->getStructureSetROISequence());
   this->LoadContoursFromRoiSequence(rtStructureSetROISequenceObject);
 
+  // Read ROI interpreted types (RTROIObservationsSequence)
+  this->LoadRoiObservations(rtStructureSetObject);
+
   // Get referenced anatomical image
   OFString referencedSeriesInstanceUID = this->GetReferencedSeriesInstanceUID(rtStructureSetObject);
 
@@ -701,11 +1044,14 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTStructureSet(DcmDataset* dataset
     return;
   }
 
-  // Read ROIs, iterate over ROI contour sequence
+  // Read ROIs, iterate over ROI contour sequence. Contour data is only collected here, and parsed for all ROIs at once below
+  std::vector<RoiContourData> roiContours;
+  roiContours.reserve(rtROIContourSequenceObject.getNumberOfItems());
   do 
   {
     DRTROIContourSequence::Item &currentRoiObject = rtROIContourSequenceObject.getCurrentItem();
-    RoiEntry* currentRoiEntry = this->LoadContour(currentRoiObject, rtStructureSetObject);
+    roiContours.push_back(RoiContourData());
+    RoiEntry* currentRoiEntry = this->LoadContour(currentRoiObject, rtStructureSetObject, roiContours.back());
     if (currentRoiEntry)
     {
       // Set referenced series UID
@@ -714,6 +1060,16 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTStructureSet(DcmDataset* dataset
   }
   while (rtROIContourSequenceObject.gotoNextItem().good());
 
+  // Parse contour data of the ROIs in parallel and store the poly data in the ROI entries
+  this->ParseRoiContourDataConcurrently(roiContours);
+  for (std::vector<RoiContourData>::iterator roiIt = roiContours.begin(); roiIt != roiContours.end(); ++roiIt)
+  {
+    if (roiIt->Roi && roiIt->PolyData)
+    {
+      roiIt->Roi->SetPolyData(roiIt->PolyData);
+    }
+  }
+
   // SOP instance UID
   OFString sopInstanceUid("");
   if (rtStructureSetObject->getSOPInstanceUID(sopInstanceUid).bad())
@@ -769,9 +1125,43 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadContoursFromRoiSequence(DRTStructu
   while (rtStructureSetROISequenceObject->gotoNextItem().good());
 }
 
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtReader::vtkInternal::LoadRoiObservations(DRTStructureSetIOD* rtStructureSetObject)
+{
+  // RT ROI Observations Sequence is optional, and only the interpreted types are used from it
+  DRTRTROIObservationsSequence &rtROIObservationsSequenceObject = rtStructureSetObject->getRTROIObservationsSequence();
+  if (!rtROIObservationsSequenceObject.gotoFirstItem().good())
+  {
+    return;
+  }
+  do
+  {
+    DRTRTROIObservationsSequence::Item &currentObservationObject = rtROIObservationsSequenceObject.getCurrentItem();
+    if (!currentObservationObject.isValid())
+    {
+      continue;
+    }
+
+    Sint32 referencedRoiNumber = -1;
+    currentObservationObject.getReferencedROINumber(referencedRoiNumber);
+    OFString interpretedType("");
+    currentObservationObject.getRTROIInterpretedType(interpretedType);
+
+    for (unsigned int i=0; i<this->RoiSequenceVector.size(); i++)
+    {
+      if (this->RoiSequenceVector[i].Number == (unsigned int)referencedRoiNumber)
+      {
+        this->RoiSequenceVector[i].InterpretedType = interpretedType.c_str();
+        break;
+      }
+    }
+  }
+  while (rtROIObservationsSequenceObject.gotoNextItem().good());
+}
+
 //----------------------------------------------------------------------------
 vtkSlicerDicomRtReader::vtkInternal::RoiEntry* vtkSlicerDicomRtReader::vtkInternal::LoadContour(
-  DRTROIContourSequence::Item &roiObject, DRTStructureSetIOD* rtStructureSetObject)
+  DRTROIContourSequence::Item &roiObject, DRTStructureSetIOD* rtStructureSetObject, RoiContourData& roiContourData)
 {
   if (!roiObject.isValid())
   {
@@ -801,11 +1191,6 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry* vtkSlicerDicomRtReader::vtkIntern
     return roiEntry;
   }
 
-  // Create containers for contour poly data
-  vtkSmartPointer<vtkPoints> currentRoiContourPoints = vtkSmartPointer<vtkPoints>::New();
-  vtkSmartPointer<vtkCellArray> currentRoiContourCells = vtkSmartPointer<vtkCellArray>::New();
-  vtkIdType pointId = 0;
-
   // Read contour data, iterate over contour sequence
   do
   {
@@ -816,29 +1201,31 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry* vtkSlicerDicomRtReader::vtkIntern
       continue;
     }
 
-    // Get number of contour points
-    OFString numberOfPointsString("");
-    contourItem.getNumberOfContourPoints(numberOfPointsString);
-    std::stringstream ss;
-    ss << numberOfPointsString;
-    int numberOfPoints;
-    ss >> numberOfPoints;
-
-    // Get contour point data
-    OFVector<vtkTypeFloat64> contourData_LPS;
-    contourItem.getContourData(contourData_LPS);
+    // Get contour point data as the whole decimal string, without converting the values
+    OFString contourDataString("");
+    contourItem.getContourData(contourDataString, -1);
 
-    unsigned int contourIndex = currentRoiContourCells->InsertNextCell(numberOfPoints+1);
-    for (int k=0; k<numberOfPoints; k++)
+    // Get number of contour points, and check it against the number of values in the contour data
+    Sint32 numberOfPoints = 0;
+    contourItem.getNumberOfContourPoints(numberOfPoints);
+    vtkIdType numberOfValues = (contourDataString.empty() ? 0 : 1 + (vtkIdType)std::count(contourDataString.begin(), contourDataString.end(), '\\'));
+    if (numberOfPoints <= 0 || numberOfPoints > numberOfValues / 3)
     {
-      // Convert from DICOM LPS -> Slicer RAS
-      currentRoiContourPoints->InsertPoint(pointId, -contourData_LPS[3*k], -contourData_LPS[3*k+1], contourData_LPS[3*k+2]);
-      currentRoiContourCells->InsertCellPoint(pointId);
-      pointId++;
+      if (numberOfPoints != numberOfValues / 3)
+      {
+        vtkWarningWithObjectMacro(this->External, "LoadContour: Number of contour points (" << numberOfPoints << ") does not match contour data ("
+          << numberOfValues << " values) in ROI " << roiEntry->Number << ": " << roiEntry->Name);
+      }
+      numberOfPoints = (Sint32)(numberOfValues / 3);
+    }
+    if (numberOfPoints == 0)
+    {
+      continue;
     }
 
-    // Close the contour
-    currentRoiContourCells->InsertCellPoint(pointId-numberOfPoints);
+    unsigned int contourIndex = (unsigned int)roiContourData.ContourDataStrings.size();
+    roiContourData.ContourDataStrings.push_back(contourDataString);
+    roiContourData.NumberOfContourPoints.push_back(numberOfPoints);
 
     // Add map to the referenced slice instance UID
     // This is not a mandatory field so no error logged if not found. The reason why
@@ -899,20 +1286,8 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry* vtkSlicerDicomRtReader::vtkIntern
     }
   }
 
-  // Save just loaded contour data into ROI entry
-  vtkSmartPointer<vtkPolyData> currentRoiPolyData = vtkSmartPointer<vtkPolyData>::New();
-  currentRoiPolyData->SetPoints(currentRoiContourPoints);
-  if (currentRoiContourPoints->GetNumberOfPoints() == 1)
-  {
-    // Point ROI
-    currentRoiPolyData->SetVerts(currentRoiContourCells);
-  }
-  else if (currentRoiContourPoints->GetNumberOfPoints() > 1)
-  {
-    // Contour ROI
-    currentRoiPolyData->SetLines(currentRoiContourCells);
-  }
-  roiEntry->SetPolyData(currentRoiPolyData);
+  // Contour data is parsed into the ROI entry later
+  roiContourData.Roi = roiEntry;
 
   // Get structure color
   Sint32 roiDisplayColor = -1;
@@ -940,6 +1315,88 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry* vtkSlicerDicomRtReader::vtkIntern
   return roiEntry;
 }
 
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtReader::vtkInternal::ParseRoiContourData(RoiContourData& roiContourData)
+{
+  if (!roiContourData.Roi)
+  {
+    // No contours were collected for the ROI
+    return;
+  }
+
+  // Count points to allocate the points and cells at once
+  vtkIdType numberOfContours = (vtkIdType)roiContourData.ContourDataStrings.size();
+  vtkIdType numberOfPoints = 0;
+  for (vtkIdType contourIndex = 0; contourIndex < numberOfContours; ++contourIndex)
+  {
+    numberOfPoints += roiContourData.NumberOfContourPoints[contourIndex];
+  }
+
+  vtkSmartPointer<vtkPoints> currentRoiContourPoints = vtkSmartPointer<vtkPoints>::New();
+  currentRoiContourPoints->SetNumberOfPoints(numberOfPoints);
+  float* pointCoordinates = vtkFloatArray::SafeDownCast(currentRoiContourPoints->GetData())->GetPointer(0);
+
+  // Each cell contains the number of points, the point IDs, and the first point ID again to close the contour
+  vtkSmartPointer<vtkIdTypeArray> cellPointIds = vtkSmartPointer<vtkIdTypeArray>::New();
+  cellPointIds->SetNumberOfValues(numberOfPoints + 2 * numberOfContours);
+  vtkIdType* cellPointId = cellPointIds->GetPointer(0);
+
+  vtkIdType pointId = 0;
+  for (vtkIdType contourIndex = 0; contourIndex < numberOfContours; ++contourIndex)
+  {
+    const OFString& contourDataString = roiContourData.ContourDataStrings[contourIndex];
+    const char* position = contourDataString.c_str();
+    const char* end = position + contourDataString.length();
+    vtkIdType numberOfContourPoints = roiContourData.NumberOfContourPoints[contourIndex];
+
+    *(cellPointId++) = numberOfContourPoints + 1;
+    for (vtkIdType k = 0; k < numberOfContourPoints; ++k)
+    {
+      // Convert from DICOM LPS -> Slicer RAS
+      *(pointCoordinates++) = -vtkSlicerDicomRtReader::ParseDecimalStringValue(position, end);
+      *(pointCoordinates++) = -vtkSlicerDicomRtReader::ParseDecimalStringValue(position, end);
+      *(pointCoordinates++) = vtkSlicerDicomRtReader::ParseDecimalStringValue(position, end);
+      *(cellPointId++) = pointId++;
+    }
+
+    // Close the contour
+    *(cellPointId++) = pointId - numberOfContourPoints;
+  }
+
+  // Release the text of the parsed contours
+  std::vector<OFString>().swap(roiContourData.ContourDataStrings);
+
+  vtkSmartPointer<vtkCellArray> currentRoiContourCells = vtkSmartPointer<vtkCellArray>::New();
+  currentRoiContourCells->SetCells(numberOfContours, cellPointIds);
+
+  roiContourData.PolyData = vtkSmartPointer<vtkPolyData>::New();
+  roiContourData.PolyData->SetPoints(currentRoiContourPoints);
+  if (numberOfPoints == 1)
+  {
+    // Point ROI
+    roiContourData.PolyData->SetVerts(currentRoiContourCells);
+  }
+  else if (numberOfPoints > 1)
+  {
+    // Contour ROI
+    roiContourData.PolyData->SetLines(currentRoiContourCells);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtReader::vtkInternal::ParseRoiContourDataJob(int jobIndex, int vtkNotUsed(workerIndex), void* roiContours)
+{
+  ParseRoiContourData((*static_cast<std::vector<RoiContourData>*>(roiContours))[jobIndex]);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtReader::vtkInternal::ParseRoiContourDataConcurrently(std::vector<RoiContourData>& roiContours)
+{
+  // ROIs differ a lot in size, so each worker of the pool takes the next unparsed ROI when finished with the previous one
+  vtkSmartPointer<vtkConcurrentJobPool> jobPool = vtkSmartPointer<vtkConcurrentJobPool>::New();
+  jobPool->Execute((int)roiContours.size(), ParseRoiContourDataJob, &roiContours);
+}
+
 //----------------------------------------------------------------------------
 void vtkSlicerDicomRtReader::vtkInternal::LoadRTImage(DcmDataset* dataset)
 {
@@ -1248,6 +1705,18 @@ void vtkSlicerDicomRtReader::PrintSelf(ostream& os, vtkIndent indent)
   this->Superclass::PrintSelf(os, indent);
 }
 
+//----------------------------------------------------------------------------
+vtkImageData* vtkSlicerDicomRtReader::GetDoseImageData()
+{
+  return this->Internal->DoseImageData.GetPointer();
+}
+
+//----------------------------------------------------------------------------
+vtkMatrix4x4* vtkSlicerDicomRtReader::GetDoseIJKToRASMatrix()
+{
+  return this->Internal->DoseIJKToRASMatrix.GetPointer();
+}
+
 //----------------------------------------------------------------------------
 void vtkSlicerDicomRtReader::Update()
 {
@@ -1339,6 +1808,17 @@ const char* vtkSlicerDicomRtReader::GetRoiName(unsigned int internalIndex)
   return (this->Internal->RoiSequenceVector[internalIndex].Name.empty() ? SlicerRtCommon::DICOMRTIMPORT_NO_NAME : this->Internal->RoiSequenceVector[internalIndex].Name).c_str();
 }
 
+//----------------------------------------------------------------------------
+unsigned int vtkSlicerDicomRtReader::GetRoiNumber(unsigned int internalIndex)
+{
+  if (internalIndex >= this->Internal->RoiSequenceVector.size())
+  {
+    vtkErrorMacro("GetRoiNumber: Cannot get ROI with internal index: " << internalIndex);
+    return 0;
+  }
+  return this->Internal->RoiSequenceVector[internalIndex].Number;
+}
+
 //----------------------------------------------------------------------------
 double* vtkSlicerDicomRtReader::GetRoiDisplayColor(unsigned int internalIndex)
 {
@@ -1372,6 +1852,17 @@ const char* vtkSlicerDicomRtReader::GetRoiReferencedSeriesUid(unsigned int inter
   return this->Internal->RoiSequenceVector[internalIndex].ReferencedSeriesUID.c_str();
 }
 
+//----------------------------------------------------------------------------
+const char* vtkSlicerDicomRtReader::GetRoiInterpretedType(unsigned int internalIndex)
+{
+  if (internalIndex >= this->Internal->RoiSequenceVector.size())
+  {
+    vtkErrorMacro("GetRoiInterpretedType: Cannot get ROI with internal index: " << internalIndex);
+    return NULL;
+  }
+  return this->Internal->RoiSequenceVector[internalIndex].InterpretedType.c_str();
+}
+
 //----------------------------------------------------------------------------
 int vtkSlicerDicomRtReader::GetNumberOfBeams()
 {
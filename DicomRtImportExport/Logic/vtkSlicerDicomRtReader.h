@@ -35,6 +35,8 @@
 // VTK includes
 #include <vtkObject.h>
 
+class vtkImageData;
+class vtkMatrix4x4;
 class vtkPolyData;
 
 // Due to some reason the Python wrapping of this class fails, therefore
@@ -57,6 +59,12 @@ public:
   /// Do reading
   void Update();
 
+  /// Parse a decimal string (DS) value starting at the given position, and move the position after the value delimiter.
+  /// Leading and trailing spaces are ignored. Values that cannot be parsed exactly from the characters are parsed by DCMTK.
+  /// \param position Start of the value within the backslash separated values (e.g. contour data). Moved after the delimiter
+  /// \param end End of the backslash separated values
+  static double ParseDecimalStringValue(const char*& position, const char* end);
+
 public:
   /// Get number of created ROIs
   int GetNumberOfRois();
@@ -65,6 +73,10 @@ public:
   /// \param internalIndex Internal index of ROI to get
   const char* GetRoiName(unsigned int internalIndex);
 
+  /// Get ROI number of a certain ROI by internal index (as in the structure set)
+  /// \param internalIndex Internal index of ROI to get
+  unsigned int GetRoiNumber(unsigned int internalIndex);
+
   /// Get display color of a certain ROI by internal index
   /// \param internalIndex Internal index of ROI to get
   double* GetRoiDisplayColor(unsigned int internalIndex);
@@ -77,6 +89,11 @@ public:
   /// \param internalIndex Internal index of ROI to get
   const char* GetRoiReferencedSeriesUid(unsigned int internalIndex);
 
+  /// Get interpreted type (RT ROI Interpreted Type in the RT ROI Observations Sequence) of a certain ROI by internal index
+  /// \param internalIndex Internal index of ROI to get
+  /// \return Interpreted type (e.g. PTV, ORGAN, SUPPORT, MARKER), empty string if not specified
+  const char* GetRoiInterpretedType(unsigned int internalIndex);
+
   /// Get number of beams
   int GetNumberOfBeams();
 
@@ -126,6 +143,12 @@ public:
   /// Set dose grid scaling
   vtkSetStringMacro(DoseGridScaling);
 
+  /// Get dose volume with the dose grid scaling applied, if it could be loaded directly from the uncompressed
+  /// pixel data of the RT Dose file. NULL otherwise, in which case the dose volume needs to be read separately.
+  vtkImageData* GetDoseImageData();
+  /// Get IJK to RAS matrix of the dose volume returned by \sa GetDoseImageData
+  vtkMatrix4x4* GetDoseIJKToRASMatrix();
+
   /// Get RT Plan SOP instance UID referenced by RT Dose
   vtkGetStringMacro(RTDoseReferencedRTPlanSOPInstanceUID);
   /// Set RT Plan SOP instance UID referenced by RT Dose
@@ -0,0 +1,221 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkSlicerDicomRtRepresentationCache.h"
+
+// VTK includes
+#include <vtkErrorCode.h>
+#include <vtkObjectFactory.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataReader.h>
+#include <vtkPolyDataWriter.h>
+#include <vtkSmartPointer.h>
+#include <vtksys/SystemTools.hxx>
+
+// Qt includes
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+
+// STD includes
+#include <sstream>
+
+//----------------------------------------------------------------------------
+/// Version of the cache file contents. Needs to be increased when the converted representations change
+/// for the same input and conversion parameters, so that files created by earlier versions are not used
+static const char* CACHE_FORMAT_VERSION = "1";
+static const char* CACHE_FILE_EXTENSION = ".vtk";
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerDicomRtRepresentationCache);
+
+//----------------------------------------------------------------------------
+vtkSlicerDicomRtRepresentationCache::vtkSlicerDicomRtRepresentationCache()
+{
+  this->CacheDirectory = NULL;
+  this->MaximumCacheSizeMB = 1024;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerDicomRtRepresentationCache::~vtkSlicerDicomRtRepresentationCache()
+{
+  this->SetCacheDirectory(NULL);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtRepresentationCache::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "CacheDirectory: " << (this->CacheDirectory ? this->CacheDirectory : "NULL") << "\n";
+  os << indent << "MaximumCacheSizeMB: " << this->MaximumCacheSizeMB << "\n";
+}
+
+//----------------------------------------------------------------------------
+std::string vtkSlicerDicomRtRepresentationCache::ComputeKey(const std::string& sopInstanceUid, unsigned int roiNumber, const std::string& conversionParameters)
+{
+  std::stringstream keyStream;
+  keyStream << CACHE_FORMAT_VERSION << "\n" << sopInstanceUid << "\n" << roiNumber << "\n" << conversionParameters;
+  std::string keyString = keyStream.str();
+  QByteArray hash = QCryptographicHash::hash(QByteArray(keyString.c_str(), (int)keyString.size()), QCryptographicHash::Sha1);
+  return std::string(hash.toHex().constData());
+}
+
+//----------------------------------------------------------------------------
+std::string vtkSlicerDicomRtRepresentationCache::GetCacheFilePath(const std::string& key)
+{
+  return std::string(this->CacheDirectory) + "/" + key + CACHE_FILE_EXTENSION;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtRepresentationCache::Load(const std::string& key, vtkPolyData* representation)
+{
+  if (!this->CacheDirectory || !this->CacheDirectory[0] || key.empty() || !representation)
+  {
+    return false;
+  }
+  std::string filePath = this->GetCacheFilePath(key);
+  if (!QFileInfo(QString::fromStdString(filePath)).exists())
+  {
+    return false;
+  }
+
+  vtkSmartPointer<vtkPolyDataReader> reader = vtkSmartPointer<vtkPolyDataReader>::New();
+  reader->SetFileName(filePath.c_str());
+  reader->Update();
+  if (reader->GetErrorCode() != vtkErrorCode::NoError)
+  {
+    vtkWarningMacro("Load: Removing invalid cache file " << filePath);
+    this->Lock.Lock();
+    QFile::remove(QString::fromStdString(filePath));
+    this->Lock.Unlock();
+    return false;
+  }
+  representation->ShallowCopy(reader->GetOutput());
+
+  // Mark the file as recently used
+  vtksys::SystemTools::Touch(filePath, false);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtRepresentationCache::Store(const std::string& key, vtkPolyData* representation)
+{
+  if (!this->CacheDirectory || !this->CacheDirectory[0] || key.empty() || !representation)
+  {
+    return false;
+  }
+  if (!QDir().mkpath(QString(this->CacheDirectory)))
+  {
+    vtkErrorMacro("Store: Failed to create cache directory " << this->CacheDirectory);
+    return false;
+  }
+
+  // Write into a temporary file first, so that a partially written file is never loaded. The temporary file is
+  // named by the representation object, as the same representation is not stored by multiple threads at once
+  std::string filePath = this->GetCacheFilePath(key);
+  std::stringstream temporaryFilePathStream;
+  temporaryFilePathStream << filePath << "." << static_cast<void*>(representation) << ".tmp";
+  std::string temporaryFilePath = temporaryFilePathStream.str();
+  vtkSmartPointer<vtkPolyDataWriter> writer = vtkSmartPointer<vtkPolyDataWriter>::New();
+  writer->SetFileName(temporaryFilePath.c_str());
+  writer->SetFileTypeToBinary();
+  writer->SetInputData(representation);
+  if (!writer->Write())
+  {
+    vtkErrorMacro("Store: Failed to write cache file " << temporaryFilePath);
+    QFile::remove(QString::fromStdString(temporaryFilePath));
+    return false;
+  }
+
+  this->Lock.Lock();
+  QFile::remove(QString::fromStdString(filePath));
+  bool success = QFile::rename(QString::fromStdString(temporaryFilePath), QString::fromStdString(filePath));
+  if (success)
+  {
+    this->RemoveLeastRecentlyUsed();
+  }
+  else
+  {
+    QFile::remove(QString::fromStdString(temporaryFilePath));
+  }
+  this->Lock.Unlock();
+
+  if (!success)
+  {
+    vtkErrorMacro("Store: Failed to create cache file " << filePath);
+  }
+  return success;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtRepresentationCache::RemoveLeastRecentlyUsed()
+{
+  // Keep the most recently used files that fit in the maximum size
+  QDir cacheDirectory(QString(this->CacheDirectory));
+  QFileInfoList cacheFiles = cacheDirectory.entryInfoList(
+    QStringList() << QString("*") + CACHE_FILE_EXTENSION, QDir::Files, QDir::Time );
+  vtkTypeInt64 maximumSize = (vtkTypeInt64)this->MaximumCacheSizeMB * 1024 * 1024;
+  vtkTypeInt64 size = 0;
+  for (QFileInfoList::iterator fileIt = cacheFiles.begin(); fileIt != cacheFiles.end(); ++fileIt)
+  {
+    size += fileIt->size();
+    if (size > maximumSize)
+    {
+      vtkDebugMacro("RemoveLeastRecentlyUsed: Removing cache file " << fileIt->absoluteFilePath().toStdString());
+      QFile::remove(fileIt->absoluteFilePath());
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtRepresentationCache::Clear()
+{
+  if (!this->CacheDirectory || !this->CacheDirectory[0])
+  {
+    return;
+  }
+
+  this->Lock.Lock();
+  QDir cacheDirectory(QString(this->CacheDirectory));
+  QFileInfoList cacheFiles = cacheDirectory.entryInfoList(QStringList() << QString("*") + CACHE_FILE_EXTENSION, QDir::Files);
+  for (QFileInfoList::iterator fileIt = cacheFiles.begin(); fileIt != cacheFiles.end(); ++fileIt)
+  {
+    QFile::remove(fileIt->absoluteFilePath());
+  }
+  this->Lock.Unlock();
+}
+
+//----------------------------------------------------------------------------
+vtkTypeInt64 vtkSlicerDicomRtRepresentationCache::GetCacheSize()
+{
+  if (!this->CacheDirectory || !this->CacheDirectory[0])
+  {
+    return 0;
+  }
+
+  this->Lock.Lock();
+  QDir cacheDirectory(QString(this->CacheDirectory));
+  QFileInfoList cacheFiles = cacheDirectory.entryInfoList(QStringList() << QString("*") + CACHE_FILE_EXTENSION, QDir::Files);
+  vtkTypeInt64 size = 0;
+  for (QFileInfoList::iterator fileIt = cacheFiles.begin(); fileIt != cacheFiles.end(); ++fileIt)
+  {
+    size += fileIt->size();
+  }
+  this->Lock.Unlock();
+  return size;
+}
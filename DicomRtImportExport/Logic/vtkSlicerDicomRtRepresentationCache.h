@@ -0,0 +1,106 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkSlicerDicomRtRepresentationCache_h
+#define __vtkSlicerDicomRtRepresentationCache_h
+
+#include "vtkSlicerDicomRtImportExportModuleLogicExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSimpleCriticalSection.h>
+
+// STD includes
+#include <string>
+
+class vtkPolyData;
+
+/// \ingroup SlicerRt_QtModules_DicomRtImport
+/// \brief Persistent cache of segment representations converted from the planar contours of RT structure sets
+///
+/// The representations are stored as binary VTK poly data files in the cache directory, named by a hash of the
+/// SOP instance UID of the structure set, the ROI number and the conversion parameters. As a structure set instance
+/// never changes, a stored representation is valid as long as the conversion parameters are the same.
+/// Only poly data representations (closed surface, ribbon model) are cached. Binary labelmaps depend on the reference
+/// geometry and oversampling of the conversion requesting them, and are not cached.
+/// When the total size of the files exceeds the maximum size, the least recently used files are removed.
+/// The files are touched when loaded, so the modification time of a file is the time it was last used.
+/// Loading and storing can be done from multiple threads.
+class VTK_SLICER_DICOMRTIMPORTEXPORT_LOGIC_EXPORT vtkSlicerDicomRtRepresentationCache : public vtkObject
+{
+public:
+  static vtkSlicerDicomRtRepresentationCache *New();
+  vtkTypeMacro(vtkSlicerDicomRtRepresentationCache, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Compute cache key of a converted representation
+  /// \param sopInstanceUid SOP instance UID of the structure set
+  /// \param roiNumber ROI number of the structure in the structure set
+  /// \param conversionParameters Conversion rule and parameters used for creating the representation
+  static std::string ComputeKey(const std::string& sopInstanceUid, unsigned int roiNumber, const std::string& conversionParameters);
+
+  /// Load representation from the cache
+  /// \param key Cache key computed by \sa ComputeKey
+  /// \param representation Output poly data the cached representation is copied into
+  /// \return True if the representation was found in the cache. An empty representation is a valid cached result
+  bool Load(const std::string& key, vtkPolyData* representation);
+
+  /// Store representation in the cache, then remove the least recently used files if the cache is too large
+  /// \param key Cache key computed by \sa ComputeKey
+  /// \param representation Representation to store
+  /// \return True if the representation was stored successfully
+  bool Store(const std::string& key, vtkPolyData* representation);
+
+  /// Remove all cached representations
+  void Clear();
+
+  /// Get total size of the cached representations in bytes
+  vtkTypeInt64 GetCacheSize();
+
+public:
+  vtkSetStringMacro(CacheDirectory);
+  vtkGetStringMacro(CacheDirectory);
+
+  vtkSetMacro(MaximumCacheSizeMB, int);
+  vtkGetMacro(MaximumCacheSizeMB, int);
+
+protected:
+  /// Get path of the cache file of a key
+  std::string GetCacheFilePath(const std::string& key);
+
+  /// Remove the least recently used files until the total size is within \sa MaximumCacheSizeMB
+  void RemoveLeastRecentlyUsed();
+
+protected:
+  /// Directory containing the cache files. Created when the first representation is stored
+  char* CacheDirectory;
+
+  /// Maximum total size of the cache files in megabytes. Default is 1024
+  int MaximumCacheSizeMB;
+
+  /// Lock serializing changes to the set of cache files
+  vtkSimpleCriticalSection Lock;
+
+protected:
+  vtkSlicerDicomRtRepresentationCache();
+  virtual ~vtkSlicerDicomRtRepresentationCache();
+
+private:
+  vtkSlicerDicomRtRepresentationCache(const vtkSlicerDicomRtRepresentationCache&); // Not implemented
+  void operator=(const vtkSlicerDicomRtRepresentationCache&);                       // Not implemented
+};
+
+#endif
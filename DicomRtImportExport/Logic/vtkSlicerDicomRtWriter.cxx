@@ -132,9 +132,9 @@ void vtkSlicerDicomRtWriter::AddStructure(UCharImageType::Pointer itk_structure,
   
 //----------------------------------------------------------------------------
 void vtkSlicerDicomRtWriter::AddStructure(const char *name, double *color,
-                                          std::vector<int> sliceNumbers,
-                                          std::vector<std::string> sliceUIDs,
-                                          std::vector<vtkPolyData*> sliceContours )
+                                          const std::vector<int>& sliceNumbers,
+                                          const std::vector<std::string>& sliceUIDs,
+                                          const std::vector<vtkPolyData*>& sliceContours )
 {
   if (sliceNumbers.size() != sliceUIDs.size() || sliceNumbers.size() != sliceContours.size())
   {
@@ -162,17 +162,21 @@ void vtkSlicerDicomRtWriter::AddStructure(const char *name, double *color,
     int sliceNumber = sliceNumbers[contourIndex];
     std::string sliceUID = sliceUIDs[contourIndex];
     vtkPolyData* contourPolyData = sliceContours[contourIndex];
-    for (int cellIndex=0; cellIndex<contourPolyData->GetNumberOfCells(); ++cellIndex)
+    vtkPoints* points = contourPolyData->GetPoints();
+    for (vtkIdType cellIndex=0; cellIndex<contourPolyData->GetNumberOfCells(); ++cellIndex)
     {
-      vtkPoints* points = contourPolyData->GetCell(cellIndex)->GetPoints();
-      Rtss_contour* contour = roi->add_polyline(points->GetNumberOfPoints());
+      // Access point IDs of the cell directly instead of creating a cell object for each contour
+      vtkIdType numberOfCellPoints = 0;
+      vtkIdType* cellPointIds = NULL;
+      contourPolyData->GetCellPoints(cellIndex, numberOfCellPoints, cellPointIds);
+      Rtss_contour* contour = roi->add_polyline(numberOfCellPoints);
       contour->slice_no = sliceNumber;
       contour->ct_slice_uid = sliceUID;
 
-      for (int pointIndex=0; pointIndex<points->GetNumberOfPoints(); ++pointIndex)
+      for (vtkIdType pointIndex=0; pointIndex<numberOfCellPoints; ++pointIndex)
       {
         double point[3] = {0.0,0.0,0.0};
-        points->GetPoint(pointIndex, point);
+        points->GetPoint(cellPointIds[pointIndex], point);
         // RAS to LPS conversion
         contour->x[pointIndex] = point[0] * -1.0;
         contour->y[pointIndex] = point[1] * -1.0;
@@ -61,10 +61,13 @@ public:
   /// Add empty structure for direct polyline format to Plastimatch RT study for export.
   /// The three argument vectors contain the slice numbers, UIDs and contours, and need to
   /// contain the same number of elements.
+  /// The contour points are copied into the in-memory RT study, so the contours can be released right after
+  /// the call. Nothing is written to the output file here: the RT study keeps the contours of all structures
+  /// until \sa Write, where Plastimatch encodes the whole structure set at once.
   void AddStructure(const char *name, double *color,
-                    std::vector<int> sliceNumbers,
-                    std::vector<std::string> sliceUIDs,
-                    std::vector<vtkPolyData*> sliceContours);
+                    const std::vector<int>& sliceNumbers,
+                    const std::vector<std::string>& sliceUIDs,
+                    const std::vector<vtkPolyData*>& sliceContours);
   /// Add 
 
   /// TODO: Description, argument names and descriptions
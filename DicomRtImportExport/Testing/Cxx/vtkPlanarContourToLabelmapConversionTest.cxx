@@ -0,0 +1,214 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkIdList.h>
+#include <vtkPointData.h>
+#include <vtkDataArray.h>
+
+// SegmentationCore includes
+#include <vtkSegmentation.h>
+#include <vtkSegment.h>
+#include <vtkSegmentationConverter.h>
+#include <vtkOrientedImageData.h>
+#include <vtkSegmentationConverterFactory.h>
+#include <vtkClosedSurfaceToBinaryLabelmapConversionRule.h>
+#include <vtkPolyDataToFractionalLabelmapFilter.h>
+
+// DicomRTImportExport includes
+#include "vtkPlanarContourToBinaryLabelmapConversionRule.h"
+#include "vtkPlanarContourToFractionalLabelmapConversionRule.h"
+
+void CreateSquareContoursPolyData(vtkPolyData* polyData, int numberOfIslands=1, double zSlopeX=0.0);
+double GetBinaryVoxelCount(vtkPolyData* contoursPolyData, vtkOrientedImageData* referenceGeometry);
+double GetSumOfVoxelValues(vtkOrientedImageData* labelmap, double backgroundValue);
+
+//----------------------------------------------------------------------------
+int vtkPlanarContourToLabelmapConversionTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  // Register converter rules
+  vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
+    vtkSmartPointer<vtkPlanarContourToBinaryLabelmapConversionRule>::New() );
+  vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
+    vtkSmartPointer<vtkPlanarContourToFractionalLabelmapConversionRule>::New() );
+
+  // Generate square contours with square holes
+  vtkNew<vtkPolyData> contoursPolyData;
+  CreateSquareContoursPolyData(contoursPolyData.GetPointer());
+
+  // Create segment
+  vtkNew<vtkSegment> squareSegment;
+  squareSegment->SetName("square1");
+  squareSegment->AddRepresentation(
+    vtkSegmentationConverter::GetSegmentationPlanarContourRepresentationName(), contoursPolyData.GetPointer());
+
+  // Create segmentation with segment
+  vtkNew<vtkSegmentation> squareSegmentation;
+  squareSegmentation->SetMasterRepresentationName(
+    vtkSegmentationConverter::GetSegmentationPlanarContourRepresentationName() );
+  squareSegmentation->AddSegment(squareSegment.GetPointer());
+
+  // Reference geometry with 1x1x2mm spacing, the contour planes coinciding with the slices
+  vtkNew<vtkOrientedImageData> referenceGeometry;
+  referenceGeometry->SetSpacing(1.0, 1.0, 2.0);
+  referenceGeometry->SetExtent(0, 99, 0, 99, 0, 49);
+  squareSegmentation->SetConversionParameter(vtkSegmentationConverter::GetReferenceImageGeometryParameterName(),
+    vtkSegmentationConverter::SerializeImageGeometry(referenceGeometry.GetPointer()) );
+  squareSegmentation->SetConversionParameter(vtkClosedSurfaceToBinaryLabelmapConversionRule::GetOversamplingFactorParameterName(), "1");
+
+  // Binary labelmap: 10x10 voxel squares with 4x4 voxel holes on 5 slices
+  squareSegmentation->CreateRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName());
+  vtkOrientedImageData* binaryLabelmap = vtkOrientedImageData::SafeDownCast(
+    squareSegment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) );
+  if (!binaryLabelmap)
+  {
+    std::cerr << __LINE__ << ": Failed to add binary labelmap representation to segment!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  double expectedBinaryVoxelCount = 5 * (10*10 - 4*4);
+  double binaryVoxelCount = GetSumOfVoxelValues(binaryLabelmap, 0.0);
+  if (binaryVoxelCount != expectedBinaryVoxelCount)
+  {
+    std::cerr << __LINE__ << ": Binary voxel count: " << binaryVoxelCount << " does not match expected value: " << expectedBinaryVoxelCount << "!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Fractional labelmap: the square edges lie on voxel centres in the slices, so the edge voxels are half covered
+  // and the fractional volume is exact
+  squareSegmentation->CreateRepresentation(vtkSegmentationConverter::GetSegmentationFractionalLabelmapRepresentationName());
+  vtkOrientedImageData* fractionalLabelmap = vtkOrientedImageData::SafeDownCast(
+    squareSegment->GetRepresentation(vtkSegmentationConverter::GetSegmentationFractionalLabelmapRepresentationName()) );
+  if (!fractionalLabelmap)
+  {
+    std::cerr << __LINE__ << ": Failed to add fractional labelmap representation to segment!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (fractionalLabelmap->GetScalarType() != VTK_FRACTIONAL_DATA_TYPE)
+  {
+    std::cerr << __LINE__ << ": Fractional labelmap scalar type: " << fractionalLabelmap->GetScalarType() << " does not match expected type: " << VTK_FRACTIONAL_DATA_TYPE << "!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  double expectedFractionalVoxelCount = expectedBinaryVoxelCount;
+  double fractionalVoxelCount = GetSumOfVoxelValues(fractionalLabelmap, FRACTIONAL_MIN) / (FRACTIONAL_MAX - FRACTIONAL_MIN);
+  if (std::abs(fractionalVoxelCount - expectedFractionalVoxelCount) > 0.00001)
+  {
+    std::cerr << __LINE__ << ": Fractional voxel count: " << fractionalVoxelCount << " does not match expected value: " << expectedFractionalVoxelCount << "!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Separated islands: the gap between the contour planes of the islands is not filled
+  vtkNew<vtkPolyData> islandContoursPolyData;
+  CreateSquareContoursPolyData(islandContoursPolyData.GetPointer(), 2);
+  double islandVoxelCount = GetBinaryVoxelCount(islandContoursPolyData.GetPointer(), referenceGeometry.GetPointer());
+  if (islandVoxelCount != 2 * expectedBinaryVoxelCount)
+  {
+    std::cerr << __LINE__ << ": Binary voxel count of separated islands: " << islandVoxelCount << " does not match expected value: " << 2 * expectedBinaryVoxelCount << "!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Contours not parallel to the slices are converted through closed surface. The sheared squares enclose the
+  // same volume as the parallel ones, which the voxelization approximates
+  vtkNew<vtkPolyData> shearedContoursPolyData;
+  CreateSquareContoursPolyData(shearedContoursPolyData.GetPointer(), 1, 0.1);
+  double shearedVoxelCount = GetBinaryVoxelCount(shearedContoursPolyData.GetPointer(), referenceGeometry.GetPointer());
+  if (std::abs(shearedVoxelCount - expectedBinaryVoxelCount) > 0.25 * expectedBinaryVoxelCount)
+  {
+    std::cerr << __LINE__ << ": Binary voxel count of non-parallel contours: " << shearedVoxelCount << " differs from expected value: " << expectedBinaryVoxelCount << " by more than 25%!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Planar contour to labelmap conversion test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+/// Create square contours with square holes on 5 planes 2mm apart for each island. The islands are 40mm apart.
+/// The z coordinate of the points changes by zSlopeX with x, so the contours are not parallel to the xy plane if non-zero
+void CreateSquareContoursPolyData(vtkPolyData* polyData, int numberOfIslands/*=1*/, double zSlopeX/*=0.0*/)
+{
+  if (!polyData)
+    {
+    return;
+    }
+
+  vtkNew<vtkPoints> points;
+  vtkNew<vtkCellArray> lines;
+  for (int islandIndex = 0; islandIndex < numberOfIslands; ++islandIndex)
+    {
+    for (int planeIndex = 0; planeIndex < 5; ++planeIndex)
+      {
+      double z = 40.0 * islandIndex + 2.0 * planeIndex;
+      double squareCorners[2][2] = { { 10.0, 20.0 }, { 13.0, 17.0 } };
+      for (int squareIndex = 0; squareIndex < 2; ++squareIndex)
+        {
+        double minimum = squareCorners[squareIndex][0];
+        double maximum = squareCorners[squareIndex][1];
+        vtkNew<vtkIdList> pointIds;
+        pointIds->InsertNextId(points->InsertNextPoint(minimum, minimum, z + zSlopeX * minimum));
+        pointIds->InsertNextId(points->InsertNextPoint(maximum, minimum, z + zSlopeX * maximum));
+        pointIds->InsertNextId(points->InsertNextPoint(maximum, maximum, z + zSlopeX * maximum));
+        pointIds->InsertNextId(points->InsertNextPoint(minimum, maximum, z + zSlopeX * minimum));
+        pointIds->InsertNextId(pointIds->GetId(0));
+        lines->InsertNextCell(pointIds.GetPointer());
+        }
+      }
+    }
+
+  polyData->SetPoints(points.GetPointer());
+  polyData->SetLines(lines.GetPointer());
+}
+
+//----------------------------------------------------------------------------
+/// Convert contours to binary labelmap in a new segmentation and count the voxels of the segment
+/// \return Number of segment voxels, -1 if the conversion failed
+double GetBinaryVoxelCount(vtkPolyData* contoursPolyData, vtkOrientedImageData* referenceGeometry)
+{
+  vtkNew<vtkSegment> segment;
+  segment->AddRepresentation(vtkSegmentationConverter::GetSegmentationPlanarContourRepresentationName(), contoursPolyData);
+  vtkNew<vtkSegmentation> segmentation;
+  segmentation->SetMasterRepresentationName(vtkSegmentationConverter::GetSegmentationPlanarContourRepresentationName());
+  segmentation->AddSegment(segment.GetPointer());
+  segmentation->SetConversionParameter(vtkSegmentationConverter::GetReferenceImageGeometryParameterName(),
+    vtkSegmentationConverter::SerializeImageGeometry(referenceGeometry) );
+  segmentation->SetConversionParameter(vtkClosedSurfaceToBinaryLabelmapConversionRule::GetOversamplingFactorParameterName(), "1");
+
+  segmentation->CreateRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName());
+  vtkOrientedImageData* binaryLabelmap = vtkOrientedImageData::SafeDownCast(
+    segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) );
+  if (!binaryLabelmap)
+    {
+    return -1.0;
+    }
+  return GetSumOfVoxelValues(binaryLabelmap, 0.0);
+}
+
+//----------------------------------------------------------------------------
+double GetSumOfVoxelValues(vtkOrientedImageData* labelmap, double backgroundValue)
+{
+  double sum = 0.0;
+  vtkIdType numberOfVoxels = labelmap->GetNumberOfPoints();
+  for (vtkIdType voxelIndex = 0; voxelIndex < numberOfVoxels; ++voxelIndex)
+    {
+    sum += labelmap->GetPointData()->GetScalars()->GetTuple1(voxelIndex) - backgroundValue;
+    }
+  return sum;
+}
@@ -0,0 +1,251 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkSphereSource.h>
+#include <vtkCubeSource.h>
+#include <vtkTriangleFilter.h>
+#include <vtkAppendPolyData.h>
+#include <vtkCleanPolyData.h>
+
+// SlicerRtCommon includes
+#include "vtkPolyDataMultiPlaneCutter.h"
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+double GetDistanceFromContour(double point[3], vtkPolyData* contours);
+
+//----------------------------------------------------------------------------
+int vtkPolyDataMultiPlaneCutterTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  // Sphere of radius 10 centered at the origin
+  double radius = 10.0;
+  vtkNew<vtkSphereSource> sphereSource;
+  sphereSource->SetRadius(radius);
+  sphereSource->SetThetaResolution(32);
+  sphereSource->SetPhiResolution(32);
+  sphereSource->Update();
+
+  // Axial planes from -11.5 to 11.5, the ones with an absolute position less than the radius intersect the sphere
+  double firstPlanePosition = -11.5;
+  int numberOfPlanes = 24;
+  vtkNew<vtkPolyDataMultiPlaneCutter> cutter;
+  cutter->SetInputPolyData(sphereSource->GetOutput());
+  cutter->SetOrigin(0.0, 0.0, firstPlanePosition);
+  cutter->SetNormal(0.0, 0.0, 2.0); // Normalized by the cutter
+  cutter->SetSpacing(1.0);
+  cutter->SetNumberOfPlanes(numberOfPlanes);
+  cutter->Update();
+  std::vector<vtkSmartPointer<vtkPolyData> > fullContours(numberOfPlanes);
+
+  for (int planeIndex = 0; planeIndex < numberOfPlanes; ++planeIndex)
+    {
+    double planePosition = firstPlanePosition + planeIndex;
+    vtkPolyData* contours = cutter->GetPlaneContours(planeIndex);
+    if (std::abs(planePosition) > radius)
+      {
+      if (contours)
+        {
+        std::cerr << __LINE__ << ": Plane " << planeIndex << " does not intersect the sphere but has contours!" << std::endl;
+        return EXIT_FAILURE;
+        }
+      continue;
+      }
+
+    // Each intersecting plane contains a single closed contour with all points on the plane and on the sphere
+    if (!contours || contours->GetNumberOfCells() != 1)
+      {
+      std::cerr << __LINE__ << ": Plane " << planeIndex << " has " << (contours ? contours->GetNumberOfCells() : 0)
+        << " contours instead of one!" << std::endl;
+      return EXIT_FAILURE;
+      }
+    vtkIdType numberOfContourPoints = 0;
+    vtkIdType* contourPointIds = NULL;
+    contours->GetPolys()->InitTraversal();
+    contours->GetPolys()->GetNextCell(numberOfContourPoints, contourPointIds);
+    if (numberOfContourPoints != 64)
+      {
+      std::cerr << __LINE__ << ": Contour on plane " << planeIndex << " has " << numberOfContourPoints
+        << " points instead of 64 (one for each crossed edge)!" << std::endl;
+      return EXIT_FAILURE;
+      }
+    double expectedRadius = sqrt(radius*radius - planePosition*planePosition);
+    for (vtkIdType index = 0; index < numberOfContourPoints; ++index)
+      {
+      double point[3] = {0.0, 0.0, 0.0};
+      contours->GetPoint(contourPointIds[index], point);
+      double pointRadius = sqrt(point[0]*point[0] + point[1]*point[1]);
+      if ( std::abs(point[2] - planePosition) > 1e-6
+        || pointRadius > expectedRadius + 1e-6 || pointRadius < 0.98 * expectedRadius )
+        {
+        std::cerr << __LINE__ << ": Contour point (" << point[0] << ", " << point[1] << ", " << point[2]
+          << ") on plane " << planeIndex << " is not on the sphere!" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    fullContours[planeIndex] = contours;
+    }
+  if (cutter->GetNumberOfNonManifoldEdges() != 0 || cutter->GetNumberOfOpenContours() != 0)
+    {
+    std::cerr << __LINE__ << ": Sphere has " << cutter->GetNumberOfNonManifoldEdges() << " non-manifold edge crossings and "
+      << cutter->GetNumberOfOpenContours() << " open contours instead of none!" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Reduce the contours with 0.1mm tolerance. All points of the full contours need to be within tolerance from the
+  // reduced ones, and the reported deviation needs to be within tolerance as well
+  double tolerance = 0.1;
+  cutter->SetContourTolerance(tolerance);
+  cutter->Update();
+  if (cutter->GetMaximumContourDeviation() <= 0.0 || cutter->GetMaximumContourDeviation() > tolerance)
+    {
+    std::cerr << __LINE__ << ": Maximum contour deviation " << cutter->GetMaximumContourDeviation()
+      << " is not between 0 and the tolerance " << tolerance << "!" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int planeIndex = 0; planeIndex < numberOfPlanes; ++planeIndex)
+    {
+    vtkPolyData* fullContour = fullContours[planeIndex];
+    vtkPolyData* reducedContour = cutter->GetPlaneContours(planeIndex);
+    if (!fullContour)
+      {
+      continue;
+      }
+    if (!reducedContour || reducedContour->GetNumberOfCells() != 1)
+      {
+      std::cerr << __LINE__ << ": Plane " << planeIndex << " does not have a single reduced contour!" << std::endl;
+      return EXIT_FAILURE;
+      }
+    vtkIdType numberOfReducedPoints = 0;
+    vtkIdType* reducedPointIds = NULL;
+    reducedContour->GetPolys()->InitTraversal();
+    reducedContour->GetPolys()->GetNextCell(numberOfReducedPoints, reducedPointIds);
+    if (numberOfReducedPoints < 3 || numberOfReducedPoints >= 64)
+      {
+      std::cerr << __LINE__ << ": Reduced contour on plane " << planeIndex << " has " << numberOfReducedPoints
+        << " points instead of less than 64!" << std::endl;
+      return EXIT_FAILURE;
+      }
+    vtkIdType numberOfFullPoints = 0;
+    vtkIdType* fullPointIds = NULL;
+    fullContour->GetPolys()->InitTraversal();
+    fullContour->GetPolys()->GetNextCell(numberOfFullPoints, fullPointIds);
+    for (vtkIdType index = 0; index < numberOfFullPoints; ++index)
+      {
+      double point[3] = {0.0, 0.0, 0.0};
+      fullContour->GetPoint(fullPointIds[index], point);
+      double distance = GetDistanceFromContour(point, reducedContour);
+      if (distance > tolerance + 1e-9)
+        {
+        std::cerr << __LINE__ << ": Contour point (" << point[0] << ", " << point[1] << ", " << point[2]
+          << ") on plane " << planeIndex << " is " << distance << " away from the reduced contour!" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  // Two cubes touching along a vertical edge, so that four triangles share the edge. Each cube section crosses four
+  // vertical edges and four face diagonals, so none of the 16 segments may be lost, and the contours need to be closed
+  vtkNew<vtkAppendPolyData> appendCubes;
+  for (int cubeIndex = 0; cubeIndex < 2; ++cubeIndex)
+    {
+    vtkNew<vtkCubeSource> cubeSource;
+    cubeSource->SetCenter(2.0 * cubeIndex, 2.0 * cubeIndex, 0.0);
+    cubeSource->SetXLength(2.0);
+    cubeSource->SetYLength(2.0);
+    cubeSource->SetZLength(2.0);
+    vtkNew<vtkTriangleFilter> triangleFilter;
+    triangleFilter->SetInputConnection(cubeSource->GetOutputPort());
+    appendCubes->AddInputConnection(triangleFilter->GetOutputPort());
+    }
+  vtkNew<vtkCleanPolyData> mergeCubePoints;
+  mergeCubePoints->SetInputConnection(appendCubes->GetOutputPort());
+  mergeCubePoints->Update();
+
+  vtkNew<vtkPolyDataMultiPlaneCutter> nonManifoldCutter;
+  nonManifoldCutter->SetInputPolyData(mergeCubePoints->GetOutput());
+  nonManifoldCutter->SetOrigin(0.0, 0.0, 0.5);
+  nonManifoldCutter->SetNormal(0.0, 0.0, 1.0);
+  nonManifoldCutter->SetNumberOfPlanes(1);
+  nonManifoldCutter->Update();
+  if (nonManifoldCutter->GetNumberOfNonManifoldEdges() != 1 || nonManifoldCutter->GetNumberOfOpenContours() != 0)
+    {
+    std::cerr << __LINE__ << ": Touching cubes have " << nonManifoldCutter->GetNumberOfNonManifoldEdges() << " non-manifold edge crossings and "
+      << nonManifoldCutter->GetNumberOfOpenContours() << " open contours instead of one and none!" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkPolyData* cubeContours = nonManifoldCutter->GetPlaneContours(0);
+  vtkIdType numberOfCubeContourPoints = 0;
+  if (cubeContours)
+    {
+    vtkIdType numberOfPoints = 0;
+    vtkIdType* pointIds = NULL;
+    for (cubeContours->GetPolys()->InitTraversal(); cubeContours->GetPolys()->GetNextCell(numberOfPoints, pointIds); )
+      {
+      numberOfCubeContourPoints += numberOfPoints;
+      }
+    }
+  if (numberOfCubeContourPoints != 16)
+    {
+    std::cerr << __LINE__ << ": Contours of the touching cubes have " << numberOfCubeContourPoints
+      << " points instead of 16 (one for each segment)!" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Poly data multi-plane cutter test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+double GetDistanceFromContour(double point[3], vtkPolyData* contours)
+{
+  vtkIdType numberOfPoints = 0;
+  vtkIdType* pointIds = NULL;
+  contours->GetPolys()->InitTraversal();
+  contours->GetPolys()->GetNextCell(numberOfPoints, pointIds);
+  double minimumDistance = VTK_DOUBLE_MAX;
+  for (vtkIdType index = 0; index < numberOfPoints; ++index)
+    {
+    double segmentStart[3] = {0.0, 0.0, 0.0};
+    double segmentEnd[3] = {0.0, 0.0, 0.0};
+    contours->GetPoint(pointIds[index], segmentStart);
+    contours->GetPoint(pointIds[(index + 1) % numberOfPoints], segmentEnd);
+    double segment[3] = { segmentEnd[0] - segmentStart[0], segmentEnd[1] - segmentStart[1], segmentEnd[2] - segmentStart[2] };
+    double vector[3] = { point[0] - segmentStart[0], point[1] - segmentStart[1], point[2] - segmentStart[2] };
+    double segmentLengthSquared = segment[0]*segment[0] + segment[1]*segment[1] + segment[2]*segment[2];
+    double t = 0.0;
+    if (segmentLengthSquared > 0.0)
+      {
+      t = (vector[0]*segment[0] + vector[1]*segment[1] + vector[2]*segment[2]) / segmentLengthSquared;
+      t = std::max(0.0, std::min(1.0, t));
+      }
+    double distanceSquared = 0.0;
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      distanceSquared += (vector[axis] - t*segment[axis]) * (vector[axis] - t*segment[axis]);
+      }
+    minimumDistance = std::min(minimumDistance, sqrt(distanceSquared));
+    }
+  return minimumDistance;
+}
@@ -0,0 +1,102 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// DicomRtImportExport includes
+#include "vtkSlicerDicomRtReader.h"
+
+// DCMTK includes
+#include <dcmtk/ofstd/ofstd.h>
+
+// STD includes
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+int vtkSlicerDicomRtReaderDecimalStringTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  // Values are parsed from one backslash separated string, as contour data is
+  std::vector<std::string> values;
+  values.push_back("1.5");
+  values.push_back("-12.25");                      // Sign
+  values.push_back("+3");
+  values.push_back("-0");
+  values.push_back("   4.75");                     // Leading spaces
+  values.push_back("5.5   ");                      // Trailing spaces
+  values.push_back("  -6.125 ");
+  values.push_back("1e3");                         // Exponent
+  values.push_back("2.5E-4");
+  values.push_back("-3.25e+2");
+  values.push_back("7.1e-30");                     // Exponent beyond the exactly representable powers of ten
+  values.push_back("1e");                          // Invalid exponent
+  values.push_back("1234567890123456789012");      // More than 18 digits
+  values.push_back("-0.1234567890123456789012");
+  values.push_back("98765432109876543.21");
+  values.push_back("0.000001234");                 // Leading zeros after the point
+  values.push_back("-0.0000000000000000012345");
+  values.push_back("0.1");
+  values.push_back("");                            // Empty values between backslashes
+  values.push_back("");
+  values.push_back("-117.0891");
+  values.push_back("  ");
+  values.push_back("42");
+
+  std::string decimalString;
+  for (unsigned int valueIndex = 0; valueIndex < values.size(); ++valueIndex)
+  {
+    decimalString += (valueIndex > 0 ? "\\" : "") + values[valueIndex];
+  }
+
+  const char* position = decimalString.c_str();
+  const char* end = position + decimalString.length();
+  for (unsigned int valueIndex = 0; valueIndex < values.size(); ++valueIndex)
+  {
+    double parsedValue = vtkSlicerDicomRtReader::ParseDecimalStringValue(position, end);
+    double expectedValue = OFStandard::atof(values[valueIndex].c_str());
+    if (fabs(parsedValue - expectedValue) > 2.0 * DBL_EPSILON * std::max(fabs(expectedValue), DBL_MIN))
+    {
+      std::cerr << __LINE__ << ": Value '" << values[valueIndex] << "' parsed as " << parsedValue
+        << " instead of " << expectedValue << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (position != end)
+  {
+    std::cerr << __LINE__ << ": Position is not at the end of the string after parsing all values!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Values with at most 15 significant digits are parsed exactly (to the nearest double, as the compiler does)
+  const char* exactValueStrings[] = { "0.1", "-117.0891", "123.456789012345", "0.000001234", "2.5E-4", "1e22" };
+  const double exactValues[] = { 0.1, -117.0891, 123.456789012345, 0.000001234, 2.5E-4, 1e22 };
+  for (unsigned int valueIndex = 0; valueIndex < sizeof(exactValues) / sizeof(exactValues[0]); ++valueIndex)
+  {
+    position = exactValueStrings[valueIndex];
+    end = position + strlen(exactValueStrings[valueIndex]);
+    double parsedValue = vtkSlicerDicomRtReader::ParseDecimalStringValue(position, end);
+    if (parsedValue != exactValues[valueIndex])
+    {
+      std::cerr << __LINE__ << ": Value '" << exactValueStrings[valueIndex] << "' parsed as " << parsedValue
+        << " is not exactly " << exactValues[valueIndex] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSphereSource.h>
+#include <vtksys/SystemTools.hxx>
+
+// Qt includes
+#include <QDir>
+
+// DicomRtImportExport includes
+#include "vtkSlicerDicomRtRepresentationCache.h"
+
+//----------------------------------------------------------------------------
+int vtkSlicerDicomRtRepresentationCacheTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkSphereSource> sphereSource;
+  sphereSource->SetRadius(10.0);
+  sphereSource->SetThetaResolution(32);
+  sphereSource->SetPhiResolution(32);
+  sphereSource->Update();
+  vtkPolyData* sphere = sphereSource->GetOutput();
+
+  // Keys differ if any of the identifying values differ
+  std::string key = vtkSlicerDicomRtRepresentationCache::ComputeKey("1.2.3.4", 1, "Closed surface");
+  if ( key != vtkSlicerDicomRtRepresentationCache::ComputeKey("1.2.3.4", 1, "Closed surface")
+    || key == vtkSlicerDicomRtRepresentationCache::ComputeKey("1.2.3.4", 2, "Closed surface")
+    || key == vtkSlicerDicomRtRepresentationCache::ComputeKey("1.2.3.5", 1, "Closed surface")
+    || key == vtkSlicerDicomRtRepresentationCache::ComputeKey("1.2.3.4", 1, "Ribbon model") )
+  {
+    std::cerr << __LINE__ << ": Cache keys do not identify the representations!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  QDir cacheDirectory(QDir::temp().filePath("vtkSlicerDicomRtRepresentationCacheTest"));
+  vtkNew<vtkSlicerDicomRtRepresentationCache> cache;
+  cache->SetCacheDirectory(cacheDirectory.absolutePath().toStdString().c_str());
+  cache->Clear();
+
+  // Not yet stored
+  vtkNew<vtkPolyData> loadedRepresentation;
+  if (cache->Load(key, loadedRepresentation.GetPointer()))
+  {
+    std::cerr << __LINE__ << ": Representation found in empty cache!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Store and load
+  if (!cache->Store(key, sphere))
+  {
+    std::cerr << __LINE__ << ": Failed to store representation!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (!cache->Load(key, loadedRepresentation.GetPointer()))
+  {
+    std::cerr << __LINE__ << ": Failed to load stored representation!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if ( loadedRepresentation->GetNumberOfPoints() != sphere->GetNumberOfPoints()
+    || loadedRepresentation->GetNumberOfPolys() != sphere->GetNumberOfPolys() )
+  {
+    std::cerr << __LINE__ << ": Loaded representation with " << loadedRepresentation->GetNumberOfPoints() << " points and "
+      << loadedRepresentation->GetNumberOfPolys() << " polygons does not match stored representation with "
+      << sphere->GetNumberOfPoints() << " points and " << sphere->GetNumberOfPolys() << " polygons!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (cache->GetCacheSize() <= 0)
+  {
+    std::cerr << __LINE__ << ": Cache size is not positive after storing a representation!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Representations are removed when exceeding the maximum size
+  cache->SetMaximumCacheSizeMB(0);
+  std::string otherKey = vtkSlicerDicomRtRepresentationCache::ComputeKey("1.2.3.4", 2, "Closed surface");
+  cache->Store(otherKey, sphere);
+  if (cache->Load(key, loadedRepresentation.GetPointer()) || cache->Load(otherKey, loadedRepresentation.GetPointer()))
+  {
+    std::cerr << __LINE__ << ": Representation not removed from cache exceeding the maximum size!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Empty representations are valid results
+  cache->SetMaximumCacheSizeMB(1024);
+  vtkNew<vtkPolyData> emptyRepresentation;
+  if (!cache->Store(key, emptyRepresentation.GetPointer()) || !cache->Load(key, loadedRepresentation.GetPointer()))
+  {
+    std::cerr << __LINE__ << ": Failed to store and load empty representation!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (loadedRepresentation->GetNumberOfPoints() != 0)
+  {
+    std::cerr << __LINE__ << ": Loaded representation with " << loadedRepresentation->GetNumberOfPoints()
+      << " points does not match stored empty representation!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  cache->Clear();
+
+  // Only the least recently used representation is removed when exceeding the maximum size.
+  // Each representation is stored in about 0.4MB, so two of them fit in the 1MB cache but three do not
+  vtkNew<vtkPoints> points;
+  for (int pointIndex = 0; pointIndex < 35000; ++pointIndex)
+  {
+    points->InsertNextPoint(pointIndex, 0.0, 0.0);
+  }
+  vtkNew<vtkPolyData> largeRepresentation;
+  largeRepresentation->SetPoints(points.GetPointer());
+  std::string thirdKey = vtkSlicerDicomRtRepresentationCache::ComputeKey("1.2.3.4", 3, "Closed surface");
+  cache->SetMaximumCacheSizeMB(1);
+  // Wait between the operations, as file modification times may only have a resolution of one second
+  cache->Store(key, largeRepresentation.GetPointer());
+  vtksys::SystemTools::Delay(1100);
+  cache->Store(otherKey, largeRepresentation.GetPointer());
+  vtksys::SystemTools::Delay(1100);
+  // Loading makes the first representation the most recently used one
+  if (!cache->Load(key, loadedRepresentation.GetPointer()))
+  {
+    std::cerr << __LINE__ << ": Failed to load representation fitting in the cache!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtksys::SystemTools::Delay(1100);
+  cache->Store(thirdKey, largeRepresentation.GetPointer());
+  if (cache->Load(otherKey, loadedRepresentation.GetPointer()))
+  {
+    std::cerr << __LINE__ << ": Least recently used representation not removed from cache exceeding the maximum size!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (!cache->Load(key, loadedRepresentation.GetPointer()) || !cache->Load(thirdKey, loadedRepresentation.GetPointer()))
+  {
+    std::cerr << __LINE__ << ": Recently used representation removed from cache exceeding the maximum size!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Clear
+  cache->SetMaximumCacheSizeMB(1024);
+  cache->Store(key, sphere);
+  cache->Clear();
+  if (cache->GetCacheSize() != 0 || cache->Load(key, loadedRepresentation.GetPointer()))
+  {
+    std::cerr << __LINE__ << ": Representation not removed when clearing the cache!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  cacheDirectory.rmdir(cacheDirectory.absolutePath());
+
+  std::cout << "Representation cache test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
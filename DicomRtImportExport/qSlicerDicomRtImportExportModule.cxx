@@ -27,6 +27,7 @@
 // Qt includes
 #include <QDebug> 
 #include <QtPlugin>
+#include <QTimer>
 
 // Slicer includes
 #include <qSlicerCoreApplication.h>
@@ -51,6 +52,10 @@ class qSlicerDicomRtImportExportModulePrivate
 {
 public:
   qSlicerDicomRtImportExportModulePrivate();
+
+  /// Timer for adding the segment representations converted in the background on the main thread.
+  /// Only runs while background conversion is in progress
+  QTimer BackgroundConversionTimer;
 };
 
 //-----------------------------------------------------------------------------
@@ -159,6 +164,34 @@ void qSlicerDicomRtImportExportModule::setup()
   // Register Subject Hierarchy plugins
   qSlicerSubjectHierarchyPluginHandler::instance()->registerPlugin(new qSlicerSubjectHierarchyRtImagePlugin());
   qSlicerSubjectHierarchyPluginHandler::instance()->registerPlugin(new qSlicerSubjectHierarchyRtDoseVolumePlugin());
+
+  // Poll background conversion of the deferred structures while it is in progress
+  Q_D(qSlicerDicomRtImportExportModule);
+  d->BackgroundConversionTimer.setInterval(200);
+  connect(&d->BackgroundConversionTimer, SIGNAL(timeout()), this, SLOT(processBackgroundConversions()));
+  qvtkConnect(dicomRtImportExportLogic, vtkSlicerDicomRtImportExportModuleLogic::BackgroundConversionStartedEvent,
+    this, SLOT(onBackgroundConversionStarted()));
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerDicomRtImportExportModule::onBackgroundConversionStarted()
+{
+  Q_D(qSlicerDicomRtImportExportModule);
+  if (!d->BackgroundConversionTimer.isActive())
+  {
+    d->BackgroundConversionTimer.start();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerDicomRtImportExportModule::processBackgroundConversions()
+{
+  Q_D(qSlicerDicomRtImportExportModule);
+  vtkSlicerDicomRtImportExportModuleLogic* dicomRtImportExportLogic = vtkSlicerDicomRtImportExportModuleLogic::SafeDownCast(this->logic());
+  if (!dicomRtImportExportLogic || !dicomRtImportExportLogic->ProcessBackgroundConversions())
+  {
+    d->BackgroundConversionTimer.stop();
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -25,6 +25,9 @@
 // SlicerQt includes
 #include "qSlicerLoadableModule.h"
 
+// CTK includes
+#include <ctkVTKObject.h>
+
 #include "qSlicerDicomRtImportExportModuleExport.h"
 
 class qSlicerDicomRtImportExportModulePrivate;
@@ -34,6 +37,7 @@ class Q_SLICER_QTMODULES_DICOMRTIMPORTEXPORT_EXPORT qSlicerDicomRtImportExportMo
   public qSlicerLoadableModule
 {
   Q_OBJECT
+  QVTK_OBJECT
   Q_INTERFACES(qSlicerLoadableModule);
 
 public:
@@ -62,6 +66,14 @@ public:
   /// List dependencies
   virtual QStringList dependencies()const;
 
+protected slots:
+  /// Start polling the background conversion of deferred segments
+  void onBackgroundConversionStarted();
+
+  /// Add the segment representations converted in the background to the segmentations.
+  /// Polling stops when no background conversion is in progress
+  void processBackgroundConversions();
+
 protected:
 
   /// Initialize the module. Register the volumes reader/writer
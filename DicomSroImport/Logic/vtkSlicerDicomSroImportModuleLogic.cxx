@@ -30,6 +30,7 @@
 
 // SlicerRT includes
 #include "SlicerRtCommon.h"
+#include "vtkConcurrentJobPool.h"
 
 // DCMTK includes
 #include <dcmtk/dcmdata/dcfilefo.h>
@@ -79,107 +80,129 @@ void vtkSlicerDicomSroImportModuleLogic::RegisterNodes()
 {
 }
 
+//---------------------------------------------------------------------------
+/// Files to examine by the workers of a job pool
+class vtkDicomSroExamineJobs
+{
+public:
+  /// Files to examine. Only read by the workers
+  std::vector<std::string> FileNames;
+  /// Names of the loadables, empty if the file does not contain a registration object.
+  /// Each element is only written by the worker processing the job
+  std::vector<std::string> LoadableNames;
+};
+
+//---------------------------------------------------------------------------
+/// Examine a DICOM file and assemble the loadable name if it contains a spatial registration object
+/// \return Loadable name, empty string if the file does not contain a supported object
+static std::string vtkExamineDicomSroFile(const std::string& fileName)
+{
+  DcmFileFormat fileformat;
+  OFCondition result;
+  result = fileformat.loadFile(fileName.c_str(), EXS_Unknown);
+  if (!result.good())
+  {
+    return ""; // Failed to parse this file, skip it
+  }
+  DcmDataset *dataset = fileformat.getDataset();
+  // Check SOP Class UID for one of the supported RT objects
+  OFString sopClass;
+  if (!dataset->findAndGetOFString(DCM_SOPClassUID, sopClass).good() || sopClass.empty())
+  {
+    return ""; // Failed to parse this file, skip it
+  }
+
+  // DICOM parsing is successful, now check if the object is loadable
+  std::string name;
+  OFString seriesNumber;
+  dataset->findAndGetOFString(DCM_SeriesNumber, seriesNumber);
+  if (!seriesNumber.empty())
+  {
+    name+=std::string(seriesNumber.c_str())+": ";
+  }
+
+  if (sopClass == UID_SpatialRegistrationStorage)
+  {
+    name+="SpatialReg";
+  }
+  else if (sopClass == UID_SpatialFiducialsStorage)
+  {
+    name+="SpatialFid";
+  }
+  else if (sopClass == UID_DeformableSpatialRegistrationStorage)
+  {
+    name+="DeformableReg";
+  }
+  else
+  {
+    return ""; // not an registration object
+  }
+
+  OFString instanceNumber;
+  dataset->findAndGetOFString(DCM_InstanceNumber, instanceNumber);
+  OFString seriesDescription;
+  dataset->findAndGetOFString(DCM_SeriesDescription, seriesDescription);
+  if (!seriesDescription.empty())
+  {
+    name+=std::string(": ")+seriesDescription.c_str();
+  }
+  if (!instanceNumber.empty())
+  {
+    name+=std::string(" [")+instanceNumber.c_str()+"]";
+  }
+  return name;
+}
+
+//---------------------------------------------------------------------------
+static void vtkDicomSroExamineJob(int jobIndex, int vtkNotUsed(workerIndex), void* userData)
+{
+  vtkDicomSroExamineJobs* jobs = static_cast<vtkDicomSroExamineJobs*>(userData);
+  jobs->LoadableNames[jobIndex] = vtkExamineDicomSroFile(jobs->FileNames[jobIndex]);
+}
+
 //---------------------------------------------------------------------------
 void vtkSlicerDicomSroImportModuleLogic::Examine(vtkDICOMImportInfo *importInfo)
 {
   importInfo->RemoveAllLoadables();
 
+  // Examine the files of all file lists on worker threads, so that the I/O latency of reading the files is hidden
+  vtkDicomSroExamineJobs jobs;
   for (int fileListIndex=0; fileListIndex<importInfo->GetNumberOfFileLists(); fileListIndex++)
   {
     vtkStringArray *fileList=importInfo->GetFileList(fileListIndex);
     for (int fileIndex=0; fileIndex<fileList->GetNumberOfValues(); fileIndex++)
     {
-      DcmFileFormat fileformat;
-
-      vtkStdString fileName=fileList->GetValue(fileIndex);
-      OFCondition result;
-      result = fileformat.loadFile(fileName.c_str(), EXS_Unknown);
-      if (!result.good())
-      {
-        continue; // Failed to parse this file, skip it
-      }
-      DcmDataset *dataset = fileformat.getDataset();
-      // Check SOP Class UID for one of the supported RT objects
-      OFString sopClass;
-      if (!dataset->findAndGetOFString(DCM_SOPClassUID, sopClass).good() || sopClass.empty())
-      {
-        continue; // Failed to parse this file, skip it
-      }    
-      
-      // DICOM parsing is successful, now check if the object is loadable 
-      std::string name;
-      std::string tooltip;
-      std::string warning;
-      bool selected=true;
-      double confidence=0.9; // Almost sure, it's not 1.0 to allow user modules to override this importer
-
-      OFString seriesNumber;
-      dataset->findAndGetOFString(DCM_SeriesNumber, seriesNumber);
-      if (!seriesNumber.empty())
-      {
-        name+=std::string(seriesNumber.c_str())+": ";
-      }
-
-      if (sopClass == UID_SpatialRegistrationStorage)
-      {
-        name+="SpatialReg";
-        OFString instanceNumber;
-        dataset->findAndGetOFString(DCM_InstanceNumber, instanceNumber);
-        OFString seriesDescription;
-        dataset->findAndGetOFString(DCM_SeriesDescription, seriesDescription);
-        if (!seriesDescription.empty())
-        {
-          name+=std::string(": ")+seriesDescription.c_str(); 
-        }
-        if (!instanceNumber.empty())
-        {
-          name+=std::string(" [")+instanceNumber.c_str()+"]"; 
-        }
-      }
-      else if (sopClass == UID_SpatialFiducialsStorage)
-      {
-        name+="SpatialFid";
-        OFString instanceNumber;
-        dataset->findAndGetOFString(DCM_InstanceNumber, instanceNumber);
-        OFString seriesDescription;
-        dataset->findAndGetOFString(DCM_SeriesDescription, seriesDescription);
-        if (!seriesDescription.empty())
-        {
-          name+=std::string(": ")+seriesDescription.c_str(); 
-        }
-        if (!instanceNumber.empty())
-        {
-          name+=std::string(" [")+instanceNumber.c_str()+"]"; 
-        }
-      }
-      else if (sopClass == UID_DeformableSpatialRegistrationStorage)
-      {
-        name+="DeformableReg";
-        OFString instanceNumber;
-        dataset->findAndGetOFString(DCM_InstanceNumber, instanceNumber);
-        OFString seriesDescription;
-        dataset->findAndGetOFString(DCM_SeriesDescription, seriesDescription);
-        if (!seriesDescription.empty())
-        {
-          name+=std::string(": ")+seriesDescription.c_str(); 
-        }
-        if (!instanceNumber.empty())
-        {
-          name+=std::string(" [")+instanceNumber.c_str()+"]"; 
-        }
-      }
-      else
-      {
-        continue; // not an registration object
-      }
-
-      // The object is stored in a single file
-      vtkSmartPointer<vtkStringArray> loadableFileList=vtkSmartPointer<vtkStringArray>::New();
-      loadableFileList->InsertNextValue(fileName);
-     
-      importInfo->InsertNextLoadable(loadableFileList, name.c_str(), tooltip.c_str(), warning.c_str(), selected, confidence);
+      jobs.FileNames.push_back(fileList->GetValue(fileIndex));
     }
   }
+  if (jobs.FileNames.empty())
+  {
+    return;
+  }
+  jobs.LoadableNames.resize(jobs.FileNames.size());
+
+  vtkSmartPointer<vtkConcurrentJobPool> jobPool = vtkSmartPointer<vtkConcurrentJobPool>::New();
+  jobPool->Execute((int)jobs.FileNames.size(), vtkDicomSroExamineJob, &jobs);
+
+  // Add loadables in the order of the files, independently of the order the workers finished in
+  for (unsigned int fileIndex=0; fileIndex<jobs.FileNames.size(); fileIndex++)
+  {
+    if (jobs.LoadableNames[fileIndex].empty())
+    {
+      continue; // Not a registration object
+    }
+
+    std::string tooltip;
+    std::string warning;
+    bool selected=true;
+    double confidence=0.9; // Almost sure, it's not 1.0 to allow user modules to override this importer
+
+    // The object is stored in a single file
+    vtkSmartPointer<vtkStringArray> loadableFileList=vtkSmartPointer<vtkStringArray>::New();
+    loadableFileList->InsertNextValue(jobs.FileNames[fileIndex]);
+
+    importInfo->InsertNextLoadable(loadableFileList, jobs.LoadableNames[fileIndex].c_str(), tooltip.c_str(), warning.c_str(), selected, confidence);
+  }
 }
 
 //---------------------------------------------------------------------------
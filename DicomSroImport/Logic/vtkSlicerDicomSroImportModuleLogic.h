@@ -48,7 +48,8 @@ public:
   vtkTypeMacro(vtkSlicerDicomSroImportModuleLogic, vtkSlicerModuleLogic);
   void PrintSelf(ostream& os, vtkIndent indent);
 
-  /// Examine a list of file lists and determine what objects can be loaded from them
+  /// Examine a list of file lists and determine what objects can be loaded from them.
+  /// The files are examined concurrently, and the loadables are added in the order of the files
   void Examine(vtkDICOMImportInfo *importInfo);
 
   /// Load DICOM Sro series from file name
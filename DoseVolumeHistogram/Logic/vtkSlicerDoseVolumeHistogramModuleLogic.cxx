@@ -25,6 +25,7 @@
 // SlicerRT includes
 #include "SlicerRtCommon.h"
 #include "vtkFractionalImageAccumulate.h"
+#include "vtkResampledDoseVolumeCache.h"
 
 // Segmentations includes
 #include "vtkMRMLSegmentationNode.h"
@@ -48,10 +49,12 @@
 #include <vtkMRMLLayoutNode.h>
 #include <vtkMRMLScalarVolumeNode.h>
 #include <vtkMRMLScene.h>
+#include <vtkMRMLTransformNode.h>
 #include <vtkEventBroker.h>
 
 // VTK includes
 #include <vtkImageAccumulate.h>
+#include <vtkImageClip.h>
 #include <vtkImageStencilData.h>
 #include <vtkImageToImageStencil.h>
 #include <vtkNew.h>
@@ -68,11 +71,15 @@
 #include <vtkDelimitedTextWriter.h>
 #include <vtkWeakPointer.h>
 #include <vtkFieldData.h>
+#include <vtkPointData.h>
+#include <vtkMultiThreader.h>
+#include <vtkSMPTools.h>
 
 // VTKSYS includes
 #include <vtksys/SystemTools.hxx>
 
 // STD includes
+#include <algorithm>
 #include <set>
 
 //----------------------------------------------------------------------------
@@ -112,6 +119,415 @@ public:
   vtkWeakPointer<vtkMRMLDoseVolumeHistogramNode> ParameterNode;
 };
 
+//---------------------------------------------------------------------------
+/// Get the scalar range of a segment labelmap stored in its field data (0 and 1 if not specified)
+static void GetLabelmapScalarRange(vtkOrientedImageData* labelmap, double &minimumValue, double &maximumValue)
+{
+  vtkDoubleArray* scalarRange = vtkDoubleArray::SafeDownCast(
+    labelmap->GetFieldData()->GetAbstractArray(vtkSegmentationConverter::GetScalarRangeFieldName()) );
+  if (scalarRange && scalarRange->GetNumberOfValues() == 2)
+  {
+    minimumValue = scalarRange->GetValue(0);
+    maximumValue = scalarRange->GetValue(1);
+  }
+}
+
+//---------------------------------------------------------------------------
+template <class T>
+static void GetLabelmapEffectiveExtentTemplate(vtkImageData* labelmap, T* vtkNotUsed(scalarTypePtr), double backgroundValue, int effectiveExtent[6])
+{
+  int extent[6] = {0,-1,0,-1,0,-1};
+  labelmap->GetExtent(extent);
+  effectiveExtent[0] = effectiveExtent[2] = effectiveExtent[4] = VTK_INT_MAX;
+  effectiveExtent[1] = effectiveExtent[3] = effectiveExtent[5] = VTK_INT_MIN;
+  for (int z = extent[4]; z <= extent[5]; ++z)
+  {
+    for (int y = extent[2]; y <= extent[3]; ++y)
+    {
+      T* rowPtr = static_cast<T*>(labelmap->GetScalarPointer(extent[0], y, z));
+      for (int x = extent[0]; x <= extent[1]; ++x, ++rowPtr)
+      {
+        if (static_cast<double>(*rowPtr) > backgroundValue)
+        {
+          effectiveExtent[0] = std::min(effectiveExtent[0], x);
+          effectiveExtent[1] = std::max(effectiveExtent[1], x);
+          effectiveExtent[2] = std::min(effectiveExtent[2], y);
+          effectiveExtent[3] = std::max(effectiveExtent[3], y);
+          effectiveExtent[4] = std::min(effectiveExtent[4], z);
+          effectiveExtent[5] = std::max(effectiveExtent[5], z);
+        }
+      }
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+/// Get the extent of the voxels in a labelmap with a value greater than the background value
+/// \return False if there are no such voxels
+static bool GetLabelmapEffectiveExtent(vtkImageData* labelmap, double backgroundValue, int effectiveExtent[6])
+{
+  if (!labelmap || !labelmap->GetPointData() || !labelmap->GetPointData()->GetScalars())
+  {
+    return false;
+  }
+  switch (labelmap->GetScalarType())
+  {
+    vtkTemplateMacro(GetLabelmapEffectiveExtentTemplate(labelmap, static_cast<VTK_TT*>(NULL), backgroundValue, effectiveExtent));
+  default:
+    return false;
+  }
+  return (effectiveExtent[0] <= effectiveExtent[1]);
+}
+
+//---------------------------------------------------------------------------
+/// Crop (or pad with the given value) an image to the given extent in place
+static void CropImageToExtent(vtkOrientedImageData* image, int extent[6], double padValue)
+{
+  int currentExtent[6] = {0,-1,0,-1,0,-1};
+  image->GetExtent(currentExtent);
+  if ( currentExtent[0] == extent[0] && currentExtent[1] == extent[1] && currentExtent[2] == extent[2]
+    && currentExtent[3] == extent[3] && currentExtent[4] == extent[4] && currentExtent[5] == extent[5] )
+  {
+    return;
+  }
+  vtkSmartPointer<vtkImageConstantPad> padder = vtkSmartPointer<vtkImageConstantPad>::New();
+  padder->SetInputData(image);
+  padder->SetConstant(padValue);
+  padder->SetOutputWholeExtent(extent);
+  padder->Update();
+  image->vtkImageData::DeepCopy(padder->GetOutput());
+}
+
+//---------------------------------------------------------------------------
+/// Functor computing the DVH of a range of segments with vtkSMPTools.
+/// Each segment only modifies its own labelmap and result, and the MRML scene is not accessed,
+/// so the segments can be processed in parallel.
+class vtkDoseVolumeHistogramSegmentFunctor
+{
+public:
+  vtkSlicerDoseVolumeHistogramModuleLogic* Logic;
+  std::vector<std::string>* SegmentIDs;
+  std::vector<vtkOrientedImageData*>* SegmentLabelmaps;
+  std::vector<vtkSlicerDoseVolumeHistogramModuleLogic::SegmentDvhResult>* Results;
+  /// Dose volume in its original geometry
+  vtkOrientedImageData* DoseImageData;
+  /// Dose volume resampled with the fixed oversampling factor. NULL if oversampling is automatic
+  vtkOrientedImageData* FixedOversampledDoseVolume;
+  /// Key of the dose volume in the resampled dose volume cache
+  std::string DoseVolumeCacheKey;
+  bool ResamplingRequired;
+  bool UseFractionalLabelmap;
+  bool IsDoseVolume;
+  double MaxDose;
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType segmentIndex = begin; segmentIndex < end; ++segmentIndex)
+    {
+      (*this->Results)[segmentIndex].ErrorMessage = this->Logic->ComputeSegmentDvh(
+        (*this->SegmentLabelmaps)[segmentIndex], this->DoseImageData, this->FixedOversampledDoseVolume,
+        this->DoseVolumeCacheKey, this->ResamplingRequired, this->UseFractionalLabelmap, this->IsDoseVolume, this->MaxDose,
+        (*this->SegmentIDs)[segmentIndex], (*this->Results)[segmentIndex] );
+    }
+  }
+};
+
+//---------------------------------------------------------------------------
+/// Assemble the cumulative DVH plot values (dose, volume percentage, 0) from a histogram
+/// \param histogram Number of voxels (or sum of voxel fractions) in each bin
+/// \param voxelBelowStartValue Number of voxels with smaller value than the start value of the histogram
+/// \param totalVoxels Total number of voxels (or sum of voxel fractions) in the structure
+static void AssembleDvhValues(vtkDoubleArray* dvhValues, const double* histogram, int numSamples, double startValue, double stepSize,
+  double voxelBelowStartValue, double totalVoxels, bool useFractionalLabelmap, bool isDoseVolume)
+{
+  // We put a fixed point at (0.0, 100%), but only if there are only positive values in the histogram
+  // Negative values can occur when the user requests histogram for an image, such as s CT volume (in this case Intensity Volume Histogram is computed),
+  // or the startValue became negative for the dose volume because the range minimum was smaller than the original start value.
+  bool insertPointAtOrigin=true;
+  if (startValue<0)
+  {
+    insertPointAtOrigin=false;
+  }
+
+  dvhValues->SetNumberOfComponents(3);
+  dvhValues->SetNumberOfTuples(numSamples + (insertPointAtOrigin?1:0));
+
+  int outputArrayIndex=0;
+
+  if (insertPointAtOrigin)
+  {
+    // Add first fixed point at (0.0, 100%)
+    dvhValues->SetComponent(outputArrayIndex, 0, 0.0);
+    dvhValues->SetComponent(outputArrayIndex, 1, 100.0);
+    dvhValues->SetComponent(outputArrayIndex, 2, 0);
+    ++outputArrayIndex;
+  }
+
+  double voxelBelowDose = voxelBelowStartValue;
+  for (int sampleIndex=0; sampleIndex<numSamples; ++sampleIndex)
+  {
+    double voxelsInBin = histogram[sampleIndex];
+    dvhValues->SetComponent( outputArrayIndex, 0, startValue + sampleIndex * stepSize );
+    if (useFractionalLabelmap)
+    {
+      dvhValues->SetComponent( outputArrayIndex, 1, std::max(0.0, (1.0-(double)voxelBelowDose/(double)totalVoxels)*100.0) );
+    }
+    else
+    {
+      dvhValues->SetComponent( outputArrayIndex, 1, (1.0-(double)voxelBelowDose/(double)totalVoxels)*100.0 );
+    }
+    dvhValues->SetComponent( outputArrayIndex, 2, 0 );
+    ++outputArrayIndex;
+    voxelBelowDose += voxelsInBin;
+  }
+
+  // Set the start of the first bin to 0 if the volume contains dose and the start value was negative
+  if (isDoseVolume && !insertPointAtOrigin)
+  {
+    dvhValues->SetComponent(0,0,0);
+  }
+}
+
+//---------------------------------------------------------------------------
+/// Statistics and histogram of the dose values in one segment, accumulated in the single sweep mode.
+/// Accumulators of the same segment computed on different parts of the dose volume can be merged.
+class vtkDvhSegmentAccumulator
+{
+public:
+  vtkDvhSegmentAccumulator()
+    : VoxelCount(0)
+    , Sum(0.0)
+    , Min(VTK_DOUBLE_MAX)
+    , Max(VTK_DOUBLE_MIN)
+    , VoxelCountBelowRange(0)
+  {
+  }
+
+  /// Add the values of another accumulator with the same bin layout
+  void Merge(const vtkDvhSegmentAccumulator& other)
+  {
+    this->VoxelCount += other.VoxelCount;
+    this->Sum += other.Sum;
+    this->Min = std::min(this->Min, other.Min);
+    this->Max = std::max(this->Max, other.Max);
+    this->VoxelCountBelowRange += other.VoxelCountBelowRange;
+    for (size_t binIndex = 0; binIndex < this->Bins.size() && binIndex < other.Bins.size(); ++binIndex)
+    {
+      this->Bins[binIndex] += other.Bins[binIndex];
+    }
+  }
+
+  vtkIdType VoxelCount;
+  double Sum;
+  double Min;
+  double Max;
+  /// Number of voxels with smaller value than the start value of the histogram
+  vtkIdType VoxelCountBelowRange;
+  /// Histogram. Empty if only the statistics are computed
+  std::vector<double> Bins;
+};
+
+//---------------------------------------------------------------------------
+/// Functor sweeping the oversampled dose volume once for all segments with vtkSMPTools.
+/// The dose volume is split into a fixed number of chunks along the Z axis, independently from the number of threads.
+/// Each chunk has its own accumulators, which are merged in chunk order, so the result is deterministic.
+template <class T>
+class vtkDvhSingleSweepFunctor
+{
+public:
+  vtkImageData* DoseVolume;
+  std::vector<vtkImageStencilData*>* Stencils;
+  /// Histogram start value, step size and number of bins for each segment. Only statistics are computed for segments with no bins
+  std::vector<double>* StartValues;
+  std::vector<double>* StepSizes;
+  std::vector<int>* NumberOfBins;
+  /// Accumulators indexed by chunk then segment
+  std::vector< std::vector<vtkDvhSegmentAccumulator> >* ChunkAccumulators;
+  int NumberOfChunks;
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    int extent[6] = {0,-1,0,-1,0,-1};
+    this->DoseVolume->GetExtent(extent);
+    int numberOfSlices = extent[5] - extent[4] + 1;
+    int numberOfSegments = (int)this->Stencils->size();
+
+    for (vtkIdType chunkIndex = begin; chunkIndex < end; ++chunkIndex)
+    {
+      std::vector<vtkDvhSegmentAccumulator>& accumulators = (*this->ChunkAccumulators)[chunkIndex];
+      int zStart = extent[4] + (int)(numberOfSlices * chunkIndex / this->NumberOfChunks);
+      int zEnd = extent[4] + (int)(numberOfSlices * (chunkIndex+1) / this->NumberOfChunks);
+
+      for (int z = zStart; z < zEnd; ++z)
+      {
+        for (int y = extent[2]; y <= extent[3]; ++y)
+        {
+          // Dose row is looked up once and used for all the segments covering it
+          T* doseRow = static_cast<T*>(this->DoseVolume->GetScalarPointer(extent[0], y, z));
+          for (int segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+          {
+            vtkImageStencilData* stencil = (*this->Stencils)[segmentIndex];
+            if (!stencil)
+            {
+              // Segment failed in the preparation step
+              continue;
+            }
+            vtkDvhSegmentAccumulator& accumulator = accumulators[segmentIndex];
+            double startValue = (*this->StartValues)[segmentIndex];
+            double stepSize = (*this->StepSizes)[segmentIndex];
+            int numberOfBins = (*this->NumberOfBins)[segmentIndex];
+
+            int r1 = 0;
+            int r2 = -1;
+            int iter = 0;
+            while (stencil->GetNextExtent(r1, r2, extent[0], extent[1], y, z, iter))
+            {
+              for (int x = r1; x <= r2; ++x)
+              {
+                double v = static_cast<double>(doseRow[x - extent[0]]);
+                accumulator.Sum += v;
+                if (v > accumulator.Max)
+                {
+                  accumulator.Max = v;
+                }
+                if (v < accumulator.Min)
+                {
+                  accumulator.Min = v;
+                }
+                ++accumulator.VoxelCount;
+
+                if (numberOfBins > 0)
+                {
+                  int binIndex = vtkMath::Floor((v - startValue) / stepSize);
+                  if (binIndex < 0)
+                  {
+                    ++accumulator.VoxelCountBelowRange;
+                  }
+                  else if (binIndex < numberOfBins)
+                  {
+                    accumulator.Bins[binIndex] += 1.0;
+                  }
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+};
+
+//---------------------------------------------------------------------------
+/// Functor preparing the segments for the single sweep DVH computation with vtkSMPTools.
+/// The labelmaps are resampled to the oversampled dose geometry if necessary and their stencils are created.
+/// If the dose is streamed, then the stencils are only created for the current slab of the oversampled dose volume.
+class vtkDvhSingleSweepStencilFunctor
+{
+public:
+  std::vector<vtkOrientedImageData*>* SegmentLabelmaps;
+  std::vector<vtkSmartPointer<vtkImageStencilData> >* Stencils;
+  /// Segments with an error message are skipped
+  std::vector<std::string>* ErrorMessages;
+  /// Geometry of the oversampled dose volume, or of its current slab if \sa SlabOnly is set
+  vtkOrientedImageData* ReferenceGeometry;
+  bool ResamplingRequired;
+  /// Flag indicating that only the part of the labelmaps within the slab given by \sa ReferenceGeometry is resampled and
+  /// thresholded, into temporary images of the size of the slab. The labelmaps are left unchanged
+  bool SlabOnly;
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType segmentIndex = begin; segmentIndex < end; ++segmentIndex)
+    {
+      (*this->Stencils)[segmentIndex] = NULL;
+      if (!(*this->ErrorMessages)[segmentIndex].empty())
+      {
+        continue;
+      }
+
+      vtkOrientedImageData* segmentLabelmap = (*this->SegmentLabelmaps)[segmentIndex];
+      vtkSmartPointer<vtkImageData> stencilInput = segmentLabelmap;
+      if (this->ResamplingRequired)
+      {
+        double minimumValue = 0.0;
+        double maximumValue = 1.0;
+        GetLabelmapScalarRange(segmentLabelmap, minimumValue, maximumValue);
+        vtkSmartPointer<vtkOrientedImageData> resampledLabelmap = segmentLabelmap;
+        if (this->SlabOnly)
+        {
+          resampledLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+        }
+        if ( !vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+          segmentLabelmap, this->ReferenceGeometry, resampledLabelmap, false, false, NULL, minimumValue ) )
+        {
+          (*this->ErrorMessages)[segmentIndex] = "Failed to resample segment binary labelmap";
+          continue;
+        }
+        stencilInput = resampledLabelmap;
+      }
+      else if (this->SlabOnly)
+      {
+        // The labelmap is on the lattice of the oversampled dose volume, only its part within the slab is thresholded
+        int labelmapExtent[6] = {0,-1,0,-1,0,-1};
+        int slabExtent[6] = {0,-1,0,-1,0,-1};
+        segmentLabelmap->GetExtent(labelmapExtent);
+        this->ReferenceGeometry->GetExtent(slabExtent);
+        bool overlapping = true;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          slabExtent[2*axis] = std::max(slabExtent[2*axis], labelmapExtent[2*axis]);
+          slabExtent[2*axis+1] = std::min(slabExtent[2*axis+1], labelmapExtent[2*axis+1]);
+          overlapping = overlapping && (slabExtent[2*axis] <= slabExtent[2*axis+1]);
+        }
+        if (!overlapping)
+        {
+          // Empty stencil, the segment is not in this slab
+          vtkSmartPointer<vtkImageStencilData> emptyStencil = vtkSmartPointer<vtkImageStencilData>::New();
+          emptyStencil->SetExtent(labelmapExtent);
+          emptyStencil->AllocateExtents();
+          (*this->Stencils)[segmentIndex] = emptyStencil;
+          continue;
+        }
+        vtkNew<vtkImageClip> clip;
+        clip->SetInputData(segmentLabelmap);
+        clip->SetOutputWholeExtent(slabExtent);
+        clip->ClipDataOn();
+        clip->Update();
+        stencilInput = clip->GetOutput();
+      }
+
+      // The labelmap is on the lattice of the oversampled dose volume, so it does not need to be padded,
+      // the sweep only visits the stencil spans inside the dose extent
+      vtkNew<vtkImageToImageStencil> stencil;
+      stencil->SetInputData(stencilInput);
+      stencil->ThresholdByUpper(1e-10);
+      stencil->Update();
+
+      vtkSmartPointer<vtkImageStencilData> structureStencil = vtkSmartPointer<vtkImageStencilData>::New();
+      structureStencil->DeepCopy(stencil->GetOutput());
+      (*this->Stencils)[segmentIndex] = structureStencil;
+    }
+  }
+};
+
+//---------------------------------------------------------------------------
+/// Run the single sweep functor on the dose volume of the given scalar type
+template <class T>
+static void vtkDvhSingleSweepExecute(T* vtkNotUsed(doseTypePtr), vtkImageData* doseVolume,
+  std::vector<vtkImageStencilData*>& stencils, std::vector<double>& startValues, std::vector<double>& stepSizes,
+  std::vector<int>& numberOfBins, std::vector< std::vector<vtkDvhSegmentAccumulator> >& chunkAccumulators)
+{
+  vtkDvhSingleSweepFunctor<T> functor;
+  functor.DoseVolume = doseVolume;
+  functor.Stencils = &stencils;
+  functor.StartValues = &startValues;
+  functor.StepSizes = &stepSizes;
+  functor.NumberOfBins = &numberOfBins;
+  functor.ChunkAccumulators = &chunkAccumulators;
+  functor.NumberOfChunks = (int)chunkAccumulators.size();
+  vtkSMPTools::For(0, functor.NumberOfChunks, 1, functor);
+}
+
 //----------------------------------------------------------------------------
 vtkSlicerDoseVolumeHistogramModuleLogic::vtkSlicerDoseVolumeHistogramModuleLogic()
 {
@@ -120,6 +536,10 @@ vtkSlicerDoseVolumeHistogramModuleLogic::vtkSlicerDoseVolumeHistogramModuleLogic
   this->NumberOfSamplesForNonDoseVolumes = 100;
   this->DefaultDoseVolumeOversamplingFactor = 2.0;
 
+  this->ComputeSegmentsInSingleSweep = false;
+  this->UseSlabStreaming = false;
+  this->SlabStreamingMemoryLimitMB = 256;
+
   this->LogSpeedMeasurements = false;
 }
 
@@ -158,6 +578,9 @@ void vtkSlicerDoseVolumeHistogramModuleLogic::OnMRMLSceneEndClose()
     return;
   }
 
+  // Resampled dose volumes of the closed scene cannot be used any more
+  vtkResampledDoseVolumeCache::GetInstance()->Clear();
+
   this->Modified();
 }
 
@@ -171,7 +594,6 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
     return errorMessage;
   }
 
-  parameterNode->ClearAutomaticOversamplingFactors();
   vtkMRMLSegmentationNode* segmentationNode = parameterNode->GetSegmentationNode();
   vtkMRMLScalarVolumeNode* doseVolumeNode = parameterNode->GetDoseVolumeNode();
   if ( !segmentationNode || !doseVolumeNode )
@@ -185,23 +607,67 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
   this->SetDisableModifiedEvent(1);
   int disabledNodeModify = parameterNode->StartModify();
 
-  // Get maximum dose from dose volume for number of DVH bins
-  vtkNew<vtkImageAccumulate> doseStat;
-  doseStat->SetInputData(doseVolumeNode->GetImageData());
-  doseStat->Update();
-  double maxDose = doseStat->GetMax()[0];
+  // Measure the time spent in each stage of the computation
+  this->LastComputationStageTimes.clear();
+  double checkpointStage = vtkTimerLog::GetUniversalTime();
 
   // Get selected segmentation
   vtkSegmentation* selectedSegmentation = segmentationNode->GetSegmentation();
 
   // If segment IDs list is empty then include all segments
+  std::vector<std::string> selectedSegmentIDs;
+  parameterNode->GetSelectedSegmentIDs(selectedSegmentIDs);
+  if (selectedSegmentIDs.empty())
+  {
+    selectedSegmentation->GetSegmentIDs(selectedSegmentIDs);
+  }
+
+  // Only compute DVH for the segments that changed since their DVH was last computed.
+  // If any of the inputs shared by all segments changed, then all segments are recomputed.
+  std::string dvhInputState = this->GetDvhInputState(parameterNode);
+  if (dvhInputState != parameterNode->GetDvhInputState())
+  {
+    parameterNode->ClearSegmentInputMTimes();
+    parameterNode->ClearAutomaticOversamplingFactors();
+    parameterNode->SetDvhInputState(dvhInputState);
+  }
   std::vector<std::string> segmentIDs;
-  parameterNode->GetSelectedSegmentIDs(segmentIDs);
+  std::vector<unsigned long> segmentInputMTimes;
+  for (std::vector<std::string>::iterator segmentIt = selectedSegmentIDs.begin(); segmentIt != selectedSegmentIDs.end(); ++segmentIt)
+  {
+    unsigned long segmentInputMTime = 0;
+    int tableRow = -1;
+    if (this->IsDvhUpToDate(parameterNode, (*segmentIt), segmentInputMTime, tableRow))
+    {
+      // Segment name is not an input of the computation, but it is shown in the table
+      const char* segmentName = selectedSegmentation->GetSegment(*segmentIt)->GetName();
+      vtkTable* metricsTable = parameterNode->GetMetricsTableNode()->GetTable();
+      if (metricsTable->GetValue(tableRow, vtkMRMLDoseVolumeHistogramNode::MetricColumnStructure).ToString() != (segmentName ? segmentName : ""))
+      {
+        metricsTable->SetValue(tableRow, vtkMRMLDoseVolumeHistogramNode::MetricColumnStructure, vtkVariant(segmentName));
+      }
+      continue;
+    }
+    segmentIDs.push_back(*segmentIt);
+    segmentInputMTimes.push_back(segmentInputMTime);
+  }
   if (segmentIDs.empty())
   {
-    selectedSegmentation->GetSegmentIDs(segmentIDs);
+    // Nothing changed, the existing DVHs are kept
+    this->SetDisableModifiedEvent(0);
+    parameterNode->EndModify(disabledNodeModify);
+    return "";
   }
 
+  // Get maximum dose from dose volume for number of DVH bins
+  vtkNew<vtkImageAccumulate> doseStat;
+  doseStat->SetInputData(doseVolumeNode->GetImageData());
+  doseStat->Update();
+  double maxDose = doseStat->GetMax()[0];
+
+  double checkpointPreparation = vtkTimerLog::GetUniversalTime();
+  this->LastComputationStageTimes["Preparation"] = checkpointPreparation - checkpointStage;
+
   // Temporarily duplicate selected segments to contain binary labelmap of a different geometry (tied to dose volume)
   vtkSmartPointer<vtkSegmentation> segmentationCopy = vtkSmartPointer<vtkSegmentation>::New();
   segmentationCopy->SetMasterRepresentationName(selectedSegmentation->GetMasterRepresentationName());
@@ -283,6 +749,9 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
     }
   }
 
+  double checkpointConversion = vtkTimerLog::GetUniversalTime();
+  this->LastComputationStageTimes["Conversion"] = checkpointConversion - checkpointPreparation;
+
   // Create oriented image data from dose volume
   vtkSmartPointer<vtkOrientedImageData> doseImageData = vtkSmartPointer<vtkOrientedImageData>::Take(
     vtkSlicerSegmentationsModuleLogic::CreateOrientedImageDataFromVolumeNode(doseVolumeNode) );
@@ -303,6 +772,13 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
     }
   }
 
+  // Resampled dose volumes are reused from the shared cache if the dose volume has not changed since they were computed
+  std::string doseVolumeCacheKey = vtkResampledDoseVolumeCache::GetDoseVolumeKey(doseVolumeNode);
+
+  // In slab streaming mode the oversampled dose volume is never resampled as a whole,
+  // only one slab at a time while all segments are accumulated in a single sweep
+  bool useSlabStreaming = this->UseSlabStreaming && !parameterNode->GetAutomaticOversampling() && !useFractionalLabelmap;
+
   // Use the same resampled dose volume if oversampling is fixed
   vtkSmartPointer<vtkOrientedImageData> fixedOversampledDoseVolume;
   if (!parameterNode->GetAutomaticOversampling())
@@ -311,25 +787,34 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
     fixedOversampledDoseVolume = vtkSmartPointer<vtkOrientedImageData>::New();
     fixedOversampledDoseVolume->ShallowCopy(doseImageData);
     vtkCalculateOversamplingFactor::ApplyOversamplingOnImageGeometry(fixedOversampledDoseVolume, this->DefaultDoseVolumeOversamplingFactor);
-
+  }
+  if (fixedOversampledDoseVolume.GetPointer() && !useSlabStreaming)
+  {
     // Resample dose volume using linear interpolation
-    if ( !vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
-      doseImageData, fixedOversampledDoseVolume, fixedOversampledDoseVolume, true ) )
+    std::string geometryKey = vtkResampledDoseVolumeCache::GetGeometryKey(fixedOversampledDoseVolume);
+    if (!vtkResampledDoseVolumeCache::GetInstance()->GetResampledDoseVolume(doseVolumeCacheKey, geometryKey, fixedOversampledDoseVolume))
     {
-      std::string errorMessage("Failed to resample dose volume");
-      vtkErrorMacro("ComputeDvh: " << errorMessage);
-      return errorMessage;
+      if ( !vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+        doseImageData, fixedOversampledDoseVolume, fixedOversampledDoseVolume, true ) )
+      {
+        std::string errorMessage("Failed to resample dose volume");
+        vtkErrorMacro("ComputeDvh: " << errorMessage);
+        return errorMessage;
+      }
+      vtkResampledDoseVolumeCache::GetInstance()->AddResampledDoseVolume(doseVolumeCacheKey, geometryKey, fixedOversampledDoseVolume);
     }
   }
 
-  // Compute DVH for each selected segment
-  int counter = 1; // Start at one so that progress can reach 100%
-  int numberOfSelectedSegments = segmentationCopy->GetNumberOfSegments();
-  for (std::vector< std::string >::const_iterator segmentIdIt = segmentIDs.begin(); segmentIdIt != segmentIDs.end(); ++segmentIdIt, ++counter)
+  double checkpointDoseResampling = vtkTimerLog::GetUniversalTime();
+  this->LastComputationStageTimes["DoseResampling"] = checkpointDoseResampling - checkpointConversion;
+
+  // Collect segment labelmaps and apply parent transformation nodes if necessary.
+  // This is done before the parallel computation step, as it accesses the MRML scene.
+  std::vector<vtkOrientedImageData*> segmentLabelmaps;
+  for (std::vector< std::string >::const_iterator segmentIdIt = segmentIDs.begin(); segmentIdIt != segmentIDs.end(); ++segmentIdIt)
   {
-    std::string segmentID = *segmentIdIt;
     vtkSegment* segment = segmentationCopy->GetSegment(*segmentIdIt);
-  
+
     // Get segment labelmap
     vtkOrientedImageData* segmentLabelmap = vtkOrientedImageData::SafeDownCast( segment->GetRepresentation(
       representationName ) );
@@ -340,19 +825,11 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
       return errorMessage;
     }
 
-    double minimumValue = 0.0;
-    double maximumValue = 1.0;
-    vtkDoubleArray* scalarRange = vtkDoubleArray::SafeDownCast(
-      segmentLabelmap->GetFieldData()->GetAbstractArray(vtkSegmentationConverter::GetScalarRangeFieldName()));
-    if (scalarRange && scalarRange->GetNumberOfValues() == 2)
-    {
-      minimumValue = scalarRange->GetValue(0);
-      maximumValue = scalarRange->GetValue(1);
-    }
-
-    // Apply parent transformation nodes if necessary
     if (segmentationNode->GetParentTransformNode())
     {
+      double minimumValue = 0.0;
+      double maximumValue = 1.0;
+      GetLabelmapScalarRange(segmentLabelmap, minimumValue, maximumValue);
       double backgroundValue[4] = {minimumValue, minimumValue, minimumValue, 0.0};
       if (!vtkSlicerSegmentationsModuleLogic::ApplyParentTransformToOrientedImageData(segmentationNode, segmentLabelmap, useFractionalLabelmap, backgroundValue))
       {
@@ -362,62 +839,59 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
       }
       resamplingRequired = true;
     }
-    // Resample labelmap if necessary (if it was master, and could not be re-converted using the oversampled geometry, or if there was a parent transform)
-    if (resamplingRequired)
-    {
 
-      // Resample segmentation labelmap volume
-      if ( !vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
-        segmentLabelmap, fixedOversampledDoseVolume, segmentLabelmap, useFractionalLabelmap, false, NULL, minimumValue ) )
-      {
-        std::string errorMessage("Failed to resample segment binary labelmap");
-        vtkErrorMacro("ComputeDvh: " << errorMessage);
-        return errorMessage;
-      }
-    }
+    segmentLabelmaps.push_back(segmentLabelmap);
+  }
 
-    // Get oversampled dose volume
-    vtkSmartPointer<vtkOrientedImageData> oversampledDoseVolume;
-    // Use the same resampled dose volume if oversampling is fixed
-    if (!parameterNode->GetAutomaticOversampling())
-    {
-      oversampledDoseVolume = fixedOversampledDoseVolume;
-    }
-    // Resample dose volume to match automatically oversampled segment labelmap geometry
-    else
-    {
-      oversampledDoseVolume = vtkSmartPointer<vtkOrientedImageData>::New();
-      if ( !vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
-        doseImageData, segmentLabelmap, oversampledDoseVolume, true ) )
-      {
-        std::string errorMessage("Failed to resample dose volume");
-        vtkErrorMacro("ComputeDvh: " << errorMessage);
-        return errorMessage;
-      }
-    }
+  // Compute DVH for each selected segment. The computation step does not access the MRML scene,
+  // the results are written to the scene in a serial commit step when all segments have been processed.
+  int numberOfSelectedSegments = (int)segmentIDs.size();
+  std::vector<SegmentDvhResult> segmentResults(numberOfSelectedSegments);
+  bool isDoseVolume = SlicerRtCommon::IsDoseVolumeNode(doseVolumeNode);
 
-    // Make sure the segment labelmap is the same dimension as the dose volume
-    vtkSmartPointer<vtkImageConstantPad> padder = vtkSmartPointer<vtkImageConstantPad>::New();
-    padder->SetInputData(segmentLabelmap);
-    padder->SetConstant(minimumValue);
-    int extent[6] = {0,-1,0,-1,0,-1};
-    oversampledDoseVolume->GetExtent(extent);
-    padder->SetOutputWholeExtent(extent);
-    padder->Update();
-    segmentLabelmap->vtkImageData::DeepCopy(padder->GetOutput());
+  if (useSlabStreaming)
+  {
+    // Only the geometry of the oversampled dose volume is given, the dose is resampled slab by slab
+    this->ComputeDvhInSingleSweep(segmentLabelmaps, fixedOversampledDoseVolume, doseImageData, resamplingRequired, isDoseVolume, maxDose, segmentResults);
+  }
+  else if (this->ComputeSegmentsInSingleSweep && fixedOversampledDoseVolume.GetPointer() && !useFractionalLabelmap)
+  {
+    // All segments are on the lattice of the same oversampled dose volume, so it can be swept once for all of them
+    this->ComputeDvhInSingleSweep(segmentLabelmaps, fixedOversampledDoseVolume, NULL, resamplingRequired, isDoseVolume, maxDose, segmentResults);
+  }
+  else
+  {
+    this->ComputeDvhPerSegment(segmentIDs, segmentLabelmaps, doseImageData, fixedOversampledDoseVolume, doseVolumeCacheKey,
+      resamplingRequired, useFractionalLabelmap, isDoseVolume, maxDose, segmentResults);
+  }
+
+  double checkpointComputation = vtkTimerLog::GetUniversalTime();
+  this->LastComputationStageTimes["Computation"] = checkpointComputation - checkpointDoseResampling;
 
-    // Calculate DVH for current segment
-    std::string errorMessage = this->ComputeDvh(parameterNode, segmentLabelmap, oversampledDoseVolume, segmentID, maxDose);
+  // Commit computed DVHs to the MRML scene in the order of the selected segments
+  for (int segmentIndex = 0; segmentIndex < numberOfSelectedSegments; ++segmentIndex)
+  {
+    std::string errorMessage = segmentResults[segmentIndex].ErrorMessage;
+    if (errorMessage.empty())
+    {
+      errorMessage = this->CommitDvh(parameterNode, segmentIDs[segmentIndex], segmentResults[segmentIndex]);
+    }
     if (!errorMessage.empty())
     {
       vtkErrorMacro("ComputeDvh: " << errorMessage);
       return errorMessage;
     }
+    parameterNode->SetSegmentInputMTime(segmentIDs[segmentIndex], segmentInputMTimes[segmentIndex]);
+  }
 
-    // Update progress bar
-    double progress = (double)counter / (double)numberOfSelectedSegments;
-    this->InvokeEvent(SlicerRtCommon::ProgressUpdated, (void*)&progress);
-  } // For each segment
+  this->LastComputationStageTimes["Commit"] = vtkTimerLog::GetUniversalTime() - checkpointComputation;
+  if (this->LogSpeedMeasurements)
+  {
+    for (std::map<std::string, double>::iterator stageIt = this->LastComputationStageTimes.begin(); stageIt != this->LastComputationStageTimes.end(); ++stageIt)
+    {
+      vtkDebugMacro("ComputeDvh: " << stageIt->first << " time: " << stageIt->second << " s");
+    }
+  }
 
   // Fire only one modified event when the computation is done
   this->SetDisableModifiedEvent(0);
@@ -433,35 +907,428 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
 }
 
 //---------------------------------------------------------------------------
-std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolumeHistogramNode* parameterNode, vtkOrientedImageData* segmentLabelmap, vtkOrientedImageData* oversampledDoseVolume, std::string segmentID, double maxDoseGy)
+void vtkSlicerDoseVolumeHistogramModuleLogic::GetLastComputationStageTimes(std::map<std::string, double>& stageTimes)
 {
-  if (!this->GetMRMLScene() || !parameterNode)
+  stageTimes = this->LastComputationStageTimes;
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerDoseVolumeHistogramModuleLogic::GetDvhInputState(vtkMRMLDoseVolumeHistogramNode* parameterNode)
+{
+  if (!parameterNode || !parameterNode->GetSegmentationNode() || !parameterNode->GetDoseVolumeNode())
   {
-    std::string errorMessage("Invalid MRML scene or parameter set node");
-    vtkErrorMacro("ComputeDvh: " << errorMessage);
-    return errorMessage;
+    return "";
   }
-  if (!segmentLabelmap)
+  vtkMRMLSegmentationNode* segmentationNode = parameterNode->GetSegmentationNode();
+
+  std::stringstream stateStream;
+  stateStream.precision(17);
+  // Dose volume voxels, geometry and transforms
+  stateStream << vtkResampledDoseVolumeCache::GetDoseVolumeKey(parameterNode->GetDoseVolumeNode());
+  // Segmentation, its source representation and transforms
+  stateStream << "|" << (segmentationNode->GetID() ? segmentationNode->GetID() : "")
+    << ";" << segmentationNode->GetSegmentation()->GetMasterRepresentationName();
+  for (vtkMRMLTransformNode* transformNode = segmentationNode->GetParentTransformNode(); transformNode; transformNode = transformNode->GetParentTransformNode())
+  {
+    stateStream << ";" << (transformNode->GetID() ? transformNode->GetID() : "") << ";" << transformNode->GetMTime();
+  }
+  // Output table
+  stateStream << "|" << (parameterNode->GetMetricsTableNode() && parameterNode->GetMetricsTableNode()->GetID() ? parameterNode->GetMetricsTableNode()->GetID() : "");
+  // Computation parameters
+  stateStream << "|" << this->StartValue << ";" << this->StepSize << ";" << this->NumberOfSamplesForNonDoseVolumes
+    << ";" << this->DefaultDoseVolumeOversamplingFactor << ";" << parameterNode->GetAutomaticOversampling()
+    << ";" << parameterNode->GetUseFractionalLabelmap();
+  return stateStream.str();
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerDoseVolumeHistogramModuleLogic::IsDvhUpToDate(vtkMRMLDoseVolumeHistogramNode* parameterNode, std::string segmentID, unsigned long &segmentInputMTime, int &tableRow)
+{
+  segmentInputMTime = 0;
+  tableRow = -1;
+  if (!parameterNode || !parameterNode->GetSegmentationNode() || !parameterNode->GetMetricsTableNode())
   {
-    std::string errorMessage("Invalid segment labelmap");
-    vtkErrorMacro("ComputeDvh: " << errorMessage);
-    return errorMessage;
+    return false;
   }
-  if (!oversampledDoseVolume)
-  {
-    std::string errorMessage("Invalid oversampled dose volume");
-    vtkErrorMacro("ComputeDvh: " << errorMessage);
-    return errorMessage;
+
+  // Get modified time of the source representation of the segment
+  vtkSegmentation* segmentation = parameterNode->GetSegmentationNode()->GetSegmentation();
+  vtkSegment* segment = segmentation->GetSegment(segmentID);
+  if (!segment)
+  {
+    return false;
   }
-  vtkMRMLSegmentationNode* segmentationNode = parameterNode->GetSegmentationNode();
-  vtkMRMLScalarVolumeNode* doseVolumeNode = parameterNode->GetDoseVolumeNode();
-  if ( !segmentationNode || !doseVolumeNode )
+  vtkDataObject* sourceRepresentation = segment->GetRepresentation(segmentation->GetMasterRepresentationName());
+  if (!sourceRepresentation)
   {
-    std::string errorMessage("Both segmentation node and dose volume node need to be set");
-    vtkErrorMacro("ComputeDvh: " << errorMessage);
-    return errorMessage;
+    return false;
+  }
+  segmentInputMTime = sourceRepresentation->GetMTime();
+
+  if (parameterNode->GetSegmentInputMTime(segmentID) != segmentInputMTime)
+  {
+    return false;
+  }
+
+  // The DVH array node and its row in the metrics table need to still exist
+  vtkMRMLTableNode* metricsTableNode = parameterNode->GetMetricsTableNode();
+  std::string structureDvhNodeRef = parameterNode->AssembleDvhNodeReference(segmentID);
+  vtkMRMLDoubleArrayNode* arrayNode = vtkMRMLDoubleArrayNode::SafeDownCast(metricsTableNode->GetNodeReference(structureDvhNodeRef.c_str()));
+  if (!arrayNode || !arrayNode->GetAttribute(DVH_TABLE_ROW_ATTRIBUTE_NAME.c_str()))
+  {
+    return false;
+  }
+  int arrayTableRow = vtkVariant(arrayNode->GetAttribute(DVH_TABLE_ROW_ATTRIBUTE_NAME.c_str())).ToInt();
+  if (arrayTableRow < 0 || arrayTableRow >= metricsTableNode->GetTable()->GetNumberOfRows())
+  {
+    return false;
+  }
+
+  tableRow = arrayTableRow;
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvhPerSegment(std::vector<std::string>& segmentIDs,
+  std::vector<vtkOrientedImageData*>& segmentLabelmaps, vtkOrientedImageData* doseImageData, vtkOrientedImageData* fixedOversampledDoseVolume,
+  std::string doseVolumeCacheKey, bool resamplingRequired, bool useFractionalLabelmap, bool isDoseVolume, double maxDoseGy,
+  std::vector<SegmentDvhResult>& segmentResults)
+{
+  int numberOfSelectedSegments = (int)segmentIDs.size();
+
+  vtkDoseVolumeHistogramSegmentFunctor segmentFunctor;
+  segmentFunctor.Logic = this;
+  segmentFunctor.SegmentIDs = &segmentIDs;
+  segmentFunctor.SegmentLabelmaps = &segmentLabelmaps;
+  segmentFunctor.Results = &segmentResults;
+  segmentFunctor.DoseImageData = doseImageData;
+  segmentFunctor.FixedOversampledDoseVolume = fixedOversampledDoseVolume;
+  segmentFunctor.DoseVolumeCacheKey = doseVolumeCacheKey;
+  segmentFunctor.ResamplingRequired = resamplingRequired;
+  segmentFunctor.UseFractionalLabelmap = useFractionalLabelmap;
+  segmentFunctor.IsDoseVolume = isDoseVolume;
+  segmentFunctor.MaxDose = maxDoseGy;
+
+  // Segments are computed in parallel in batches of the number of threads so that progress can be reported in between
+  int batchSize = std::max(1, vtkMultiThreader::GetGlobalDefaultNumberOfThreads());
+  for (int batchStart = 0; batchStart < numberOfSelectedSegments; batchStart += batchSize)
+  {
+    int batchEnd = std::min(batchStart + batchSize, numberOfSelectedSegments);
+    vtkSMPTools::For(batchStart, batchEnd, 1, segmentFunctor);
+
+    // Update progress bar
+    double progress = (double)batchEnd / (double)numberOfSelectedSegments;
+    this->InvokeEvent(SlicerRtCommon::ProgressUpdated, (void*)&progress);
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvhInSingleSweep(std::vector<vtkOrientedImageData*>& segmentLabelmaps,
+  vtkOrientedImageData* fixedOversampledDoseVolume, vtkOrientedImageData* streamedDoseImageData, bool resamplingRequired,
+  bool isDoseVolume, double maxDoseGy, std::vector<SegmentDvhResult>& segmentResults)
+{
+  int numberOfSegments = (int)segmentLabelmaps.size();
+  if (!fixedOversampledDoseVolume || numberOfSegments == 0)
+  {
+    return;
+  }
+
+  vtkSmartPointer<vtkTimerLog> timer = vtkSmartPointer<vtkTimerLog>::New();
+  double checkpointStart = timer->GetUniversalTime();
+  UNUSED_VARIABLE(checkpointStart); // Although it is used later, a warning is logged so needs to be suppressed
+
+  // Resample labelmaps and create stencils for all segments in parallel. If the dose is streamed, then the stencils are
+  // created for each slab when it is swept instead, so that their size does not grow with the oversampled dose volume.
+  // Segments are excluded from the computation when an error message is set for them.
+  std::vector<vtkSmartPointer<vtkImageStencilData> > stencils(numberOfSegments);
+  std::vector<std::string> errorMessages(numberOfSegments);
+  vtkDvhSingleSweepStencilFunctor stencilFunctor;
+  stencilFunctor.SegmentLabelmaps = &segmentLabelmaps;
+  stencilFunctor.Stencils = &stencils;
+  stencilFunctor.ErrorMessages = &errorMessages;
+  stencilFunctor.ReferenceGeometry = fixedOversampledDoseVolume;
+  stencilFunctor.ResamplingRequired = resamplingRequired;
+  stencilFunctor.SlabOnly = (streamedDoseImageData != NULL);
+  if (!streamedDoseImageData)
+  {
+    vtkSMPTools::For(0, numberOfSegments, 1, stencilFunctor);
+  }
+
+  double progress = 0.5;
+  this->InvokeEvent(SlicerRtCommon::ProgressUpdated, (void*)&progress);
+
+  std::vector<vtkImageStencilData*> stencilPointers(numberOfSegments, (vtkImageStencilData*)NULL);
+  for (int segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+  {
+    stencilPointers[segmentIndex] = stencils[segmentIndex].GetPointer();
+  }
+
+  // Determine DVH bins. For dose volumes they are the same for all segments, for other volumes only the statistics
+  // are computed in the first sweep, and the histogram with the bins spanning the intensity range of each segment in a second one.
+  std::vector<double> startValues(numberOfSegments, this->StartValue);
+  std::vector<double> stepSizes(numberOfSegments, this->StepSize);
+  std::vector<int> numberOfBins(numberOfSegments, 0);
+  if (isDoseVolume)
+  {
+    std::fill(numberOfBins.begin(), numberOfBins.end(), (int)ceil( (maxDoseGy-this->StartValue)/this->StepSize ) + 1);
+  }
+
+  // Determine the slabs of the oversampled dose volume that are swept one after the other. If the dose is streamed,
+  // then the thickness of the slabs is chosen so that the resampled dose slab fits in the memory limit,
+  // otherwise the whole oversampled dose volume is swept at once.
+  int doseExtent[6] = {0,-1,0,-1,0,-1};
+  fixedOversampledDoseVolume->GetExtent(doseExtent);
+  int numberOfSlices = doseExtent[5] - doseExtent[4] + 1;
+  int slabThickness = numberOfSlices;
+  if (streamedDoseImageData)
+  {
+    double sliceSizeBytes = (double)(doseExtent[1]-doseExtent[0]+1) * (double)(doseExtent[3]-doseExtent[2]+1)
+      * streamedDoseImageData->GetScalarSize() * streamedDoseImageData->GetNumberOfScalarComponents();
+    slabThickness = (int)std::max(1.0, std::floor(this->SlabStreamingMemoryLimitMB * 1024.0 * 1024.0 / std::max(1.0, sliceSizeBytes)));
+  }
+
+  std::vector<vtkDvhSegmentAccumulator> totals;
+  int numberOfSweeps = (isDoseVolume ? 1 : 2);
+  for (int sweepIndex = 0; sweepIndex < numberOfSweeps; ++sweepIndex)
+  {
+    totals.assign(numberOfSegments, vtkDvhSegmentAccumulator());
+    for (int segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+    {
+      totals[segmentIndex].Bins.resize(numberOfBins[segmentIndex], 0.0);
+    }
+
+    for (int slabStart = doseExtent[4]; slabStart <= doseExtent[5]; slabStart += slabThickness)
+    {
+      // Get dose slab
+      vtkSmartPointer<vtkOrientedImageData> doseSlab = vtkSmartPointer<vtkOrientedImageData>::New();
+      if (streamedDoseImageData)
+      {
+        vtkSmartPointer<vtkOrientedImageData> slabGeometry = vtkSmartPointer<vtkOrientedImageData>::New();
+        slabGeometry->CopyDirections(fixedOversampledDoseVolume);
+        slabGeometry->SetOrigin(fixedOversampledDoseVolume->GetOrigin());
+        slabGeometry->SetSpacing(fixedOversampledDoseVolume->GetSpacing());
+        slabGeometry->SetExtent(doseExtent[0], doseExtent[1], doseExtent[2], doseExtent[3],
+          slabStart, std::min(slabStart + slabThickness - 1, doseExtent[5]));
+        if ( !vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+          streamedDoseImageData, slabGeometry, doseSlab, true ) )
+        {
+          for (int segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+          {
+            segmentResults[segmentIndex].ErrorMessage = "Failed to resample dose volume";
+          }
+          return;
+        }
+
+        // Create the stencils of the segments within the slab, replacing the ones of the previous slab
+        stencilFunctor.ReferenceGeometry = slabGeometry;
+        vtkSMPTools::For(0, numberOfSegments, 1, stencilFunctor);
+        for (int segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+        {
+          stencilPointers[segmentIndex] = (errorMessages[segmentIndex].empty() ? stencils[segmentIndex].GetPointer() : NULL);
+        }
+      }
+      else
+      {
+        doseSlab->ShallowCopy(fixedOversampledDoseVolume);
+      }
+
+      // Split the slab into a fixed number of chunks (not dependent on the number of threads) so that the merged results are reproducible
+      int slabExtent[6] = {0,-1,0,-1,0,-1};
+      doseSlab->GetExtent(slabExtent);
+      int numberOfChunks = std::max(1, std::min(slabExtent[5]-slabExtent[4]+1, 32));
+
+      std::vector< std::vector<vtkDvhSegmentAccumulator> > chunkAccumulators(numberOfChunks, std::vector<vtkDvhSegmentAccumulator>(numberOfSegments));
+      for (int chunkIndex = 0; chunkIndex < numberOfChunks; ++chunkIndex)
+      {
+        for (int segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+        {
+          chunkAccumulators[chunkIndex][segmentIndex].Bins.resize(numberOfBins[segmentIndex], 0.0);
+        }
+      }
+
+      switch (doseSlab->GetScalarType())
+      {
+        vtkTemplateMacro( vtkDvhSingleSweepExecute( (VTK_TT*)NULL, doseSlab.GetPointer(),
+          stencilPointers, startValues, stepSizes, numberOfBins, chunkAccumulators ) );
+      default:
+        for (int segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+        {
+          segmentResults[segmentIndex].ErrorMessage = "Unsupported dose volume scalar type";
+        }
+        return;
+      }
+
+      // Merge the accumulators of the chunks in chunk order
+      for (int chunkIndex = 0; chunkIndex < numberOfChunks; ++chunkIndex)
+      {
+        for (int segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+        {
+          totals[segmentIndex].Merge(chunkAccumulators[chunkIndex][segmentIndex]);
+        }
+      }
+    }
+
+    // Validate statistics and set up bins spanning the intensity range of each segment for the second sweep
+    for (int segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+    {
+      if (!errorMessages[segmentIndex].empty())
+      {
+        continue;
+      }
+      vtkDvhSegmentAccumulator& total = totals[segmentIndex];
+      std::string errorMessage;
+      if (total.VoxelCount < 1)
+      {
+        errorMessage = "Dose volume and the structure do not overlap"; // User-friendly error to help troubleshooting
+      }
+      else if (isDoseVolume && total.Min < 0)
+      {
+        errorMessage = "The dose volume contains negative dose values";
+      }
+      if (!errorMessage.empty())
+      {
+        errorMessages[segmentIndex] = errorMessage;
+        stencilPointers[segmentIndex] = NULL;
+        continue;
+      }
+
+      if (!isDoseVolume && sweepIndex == 0)
+      {
+        startValues[segmentIndex] = total.Min;
+        numberOfBins[segmentIndex] = this->NumberOfSamplesForNonDoseVolumes;
+        stepSizes[segmentIndex] = (total.Max - total.Min) / (double)(this->NumberOfSamplesForNonDoseVolumes-1);
+      }
+    }
+  }
+
+  // Get voxel volume (all labelmaps are on the lattice of the oversampled dose volume)
+  double* doseSpacing = fixedOversampledDoseVolume->GetSpacing();
+  double cubicMMPerVoxel = doseSpacing[0] * doseSpacing[1] * doseSpacing[2];
+  double ccPerCubicMM = 0.001;
+
+  for (int segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+  {
+    if (!errorMessages[segmentIndex].empty())
+    {
+      segmentResults[segmentIndex].ErrorMessage = errorMessages[segmentIndex];
+      continue;
+    }
+    vtkDvhSegmentAccumulator& total = totals[segmentIndex];
+    SegmentDvhResult& result = segmentResults[segmentIndex];
+    double totalVoxels = (double)total.VoxelCount;
+    result.VolumeCc = totalVoxels * cubicMMPerVoxel * ccPerCubicMM;
+    result.MeanDose = total.Sum / totalVoxels;
+    result.MinDose = total.Min;
+    result.MaxDose = total.Max;
+
+    result.DvhValues = vtkSmartPointer<vtkDoubleArray>::New();
+    AssembleDvhValues(result.DvhValues, (total.Bins.empty() ? NULL : &total.Bins[0]), numberOfBins[segmentIndex],
+      startValues[segmentIndex], stepSizes[segmentIndex], (double)total.VoxelCountBelowRange, totalVoxels, false, isDoseVolume);
+  }
+
+  progress = 1.0;
+  this->InvokeEvent(SlicerRtCommon::ProgressUpdated, (void*)&progress);
+
+  // Log measured time
+  double checkpointEnd = timer->GetUniversalTime();
+  UNUSED_VARIABLE(checkpointEnd); // Although it is used just below, a warning is logged so needs to be suppressed
+  if (this->LogSpeedMeasurements)
+  {
+    vtkDebugMacro("ComputeDvhInSingleSweep: DVH computation time for " << numberOfSegments << " structures: " << checkpointEnd-checkpointStart << " s");
+  }
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeSegmentDvh(vtkOrientedImageData* segmentLabelmap,
+  vtkOrientedImageData* doseImageData, vtkOrientedImageData* fixedOversampledDoseVolume, std::string doseVolumeCacheKey,
+  bool resamplingRequired, bool useFractionalLabelmap, bool isDoseVolume, double maxDoseGy, std::string segmentID, SegmentDvhResult &result)
+{
+  if (!segmentLabelmap || !doseImageData)
+  {
+    return std::string("Invalid segment labelmap or dose volume");
+  }
+
+  double minimumValue = 0.0;
+  double maximumValue = 1.0;
+  GetLabelmapScalarRange(segmentLabelmap, minimumValue, maximumValue);
+
+  // Resample labelmap if necessary (if it was master, and could not be re-converted using the oversampled geometry, or if there was a parent transform)
+  if (resamplingRequired)
+  {
+    // Resample segmentation labelmap volume
+    if ( !vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+      segmentLabelmap, fixedOversampledDoseVolume, segmentLabelmap, useFractionalLabelmap, false, NULL, minimumValue ) )
+    {
+      return std::string("Failed to resample segment binary labelmap");
+    }
+  }
+
+  // Crop the labelmap to the extent actually containing the segment, so that the dose is only resampled and
+  // accumulated where the segment is. The dose is resampled from the full dose volume, so no interpolation margin is needed.
+  int effectiveExtent[6] = {0,-1,0,-1,0,-1};
+  if (!GetLabelmapEffectiveExtent(segmentLabelmap, minimumValue, effectiveExtent))
+  {
+    return std::string("Dose volume and the structure do not overlap"); // Empty segment
+  }
+  if (fixedOversampledDoseVolume)
+  {
+    // The labelmap and the dose are on the same lattice, only the part inside the dose volume needs to be considered
+    int doseExtent[6] = {0,-1,0,-1,0,-1};
+    fixedOversampledDoseVolume->GetExtent(doseExtent);
+    for (int axis=0; axis<3; ++axis)
+    {
+      effectiveExtent[axis*2] = std::max(effectiveExtent[axis*2], doseExtent[axis*2]);
+      effectiveExtent[axis*2+1] = std::min(effectiveExtent[axis*2+1], doseExtent[axis*2+1]);
+      if (effectiveExtent[axis*2] > effectiveExtent[axis*2+1])
+      {
+        return std::string("Dose volume and the structure do not overlap");
+      }
+    }
+  }
+  CropImageToExtent(segmentLabelmap, effectiveExtent, minimumValue);
+
+  // Get oversampled dose volume.
+  // The shared dose volumes are shallow copied so that the pipelines running in parallel do not use the same data object
+  vtkSmartPointer<vtkOrientedImageData> oversampledDoseVolume = vtkSmartPointer<vtkOrientedImageData>::New();
+  // Use the same resampled dose volume if oversampling is fixed, cropped to the segment
+  if (fixedOversampledDoseVolume)
+  {
+    oversampledDoseVolume->ShallowCopy(fixedOversampledDoseVolume);
+    CropImageToExtent(oversampledDoseVolume, effectiveExtent, 0.0);
+  }
+  // Resample dose volume to match automatically oversampled segment labelmap geometry
+  else
+  {
+    std::string geometryKey = vtkResampledDoseVolumeCache::GetGeometryKey(segmentLabelmap);
+    if (!vtkResampledDoseVolumeCache::GetInstance()->GetResampledDoseVolume(doseVolumeCacheKey, geometryKey, oversampledDoseVolume))
+    {
+      vtkSmartPointer<vtkOrientedImageData> doseImageDataCopy = vtkSmartPointer<vtkOrientedImageData>::New();
+      doseImageDataCopy->ShallowCopy(doseImageData);
+      if ( !vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+        doseImageDataCopy, segmentLabelmap, oversampledDoseVolume, true ) )
+      {
+        return std::string("Failed to resample dose volume");
+      }
+      vtkResampledDoseVolumeCache::GetInstance()->AddResampledDoseVolume(doseVolumeCacheKey, geometryKey, oversampledDoseVolume);
+    }
+  }
+
+  // Calculate DVH for current segment
+  return this->ComputeDvh(segmentLabelmap, oversampledDoseVolume, useFractionalLabelmap, isDoseVolume, maxDoseGy, segmentID, result);
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkOrientedImageData* segmentLabelmap, vtkOrientedImageData* oversampledDoseVolume,
+  bool useFractionalLabelmap, bool isDoseVolume, double maxDoseGy, std::string segmentID, SegmentDvhResult &result)
+{
+  if (!segmentLabelmap)
+  {
+    return std::string("Invalid segment labelmap");
+  }
+  if (!oversampledDoseVolume)
+  {
+    return std::string("Invalid oversampled dose volume");
   }
-  std::string segmentName = parameterNode->GetSegmentationNode()->GetSegmentation()->GetSegment(segmentID)->GetName();
 
   vtkSmartPointer<vtkTimerLog> timer = vtkSmartPointer<vtkTimerLog>::New();
   double checkpointStart = timer->GetUniversalTime();
@@ -477,17 +1344,8 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
   // which is a rare scenario, but may still happen.
   double minimumValue = 0.0;
   double maximumValue = 1.0;
-  segmentLabelmap->GetFieldData();
-  vtkDoubleArray* scalarRange = vtkDoubleArray::SafeDownCast(
-    segmentLabelmap->GetFieldData()->GetAbstractArray( vtkSegmentationConverter::GetScalarRangeFieldName() )
-    );
-  if (scalarRange && scalarRange->GetNumberOfValues() == 2)
-  {
-    minimumValue = scalarRange->GetValue(0);
-    maximumValue = scalarRange->GetValue(1);
-  }
+  GetLabelmapScalarRange(segmentLabelmap, minimumValue, maximumValue);
 
-  bool useFractionalLabelmap = parameterNode->GetUseFractionalLabelmap();
   if (useFractionalLabelmap)
   {
     stencil->ThresholdByUpper(minimumValue + 1e-10);
@@ -503,39 +1361,127 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
 
   int stencilExtent[6] = {0,-1,0,-1,0,-1};
   structureStencil->GetExtent(stencilExtent);
-  if (stencilExtent[1]-stencilExtent[0] <= 0 || stencilExtent[3]-stencilExtent[2] <= 0 || stencilExtent[5]-stencilExtent[4] <= 0)
+  if (stencilExtent[1]-stencilExtent[0] < 0 || stencilExtent[3]-stencilExtent[2] < 0 || stencilExtent[5]-stencilExtent[4] < 0)
   {
-    std::string errorMessage("Invalid stenciled dose volume");
-    vtkErrorMacro("ComputeDvh: " << errorMessage);
-    return errorMessage;
+    return std::string("Invalid stenciled dose volume");
   }
 
-  // Compute statistics
-  vtkSmartPointer<vtkImageAccumulate> structureStat;
+  // Set up accumulator computing the statistics, the histogram, and the number of voxels below the histogram range in one pass.
+  // Binary labelmaps are also handled by the fractional accumulator (with every voxel weighted by one).
+  vtkSmartPointer<vtkFractionalImageAccumulate> structureStat = vtkSmartPointer<vtkFractionalImageAccumulate>::New();
+  structureStat->SetUseFractionalLabelmap(useFractionalLabelmap);
   if (useFractionalLabelmap)
   {
-    structureStat = vtkSmartPointer<vtkFractionalImageAccumulate>::New();
-    vtkFractionalImageAccumulate::SafeDownCast(structureStat)->UseFractionalLabelmapOn();
-    vtkFractionalImageAccumulate::SafeDownCast(structureStat)->SetFractionalLabelmap(segmentLabelmap);
-    vtkFractionalImageAccumulate::SafeDownCast(structureStat)->SetMinimumFractionalValue(minimumValue);
-    vtkFractionalImageAccumulate::SafeDownCast(structureStat)->SetMaximumFractionalValue(maximumValue);
-  }
-  else
-  {
-    structureStat = vtkSmartPointer<vtkImageAccumulate>::New();
+    structureStat->SetFractionalLabelmap(segmentLabelmap);
+    structureStat->SetMinimumFractionalValue(minimumValue);
+    structureStat->SetMaximumFractionalValue(maximumValue);
   }
   structureStat->SetInputData(oversampledDoseVolume);
   structureStat->SetStencilData(structureStencil);
+
+  // Determine DVH bins. For dose volumes they only depend on the dose volume, so a single pass is enough.
+  // For other volumes the bins span the intensity range of the structure, so statistics need to be computed first.
+  int numSamples = 0;
+  double startValue = 0.0;
+  double stepSize = 1.0;
+  if (isDoseVolume)
+  {
+    startValue = this->StartValue;
+    stepSize = this->StepSize;
+    numSamples = (int)ceil( (maxDoseGy-startValue)/stepSize ) + 1;
+
+    structureStat->SetComponentExtent(0,numSamples-1,0,0,0,0);
+    structureStat->SetComponentOrigin(startValue,0,0);
+    structureStat->SetComponentSpacing(stepSize,1,1);
+  }
   structureStat->Update();
 
   // Report error if there are no voxels in the stenciled dose volume (no non-zero voxels in the resampled labelmap)
   if (structureStat->GetVoxelCount() < 1)
   {
-    std::string errorMessage("Dose volume and the structure do not overlap"); // User-friendly error to help troubleshooting
-    vtkErrorMacro("ComputeDvh: " << errorMessage);
-    return errorMessage;
+    return std::string("Dose volume and the structure do not overlap"); // User-friendly error to help troubleshooting
   }
 
+  double rangeMin = structureStat->GetMin()[0];
+  double rangeMax = structureStat->GetMax()[0];
+  if (isDoseVolume)
+  {
+    if (rangeMin<0)
+    {
+      return std::string("The dose volume contains negative dose values");
+    }
+  }
+  else
+  {
+    startValue = rangeMin;
+    numSamples = this->NumberOfSamplesForNonDoseVolumes;
+    stepSize = (rangeMax - rangeMin) / (double)(numSamples-1);
+
+    structureStat->SetComponentExtent(0,numSamples-1,0,0,0,0);
+    structureStat->SetComponentOrigin(startValue,0,0);
+    structureStat->SetComponentSpacing(stepSize,1,1);
+    structureStat->Update();
+  }
+
+  // Get spacing and voxel volume
+  double* segmentLabelmapSpacing = segmentLabelmap->GetSpacing();
+  double cubicMMPerVoxel = segmentLabelmapSpacing[0] * segmentLabelmapSpacing[1] * segmentLabelmapSpacing[2];
+  double ccPerCubicMM = 0.001;
+
+  // Volume (cc)
+  double totalVoxels = 0;
+  if (useFractionalLabelmap)
+  {
+    totalVoxels = structureStat->GetFractionalVoxelCount();
+  }
+  else
+  {
+    totalVoxels = structureStat->GetVoxelCount();
+  }
+  result.VolumeCc = totalVoxels * cubicMMPerVoxel * ccPerCubicMM;
+  // Mean, min, max dose
+  result.MeanDose = structureStat->GetMean()[0];
+  result.MinDose = rangeMin;
+  result.MaxDose = rangeMax;
+
+  // Get the number of voxels with smaller dose than at the start value
+  double voxelBelowDose = structureStat->GetFractionalVoxelCountBelowRange();
+
+  // Assemble cumulative DVH from the histogram
+  result.DvhValues = vtkSmartPointer<vtkDoubleArray>::New();
+  AssembleDvhValues(result.DvhValues, static_cast<double*>(structureStat->GetOutput()->GetScalarPointer()), numSamples,
+    startValue, stepSize, voxelBelowDose, totalVoxels, useFractionalLabelmap, isDoseVolume);
+
+  // Log measured time
+  double checkpointEnd = timer->GetUniversalTime();
+  UNUSED_VARIABLE(checkpointEnd); // Although it is used just below, a warning is logged so needs to be suppressed
+  if (this->LogSpeedMeasurements)
+  {
+    vtkDebugMacro("ComputeDvh: DVH computation time for structure '" << segmentID << "': " << checkpointEnd-checkpointStart << " s");
+  }
+
+  return "";
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerDoseVolumeHistogramModuleLogic::CommitDvh(vtkMRMLDoseVolumeHistogramNode* parameterNode, std::string segmentID, SegmentDvhResult &result)
+{
+  if (!this->GetMRMLScene() || !parameterNode)
+  {
+    return std::string("Invalid MRML scene or parameter set node");
+  }
+  vtkMRMLSegmentationNode* segmentationNode = parameterNode->GetSegmentationNode();
+  vtkMRMLScalarVolumeNode* doseVolumeNode = parameterNode->GetDoseVolumeNode();
+  if ( !segmentationNode || !doseVolumeNode )
+  {
+    return std::string("Both segmentation node and dose volume node need to be set");
+  }
+  if (!result.DvhValues.GetPointer())
+  {
+    return std::string("Missing DVH values for segment " + segmentID);
+  }
+  std::string segmentName = segmentationNode->GetSegmentation()->GetSegment(segmentID)->GetName();
+
   // Get metrics table for the parameter node; Create one if missing
   vtkMRMLTableNode* metricsTableNode = parameterNode->GetMetricsTableNode();
   vtkTable* metricsTable = metricsTableNode->GetTable();
@@ -577,9 +1523,7 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
   }
   else
   {
-    std::string errorMessage("Failed to find metrics table row for structure " + segmentName);
-    vtkErrorMacro("ComputeDvh: " << errorMessage);
-    return errorMessage;
+    return std::string("Failed to find metrics table row for structure " + segmentName);
   }
 
   // Set array node attributes:
@@ -590,11 +1534,6 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
   oversamplingAttrValueStream << (parameterNode->GetAutomaticOversampling() ? (-1.0) : this->DefaultDoseVolumeOversamplingFactor);
   arrayNode->SetAttribute(DVH_DOSE_VOLUME_OVERSAMPLING_FACTOR_ATTRIBUTE_NAME.c_str(), oversamplingAttrValueStream.str().c_str());
 
-  // Get spacing and voxel volume
-  double* segmentLabelmapSpacing = segmentLabelmap->GetSpacing();
-  double cubicMMPerVoxel = segmentLabelmapSpacing[0] * segmentLabelmapSpacing[1] * segmentLabelmapSpacing[2];
-  double ccPerCubicMM = 0.001;
-
   // Set default column values
 
   // Structure name
@@ -602,130 +1541,33 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
   // Volume name
   metricsTable->SetValue(tableRow, vtkMRMLDoseVolumeHistogramNode::MetricColumnDoseVolume, vtkVariant(doseVolumeNode->GetName()));
   // Volume (cc) - save as attribute too (the DVH contains percentages that often need to be converted to volume)
-  double volumeCc = 0;
-  if (useFractionalLabelmap)
-  {
-    volumeCc = vtkFractionalImageAccumulate::SafeDownCast(structureStat)->GetFractionalVoxelCount() * cubicMMPerVoxel * ccPerCubicMM;
-  }
-  else
-  {
-    volumeCc = structureStat->GetVoxelCount() * cubicMMPerVoxel * ccPerCubicMM;
-  }
-  metricsTable->SetValue(tableRow, vtkMRMLDoseVolumeHistogramNode::MetricColumnVolumeCc, vtkVariant(volumeCc));
+  metricsTable->SetValue(tableRow, vtkMRMLDoseVolumeHistogramNode::MetricColumnVolumeCc, vtkVariant(result.VolumeCc));
   std::ostringstream attributeNameStream;
   std::ostringstream attributeValueStream;
   attributeNameStream << vtkMRMLDoseVolumeHistogramNode::DVH_ATTRIBUTE_PREFIX << vtkSlicerDoseVolumeHistogramModuleLogic::DVH_METRIC_TOTAL_VOLUME_CC;
-  attributeValueStream << volumeCc;
+  attributeValueStream << result.VolumeCc;
   arrayNode->SetAttribute(attributeNameStream.str().c_str(), attributeValueStream.str().c_str());
   // Mean dose
-  metricsTable->SetValue(tableRow, vtkMRMLDoseVolumeHistogramNode::MetricColumnMeanDose, vtkVariant(structureStat->GetMean()[0]));
+  metricsTable->SetValue(tableRow, vtkMRMLDoseVolumeHistogramNode::MetricColumnMeanDose, vtkVariant(result.MeanDose));
   // Min dose
-  metricsTable->SetValue(tableRow, vtkMRMLDoseVolumeHistogramNode::MetricColumnMinDose, vtkVariant(structureStat->GetMin()[0]));
+  metricsTable->SetValue(tableRow, vtkMRMLDoseVolumeHistogramNode::MetricColumnMinDose, vtkVariant(result.MinDose));
   // Max dose
-  metricsTable->SetValue(tableRow, vtkMRMLDoseVolumeHistogramNode::MetricColumnMaxDose, vtkVariant(structureStat->GetMax()[0]));
-
-  // Create DVH plot values
-  int numSamples = 0;
-  double startValue;
-  double stepSize;
-  double rangeMin = structureStat->GetMin()[0];
-  double rangeMax = structureStat->GetMax()[0];
-  if (SlicerRtCommon::IsDoseVolumeNode(doseVolumeNode))
-  {
-    if (rangeMin<0)
-    {
-      std::string errorMessage("The dose volume contains negative dose values");
-      vtkErrorMacro("ComputeDvh: " << errorMessage);
-      return errorMessage;
-    }
-
-    startValue = this->StartValue;
-    stepSize = this->StepSize;
-    numSamples = (int)ceil( (maxDoseGy-startValue)/stepSize ) + 1;
-  }
-  else
-  {
-    startValue = rangeMin;
-    numSamples = this->NumberOfSamplesForNonDoseVolumes;
-    stepSize = (rangeMax - rangeMin) / (double)(numSamples-1);
-  }
-
-  // Get the number of voxels with smaller dose than at the start value
-  structureStat->SetComponentExtent(0,1,0,0,0,0);
-  structureStat->SetComponentOrigin(0,0,0);
-  structureStat->SetComponentSpacing(startValue,1,1);
-  structureStat->Update();
-  double voxelBelowDose = structureStat->GetOutput()->GetScalarComponentAsDouble(0,0,0,0);
-
-  // We put a fixed point at (0.0, 100%), but only if there are only positive values in the histogram
-  // Negative values can occur when the user requests histogram for an image, such as s CT volume (in this case Intensity Volume Histogram is computed),
-  // or the startValue became negative for the dose volume because the range minimum was smaller than the original start value.
-  bool insertPointAtOrigin=true;
-  if (startValue<0)
-  {
-    insertPointAtOrigin=false;
-  }
-
-  structureStat->SetComponentExtent(0,numSamples-1,0,0,0,0);
-  structureStat->SetComponentOrigin(startValue,0,0);
-  structureStat->SetComponentSpacing(stepSize,1,1);
-  structureStat->Update();
+  metricsTable->SetValue(tableRow, vtkMRMLDoseVolumeHistogramNode::MetricColumnMaxDose, vtkVariant(result.MaxDose));
 
+  // Copy DVH plot values
   vtkDoubleArray* doubleArray = arrayNode->GetArray();
-  doubleArray->SetNumberOfTuples(numSamples + (insertPointAtOrigin?1:0));
-
-  int outputArrayIndex=0;
-
-  if (insertPointAtOrigin)
-  {
-    // Add first fixed point at (0.0, 100%)
-    doubleArray->SetComponent(outputArrayIndex, 0, 0.0);
-    doubleArray->SetComponent(outputArrayIndex, 1, 100.0);
-    doubleArray->SetComponent(outputArrayIndex, 2, 0);
-    ++outputArrayIndex;
-  }
-
-  vtkImageData* statArray = structureStat->GetOutput();
-  double totalVoxels = 0;
-  if (useFractionalLabelmap)
-  {
-    totalVoxels = vtkFractionalImageAccumulate::SafeDownCast(structureStat)->GetFractionalVoxelCount();
-  }
-  else
-  {
-    totalVoxels = structureStat->GetVoxelCount();
-  }
-
-  for (int sampleIndex=0; sampleIndex<numSamples; ++sampleIndex)
-  {
-    double voxelsInBin = statArray->GetScalarComponentAsDouble(sampleIndex,0,0,0);
-    doubleArray->SetComponent( outputArrayIndex, 0, startValue + sampleIndex * stepSize );
-    if (useFractionalLabelmap)
-    {
-      doubleArray->SetComponent( outputArrayIndex, 1, std::max(0.0, (1.0-(double)voxelBelowDose/(double)totalVoxels)*100.0) );
-    }
-    else
-    {
-      doubleArray->SetComponent( outputArrayIndex, 1, (1.0-(double)voxelBelowDose/(double)totalVoxels)*100.0 );
-    }
-    doubleArray->SetComponent( outputArrayIndex, 2, 0 );
-    ++outputArrayIndex;
-    voxelBelowDose += voxelsInBin;
-  }
-
-  // Set the start of the first bin to 0 if the volume contains dose and the start value was negative
-  if (SlicerRtCommon::IsDoseVolumeNode(doseVolumeNode) && !insertPointAtOrigin)
+  vtkIdType numberOfTuples = result.DvhValues->GetNumberOfTuples();
+  doubleArray->SetNumberOfTuples(numberOfTuples);
+  for (vtkIdType tupleIndex=0; tupleIndex<numberOfTuples; ++tupleIndex)
   {
-    doubleArray->SetComponent(0,0,0);
+    doubleArray->SetTuple(tupleIndex, result.DvhValues->GetTuple(tupleIndex));
   }
 
   // Setup DVH subject hierarchy item
   vtkMRMLSubjectHierarchyNode* shNode = vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(this->GetMRMLScene());
   if (!shNode)
   {
-    std::string errorMessage("Failed to access subject hierarchy node");
-    vtkErrorMacro("ComputeDvh: " << errorMessage);
-    return errorMessage;
+    return std::string("Failed to access subject hierarchy node");
   }
   vtkIdType doseShItemID = shNode->GetItemByDataNode(doseVolumeNode);
   vtkIdType dvhShItemID = shNode->CreateItem(doseShItemID, arrayNode);
@@ -744,14 +1586,6 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
   segmentationNode->AddNodeReferenceID(DVH_CREATED_DVH_NODE_REFERENCE_ROLE.c_str(), arrayNode->GetID());
   doseVolumeNode->AddNodeReferenceID(DVH_CREATED_DVH_NODE_REFERENCE_ROLE.c_str(), arrayNode->GetID());
 
-  // Log measured time
-  double checkpointEnd = timer->GetUniversalTime();
-  UNUSED_VARIABLE(checkpointEnd); // Although it is used just below, a warning is logged so needs to be suppressed
-  if (this->LogSpeedMeasurements)
-  {
-    vtkDebugMacro("ComputeDvh: DVH computation time for structure '" << segmentID << "': " << checkpointEnd-checkpointStart << " s");
-  }
-
   return "";
 }
 
@@ -32,6 +32,12 @@
 
 // VTK includes
 #include "vtkImageAccumulate.h"
+#include <vtkDoubleArray.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <map>
+#include <vector>
 
 #include "vtkSlicerDoseVolumeHistogramModuleLogicExport.h"
 
@@ -83,6 +89,10 @@ public:
   /// Compute DVH based on parameter node selections (dose volume, segmentation, segment IDs)
   std::string ComputeDvh(vtkMRMLDoseVolumeHistogramNode* parameterNode);
 
+  /// Get the time spent in the stages of the last DVH computation in seconds, keyed by stage name.
+  /// The stages are Preparation, Conversion, DoseResampling, Computation and Commit. Empty if no DVH was computed in the last call
+  void GetLastComputationStageTimes(std::map<std::string, double>& stageTimes);
+
   /// Compute V metrics for existing DVHs using the given dose values and add them in the metrics table
   bool ComputeVMetrics(vtkMRMLDoseVolumeHistogramNode* parameterNode);
 
@@ -127,20 +137,96 @@ public:
   vtkGetMacro(DefaultDoseVolumeOversamplingFactor, double);
   vtkSetMacro(DefaultDoseVolumeOversamplingFactor, double);
 
+  vtkGetMacro(ComputeSegmentsInSingleSweep, bool);
+  vtkSetMacro(ComputeSegmentsInSingleSweep, bool);
+  vtkBooleanMacro(ComputeSegmentsInSingleSweep, bool);
+
+  vtkGetMacro(UseSlabStreaming, bool);
+  vtkSetMacro(UseSlabStreaming, bool);
+  vtkBooleanMacro(UseSlabStreaming, bool);
+
+  vtkGetMacro(SlabStreamingMemoryLimitMB, double);
+  vtkSetMacro(SlabStreamingMemoryLimitMB, double);
+
   vtkGetMacro(LogSpeedMeasurements, bool);
   vtkSetMacro(LogSpeedMeasurements, bool);
   vtkBooleanMacro(LogSpeedMeasurements, bool);
 
 protected:
+  /// Output of the DVH computation for one segment. It is filled in the parallel computation step of \sa ComputeDvh()
+  /// that does not access the MRML scene, and is written to the DVH array node and metrics table in the serial commit step.
+  struct SegmentDvhResult
+  {
+    SegmentDvhResult() : VolumeCc(0.0), MeanDose(0.0), MinDose(0.0), MaxDose(0.0) { };
+
+    /// Error message, empty string if the computation succeeded
+    std::string ErrorMessage;
+    /// Total volume of the structure in cc
+    double VolumeCc;
+    /// Mean, minimum and maximum dose (or intensity) in the structure
+    double MeanDose;
+    double MinDose;
+    double MaxDose;
+    /// DVH plot values (dose, volume percentage, 0), in the same layout as the array of the DVH double array node
+    vtkSmartPointer<vtkDoubleArray> DvhValues;
+  };
+
+  /// Get state of the inputs shared by all segments: dose volume, segmentation transforms, metrics table and computation parameters.
+  /// If it changes, then the DVH of all segments need to be recomputed.
+  std::string GetDvhInputState(vtkMRMLDoseVolumeHistogramNode* parameterNode);
+
+  /// Determine whether the DVH of a segment needs to be recomputed. The DVH is up to date if the source representation
+  /// of the segment has not been modified since it was computed, and the DVH array node and its metrics table row still exist.
+  /// Neither the parameter node nor the metrics table is modified.
+  /// \param segmentInputMTime Output current modified time of the source representation of the segment
+  /// \param tableRow Output metrics table row of the DVH of the segment if it is up to date, -1 otherwise
+  bool IsDvhUpToDate(vtkMRMLDoseVolumeHistogramNode* parameterNode, std::string segmentID, unsigned long &segmentInputMTime, int &tableRow);
+
+  /// Compute DVH for each segment separately, the segments being processed in parallel
+  void ComputeDvhPerSegment(std::vector<std::string>& segmentIDs, std::vector<vtkOrientedImageData*>& segmentLabelmaps,
+    vtkOrientedImageData* doseImageData, vtkOrientedImageData* fixedOversampledDoseVolume, std::string doseVolumeCacheKey,
+    bool resamplingRequired, bool useFractionalLabelmap, bool isDoseVolume, double maxDoseGy, std::vector<SegmentDvhResult>& segmentResults);
+
+  /// Compute DVH for all segments by sweeping the oversampled dose volume once.
+  /// Every row of the dose volume is read once, and its values are accumulated for each segment whose stencil covers it.
+  /// Only applicable for binary labelmaps with fixed oversampling (when all segments share the lattice of the oversampled dose volume).
+  /// \param segmentLabelmaps Binary labelmaps of the segments. They are resampled in place if necessary, except if the dose is streamed
+  /// \param fixedOversampledDoseVolume Dose volume resampled with the fixed oversampling factor. If the dose is streamed, then only its geometry is used
+  /// \param streamedDoseImageData Dose volume in its original geometry if it is to be resampled slab by slab (see \sa UseSlabStreaming), NULL otherwise
+  /// \param segmentResults Output DVH values and statistics, one for each segment
+  void ComputeDvhInSingleSweep(std::vector<vtkOrientedImageData*>& segmentLabelmaps, vtkOrientedImageData* fixedOversampledDoseVolume,
+    vtkOrientedImageData* streamedDoseImageData, bool resamplingRequired, bool isDoseVolume, double maxDoseGy,
+    std::vector<SegmentDvhResult>& segmentResults);
+
+  /// Prepare the labelmap and the oversampled dose volume for one segment, then compute its DVH.
+  /// Does not access the MRML scene, so it can be called for different segments in parallel.
+  /// \param segmentLabelmap Labelmap representation of the segment. It is resampled and padded in place
+  /// \param doseImageData Dose volume in its original geometry (used for resampling with automatic oversampling)
+  /// \param fixedOversampledDoseVolume Dose volume resampled with the fixed oversampling factor. NULL if oversampling is automatic
+  /// \param doseVolumeCacheKey Key of the dose volume in the resampled dose volume cache (empty if caching is not used)
+  /// \param resamplingRequired Flag indicating whether the labelmap needs to be resampled to the oversampled dose geometry
+  /// \return Error message, empty string if no error
+  std::string ComputeSegmentDvh(vtkOrientedImageData* segmentLabelmap, vtkOrientedImageData* doseImageData,
+    vtkOrientedImageData* fixedOversampledDoseVolume, std::string doseVolumeCacheKey, bool resamplingRequired,
+    bool useFractionalLabelmap, bool isDoseVolume, double maxDoseGy, std::string segmentID, SegmentDvhResult &result);
+
   /// Compute DVH for the given structure segment with the stenciled dose volume
   /// (the labelmap representation of a segment but with dose values instead of the labels)
-  /// \param parameterNode Dose volume histogram parameter set node
+  /// Does not access the MRML scene, so it can be called for different segments in parallel.
   /// \param segmentLabelmap Binary representation of the labelmap representation of the segment the DVH is calculated on
   /// \param oversampledDoseVolume Dose volume resampled to match the geometry of the segment labelmap (to allow stenciling)
-  /// \param segmentID ID of segment the DVH is calculated on
+  /// \param useFractionalLabelmap Flag determining whether the segment labelmap is fractional
+  /// \param isDoseVolume Flag determining whether the input volume is a dose volume (intensity volume otherwise)
   /// \param maxDoseGy Maximum dose determining the number of DVH bins (passed as argument so that it is only calculated once in \sa ComputeDvh() )
+  /// \param segmentID ID of segment the DVH is calculated on (for logging)
+  /// \param result Output DVH values and statistics
   /// \return Error message, empty string if no error
-  std::string ComputeDvh(vtkMRMLDoseVolumeHistogramNode* parameterNode, vtkOrientedImageData* segmentLabelmap, vtkOrientedImageData* oversampledDoseVolume, std::string segmentID, double maxDoseGy);
+  std::string ComputeDvh(vtkOrientedImageData* segmentLabelmap, vtkOrientedImageData* oversampledDoseVolume,
+    bool useFractionalLabelmap, bool isDoseVolume, double maxDoseGy, std::string segmentID, SegmentDvhResult &result);
+
+  /// Write DVH computed for a segment to the MRML scene: DVH double array node, metrics table row, subject hierarchy
+  /// \return Error message, empty string if no error
+  std::string CommitDvh(vtkMRMLDoseVolumeHistogramNode* parameterNode, std::string segmentID, SegmentDvhResult &result);
 
   /// Return the chart view node object from the layout
   vtkMRMLChartViewNode* GetChartViewNode();
@@ -178,6 +264,8 @@ private:
   vtkSlicerDoseVolumeHistogramModuleLogic(const vtkSlicerDoseVolumeHistogramModuleLogic&); // Not implemented
   void operator=(const vtkSlicerDoseVolumeHistogramModuleLogic&);               // Not implemented
 
+  friend class vtkDoseVolumeHistogramSegmentFunctor; // For parallel computation of the segments
+
 protected:
   /// Start value for the dose axis of the DVH table
   double StartValue;
@@ -192,8 +280,26 @@ protected:
   /// The structure labelmap is resampled temporarily to the same lattice as the oversampled dose volume if needed.
   double DefaultDoseVolumeOversamplingFactor;
 
+  /// Flag determining whether the DVHs of all segments are computed in a single sweep of the dose volume
+  /// instead of one pass per segment. Only used with binary labelmaps and fixed oversampling. Off by default
+  bool ComputeSegmentsInSingleSweep;
+
+  /// Flag determining whether the oversampled dose volume is resampled and swept in slabs along the Z axis instead of as a whole.
+  /// The stencils of the segments are created for each slab from the part of their labelmaps within the slab (resampled to the slab
+  /// if needed), so neither the resampled dose nor the stencils grow with the size of the oversampled dose volume. The segment
+  /// labelmaps themselves are still created by the segmentation on the oversampled lattice before the computation (each cropped to
+  /// its segment), so their memory does grow with the oversampling factor. The DVHs of all segments are accumulated in the same sweep.
+  /// Only used with binary labelmaps and fixed oversampling. Off by default
+  bool UseSlabStreaming;
+
+  /// Maximum memory size of one resampled dose slab in megabytes if slab streaming is used. A slab contains at least one slice
+  double SlabStreamingMemoryLimitMB;
+
   /// Flag telling whether the speed measurements are logged on standard output
   bool LogSpeedMeasurements;
+
+  /// Time spent in the stages of the last DVH computation in seconds (see \sa GetLastComputationStageTimes)
+  std::map<std::string, double> LastComputationStageTimes;
 };
 
 #endif
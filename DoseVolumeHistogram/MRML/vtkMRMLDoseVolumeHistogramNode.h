@@ -137,6 +137,35 @@ public:
     factors = this->AutomaticOversamplingFactors;
   }
 
+  /// Clear the stored input states of the computed DVHs, so that all segments are recomputed next time
+  void ClearSegmentInputMTimes()
+  {
+    this->SegmentInputMTimes.clear();
+    this->DvhInputState.clear();
+  }
+  /// Store modified time of the source representation of a segment at the time its DVH was computed
+  void SetSegmentInputMTime(std::string segmentID, unsigned long mtime)
+  {
+    this->SegmentInputMTimes[segmentID] = mtime;
+  }
+  /// Get modified time of the source representation of a segment at the time its DVH was computed. 0 if not computed
+  unsigned long GetSegmentInputMTime(std::string segmentID)
+  {
+    std::map<std::string, unsigned long>::iterator mtimeIt = this->SegmentInputMTimes.find(segmentID);
+    return (mtimeIt == this->SegmentInputMTimes.end() ? 0 : mtimeIt->second);
+  }
+  /// Set state of the inputs shared by all segments (dose volume, segmentation transform, computation parameters)
+  /// at the time the stored segment DVHs were computed
+  void SetDvhInputState(std::string state)
+  {
+    this->DvhInputState = state;
+  }
+  /// Get state of the inputs shared by all segments at the time the stored segment DVHs were computed
+  std::string GetDvhInputState()
+  {
+    return this->DvhInputState;
+  }
+
   /// Assemble DVH node reference role for current input selection and specific segment
   std::string AssembleDvhNodeReference(std::string segmentID);
 
@@ -252,6 +281,15 @@ protected:
   /// This property is not saved to the scene, as these are temporary values.
   std::map<std::string, double> AutomaticOversamplingFactors;
 
+  /// Modified times of the source representation of the segments at the time their DVHs were computed.
+  /// Used for skipping the segments that have not changed since the last computation.
+  /// This property is not saved to the scene, so all segments are recomputed after loading.
+  std::map<std::string, unsigned long> SegmentInputMTimes;
+
+  /// State of the inputs shared by all segments at the time the DVHs in \sa SegmentInputMTimes were computed.
+  /// This property is not saved to the scene.
+  std::string DvhInputState;
+
   /// Flag telling whether or not to use fractional labelmaps
   bool UseFractionalLabelmap;
 };
@@ -0,0 +1,597 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// DoseVolumeHistogram includes
+#include "vtkSlicerDoseVolumeHistogramModuleLogic.h"
+#include "vtkMRMLDoseVolumeHistogramNode.h"
+
+// SlicerRt includes
+#include "SlicerRtCommon.h"
+#include "vtkPlanarContourToClosedSurfaceConversionRule.h"
+#include "vtkClosedSurfaceToFractionalLabelmapConversionRule.h"
+#include "vtkResampledDoseVolumeCache.h"
+
+// Segmentations includes
+#include "vtkMRMLSegmentationNode.h"
+#include "vtkSlicerSegmentationsModuleLogic.h"
+
+// SegmentationCore includes
+#include "vtkSegment.h"
+#include "vtkSegmentation.h"
+#include "vtkSegmentationConverter.h"
+#include "vtkSegmentationConverterFactory.h"
+
+// MRML includes
+#include <vtkMRMLCoreTestingMacros.h>
+#include <vtkMRMLDoubleArrayNode.h>
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLSubjectHierarchyNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkSphereSource.h>
+#include <vtkTimerLog.h>
+
+// ITK includes
+#include "itkFactoryRegistration.h"
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#ifdef _WIN32
+  #include <windows.h>
+  #include <psapi.h>
+  #pragma comment(lib, "psapi.lib")
+#else
+  #include <sys/resource.h>
+  #ifdef __APPLE__
+    #include <mach/mach.h>
+  #else
+    #include <unistd.h>
+  #endif
+#endif
+
+namespace
+{
+  //-----------------------------------------------------------------------------
+  /// Get peak resident set size (high water mark) of the process in kibibytes
+  double GetPeakResidentSetSizeKiB()
+  {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS memoryCounters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &memoryCounters, sizeof(memoryCounters)))
+    {
+      return memoryCounters.PeakWorkingSetSize / 1024.0;
+    }
+    return 0.0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+      return 0.0;
+    }
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024.0; // bytes on Mac
+#else
+    return (double)usage.ru_maxrss; // kibibytes on Linux
+#endif
+#endif
+  }
+
+  //-----------------------------------------------------------------------------
+  /// Get current resident set size of the process in kibibytes
+  double GetResidentSetSizeKiB()
+  {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS memoryCounters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &memoryCounters, sizeof(memoryCounters)))
+    {
+      return memoryCounters.WorkingSetSize / 1024.0;
+    }
+    return 0.0;
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t taskInfo;
+    mach_msg_type_number_t taskInfoCount = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&taskInfo, &taskInfoCount) != KERN_SUCCESS)
+    {
+      return 0.0;
+    }
+    return taskInfo.resident_size / 1024.0;
+#else
+    // Second field of statm is the number of resident pages
+    std::ifstream statmFile("/proc/self/statm");
+    long totalPages = 0;
+    long residentPages = 0;
+    if (!(statmFile >> totalPages >> residentPages))
+    {
+      return 0.0;
+    }
+    return residentPages * (sysconf(_SC_PAGESIZE) / 1024.0);
+#endif
+  }
+
+  //-----------------------------------------------------------------------------
+  /// Parse comma separated list of integers
+  std::vector<int> ParseIntegerList(const char* listString)
+  {
+    std::vector<int> values;
+    std::stringstream listStream(listString ? listString : "");
+    std::string item;
+    while (std::getline(listStream, item, ','))
+    {
+      if (!item.empty())
+      {
+        values.push_back(atoi(item.c_str()));
+      }
+    }
+    return values;
+  }
+
+  //-----------------------------------------------------------------------------
+  /// Get key identifying a benchmark case in the baseline
+  std::string GetBenchmarkCaseKey(const std::string& dataSetName, const std::string& labelmap, const std::string& oversampling)
+  {
+    return dataSetName + "|" + labelmap + "|" + oversampling;
+  }
+
+  //-----------------------------------------------------------------------------
+  /// Read minimum wall times of the cases from a JSON report written by an earlier run of the benchmark
+  /// \param baselineMinimumWallTimes Output minimum wall times by case key (see \sa GetBenchmarkCaseKey)
+  /// \return False if the file cannot be read
+  bool ReadBaselineWallTimes(const char* baselineJsonFileName, std::map<std::string, double>& baselineMinimumWallTimes)
+  {
+    std::ifstream baselineFile(baselineJsonFileName);
+    if (!baselineFile.is_open())
+    {
+      return false;
+    }
+
+    // The report is written one value per line, so the values are read by line
+    std::string dataSetName, labelmap, oversampling;
+    std::string line;
+    while (std::getline(baselineFile, line))
+    {
+      size_t valueStart = line.find(':');
+      if (valueStart == std::string::npos)
+      {
+        continue;
+      }
+      std::string value = line.substr(valueStart + 1);
+      value.erase(std::remove(value.begin(), value.end(), '"'), value.end());
+      value.erase(std::remove(value.begin(), value.end(), ','), value.end());
+      value.erase(std::remove(value.begin(), value.end(), ' '), value.end());
+      if (line.find("\"dataSet\"") != std::string::npos)
+      {
+        dataSetName = value;
+      }
+      else if (line.find("\"labelmap\"") != std::string::npos)
+      {
+        labelmap = value;
+      }
+      else if (line.find("\"oversampling\"") != std::string::npos)
+      {
+        oversampling = value;
+      }
+      else if (line.find("\"wallTimeMinSec\"") != std::string::npos)
+      {
+        baselineMinimumWallTimes[GetBenchmarkCaseKey(dataSetName, labelmap, oversampling)] = atof(value.c_str());
+      }
+    }
+    return true;
+  }
+
+  //-----------------------------------------------------------------------------
+  /// Create dose volume with a smooth dose distribution peaking in the center.
+  /// The physical size of the grid is fixed, the number of voxels is scaled along each axis by the given factor
+  vtkMRMLScalarVolumeNode* CreateSyntheticDoseVolume(vtkMRMLScene* scene, int gridScale)
+  {
+    const int baseDimensions[3] = {64, 64, 48};
+    const double baseSpacing[3] = {4.0, 4.0, 4.0};
+    int dimensions[3] = {baseDimensions[0]*gridScale, baseDimensions[1]*gridScale, baseDimensions[2]*gridScale};
+    double spacing[3] = {baseSpacing[0]/gridScale, baseSpacing[1]/gridScale, baseSpacing[2]/gridScale};
+
+    vtkSmartPointer<vtkImageData> doseImageData = vtkSmartPointer<vtkImageData>::New();
+    doseImageData->SetDimensions(dimensions);
+    doseImageData->AllocateScalars(VTK_FLOAT, 1);
+    float* dosePtr = static_cast<float*>(doseImageData->GetScalarPointer());
+    double sigmaMm = 60.0;
+    for (int k = 0; k < dimensions[2]; ++k)
+    {
+      double z = (k - (dimensions[2]-1) / 2.0) * spacing[2];
+      for (int j = 0; j < dimensions[1]; ++j)
+      {
+        double y = (j - (dimensions[1]-1) / 2.0) * spacing[1];
+        for (int i = 0; i < dimensions[0]; ++i)
+        {
+          double x = (i - (dimensions[0]-1) / 2.0) * spacing[0];
+          (*dosePtr++) = static_cast<float>( 70.0 * exp( -(x*x + y*y + z*z) / (2.0*sigmaMm*sigmaMm) ) );
+        }
+      }
+    }
+
+    vtkMRMLScalarVolumeNode* doseVolumeNode = vtkMRMLScalarVolumeNode::New();
+    std::stringstream nameStream;
+    nameStream << "SyntheticDose_x" << gridScale;
+    doseVolumeNode->SetName(nameStream.str().c_str());
+    doseVolumeNode->SetSpacing(spacing);
+    doseVolumeNode->SetOrigin( -(dimensions[0]-1)*spacing[0]/2.0, -(dimensions[1]-1)*spacing[1]/2.0, -(dimensions[2]-1)*spacing[2]/2.0 );
+    doseVolumeNode->SetAndObserveImageData(doseImageData);
+    doseVolumeNode->SetAttribute(SlicerRtCommon::DICOMRTIMPORT_DOSE_VOLUME_IDENTIFIER_ATTRIBUTE_NAME.c_str(), "1");
+    scene->AddNode(doseVolumeNode);
+    doseVolumeNode->Delete(); // Scene owns it now
+    return doseVolumeNode;
+  }
+
+  //-----------------------------------------------------------------------------
+  /// Create segmentation with spherical closed surface segments of varying size, distributed on a ring around the dose peak
+  vtkMRMLSegmentationNode* CreateSyntheticSegmentation(vtkMRMLScene* scene, int numberOfSegments)
+  {
+    vtkMRMLSegmentationNode* segmentationNode = vtkMRMLSegmentationNode::New();
+    std::stringstream nameStream;
+    nameStream << "SyntheticSegments_" << numberOfSegments;
+    segmentationNode->SetName(nameStream.str().c_str());
+    scene->AddNode(segmentationNode);
+    segmentationNode->Delete(); // Scene owns it now
+
+    vtkSegmentation* segmentation = segmentationNode->GetSegmentation();
+    segmentation->SetMasterRepresentationName(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName());
+    for (int segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+    {
+      double angle = 2.0 * vtkMath::Pi() * segmentIndex / numberOfSegments;
+      double ringRadius = 20.0 + 10.0 * (segmentIndex % 3);
+      vtkNew<vtkSphereSource> sphereSource;
+      sphereSource->SetCenter(ringRadius * cos(angle), ringRadius * sin(angle), 8.0 * ((segmentIndex % 5) - 2));
+      sphereSource->SetRadius(8.0 + 4.0 * (segmentIndex % 4));
+      sphereSource->SetThetaResolution(32);
+      sphereSource->SetPhiResolution(32);
+      sphereSource->Update();
+
+      vtkSmartPointer<vtkSegment> segment = vtkSmartPointer<vtkSegment>::New();
+      std::stringstream segmentNameStream;
+      segmentNameStream << "Sphere_" << segmentIndex;
+      segment->SetName(segmentNameStream.str().c_str());
+      segment->AddRepresentation(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName(), sphereSource->GetOutput());
+      segmentation->AddSegment(segment);
+    }
+    return segmentationNode;
+  }
+
+  //-----------------------------------------------------------------------------
+  /// Run DVH computation with the given options and write the measurements as a JSON object.
+  /// The peak resident set size is the high water mark of the whole process, so besides it the increase of the high water mark
+  /// and of the resident set size during the case are reported. For the peak memory of a single case, run it in its own process
+  /// using the -CaseIndex argument of the benchmark.
+  /// \param minimumWallTime Output shortest wall time of the repetitions
+  /// \return True if all repetitions succeeded
+  bool RunDvhBenchmarkCase(vtkMRMLScene* scene, vtkSlicerDoseVolumeHistogramModuleLogic* dvhLogic,
+    vtkMRMLScalarVolumeNode* doseVolumeNode, vtkMRMLSegmentationNode* segmentationNode, const std::string& dataSetName,
+    bool useFractionalLabelmap, bool automaticOversampling, int numberOfRepetitions, std::ostream& jsonStream, double& minimumWallTime)
+  {
+    double totalWallTime = 0.0;
+    minimumWallTime = VTK_DOUBLE_MAX;
+    std::map<std::string, double> totalStageTimes;
+    bool success = true;
+    double residentSetSizeBeforeKiB = GetResidentSetSizeKiB();
+    double peakResidentSetSizeBeforeKiB = GetPeakResidentSetSizeKiB();
+
+    for (int repetitionIndex = 0; repetitionIndex < numberOfRepetitions; ++repetitionIndex)
+    {
+      // Use a new parameter node and empty dose cache so that every run computes all DVHs from scratch
+      vtkResampledDoseVolumeCache::GetInstance()->Clear();
+      vtkSmartPointer<vtkMRMLDoseVolumeHistogramNode> paramNode = vtkSmartPointer<vtkMRMLDoseVolumeHistogramNode>::New();
+      paramNode->SetAndObserveDoseVolumeNode(doseVolumeNode);
+      paramNode->SetAndObserveSegmentationNode(segmentationNode);
+      paramNode->SetAutomaticOversampling(automaticOversampling);
+      paramNode->SetUseFractionalLabelmap(useFractionalLabelmap);
+      scene->AddNode(paramNode);
+
+      double checkpointStart = vtkTimerLog::GetUniversalTime();
+      std::string errorMessage = dvhLogic->ComputeDvh(paramNode);
+      double wallTime = vtkTimerLog::GetUniversalTime() - checkpointStart;
+      if (!errorMessage.empty())
+      {
+        std::cerr << "ERROR: DVH computation failed for " << dataSetName << ": " << errorMessage << std::endl;
+        success = false;
+      }
+
+      totalWallTime += wallTime;
+      minimumWallTime = std::min(minimumWallTime, wallTime);
+      std::map<std::string, double> stageTimes;
+      dvhLogic->GetLastComputationStageTimes(stageTimes);
+      for (std::map<std::string, double>::iterator stageIt = stageTimes.begin(); stageIt != stageTimes.end(); ++stageIt)
+      {
+        totalStageTimes[stageIt->first] += stageIt->second;
+      }
+
+      // Remove created nodes so that the scene does not grow between runs
+      std::vector<vtkMRMLDoubleArrayNode*> dvhNodes;
+      paramNode->GetDvhArrayNodes(dvhNodes);
+      for (std::vector<vtkMRMLDoubleArrayNode*>::iterator dvhNodeIt = dvhNodes.begin(); dvhNodeIt != dvhNodes.end(); ++dvhNodeIt)
+      {
+        scene->RemoveNode(*dvhNodeIt);
+      }
+      if (paramNode->GetMetricsTableNode())
+      {
+        scene->RemoveNode(paramNode->GetMetricsTableNode());
+      }
+      if (paramNode->GetChartNode())
+      {
+        scene->RemoveNode(paramNode->GetChartNode());
+      }
+      scene->RemoveNode(paramNode);
+    }
+    double peakResidentSetSizeKiB = GetPeakResidentSetSizeKiB();
+
+    int* doseDimensions = doseVolumeNode->GetImageData()->GetDimensions();
+    jsonStream << "    {\n"
+      << "      \"dataSet\": \"" << dataSetName << "\",\n"
+      << "      \"doseDimensions\": [" << doseDimensions[0] << ", " << doseDimensions[1] << ", " << doseDimensions[2] << "],\n"
+      << "      \"numberOfSegments\": " << segmentationNode->GetSegmentation()->GetNumberOfSegments() << ",\n"
+      << "      \"labelmap\": \"" << (useFractionalLabelmap ? "fractional" : "binary") << "\",\n"
+      << "      \"oversampling\": \"" << (automaticOversampling ? "automatic" : "fixed") << "\",\n"
+      << "      \"repetitions\": " << numberOfRepetitions << ",\n"
+      << "      \"success\": " << (success ? "true" : "false") << ",\n"
+      << "      \"wallTimeMeanSec\": " << totalWallTime / numberOfRepetitions << ",\n"
+      << "      \"wallTimeMinSec\": " << minimumWallTime << ",\n"
+      << "      \"stageTimeMeanSec\": {";
+    for (std::map<std::string, double>::iterator stageIt = totalStageTimes.begin(); stageIt != totalStageTimes.end(); ++stageIt)
+    {
+      jsonStream << (stageIt == totalStageTimes.begin() ? "" : ",") << "\n        \"" << stageIt->first << "\": " << stageIt->second / numberOfRepetitions;
+    }
+    jsonStream << "\n      },\n"
+      << "      \"peakResidentSetSizeKiB\": " << peakResidentSetSizeKiB << ",\n"
+      << "      \"peakResidentSetSizeIncreaseKiB\": " << peakResidentSetSizeKiB - peakResidentSetSizeBeforeKiB << ",\n"
+      << "      \"residentSetSizeIncreaseKiB\": " << GetResidentSetSizeKiB() - residentSetSizeBeforeKiB << "\n"
+      << "    }";
+
+    std::cout << dataSetName << " (" << (useFractionalLabelmap ? "fractional" : "binary") << ", "
+      << (automaticOversampling ? "automatic" : "fixed") << " oversampling): " << totalWallTime / numberOfRepetitions << " s" << std::endl;
+    return success;
+  }
+}
+
+//-----------------------------------------------------------------------------
+/// Benchmark of DVH computation. Runs ComputeDvh on the dose and structures of a test scene and on synthetic dose grids
+/// and structure sets of increasing size, with binary and fractional labelmaps and fixed and automatic oversampling.
+/// Wall time, time of the computation stages and memory usage are written to a JSON file for regression tracking.
+/// If a case index is given, then only that case is run (cases are numbered in the order they appear in the report),
+/// so that the peak resident set size of the process is that of the single case.
+/// If a baseline report of an earlier run is given, then the benchmark fails if the shortest wall time of any case exceeds
+/// the shortest wall time of the same case in the baseline by more than the allowed ratio.
+int vtkSlicerDoseVolumeHistogramModuleLogicBenchmark( int argc, char * argv[] )
+{
+  const char* testSceneFileName = NULL;
+  const char* outputJsonFileName = NULL;
+  const char* baselineJsonFileName = NULL;
+  double maximumRelativeWallTime = 1.5;
+  std::vector<int> syntheticGridScales;
+  std::vector<int> syntheticSegmentCounts;
+  int numberOfRepetitions = 1;
+  int selectedCaseIndex = -1;
+  bool computeSegmentsInSingleSweep = false;
+
+  for (int argIndex = 1; argIndex+1 < argc; argIndex += 2)
+  {
+    if (STRCASECMP(argv[argIndex], "-TestSceneFile") == 0)
+    {
+      testSceneFileName = argv[argIndex+1];
+    }
+    else if (STRCASECMP(argv[argIndex], "-OutputJsonFile") == 0)
+    {
+      outputJsonFileName = argv[argIndex+1];
+    }
+    else if (STRCASECMP(argv[argIndex], "-BaselineJsonFile") == 0)
+    {
+      baselineJsonFileName = argv[argIndex+1];
+    }
+    else if (STRCASECMP(argv[argIndex], "-MaximumRelativeWallTime") == 0)
+    {
+      maximumRelativeWallTime = atof(argv[argIndex+1]);
+    }
+    else if (STRCASECMP(argv[argIndex], "-SyntheticGridScales") == 0)
+    {
+      syntheticGridScales = ParseIntegerList(argv[argIndex+1]);
+    }
+    else if (STRCASECMP(argv[argIndex], "-SyntheticSegmentCounts") == 0)
+    {
+      syntheticSegmentCounts = ParseIntegerList(argv[argIndex+1]);
+    }
+    else if (STRCASECMP(argv[argIndex], "-NumberOfRepetitions") == 0)
+    {
+      numberOfRepetitions = std::max(1, atoi(argv[argIndex+1]));
+    }
+    else if (STRCASECMP(argv[argIndex], "-CaseIndex") == 0)
+    {
+      selectedCaseIndex = atoi(argv[argIndex+1]);
+    }
+    else if (STRCASECMP(argv[argIndex], "-ComputeSegmentsInSingleSweep") == 0)
+    {
+      computeSegmentsInSingleSweep = (atoi(argv[argIndex+1]) > 0);
+    }
+    else
+    {
+      std::cerr << "Invalid argument: " << argv[argIndex] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (!outputJsonFileName)
+  {
+    std::cerr << "Invalid arguments! Output JSON file needs to be specified" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::map<std::string, double> baselineMinimumWallTimes;
+  if (baselineJsonFileName && !ReadBaselineWallTimes(baselineJsonFileName, baselineMinimumWallTimes))
+  {
+    std::cerr << "ERROR: Failed to read baseline JSON file " << baselineJsonFileName << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Make sure NRRD reading works
+  itk::itkFactoryRegistration();
+
+  // Register conversion rules needed for the structures of the test scene and for fractional labelmaps
+  vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
+    vtkSmartPointer<vtkPlanarContourToClosedSurfaceConversionRule>::New() );
+  vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
+    vtkSmartPointer<vtkClosedSurfaceToFractionalLabelmapConversionRule>::New() );
+
+  vtkSmartPointer<vtkMRMLScene> mrmlScene = vtkSmartPointer<vtkMRMLScene>::New();
+  vtkSmartPointer<vtkSlicerSegmentationsModuleLogic> segmentationsLogic = vtkSmartPointer<vtkSlicerSegmentationsModuleLogic>::New();
+  segmentationsLogic->SetMRMLScene(mrmlScene);
+  vtkSmartPointer<vtkSlicerDoseVolumeHistogramModuleLogic> dvhLogic = vtkSmartPointer<vtkSlicerDoseVolumeHistogramModuleLogic>::New();
+  dvhLogic->SetMRMLScene(mrmlScene);
+  dvhLogic->SetComputeSegmentsInSingleSweep(computeSegmentsInSingleSweep);
+
+  std::stringstream casesStream;
+  bool firstCase = true;
+  bool returnWithSuccess = true;
+
+  // Collect data sets: dose and segmentation pairs
+  std::vector<std::string> dataSetNames;
+  std::vector<vtkMRMLScalarVolumeNode*> doseVolumeNodes;
+  std::vector<vtkMRMLSegmentationNode*> segmentationNodes;
+
+  if (testSceneFileName && vtksys::SystemTools::FileExists(testSceneFileName))
+  {
+    mrmlScene->SetURL(testSceneFileName);
+    mrmlScene->Import();
+    vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(mrmlScene);
+
+    vtkMRMLScalarVolumeNode* sceneDoseVolumeNode = NULL;
+    std::vector<vtkMRMLNode*> volumeNodes;
+    mrmlScene->GetNodesByClass("vtkMRMLScalarVolumeNode", volumeNodes);
+    for (std::vector<vtkMRMLNode*>::iterator volumeNodeIt=volumeNodes.begin(); volumeNodeIt!=volumeNodes.end(); ++volumeNodeIt)
+    {
+      if (SlicerRtCommon::IsDoseVolumeNode(*volumeNodeIt))
+      {
+        sceneDoseVolumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(*volumeNodeIt);
+        break;
+      }
+    }
+    vtkMRMLSegmentationNode* sceneSegmentationNode = vtkMRMLSegmentationNode::SafeDownCast(
+      mrmlScene->GetFirstNodeByClass("vtkMRMLSegmentationNode") );
+    if (!sceneDoseVolumeNode || !sceneSegmentationNode)
+    {
+      std::cerr << "ERROR: Failed to get dose volume and segmentation from test scene " << testSceneFileName << std::endl;
+      return EXIT_FAILURE;
+    }
+    dataSetNames.push_back(vtksys::SystemTools::GetFilenameWithoutLastExtension(testSceneFileName));
+    doseVolumeNodes.push_back(sceneDoseVolumeNode);
+    segmentationNodes.push_back(sceneSegmentationNode);
+  }
+  else if (testSceneFileName)
+  {
+    std::cerr << "ERROR: Test scene file not found: " << testSceneFileName << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  for (std::vector<int>::iterator scaleIt = syntheticGridScales.begin(); scaleIt != syntheticGridScales.end(); ++scaleIt)
+  {
+    vtkMRMLScalarVolumeNode* syntheticDoseVolumeNode = CreateSyntheticDoseVolume(mrmlScene, std::max(1, *scaleIt));
+    for (std::vector<int>::iterator countIt = syntheticSegmentCounts.begin(); countIt != syntheticSegmentCounts.end(); ++countIt)
+    {
+      std::stringstream dataSetNameStream;
+      dataSetNameStream << "Synthetic_Grid" << *scaleIt << "_Segments" << *countIt;
+      dataSetNames.push_back(dataSetNameStream.str());
+      doseVolumeNodes.push_back(syntheticDoseVolumeNode);
+      segmentationNodes.push_back(CreateSyntheticSegmentation(mrmlScene, std::max(1, *countIt)));
+    }
+  }
+
+  // Run all labelmap type and oversampling combinations on each data set
+  int caseIndex = -1;
+  for (unsigned int dataSetIndex = 0; dataSetIndex < dataSetNames.size(); ++dataSetIndex)
+  {
+    for (int fractional = 0; fractional <= 1; ++fractional)
+    {
+      for (int automatic = 0; automatic <= 1; ++automatic)
+      {
+        ++caseIndex;
+        if (selectedCaseIndex >= 0 && caseIndex != selectedCaseIndex)
+        {
+          continue;
+        }
+        casesStream << (firstCase ? "" : ",\n");
+        firstCase = false;
+        double minimumWallTime = 0.0;
+        if (!RunDvhBenchmarkCase(mrmlScene, dvhLogic, doseVolumeNodes[dataSetIndex], segmentationNodes[dataSetIndex],
+          dataSetNames[dataSetIndex], fractional > 0, automatic > 0, numberOfRepetitions, casesStream, minimumWallTime))
+        {
+          returnWithSuccess = false;
+        }
+
+        // Compare to baseline
+        if (!baselineJsonFileName)
+        {
+          continue;
+        }
+        std::string caseKey = GetBenchmarkCaseKey(dataSetNames[dataSetIndex], (fractional ? "fractional" : "binary"), (automatic ? "automatic" : "fixed"));
+        std::map<std::string, double>::iterator baselineIt = baselineMinimumWallTimes.find(caseKey);
+        if (baselineIt == baselineMinimumWallTimes.end())
+        {
+          std::cerr << "ERROR: Case " << caseKey << " not found in baseline JSON file " << baselineJsonFileName << std::endl;
+          returnWithSuccess = false;
+        }
+        else if (minimumWallTime > baselineIt->second * maximumRelativeWallTime)
+        {
+          std::cerr << "ERROR: Case " << caseKey << " took " << minimumWallTime << " s, exceeding " << maximumRelativeWallTime
+            << " times the baseline " << baselineIt->second << " s" << std::endl;
+          returnWithSuccess = false;
+        }
+      }
+    }
+  }
+
+  if (selectedCaseIndex > caseIndex)
+  {
+    std::cerr << "ERROR: Case index " << selectedCaseIndex << " is out of range, the number of cases is " << caseIndex+1 << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Write report
+  std::ofstream jsonFile(outputJsonFileName, std::ios::out | std::ios::trunc);
+  if (!jsonFile.is_open())
+  {
+    std::cerr << "ERROR: Failed to open output JSON file " << outputJsonFileName << std::endl;
+    return EXIT_FAILURE;
+  }
+  jsonFile << "{\n"
+    << "  \"benchmark\": \"DoseVolumeHistogram\",\n"
+    << "  \"numberOfThreads\": " << vtkMultiThreader::GetGlobalDefaultNumberOfThreads() << ",\n"
+    << "  \"computeSegmentsInSingleSweep\": " << (computeSegmentsInSingleSweep ? "true" : "false") << ",\n"
+    << "  \"cases\": [\n" << casesStream.str() << "\n  ]\n"
+    << "}\n";
+  jsonFile.close();
+  std::cout << "Benchmark results written to " << outputJsonFileName << std::endl;
+
+  if (!returnWithSuccess)
+  {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
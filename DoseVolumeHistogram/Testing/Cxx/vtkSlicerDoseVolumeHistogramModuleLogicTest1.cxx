@@ -305,6 +305,28 @@ int vtkSlicerDoseVolumeHistogramModuleLogicTest1( int argc, char * argv[] )
     std::cerr << "Invalid arguments!" << std::endl;
     return EXIT_FAILURE;
   }
+  // ComputeSegmentsInSingleSweep (optional)
+  bool computeSegmentsInSingleSweep = false;
+  if (argc > argIndex+1)
+  {
+    if (STRCASECMP(argv[argIndex], "-ComputeSegmentsInSingleSweep") == 0)
+    {
+      computeSegmentsInSingleSweep = (vtkVariant(argv[argIndex+1]).ToInt() > 0 ? true : false);
+      std::cout << "Compute segments in single sweep: " << (computeSegmentsInSingleSweep ? "true" : "false") << std::endl;
+      argIndex += 2;
+    }
+  }
+  // SlabStreamingMemoryLimitMB (optional, slab streaming is used if specified)
+  double slabStreamingMemoryLimitMB = 0.0;
+  if (argc > argIndex+1)
+  {
+    if (STRCASECMP(argv[argIndex], "-SlabStreamingMemoryLimitMB") == 0)
+    {
+      slabStreamingMemoryLimitMB = vtkVariant(argv[argIndex+1]).ToDouble();
+      std::cout << "Slab streaming memory limit: " << slabStreamingMemoryLimitMB << " MB" << std::endl;
+      argIndex += 2;
+    }
+  }
 
   // Constraint the criteria to be greater than zero
   if (volumeDifferenceCriterion == 0.0)
@@ -413,6 +435,12 @@ int vtkSlicerDoseVolumeHistogramModuleLogicTest1( int argc, char * argv[] )
     dvhLogic->SetStartValue(dvhStartValue);
     dvhLogic->SetStepSize(dvhStepSize);
   }
+  dvhLogic->SetComputeSegmentsInSingleSweep(computeSegmentsInSingleSweep);
+  if (slabStreamingMemoryLimitMB > 0.0)
+  {
+    dvhLogic->UseSlabStreamingOn();
+    dvhLogic->SetSlabStreamingMemoryLimitMB(slabStreamingMemoryLimitMB);
+  }
 
   // Setup time measurement
   vtkSmartPointer<vtkTimerLog> timer = vtkSmartPointer<vtkTimerLog>::New();
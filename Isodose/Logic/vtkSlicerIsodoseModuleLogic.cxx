@@ -30,6 +30,7 @@
 
 // SlicerRT includes
 #include "SlicerRtCommon.h"
+#include "vtkResampledDoseVolumeCache.h"
 
 // MRML includes
 #include <vtkMRMLScalarVolumeNode.h>
@@ -153,6 +154,9 @@ void vtkSlicerIsodoseModuleLogic::OnMRMLSceneEndClose()
     return;
   }
 
+  // Resampled dose volumes of the closed scene cannot be used any more
+  vtkResampledDoseVolumeCache::GetInstance()->Clear();
+
   this->Modified();
 }
 
@@ -516,14 +520,23 @@ void vtkSlicerIsodoseModuleLogic::CreateIsodoseSurfaces(vtkMRMLIsodoseNode* para
 
   int dimensions[3] = {0, 0, 0};
   doseVolumeNode->GetImageData()->GetDimensions(dimensions);
-  vtkSmartPointer<vtkImageReslice> reslice = vtkSmartPointer<vtkImageReslice>::New();
-  reslice->SetInputData(doseVolumeNode->GetImageData());
-  reslice->SetOutputOrigin(0, 0, 0);
-  reslice->SetOutputSpacing(1, 1, 1);
-  reslice->SetOutputExtent(0, dimensions[0]-1, 0, dimensions[1]-1, 0, dimensions[2]-1);
-  reslice->SetResliceTransform(outputIJK2IJKResliceTransform);
-  reslice->Update();
-  vtkSmartPointer<vtkImageData> reslicedDoseVolumeImage = reslice->GetOutput(); 
+
+  // Reuse resliced dose volume from the shared cache if the dose volume and its transforms have not changed
+  std::string doseVolumeCacheKey = vtkResampledDoseVolumeCache::GetDoseVolumeKey(doseVolumeNode);
+  std::string resliceGeometryKey = "IsodoseReslice";
+  vtkSmartPointer<vtkImageData> reslicedDoseVolumeImage = vtkSmartPointer<vtkImageData>::New();
+  if (!vtkResampledDoseVolumeCache::GetInstance()->GetResampledDoseVolume(doseVolumeCacheKey, resliceGeometryKey, reslicedDoseVolumeImage))
+  {
+    vtkSmartPointer<vtkImageReslice> reslice = vtkSmartPointer<vtkImageReslice>::New();
+    reslice->SetInputData(doseVolumeNode->GetImageData());
+    reslice->SetOutputOrigin(0, 0, 0);
+    reslice->SetOutputSpacing(1, 1, 1);
+    reslice->SetOutputExtent(0, dimensions[0]-1, 0, dimensions[1]-1, 0, dimensions[2]-1);
+    reslice->SetResliceTransform(outputIJK2IJKResliceTransform);
+    reslice->Update();
+    reslicedDoseVolumeImage = reslice->GetOutput();
+    vtkResampledDoseVolumeCache::GetInstance()->AddResampledDoseVolume(doseVolumeCacheKey, resliceGeometryKey, reslicedDoseVolumeImage);
+  }
 
   // Report progress
   ++currentStep;
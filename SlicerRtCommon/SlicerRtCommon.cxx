@@ -57,6 +57,8 @@ const std::string SlicerRtCommon::DISPLAY_NODE_SUFFIX = "_Display";
 
 // Segmentation constants
 const char* SlicerRtCommon::SEGMENTATION_RIBBON_MODEL_REPRESENTATION_NAME = "Ribbon model";
+const char* SlicerRtCommon::SEGMENT_DEFERRED_CONVERSION_TAG_NAME = "DicomRtImport.DeferredConversion";
+const char* SlicerRtCommon::SEGMENT_DICOM_SOURCE_TAG_NAME = "DicomRtImport.DicomSource";
 
 const double SlicerRtCommon::COLOR_VALUE_INVALID[4] = {0.5, 0.5, 0.5, 1.0};
 
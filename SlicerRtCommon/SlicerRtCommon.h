@@ -84,6 +84,12 @@ public:
 
   // Segmentation constants
   static const char* SEGMENTATION_RIBBON_MODEL_REPRESENTATION_NAME;
+  /// Tag of segments the conversion of which has been deferred. The value is the name of the representation the
+  /// segment is converted to when its segmentation is shown. Conversion is deferred for all segments of a segmentation,
+  /// so that a representation is either contained by all segments or by none
+  static const char* SEGMENT_DEFERRED_CONVERSION_TAG_NAME;
+  /// Tag of segments loaded from a structure set. The value is the SOP instance UID of the structure set and the ROI number separated by a slash
+  static const char* SEGMENT_DICOM_SOURCE_TAG_NAME;
 
   static const double COLOR_VALUE_INVALID[4];
 
@@ -0,0 +1,143 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkConcurrentJobPool.h"
+
+// VTK includes
+#include <vtkMultiThreader.h>
+#include <vtkObjectFactory.h>
+#include <vtkSimpleCriticalSection.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkConcurrentJobPool);
+
+//----------------------------------------------------------------------------
+/// Jobs of one \sa vtkConcurrentJobPool::Execute call shared by the worker threads
+class vtkConcurrentJobPoolExecution
+{
+public:
+  vtkConcurrentJobPoolExecution(int numberOfJobs, vtkConcurrentJobPool::JobFunctionType jobFunction, void* userData)
+    : NumberOfJobs(numberOfJobs)
+    , JobFunction(jobFunction)
+    , UserData(userData)
+    , NextJobIndex(0)
+  {
+  }
+
+  /// Take the index of the next job to process
+  /// \return Job index, -1 if all jobs have been taken
+  int TakeNextJob()
+  {
+    this->Lock.Lock();
+    int jobIndex = (this->NextJobIndex < this->NumberOfJobs ? this->NextJobIndex++ : -1);
+    this->Lock.Unlock();
+    return jobIndex;
+  }
+
+public:
+  int NumberOfJobs;
+  vtkConcurrentJobPool::JobFunctionType JobFunction;
+  void* UserData;
+
+protected:
+  int NextJobIndex;
+  vtkSimpleCriticalSection Lock;
+};
+
+//----------------------------------------------------------------------------
+static VTK_THREAD_RETURN_TYPE vtkConcurrentJobPoolWorker(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkConcurrentJobPoolExecution* execution = static_cast<vtkConcurrentJobPoolExecution*>(threadInfo->UserData);
+
+  for (int jobIndex = execution->TakeNextJob(); jobIndex >= 0; jobIndex = execution->TakeNextJob())
+  {
+    execution->JobFunction(jobIndex, threadInfo->ThreadID, execution->UserData);
+  }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+vtkConcurrentJobPool::vtkConcurrentJobPool()
+{
+  this->MaximumNumberOfWorkers = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkConcurrentJobPool::~vtkConcurrentJobPool()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkConcurrentJobPool::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "MaximumNumberOfWorkers: " << this->MaximumNumberOfWorkers << "\n";
+}
+
+//----------------------------------------------------------------------------
+int vtkConcurrentJobPool::GetNumberOfWorkers(int numberOfJobs)
+{
+  int numberOfWorkers = this->MaximumNumberOfWorkers;
+  if (numberOfWorkers <= 0)
+  {
+    numberOfWorkers = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  }
+  // The multi-threader does not start more threads than its limits
+  numberOfWorkers = std::min(numberOfWorkers, VTK_MAX_THREADS);
+  int globalMaximumNumberOfThreads = vtkMultiThreader::GetGlobalMaximumNumberOfThreads();
+  if (globalMaximumNumberOfThreads > 0)
+  {
+    numberOfWorkers = std::min(numberOfWorkers, globalMaximumNumberOfThreads);
+  }
+  return std::max(1, std::min(numberOfWorkers, numberOfJobs));
+}
+
+//----------------------------------------------------------------------------
+void vtkConcurrentJobPool::Execute(int numberOfJobs, JobFunctionType jobFunction, void* userData)
+{
+  if (!jobFunction)
+  {
+    vtkErrorMacro("Execute: Invalid job function!");
+    return;
+  }
+  if (numberOfJobs <= 0)
+  {
+    return;
+  }
+
+  int numberOfWorkers = this->GetNumberOfWorkers(numberOfJobs);
+  if (numberOfWorkers == 1)
+  {
+    // No need for threads, process the jobs in order
+    for (int jobIndex = 0; jobIndex < numberOfJobs; ++jobIndex)
+    {
+      jobFunction(jobIndex, 0, userData);
+    }
+    return;
+  }
+
+  vtkConcurrentJobPoolExecution execution(numberOfJobs, jobFunction, userData);
+  vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+  threader->SetNumberOfThreads(numberOfWorkers);
+  threader->SetSingleMethod(vtkConcurrentJobPoolWorker, &execution);
+  threader->SingleMethodExecute();
+}
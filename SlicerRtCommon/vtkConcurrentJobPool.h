@@ -0,0 +1,73 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkConcurrentJobPool_h
+#define __vtkConcurrentJobPool_h
+
+#include "vtkSlicerRtCommonWin32Header.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+/// \ingroup SlicerRt_SlicerRtCommon
+/// \brief Process independent jobs on a bounded number of worker threads
+///
+/// Each worker takes the next unprocessed job when finished with the previous one, so jobs of different
+/// size are balanced between the workers. The jobs are processed by a function called with the index of the
+/// job and the index of the worker processing it. A worker processes its jobs one after the other, so state
+/// that is not thread safe (such as filters or conversion rules) can be kept per worker, indexed by the worker index.
+/// If only one worker is used, the jobs are processed in order in the calling thread.
+class VTK_SLICERRTCOMMON_EXPORT vtkConcurrentJobPool : public vtkObject
+{
+public:
+  /// Function processing a job
+  /// \param jobIndex Index of the job to process
+  /// \param workerIndex Index of the worker processing the job (0 .. number of workers - 1)
+  /// \param userData Data given to \sa Execute
+  typedef void (*JobFunctionType)(int jobIndex, int workerIndex, void* userData);
+
+public:
+  static vtkConcurrentJobPool *New();
+  vtkTypeMacro(vtkConcurrentJobPool, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Get the number of workers that process a given number of jobs. Per-worker state needs to be allocated for this many workers
+  /// \return Number of workers, between 1 and the number of jobs (1 if there are no jobs)
+  int GetNumberOfWorkers(int numberOfJobs);
+
+  /// Process jobs 0 .. numberOfJobs-1 by calling the job function for each of them from the workers.
+  /// Returns when all jobs are processed
+  void Execute(int numberOfJobs, JobFunctionType jobFunction, void* userData);
+
+public:
+  /// Maximum number of worker threads. If 0 (default), the number of processor cores is used
+  vtkSetMacro(MaximumNumberOfWorkers, int);
+  vtkGetMacro(MaximumNumberOfWorkers, int);
+
+protected:
+  /// Maximum number of worker threads. If 0, the number of processor cores is used
+  int MaximumNumberOfWorkers;
+
+protected:
+  vtkConcurrentJobPool();
+  virtual ~vtkConcurrentJobPool();
+
+private:
+  vtkConcurrentJobPool(const vtkConcurrentJobPool&); // Not implemented
+  void operator=(const vtkConcurrentJobPool&);       // Not implemented
+};
+
+#endif
@@ -26,12 +26,18 @@
 #include <vtkImageStencilIterator.h>
 #include <vtkInformation.h>
 #include <vtkInformationVector.h>
+#include <vtkMath.h>
+#include <vtkSMPTools.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 #include <vtkFieldData.h>
 
 // SlicerRtCommon includes
 #include "SlicerRtCommon.h"
 
+// STD includes
+#include <algorithm>
+#include <vector>
+
 vtkStandardNewMacro(vtkFractionalImageAccumulate);
 
 //----------------------------------------------------------------------------
@@ -39,6 +45,10 @@ vtkFractionalImageAccumulate::vtkFractionalImageAccumulate()
 {
   this->MinimumFractionalValue = 0;
   this->MaximumFractionalValue = 1.0;
+  this->FractionalLabelmap = NULL;
+  this->FractionalVoxelCount = 0.0;
+  this->FractionalVoxelCountBelowRange = 0.0;
+  this->UseFractionalLabelmap = false;
 }
 
 //----------------------------------------------------------------------------
@@ -74,8 +84,26 @@ int vtkFractionalImageAccumulateExecute(vtkFractionalImageAccumulate *self,
                               double standardDeviation[3],
                               vtkIdType *voxelCount,
                               double *fractionalVoxelCount,
+                              double *fractionalVoxelCountBelowRange,
                               int* updateExtent)
 {
+    // Binary case: every voxel in the stencil has the weight of one, fractional scalar type is not used
+    if (!self->GetUseFractionalLabelmap() || !self->GetFractionalLabelmap())
+    {
+      return vtkFractionalImageAccumulateExecute2( self,
+                                                (BaseImageScalarType*) NULL,
+                                                (unsigned char*) NULL,
+                                                inData,
+                                                outData,
+                                                min, max,
+                                                mean,
+                                                standardDeviation,
+                                                voxelCount,
+                                                fractionalVoxelCount,
+                                                fractionalVoxelCountBelowRange,
+                                                updateExtent );
+    }
+
     switch (self->GetFractionalLabelmap()->GetScalarType())
     {
     vtkTemplateMacro( vtkFractionalImageAccumulateExecute2( self,
@@ -88,6 +116,7 @@ int vtkFractionalImageAccumulateExecute(vtkFractionalImageAccumulate *self,
                                                 standardDeviation,
                                                 voxelCount,
                                                 fractionalVoxelCount,
+                                                fractionalVoxelCountBelowRange,
                                                 updateExtent ) );
     default:
       //vtkErrorMacro(<< "Execute: Unknown ScalarType");
@@ -97,6 +126,327 @@ int vtkFractionalImageAccumulateExecute(vtkFractionalImageAccumulate *self,
     return 1;
 }
 
+//----------------------------------------------------------------------------
+// Parameters of the accumulation, queried once before the voxel loops instead of for each voxel
+struct vtkFractionalImageAccumulateParameters
+{
+  int NumberOfComponents;
+  bool UseFractionalLabelmap;
+  bool ReverseStencil;
+  bool IgnoreZero;
+  // Fraction of a voxel is (labelmapValue - MinimumFractionalValue) * FractionalScale
+  double MinimumFractionalValue;
+  double FractionalScale;
+  // Histogram layout
+  int OutExtent[6];
+  vtkIdType OutIncrements[3];
+  double Origin[3];
+  double Spacing[3];
+};
+
+//----------------------------------------------------------------------------
+// Statistics accumulated over (a part of) the input image
+struct vtkFractionalImageAccumulateSums
+{
+  vtkFractionalImageAccumulateSums()
+  {
+    for (int idxC = 0; idxC < 3; ++idxC)
+      {
+      this->Sum[idxC] = 0.0;
+      this->SumSqr[idxC] = 0.0;
+      this->Min[idxC] = VTK_DOUBLE_MAX;
+      this->Max[idxC] = VTK_DOUBLE_MIN;
+      }
+    this->VoxelCount = 0;
+    this->FractionalVoxelCount = 0.0;
+    this->FractionalVoxelCountBelowRange = 0.0;
+  }
+
+  // Add statistics accumulated over another part of the image
+  void Merge(const vtkFractionalImageAccumulateSums& other)
+  {
+    for (int idxC = 0; idxC < 3; ++idxC)
+      {
+      this->Sum[idxC] += other.Sum[idxC];
+      this->SumSqr[idxC] += other.SumSqr[idxC];
+      this->Min[idxC] = std::min(this->Min[idxC], other.Min[idxC]);
+      this->Max[idxC] = std::max(this->Max[idxC], other.Max[idxC]);
+      }
+    this->VoxelCount += other.VoxelCount;
+    this->FractionalVoxelCount += other.FractionalVoxelCount;
+    this->FractionalVoxelCountBelowRange += other.FractionalVoxelCountBelowRange;
+  }
+
+  double Sum[3];
+  double SumSqr[3];
+  double Min[3];
+  double Max[3];
+  vtkIdType VoxelCount;
+  double FractionalVoxelCount;
+  double FractionalVoxelCountBelowRange;
+};
+
+//----------------------------------------------------------------------------
+// Accumulate a span of a single component image. This is the common case (e.g. DVH computation on a dose volume),
+// so it avoids the per-component bookkeeping of the general case.
+// If fractionalPtr is NULL then all voxels have the weight of one.
+template <class BaseImageScalarType, class FractionalImageScalarType>
+inline void vtkFractionalImageAccumulateSingleComponentSpan(const BaseImageScalarType* inPtr,
+                                                           const BaseImageScalarType* spanEndPtr,
+                                                           const FractionalImageScalarType* fractionalPtr,
+                                                           const vtkFractionalImageAccumulateParameters& params,
+                                                           vtkFractionalImageAccumulateSums& sums,
+                                                           double* histogram)
+{
+  // Local copies so that the compiler can keep them in registers
+  const bool ignoreZero = params.IgnoreZero;
+  const double origin = params.Origin[0];
+  const double spacing = params.Spacing[0];
+  const int binMin = params.OutExtent[0];
+  const int binMax = params.OutExtent[1];
+  double sum = 0.0;
+  double sumSqr = 0.0;
+  double min = sums.Min[0];
+  double max = sums.Max[0];
+  vtkIdType voxelCount = 0;
+  double fractionalVoxelCount = 0.0;
+  double belowRange = 0.0;
+
+  if (fractionalPtr)
+    {
+    const double minimumFractionalValue = params.MinimumFractionalValue;
+    const double fractionalScale = params.FractionalScale;
+    for (; inPtr != spanEndPtr; ++inPtr, ++fractionalPtr)
+      {
+      double v = static_cast<double>(*inPtr);
+      if (ignoreZero && v == 0)
+        {
+        continue;
+        }
+      double f = (static_cast<double>(*fractionalPtr) - minimumFractionalValue) * fractionalScale;
+      sum += v*f;
+      sumSqr += v*v*f*f;
+      max = (v > max ? v : max);
+      min = (v < min ? v : min);
+      ++voxelCount;
+      fractionalVoxelCount += f;
+
+      int binIndex = vtkMath::Floor((v - origin) / spacing);
+      if (binIndex < binMin)
+        {
+        belowRange += f;
+        }
+      else if (binIndex <= binMax)
+        {
+        histogram[binIndex - binMin] += f;
+        }
+      }
+    }
+  else
+    {
+    for (; inPtr != spanEndPtr; ++inPtr)
+      {
+      double v = static_cast<double>(*inPtr);
+      if (ignoreZero && v == 0)
+        {
+        continue;
+        }
+      sum += v;
+      sumSqr += v*v;
+      max = (v > max ? v : max);
+      min = (v < min ? v : min);
+      ++voxelCount;
+
+      int binIndex = vtkMath::Floor((v - origin) / spacing);
+      if (binIndex < binMin)
+        {
+        belowRange += 1.0;
+        }
+      else if (binIndex <= binMax)
+        {
+        histogram[binIndex - binMin] += 1.0;
+        }
+      }
+    fractionalVoxelCount = static_cast<double>(voxelCount);
+    }
+
+  sums.Sum[0] += sum;
+  sums.SumSqr[0] += sumSqr;
+  sums.Min[0] = min;
+  sums.Max[0] = max;
+  sums.VoxelCount += voxelCount;
+  sums.FractionalVoxelCount += fractionalVoxelCount;
+  sums.FractionalVoxelCountBelowRange += belowRange;
+}
+
+//----------------------------------------------------------------------------
+// Accumulate a span of an image with any number of components (up to three)
+template <class BaseImageScalarType, class FractionalImageScalarType>
+inline void vtkFractionalImageAccumulateMultiComponentSpan(const BaseImageScalarType* inPtr,
+                                                          const BaseImageScalarType* spanEndPtr,
+                                                          const FractionalImageScalarType* fractionalPtr,
+                                                          const vtkFractionalImageAccumulateParameters& params,
+                                                          vtkFractionalImageAccumulateSums& sums,
+                                                          double* histogram)
+{
+  int numC = params.NumberOfComponents;
+  while (inPtr != spanEndPtr)
+    {
+    // find the bin for this pixel.
+    bool outOfBounds = false;
+    double *outPtrC = histogram;
+    double total  = 0.0;
+
+    for (int idxC = 0; idxC < numC; ++idxC)
+      {
+
+      double v = static_cast<double>(*inPtr++);
+      double f = 1.0;
+
+      if (fractionalPtr)
+      {
+        f = ( static_cast<double>(*fractionalPtr++) - params.MinimumFractionalValue ) * params.FractionalScale;
+      }
+
+      if (!params.IgnoreZero || v != 0)
+        {
+        // gather statistics
+        sums.Sum[idxC] += v*f;
+        sums.SumSqr[idxC] += v*v*f*f;
+        if (v > sums.Max[idxC])
+          {
+          sums.Max[idxC] = v;
+          }
+        if (v < sums.Min[idxC])
+          {
+          sums.Min[idxC] = v;
+          }
+        sums.VoxelCount++;
+        sums.FractionalVoxelCount+=f;
+        total+=f;
+        }
+
+      // compute the index
+      int outIdx = vtkMath::Floor((v - params.Origin[idxC]) / params.Spacing[idxC]);
+
+      // count voxels below the histogram range (used for cumulative histograms, so that no second pass is needed)
+      if (idxC == 0 && outIdx < params.OutExtent[0] && (!params.IgnoreZero || v != 0))
+        {
+        sums.FractionalVoxelCountBelowRange += f;
+        }
+
+      // verify that it is in range
+      if (outIdx >= params.OutExtent[idxC*2] && outIdx <= params.OutExtent[idxC*2+1])
+        {
+        outPtrC += (outIdx - params.OutExtent[idxC*2]) * params.OutIncrements[idxC];
+        }
+      else
+        {
+          outOfBounds = true;
+        }
+
+      }
+
+    // increment the bin
+    if (!outOfBounds)
+      {
+        (*outPtrC) += total;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Accumulate the statistics and the histogram of the input image within the given extent
+template <class BaseImageScalarType, class FractionalImageScalarType>
+void vtkFractionalImageAccumulateExtent(vtkImageData *inData,
+                                        vtkImageData *fractionalLabelmap,
+                                        vtkImageStencilData *stencil,
+                                        int* extent,
+                                        vtkAlgorithm *progressAlgorithm,
+                                        const vtkFractionalImageAccumulateParameters& params,
+                                        vtkFractionalImageAccumulateSums& sums,
+                                        double *histogram)
+{
+  vtkImageStencilIterator<BaseImageScalarType> inIter(inData, stencil, extent, progressAlgorithm);
+
+  // Fractional labelmap is iterated together with the input image if used, otherwise all voxels have the weight of one
+  vtkImageStencilIterator<FractionalImageScalarType>* fractionalIter = NULL;
+  if (params.UseFractionalLabelmap)
+    {
+    fractionalIter = new vtkImageStencilIterator<FractionalImageScalarType>(fractionalLabelmap, stencil, extent, NULL);
+    }
+
+  while (!inIter.IsAtEnd())
+    {
+    if (inIter.IsInStencil() ^ params.ReverseStencil)
+      {
+      BaseImageScalarType *inPtr = inIter.BeginSpan();
+      BaseImageScalarType *spanEndPtr = inIter.EndSpan();
+      FractionalImageScalarType* fractionalPtr = (fractionalIter ? (FractionalImageScalarType*)fractionalIter->BeginSpan() : NULL);
+
+      if (params.NumberOfComponents == 1)
+        {
+        vtkFractionalImageAccumulateSingleComponentSpan(inPtr, spanEndPtr, fractionalPtr, params, sums, histogram);
+        }
+      else
+        {
+        vtkFractionalImageAccumulateMultiComponentSpan(inPtr, spanEndPtr, fractionalPtr, params, sums, histogram);
+        }
+      }
+    if (fractionalIter)
+      {
+      fractionalIter->NextSpan();
+      }
+    inIter.NextSpan();
+    }
+  delete fractionalIter;
+}
+
+//----------------------------------------------------------------------------
+// Functor accumulating separate chunks of the update extent with vtkSMPTools.
+// Each chunk has its own statistics and histogram, which are reduced in chunk order after all chunks are processed,
+// so the result does not depend on the number of threads or the order in which the chunks are executed.
+template <class BaseImageScalarType, class FractionalImageScalarType>
+class vtkFractionalImageAccumulateFunctor
+{
+public:
+  vtkImageData* InData;
+  vtkImageData* FractionalLabelmap;
+  vtkImageStencilData* Stencil;
+  const vtkFractionalImageAccumulateParameters* Parameters;
+  int* UpdateExtent;
+  // Axis along which the update extent is split into chunks (1: Y, 2: Z)
+  int SplitAxis;
+  int NumberOfChunks;
+  vtkIdType HistogramSize;
+  std::vector<vtkFractionalImageAccumulateSums>* ChunkSums;
+  std::vector< std::vector<double> >* ChunkHistograms;
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    int axisMin = this->UpdateExtent[this->SplitAxis*2];
+    int axisSize = this->UpdateExtent[this->SplitAxis*2+1] - axisMin + 1;
+    for (vtkIdType chunkIndex = begin; chunkIndex < end; ++chunkIndex)
+    {
+      int chunkExtent[6] = {0,-1,0,-1,0,-1};
+      for (int i = 0; i < 6; ++i)
+      {
+        chunkExtent[i] = this->UpdateExtent[i];
+      }
+      chunkExtent[this->SplitAxis*2] = axisMin + (int)(axisSize * chunkIndex / this->NumberOfChunks);
+      chunkExtent[this->SplitAxis*2+1] = axisMin + (int)(axisSize * (chunkIndex+1) / this->NumberOfChunks) - 1;
+
+      std::vector<double>& histogram = (*this->ChunkHistograms)[chunkIndex];
+      histogram.assign(this->HistogramSize, 0.0);
+
+      // Progress is not reported from the worker threads
+      vtkFractionalImageAccumulateExtent<BaseImageScalarType, FractionalImageScalarType>(
+        this->InData, this->FractionalLabelmap, this->Stencil, chunkExtent, NULL,
+        *this->Parameters, (*this->ChunkSums)[chunkIndex], &histogram[0]);
+    }
+  }
+};
+
 //----------------------------------------------------------------------------
 // This templated function executes the filter for any type of data.
 template <class BaseImageScalarType, class FractionalImageScalarType>
@@ -110,18 +460,15 @@ int vtkFractionalImageAccumulateExecute2(vtkFractionalImageAccumulate *self,
                               double standardDeviation[3],
                               vtkIdType *voxelCount,
                               double *fractionalVoxelCount,
+                              double *fractionalVoxelCountBelowRange,
                               int* updateExtent)
 {
-  // variables used to compute statistics (filter handles max 3 components)
-  double sum[3];
-  sum[0] = sum[1] = sum[2] = 0.0;
-  double sumSqr[3];
-  sumSqr[0] = sumSqr[1] = sumSqr[2] = 0.0;
   min[0] = min[1] = min[2] = VTK_DOUBLE_MAX;
   max[0] = max[1] = max[2] = VTK_DOUBLE_MIN;
   standardDeviation[0] = standardDeviation[1] = standardDeviation[2] = 0.0;
   *voxelCount = 0;
   *fractionalVoxelCount = 0;
+  *fractionalVoxelCountBelowRange = 0;
   double *outPtr = static_cast<double *>(outData->GetScalarPointer());
   if (!outPtr)
     {
@@ -129,111 +476,84 @@ int vtkFractionalImageAccumulateExecute2(vtkFractionalImageAccumulate *self,
     }
 
   // input's number of components is used as output dimensionality
-  int numC = inData->GetNumberOfScalarComponents();
-  if (numC > 3)
+  vtkFractionalImageAccumulateParameters params;
+  params.NumberOfComponents = inData->GetNumberOfScalarComponents();
+  if (params.NumberOfComponents > 3)
     {
     return 0;
     }
 
   // get information for output data
-  int outExtent[6];
-  outData->GetExtent(outExtent);
-  vtkIdType outIncs[3];
-  outData->GetIncrements(outIncs);
-  double origin[3];
-  outData->GetOrigin(origin);
-  double spacing[3];
-  outData->GetSpacing(spacing);
+  outData->GetExtent(params.OutExtent);
+  outData->GetIncrements(params.OutIncrements);
+  outData->GetOrigin(params.Origin);
+  outData->GetSpacing(params.Spacing);
 
   // zero count in every bin
   vtkIdType size = 1;
-  size *= (outExtent[1] - outExtent[0] + 1);
-  size *= (outExtent[3] - outExtent[2] + 1);
-  size *= (outExtent[5] - outExtent[4] + 1);
+  size *= (params.OutExtent[1] - params.OutExtent[0] + 1);
+  size *= (params.OutExtent[3] - params.OutExtent[2] + 1);
+  size *= (params.OutExtent[5] - params.OutExtent[4] + 1);
   for (vtkIdType j = 0; j < size; j++)
     {
     outPtr[j] = 0;
     }
 
-  vtkImageStencilData *stencil = self->GetStencil();
-  bool reverseStencil = (self->GetReverseStencil() != 0);
-  bool ignoreZero = (self->GetIgnoreZero() != 0);
-
-  vtkImageStencilIterator<BaseImageScalarType> inIter(inData, stencil, updateExtent, self);
-
   vtkImageData* fractionalLabelmap = self->GetFractionalLabelmap();
-  vtkImageStencilIterator<FractionalImageScalarType> fractionalIter(fractionalLabelmap, stencil, updateExtent, self);
-
-  while (!inIter.IsAtEnd())
+  params.UseFractionalLabelmap = (self->GetUseFractionalLabelmap() && fractionalLabelmap != NULL);
+  params.ReverseStencil = (self->GetReverseStencil() != 0);
+  params.IgnoreZero = (self->GetIgnoreZero() != 0);
+  params.MinimumFractionalValue = self->GetMinimumFractionalValue();
+  params.FractionalScale = 1.0 / (self->GetMaximumFractionalValue() - self->GetMinimumFractionalValue());
+
+  // Split the update extent into a fixed number of chunks along the slowest varying axis that has more than one slice.
+  // The number of chunks does not depend on the number of threads so that the reduced result is reproducible.
+  // It is limited so that the private histograms of the chunks do not take excessive memory.
+  int splitAxis = (updateExtent[5] > updateExtent[4] ? 2 : 1);
+  int axisSize = updateExtent[splitAxis*2+1] - updateExtent[splitAxis*2] + 1;
+  const int maximumNumberOfChunks = 32;
+  const vtkIdType maximumNumberOfChunkHistogramBins = 16*1024*1024;
+  vtkIdType numberOfChunksForHistogramMemory = std::max((vtkIdType)1, maximumNumberOfChunkHistogramBins / size);
+  int numberOfChunks = (int)std::min((vtkIdType)std::min(axisSize, maximumNumberOfChunks), numberOfChunksForHistogramMemory);
+  numberOfChunks = std::max(1, numberOfChunks);
+
+  std::vector<vtkFractionalImageAccumulateSums> chunkSums(numberOfChunks);
+  std::vector< std::vector<double> > chunkHistograms(numberOfChunks);
+
+  vtkFractionalImageAccumulateFunctor<BaseImageScalarType, FractionalImageScalarType> functor;
+  functor.InData = inData;
+  functor.FractionalLabelmap = fractionalLabelmap;
+  functor.Stencil = self->GetStencil();
+  functor.Parameters = &params;
+  functor.UpdateExtent = updateExtent;
+  functor.SplitAxis = splitAxis;
+  functor.NumberOfChunks = numberOfChunks;
+  functor.HistogramSize = size;
+  functor.ChunkSums = &chunkSums;
+  functor.ChunkHistograms = &chunkHistograms;
+  vtkSMPTools::For(0, numberOfChunks, 1, functor);
+
+  // Reduce the results of the chunks in chunk order
+  vtkFractionalImageAccumulateSums sums;
+  for (int chunkIndex = 0; chunkIndex < numberOfChunks; ++chunkIndex)
     {
-    if (inIter.IsInStencil() ^ reverseStencil)
+    sums.Merge(chunkSums[chunkIndex]);
+    const double* chunkHistogram = &(chunkHistograms[chunkIndex][0]);
+    for (vtkIdType j = 0; j < size; j++)
       {
-      BaseImageScalarType *inPtr = inIter.BeginSpan();
-      BaseImageScalarType *spanEndPtr = inIter.EndSpan();
-
-      FractionalImageScalarType* fractionalPtr = (FractionalImageScalarType*)fractionalIter.BeginSpan();
-
-      while (inPtr != spanEndPtr)
-        {
-        // find the bin for this pixel.
-        bool outOfBounds = false;
-        double *outPtrC = outPtr;
-        double total  = 0.0;
-
-        for (int idxC = 0; idxC < numC; ++idxC)
-          {
-
-          double v = static_cast<double>(*inPtr++);
-          double f = 1.0;
-
-          if (self->GetUseFractionalLabelmap())
-          {
-            f = ( (*fractionalPtr++) - self->GetMinimumFractionalValue() ) / (self->GetMaximumFractionalValue() - self->GetMinimumFractionalValue());
-          }
-
-          if (!ignoreZero || v != 0)
-            {
-            // gather statistics
-            sum[idxC] += v*f;
-            sumSqr[idxC] += v*v*f*f;
-            if (v > max[idxC])
-              {
-              max[idxC] = v;
-              }
-            if (v < min[idxC])
-              {
-              min[idxC] = v;
-              }
-            (*voxelCount)++;
-            (*fractionalVoxelCount)+=f;
-            total+=f;
-            }
-
-          // compute the index
-          int outIdx = vtkMath::Floor((v - origin[idxC]) / spacing[idxC]);
-
-          // verify that it is in range
-          if (outIdx >= outExtent[idxC*2] && outIdx <= outExtent[idxC*2+1])
-            {
-            outPtrC += (outIdx - outExtent[idxC*2]) * outIncs[idxC];
-            }
-          else
-            {
-              outOfBounds = true;
-            }
-
-          }
-
-        // increment the bin
-        if (!outOfBounds)
-          {
-            (*outPtrC) += total;
-          }
-        }
+      outPtr[j] += chunkHistogram[j];
       }
-    fractionalIter.NextSpan();
-    inIter.NextSpan();
     }
+  self->UpdateProgress(1.0);
+
+  for (int idxC = 0; idxC < 3; ++idxC)
+    {
+    min[idxC] = sums.Min[idxC];
+    max[idxC] = sums.Max[idxC];
+    }
+  *voxelCount = sums.VoxelCount;
+  *fractionalVoxelCount = sums.FractionalVoxelCount;
+  *fractionalVoxelCountBelowRange = sums.FractionalVoxelCountBelowRange;
 
   // initialize the statistics
   mean[0] = 0;
@@ -247,16 +567,16 @@ int vtkFractionalImageAccumulateExecute2(vtkFractionalImageAccumulate *self,
   if (*fractionalVoxelCount != 0) // avoid the div0
     {
     double n = static_cast<double>(*fractionalVoxelCount);
-    mean[0] = sum[0]/n;
-    mean[1] = sum[1]/n;
-    mean[2] = sum[2]/n;
+    mean[0] = sums.Sum[0]/n;
+    mean[1] = sums.Sum[1]/n;
+    mean[2] = sums.Sum[2]/n;
 
     if (*fractionalVoxelCount - 1 != 0) // avoid the div0
       {
       double m = static_cast<double>(*fractionalVoxelCount - 1);
-      standardDeviation[0] = sqrt((sumSqr[0] - mean[0]*mean[0]*n)/m);
-      standardDeviation[1] = sqrt((sumSqr[1] - mean[1]*mean[1]*n)/m);
-      standardDeviation[2] = sqrt((sumSqr[2] - mean[2]*mean[2]*n)/m);
+      standardDeviation[0] = sqrt((sums.SumSqr[0] - mean[0]*mean[0]*n)/m);
+      standardDeviation[1] = sqrt((sums.SumSqr[1] - mean[1]*mean[1]*n)/m);
+      standardDeviation[2] = sqrt((sums.SumSqr[2] - mean[2]*mean[2]*n)/m);
       }
     }
 
@@ -317,6 +637,7 @@ int vtkFractionalImageAccumulate::RequestData(
                                                 this->StandardDeviation,
                                                 &this->VoxelCount,
                                                 &this->FractionalVoxelCount,
+                                                &this->FractionalVoxelCountBelowRange,
                                                 uExt ));
     default:
       vtkErrorMacro(<< "Execute: Unknown ScalarType");
@@ -41,6 +41,9 @@ public:
     vtkSetMacro(FractionalLabelmap, vtkImageData*);
     vtkGetMacro(FractionalLabelmap, vtkImageData*);
     vtkGetMacro(FractionalVoxelCount, double);
+    /// Get the (fractional) number of voxels with a value below the histogram range (first bin) of the first component.
+    /// Allows computing cumulative histograms without a second pass over the input.
+    vtkGetMacro(FractionalVoxelCountBelowRange, double);
     vtkSetMacro(UseFractionalLabelmap, bool);
     vtkGetMacro(UseFractionalLabelmap, bool);
     vtkBooleanMacro(UseFractionalLabelmap, bool);
@@ -63,6 +66,7 @@ protected:
   double MaximumFractionalValue;
   vtkImageData* FractionalLabelmap;
   double FractionalVoxelCount;
+  double FractionalVoxelCountBelowRange;
   bool UseFractionalLabelmap;
 
 private:
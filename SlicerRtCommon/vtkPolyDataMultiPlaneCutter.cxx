@@ -0,0 +1,565 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkPolyDataMultiPlaneCutter.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkMath.h>
+#include <vtkObjectFactory.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTriangleFilter.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkPolyDataMultiPlaneCutter);
+vtkCxxSetObjectMacro(vtkPolyDataMultiPlaneCutter, InputPolyData, vtkPolyData);
+
+//----------------------------------------------------------------------------
+class vtkPolyDataMultiPlaneCutter::vtkInternal
+{
+public:
+  /// Crossing of a surface edge by the current plane, identified by the (ordered) point IDs of the edge
+  struct EdgeCrossing
+  {
+    vtkIdType EdgePointId0;
+    vtkIdType EdgePointId1;
+    /// Index of the intersection segment end (segment index * 2 + end index)
+    vtkIdType SegmentEnd;
+
+    bool operator<(const EdgeCrossing& other) const
+    {
+      if (this->EdgePointId0 != other.EdgePointId0)
+      {
+        return this->EdgePointId0 < other.EdgePointId0;
+      }
+      return this->EdgePointId1 < other.EdgePointId1;
+    }
+    bool IsSameEdge(const EdgeCrossing& other) const
+    {
+      return this->EdgePointId0 == other.EdgePointId0 && this->EdgePointId1 == other.EdgePointId1;
+    }
+  };
+
+  /// Cut the given triangles with a plane and join the intersection segments into contours
+  /// \param planeIndex Index of the plane. The plane is where the point positions equal the plane index
+  /// \param activeTriangles Indices of the triangles intersecting the plane
+  /// \return Contours on the plane, NULL if there are none
+  vtkSmartPointer<vtkPolyData> CutPlane(int planeIndex, const std::vector<vtkIdType>& activeTriangles);
+
+  /// Remove the contour points that are not needed to keep the contour within \sa ContourTolerance.
+  /// Each output segment is extended greedily from its start point while the skipped points stay within the tolerance.
+  /// The directions from the start point that keep the skipped points within tolerance form an angular sector narrowed
+  /// by each skipped point, so checking a new end point takes constant time, and each point is visited at most twice.
+  /// \param contourPoints Points of the contours on the plane
+  /// \param contourPointIds Point IDs of the contour, replaced by the IDs of the kept points
+  /// \param closed Flag indicating whether the contour is a closed loop (its first point is not repeated at the end)
+  /// \return Largest distance of a removed point from the reduced contour
+  double ReduceContour(vtkPoints* contourPoints, std::vector<vtkIdType>& contourPointIds, bool closed);
+
+public:
+  /// Points of the triangulated surface
+  vtkPoints* SurfacePoints;
+  /// Point IDs of the triangles, three for each triangle
+  std::vector<vtkIdType> TrianglePointIds;
+  /// Position of the surface points along the normal, in units of plane spacing from the first plane
+  std::vector<double> PointPositions;
+  /// Contours on each plane
+  std::vector<vtkSmartPointer<vtkPolyData> > PlaneContours;
+
+  /// Tolerance of the contour reduction, not reduced if not positive
+  double ContourTolerance;
+  /// Orthonormal axes of the planes used for computing in-plane distances in the contour reduction
+  double PlaneAxis0[3];
+  double PlaneAxis1[3];
+  /// Largest distance of a removed contour point from its contour
+  double MaximumContourDeviation;
+  /// Number of crossings of the planes with edges shared by more than two triangles
+  int NumberOfNonManifoldEdges;
+  /// Number of contours that are open chains
+  int NumberOfOpenContours;
+};
+
+//----------------------------------------------------------------------------
+/// Distance of a 2D point from a line segment
+static double vtkDistanceToSegment2D(const double* point, const double* segmentStart, const double* segmentEnd)
+{
+  double segment[2] = { segmentEnd[0] - segmentStart[0], segmentEnd[1] - segmentStart[1] };
+  double vector[2] = { point[0] - segmentStart[0], point[1] - segmentStart[1] };
+  double segmentLengthSquared = segment[0]*segment[0] + segment[1]*segment[1];
+  double t = 0.0;
+  if (segmentLengthSquared > 0.0)
+  {
+    t = std::max(0.0, std::min(1.0, (vector[0]*segment[0] + vector[1]*segment[1]) / segmentLengthSquared));
+  }
+  return sqrt( (vector[0] - t*segment[0]) * (vector[0] - t*segment[0]) + (vector[1] - t*segment[1]) * (vector[1] - t*segment[1]) );
+}
+
+//----------------------------------------------------------------------------
+double vtkPolyDataMultiPlaneCutter::vtkInternal::ReduceContour(vtkPoints* contourPoints, std::vector<vtkIdType>& contourPointIds, bool closed)
+{
+  // In-plane coordinates of the contour points. A closed contour is processed as a chain returning to its first point
+  size_t numberOfContourPoints = contourPointIds.size();
+  size_t numberOfChainPoints = numberOfContourPoints + (closed ? 1 : 0);
+  std::vector<double> coordinates(2 * numberOfChainPoints, 0.0);
+  for (size_t index = 0; index < numberOfChainPoints; ++index)
+  {
+    double point[3] = {0.0, 0.0, 0.0};
+    contourPoints->GetPoint(contourPointIds[index % numberOfContourPoints], point);
+    coordinates[2*index] = vtkMath::Dot(point, this->PlaneAxis0);
+    coordinates[2*index+1] = vtkMath::Dot(point, this->PlaneAxis1);
+  }
+
+  // A skipped point farther than the tolerance from the start point is within tolerance of the segment if the segment
+  // direction is within asin(tolerance/distance) of the direction of the point, and the segment is not shorter than the
+  // distance of the point. The angles are measured from the direction of the first such point
+  const double tolerance = this->ContourTolerance;
+  std::vector<size_t> keptIndices(1, 0);
+  size_t lastIndex = numberOfChainPoints - 1;
+  size_t startIndex = 0;
+  while (startIndex < lastIndex)
+  {
+    const double* start = &(coordinates[2*startIndex]);
+    double referenceDirection[2] = {0.0, 0.0};
+    bool sectorBounded = false;
+    double minimumAngle = -vtkMath::Pi();
+    double maximumAngle = vtkMath::Pi();
+    double maximumDistance = 0.0;
+    size_t endIndex = startIndex + 1;
+    for (size_t index = startIndex + 1; index <= lastIndex; ++index)
+    {
+      double vector[2] = { coordinates[2*index] - start[0], coordinates[2*index+1] - start[1] };
+      double distance = sqrt(vector[0]*vector[0] + vector[1]*vector[1]);
+      double angle = 0.0;
+      if (sectorBounded && distance > 0.0)
+      {
+        angle = atan2( referenceDirection[0]*vector[1] - referenceDirection[1]*vector[0],
+                       referenceDirection[0]*vector[0] + referenceDirection[1]*vector[1] );
+      }
+      if ( distance < maximumDistance
+        || (sectorBounded && (distance <= 0.0 || angle < minimumAngle || angle > maximumAngle)) )
+      {
+        break; // The point cannot be the end of the segment, so the previous one is
+      }
+      endIndex = index;
+
+      // Narrow the sector by the point, as it is skipped if the segment is extended further
+      if (distance > tolerance)
+      {
+        if (!sectorBounded)
+        {
+          referenceDirection[0] = vector[0] / distance;
+          referenceDirection[1] = vector[1] / distance;
+          sectorBounded = true;
+        }
+        double halfWidth = asin(tolerance / distance);
+        minimumAngle = std::max(minimumAngle, angle - halfWidth);
+        maximumAngle = std::min(maximumAngle, angle + halfWidth);
+        maximumDistance = distance;
+        if (minimumAngle > maximumAngle)
+        {
+          break;
+        }
+      }
+    }
+    keptIndices.push_back(endIndex);
+    startIndex = endIndex;
+  }
+
+  // Closed contours need at least three points after dropping the repeated first point
+  size_t numberOfKeptPoints = keptIndices.size() - (closed ? 1 : 0);
+  if (numberOfKeptPoints < 3 || numberOfKeptPoints == numberOfContourPoints)
+  {
+    return 0.0;
+  }
+
+  // Measure the actual deviation of the removed points
+  double maximumDeviation = 0.0;
+  for (size_t keptIndex = 1; keptIndex < keptIndices.size(); ++keptIndex)
+  {
+    const double* segmentStart = &(coordinates[2*keptIndices[keptIndex-1]]);
+    const double* segmentEnd = &(coordinates[2*keptIndices[keptIndex]]);
+    for (size_t index = keptIndices[keptIndex-1] + 1; index < keptIndices[keptIndex]; ++index)
+    {
+      maximumDeviation = std::max(maximumDeviation, vtkDistanceToSegment2D(&(coordinates[2*index]), segmentStart, segmentEnd));
+    }
+  }
+
+  std::vector<vtkIdType> keptPointIds(numberOfKeptPoints);
+  for (size_t keptIndex = 0; keptIndex < numberOfKeptPoints; ++keptIndex)
+  {
+    keptPointIds[keptIndex] = contourPointIds[keptIndices[keptIndex]];
+  }
+  contourPointIds.swap(keptPointIds);
+  return maximumDeviation;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> vtkPolyDataMultiPlaneCutter::vtkInternal::CutPlane(int planeIndex, const std::vector<vtkIdType>& activeTriangles)
+{
+  // Find the two crossed edges of each triangle. A point is considered above the plane if its position is not less
+  // than that of the plane, so that neighboring triangles always agree on which of their shared edges are crossed
+  std::vector<EdgeCrossing> crossings;
+  crossings.reserve(2 * activeTriangles.size());
+  for (std::vector<vtkIdType>::const_iterator triangleIt = activeTriangles.begin(); triangleIt != activeTriangles.end(); ++triangleIt)
+  {
+    const vtkIdType* pointIds = &(this->TrianglePointIds[3 * (*triangleIt)]);
+    vtkIdType segmentIndex = (vtkIdType)crossings.size() / 2;
+    int segmentEnd = 0;
+    for (int edgeIndex = 0; edgeIndex < 3; ++edgeIndex)
+    {
+      vtkIdType pointId0 = pointIds[edgeIndex];
+      vtkIdType pointId1 = pointIds[(edgeIndex + 1) % 3];
+      bool above0 = (this->PointPositions[pointId0] >= planeIndex);
+      bool above1 = (this->PointPositions[pointId1] >= planeIndex);
+      if (above0 != above1 && segmentEnd < 2)
+      {
+        EdgeCrossing crossing;
+        crossing.EdgePointId0 = std::min(pointId0, pointId1);
+        crossing.EdgePointId1 = std::max(pointId0, pointId1);
+        crossing.SegmentEnd = 2 * segmentIndex + segmentEnd;
+        crossings.push_back(crossing);
+        ++segmentEnd;
+      }
+    }
+  }
+  vtkIdType numberOfSegments = (vtkIdType)crossings.size() / 2;
+  if (numberOfSegments == 0)
+  {
+    return NULL;
+  }
+
+  // Create a contour point for each crossed edge, shared by the segments of the two triangles of the edge.
+  // If more than two triangles share the edge (non-manifold surface), the additional segments are joined in pairs
+  // on copies of the point, so that no segment is lost
+  std::vector<vtkIdType> segmentEndPointIds(crossings.size(), -1);
+  std::vector<vtkIdType> pointSegments; // Two segment slots for each contour point
+  vtkSmartPointer<vtkPoints> contourPoints = vtkSmartPointer<vtkPoints>::New();
+  contourPoints->SetDataTypeToDouble();
+  std::vector<EdgeCrossing> sortedCrossings(crossings);
+  std::sort(sortedCrossings.begin(), sortedCrossings.end());
+  vtkIdType edgePointId = -1; // First contour point of the current edge
+  for (std::vector<EdgeCrossing>::iterator crossingIt = sortedCrossings.begin(); crossingIt != sortedCrossings.end(); ++crossingIt)
+  {
+    if (crossingIt == sortedCrossings.begin() || !crossingIt->IsSameEdge(*(crossingIt - 1)))
+    {
+      // Interpolate the intersection point on the edge
+      double point0[3] = {0.0, 0.0, 0.0};
+      double point1[3] = {0.0, 0.0, 0.0};
+      this->SurfacePoints->GetPoint(crossingIt->EdgePointId0, point0);
+      this->SurfacePoints->GetPoint(crossingIt->EdgePointId1, point1);
+      double distance0 = this->PointPositions[crossingIt->EdgePointId0] - planeIndex;
+      double distance1 = this->PointPositions[crossingIt->EdgePointId1] - planeIndex;
+      double t = distance0 / (distance0 - distance1);
+      contourPoints->InsertNextPoint( point0[0] + t * (point1[0] - point0[0]),
+                                      point0[1] + t * (point1[1] - point0[1]),
+                                      point0[2] + t * (point1[2] - point0[2]) );
+      pointSegments.push_back(-1);
+      pointSegments.push_back(-1);
+      edgePointId = contourPoints->GetNumberOfPoints() - 1;
+    }
+    else if (pointSegments[2 * (contourPoints->GetNumberOfPoints() - 1) + 1] >= 0)
+    {
+      // Third or further triangle of the edge
+      if (contourPoints->GetNumberOfPoints() - 1 == edgePointId)
+      {
+        ++this->NumberOfNonManifoldEdges;
+      }
+      double point[3] = {0.0, 0.0, 0.0};
+      contourPoints->GetPoint(edgePointId, point);
+      contourPoints->InsertNextPoint(point);
+      pointSegments.push_back(-1);
+      pointSegments.push_back(-1);
+    }
+    vtkIdType contourPointId = contourPoints->GetNumberOfPoints() - 1;
+    vtkIdType segmentIndex = crossingIt->SegmentEnd / 2;
+    segmentEndPointIds[crossingIt->SegmentEnd] = contourPointId;
+    if (pointSegments[2 * contourPointId] < 0)
+    {
+      pointSegments[2 * contourPointId] = segmentIndex;
+    }
+    else
+    {
+      pointSegments[2 * contourPointId + 1] = segmentIndex;
+    }
+  }
+
+  // Join the segments into contours. Open chains (at the boundary of an open surface) are traced first from their
+  // end points, so that they are not split, then the remaining segments form closed loops
+  vtkSmartPointer<vtkCellArray> contourCells = vtkSmartPointer<vtkCellArray>::New();
+  std::vector<char> segmentVisited(numberOfSegments, 0);
+  std::vector<vtkIdType> contourPointIds;
+  vtkIdType numberOfContourPoints = contourPoints->GetNumberOfPoints();
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    for (vtkIdType startPointId = 0; startPointId < numberOfContourPoints; ++startPointId)
+    {
+      bool chainEnd = (pointSegments[2 * startPointId + 1] < 0);
+      if ((pass == 0) != chainEnd)
+      {
+        continue;
+      }
+      vtkIdType pointId = startPointId;
+      contourPointIds.clear();
+      while (true)
+      {
+        vtkIdType segmentIndex = pointSegments[2 * pointId];
+        if (segmentIndex < 0 || segmentVisited[segmentIndex])
+        {
+          segmentIndex = pointSegments[2 * pointId + 1];
+        }
+        if (segmentIndex < 0 || segmentVisited[segmentIndex])
+        {
+          break;
+        }
+        segmentVisited[segmentIndex] = 1;
+        contourPointIds.push_back(pointId);
+        pointId = ( segmentEndPointIds[2 * segmentIndex] == pointId
+          ? segmentEndPointIds[2 * segmentIndex + 1] : segmentEndPointIds[2 * segmentIndex] );
+      }
+      bool closed = (pointId == startPointId);
+      if (!closed && !contourPointIds.empty())
+      {
+        contourPointIds.push_back(pointId); // End point of open chain
+      }
+      if (contourPointIds.size() < 3)
+      {
+        continue; // Degenerate contour
+      }
+      if (!closed)
+      {
+        ++this->NumberOfOpenContours;
+      }
+      if (this->ContourTolerance > 0.0)
+      {
+        this->MaximumContourDeviation = std::max(this->MaximumContourDeviation,
+          this->ReduceContour(contourPoints, contourPointIds, closed));
+      }
+      contourCells->InsertNextCell((vtkIdType)contourPointIds.size(), &(contourPointIds[0]));
+    }
+  }
+  if (contourCells->GetNumberOfCells() == 0)
+  {
+    return NULL;
+  }
+
+  vtkSmartPointer<vtkPolyData> contours = vtkSmartPointer<vtkPolyData>::New();
+  contours->SetPoints(contourPoints);
+  contours->SetPolys(contourCells);
+  return contours;
+}
+
+//----------------------------------------------------------------------------
+vtkPolyDataMultiPlaneCutter::vtkPolyDataMultiPlaneCutter()
+{
+  this->InputPolyData = NULL;
+  this->Origin[0] = this->Origin[1] = this->Origin[2] = 0.0;
+  this->Normal[0] = this->Normal[1] = 0.0;
+  this->Normal[2] = 1.0;
+  this->Spacing = 1.0;
+  this->NumberOfPlanes = 0;
+  this->ContourTolerance = 0.0;
+  this->MaximumContourDeviation = 0.0;
+  this->NumberOfNonManifoldEdges = 0;
+  this->NumberOfOpenContours = 0;
+  this->Internal = new vtkInternal();
+  this->Internal->SurfacePoints = NULL;
+}
+
+//----------------------------------------------------------------------------
+vtkPolyDataMultiPlaneCutter::~vtkPolyDataMultiPlaneCutter()
+{
+  this->SetInputPolyData(NULL);
+  delete this->Internal;
+  this->Internal = NULL;
+}
+
+//----------------------------------------------------------------------------
+void vtkPolyDataMultiPlaneCutter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Origin: (" << this->Origin[0] << ", " << this->Origin[1] << ", " << this->Origin[2] << ")\n";
+  os << indent << "Normal: (" << this->Normal[0] << ", " << this->Normal[1] << ", " << this->Normal[2] << ")\n";
+  os << indent << "Spacing: " << this->Spacing << "\n";
+  os << indent << "NumberOfPlanes: " << this->NumberOfPlanes << "\n";
+  os << indent << "ContourTolerance: " << this->ContourTolerance << "\n";
+  os << indent << "MaximumContourDeviation: " << this->MaximumContourDeviation << "\n";
+  os << indent << "NumberOfNonManifoldEdges: " << this->NumberOfNonManifoldEdges << "\n";
+  os << indent << "NumberOfOpenContours: " << this->NumberOfOpenContours << "\n";
+}
+
+//----------------------------------------------------------------------------
+vtkPolyData* vtkPolyDataMultiPlaneCutter::GetPlaneContours(int planeIndex)
+{
+  if (planeIndex < 0 || planeIndex >= (int)this->Internal->PlaneContours.size())
+  {
+    return NULL;
+  }
+  return this->Internal->PlaneContours[planeIndex];
+}
+
+//----------------------------------------------------------------------------
+void vtkPolyDataMultiPlaneCutter::Update()
+{
+  this->Internal->PlaneContours.clear();
+  this->MaximumContourDeviation = 0.0;
+  this->NumberOfNonManifoldEdges = 0;
+  this->NumberOfOpenContours = 0;
+  if (!this->InputPolyData)
+  {
+    vtkErrorMacro("Update: Invalid input poly data");
+    return;
+  }
+  double normal[3] = { this->Normal[0], this->Normal[1], this->Normal[2] };
+  if (vtkMath::Normalize(normal) <= 0.0 || this->Spacing <= 0.0)
+  {
+    vtkErrorMacro("Update: Invalid plane normal or spacing");
+    return;
+  }
+  if (this->NumberOfPlanes <= 0)
+  {
+    return;
+  }
+  this->Internal->PlaneContours.resize(this->NumberOfPlanes);
+  this->Internal->ContourTolerance = this->ContourTolerance;
+  this->Internal->MaximumContourDeviation = 0.0;
+  this->Internal->NumberOfNonManifoldEdges = 0;
+  this->Internal->NumberOfOpenContours = 0;
+  vtkMath::Perpendiculars(normal, this->Internal->PlaneAxis0, this->Internal->PlaneAxis1, 0.0);
+
+  // Triangulate the surface if it contains strips or polygons
+  vtkSmartPointer<vtkPolyData> surface = this->InputPolyData;
+  vtkCellArray* polys = surface->GetPolys();
+  bool triangulated = (surface->GetNumberOfStrips() == 0
+    && polys->GetNumberOfConnectivityEntries() == 4 * polys->GetNumberOfCells());
+  if (!triangulated)
+  {
+    vtkSmartPointer<vtkTriangleFilter> triangleFilter = vtkSmartPointer<vtkTriangleFilter>::New();
+    triangleFilter->SetInputData(this->InputPolyData);
+    triangleFilter->PassVertsOff();
+    triangleFilter->PassLinesOff();
+    triangleFilter->Update();
+    surface = triangleFilter->GetOutput();
+    polys = surface->GetPolys();
+  }
+  this->Internal->SurfacePoints = surface->GetPoints();
+  if (!this->Internal->SurfacePoints || polys->GetNumberOfCells() == 0)
+  {
+    return;
+  }
+
+  // Position of the points along the normal in units of plane spacing, so that plane i is at position i
+  vtkIdType numberOfPoints = this->Internal->SurfacePoints->GetNumberOfPoints();
+  double originPosition = vtkMath::Dot(this->Origin, normal);
+  this->Internal->PointPositions.resize(numberOfPoints);
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+  {
+    double point[3] = {0.0, 0.0, 0.0};
+    this->Internal->SurfacePoints->GetPoint(pointId, point);
+    this->Internal->PointPositions[pointId] = (vtkMath::Dot(point, normal) - originPosition) / this->Spacing;
+  }
+
+  // Determine the range of planes intersected by each triangle. A triangle intersects plane i if its lowest point is
+  // below it and its highest point is not
+  std::vector<vtkIdType>& trianglePointIds = this->Internal->TrianglePointIds;
+  trianglePointIds.clear();
+  trianglePointIds.reserve(3 * polys->GetNumberOfCells());
+  std::vector<int> triangleFirstPlanes;
+  std::vector<int> triangleLastPlanes;
+  std::vector<vtkIdType> numberOfTrianglesStartingAtPlane(this->NumberOfPlanes + 1, 0);
+  vtkIdType numberOfTrianglePoints = 0;
+  vtkIdType* pointIds = NULL;
+  for (polys->InitTraversal(); polys->GetNextCell(numberOfTrianglePoints, pointIds); )
+  {
+    if (numberOfTrianglePoints != 3)
+    {
+      continue;
+    }
+    double minimumPosition = this->Internal->PointPositions[pointIds[0]];
+    double maximumPosition = minimumPosition;
+    for (int index = 1; index < 3; ++index)
+    {
+      minimumPosition = std::min(minimumPosition, this->Internal->PointPositions[pointIds[index]]);
+      maximumPosition = std::max(maximumPosition, this->Internal->PointPositions[pointIds[index]]);
+    }
+    if (maximumPosition < 0.0 || minimumPosition >= this->NumberOfPlanes - 1)
+    {
+      continue; // Outside the stack of planes
+    }
+    int firstPlane = std::max(0, (int)floor(minimumPosition) + 1);
+    int lastPlane = std::min(this->NumberOfPlanes - 1, (int)floor(maximumPosition));
+    if (firstPlane > lastPlane)
+    {
+      continue; // Between two planes
+    }
+    trianglePointIds.insert(trianglePointIds.end(), pointIds, pointIds + 3);
+    triangleFirstPlanes.push_back(firstPlane);
+    triangleLastPlanes.push_back(lastPlane);
+    ++numberOfTrianglesStartingAtPlane[firstPlane];
+  }
+
+  // Sort the triangles by their first intersected plane (counting sort)
+  vtkIdType numberOfTriangles = (vtkIdType)triangleFirstPlanes.size();
+  std::vector<vtkIdType> firstTriangleOfPlane(this->NumberOfPlanes + 1, 0);
+  for (int planeIndex = 0; planeIndex < this->NumberOfPlanes; ++planeIndex)
+  {
+    firstTriangleOfPlane[planeIndex + 1] = firstTriangleOfPlane[planeIndex] + numberOfTrianglesStartingAtPlane[planeIndex];
+  }
+  std::vector<vtkIdType> sortedTriangles(numberOfTriangles);
+  std::vector<vtkIdType> insertPositions(firstTriangleOfPlane.begin(), firstTriangleOfPlane.end() - 1);
+  for (vtkIdType triangleIndex = 0; triangleIndex < numberOfTriangles; ++triangleIndex)
+  {
+    sortedTriangles[insertPositions[triangleFirstPlanes[triangleIndex]]++] = triangleIndex;
+  }
+
+  // Sweep through the planes, maintaining the triangles that span the current plane
+  std::vector<vtkIdType> activeTriangles;
+  for (int planeIndex = 0; planeIndex < this->NumberOfPlanes; ++planeIndex)
+  {
+    // Remove the triangles that ended at the previous plane and add the ones starting at this one
+    std::vector<vtkIdType>::iterator activeEnd = activeTriangles.begin();
+    for (std::vector<vtkIdType>::iterator triangleIt = activeTriangles.begin(); triangleIt != activeTriangles.end(); ++triangleIt)
+    {
+      if (triangleLastPlanes[*triangleIt] >= planeIndex)
+      {
+        *(activeEnd++) = *triangleIt;
+      }
+    }
+    activeTriangles.erase(activeEnd, activeTriangles.end());
+    activeTriangles.insert(activeTriangles.end(),
+      sortedTriangles.begin() + firstTriangleOfPlane[planeIndex], sortedTriangles.begin() + firstTriangleOfPlane[planeIndex + 1]);
+    if (activeTriangles.empty())
+    {
+      continue;
+    }
+
+    this->Internal->PlaneContours[planeIndex] = this->Internal->CutPlane(planeIndex, activeTriangles);
+  }
+  this->MaximumContourDeviation = this->Internal->MaximumContourDeviation;
+  this->NumberOfNonManifoldEdges = this->Internal->NumberOfNonManifoldEdges;
+  this->NumberOfOpenContours = this->Internal->NumberOfOpenContours;
+
+  // Release the temporary data
+  this->Internal->SurfacePoints = NULL;
+  std::vector<vtkIdType>().swap(this->Internal->TrianglePointIds);
+  std::vector<double>().swap(this->Internal->PointPositions);
+}
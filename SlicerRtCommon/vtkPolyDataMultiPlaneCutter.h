@@ -0,0 +1,131 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkPolyDataMultiPlaneCutter_h
+#define __vtkPolyDataMultiPlaneCutter_h
+
+#include "vtkSlicerRtCommonWin32Header.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+class vtkPolyData;
+
+/// \ingroup SlicerRt_SlicerRtCommon
+/// \brief Cut a closed surface with a stack of equally spaced parallel planes in a single sweep
+///
+/// The planes are located at Origin + i * Spacing * Normal (i = 0 .. NumberOfPlanes-1, Normal is normalized).
+/// The triangles of the surface are sorted by the first plane they intersect, and the planes are processed in order
+/// while maintaining the set of triangles spanning the current plane. This way each triangle is only visited for the
+/// planes it intersects, instead of traversing the whole surface for every plane as a vtkCutter per plane would.
+///
+/// The intersection segments of each plane are joined into contours using the surface edges they cross, so the
+/// surface needs to have its points merged and be manifold (each edge shared by at most two triangles), which is the
+/// case for closed surface segment representations. Surfaces violating this are still cut without losing segments,
+/// but the contours may not follow the surface:
+/// - At an edge shared by more than two triangles, the segments are joined in pairs on copies of the contour point
+///   (see \sa GetNumberOfNonManifoldEdges)
+/// - At the boundary of an open surface the contour is an open chain (see \sa GetNumberOfOpenContours)
+/// Closed loops and open chains are both stored as polygons in the output contours, so callers writing the contours
+/// as closed polygons should check these counts.
+///
+/// If a contour tolerance is set, the contours are reduced to the points needed to stay within the tolerance
+/// (in the plane): each removed point is at most the tolerance away from the remaining contour. The reduction takes
+/// linear time in the number of contour points, and the largest distance of a removed point is reported.
+class VTK_SLICERRTCOMMON_EXPORT vtkPolyDataMultiPlaneCutter : public vtkObject
+{
+public:
+  static vtkPolyDataMultiPlaneCutter *New();
+  vtkTypeMacro(vtkPolyDataMultiPlaneCutter, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Compute the contours on all planes
+  virtual void Update();
+
+  /// Get the contours on a plane computed by \sa Update
+  /// \return Contours on the plane, NULL if the plane does not intersect the surface or the index is out of range
+  vtkPolyData* GetPlaneContours(int planeIndex);
+
+public:
+  vtkSetObjectMacro(InputPolyData, vtkPolyData);
+  vtkGetObjectMacro(InputPolyData, vtkPolyData);
+
+  vtkSetVector3Macro(Origin, double);
+  vtkGetVector3Macro(Origin, double);
+
+  vtkSetVector3Macro(Normal, double);
+  vtkGetVector3Macro(Normal, double);
+
+  vtkSetMacro(Spacing, double);
+  vtkGetMacro(Spacing, double);
+
+  vtkSetMacro(NumberOfPlanes, int);
+  vtkGetMacro(NumberOfPlanes, int);
+
+  vtkSetMacro(ContourTolerance, double);
+  vtkGetMacro(ContourTolerance, double);
+
+  /// Get the largest distance of a removed contour point from its contour, computed by \sa Update
+  vtkGetMacro(MaximumContourDeviation, double);
+
+  /// Get the number of crossings of the planes with edges shared by more than two triangles, computed by \sa Update
+  vtkGetMacro(NumberOfNonManifoldEdges, int);
+
+  /// Get the number of contours that are open chains instead of closed loops, computed by \sa Update
+  vtkGetMacro(NumberOfOpenContours, int);
+
+protected:
+  /// Input closed surface
+  vtkPolyData* InputPolyData;
+
+  /// Point on the first plane
+  double Origin[3];
+
+  /// Normal of the planes, the direction in which the planes follow each other
+  double Normal[3];
+
+  /// Distance between neighboring planes. Default is 1
+  double Spacing;
+
+  /// Number of planes. Default is 0
+  int NumberOfPlanes;
+
+  /// Maximum distance of the removed contour points from the reduced contours. Contours are not reduced if not positive.
+  /// Default is 0
+  double ContourTolerance;
+
+  /// Largest distance of a removed contour point from its contour in the last update
+  double MaximumContourDeviation;
+
+  /// Number of crossings of the planes with non-manifold edges in the last update
+  int NumberOfNonManifoldEdges;
+
+  /// Number of open contours in the last update
+  int NumberOfOpenContours;
+
+protected:
+  vtkPolyDataMultiPlaneCutter();
+  virtual ~vtkPolyDataMultiPlaneCutter();
+
+private:
+  vtkPolyDataMultiPlaneCutter(const vtkPolyDataMultiPlaneCutter&); // Not implemented
+  void operator=(const vtkPolyDataMultiPlaneCutter&);               // Not implemented
+
+  class vtkInternal;
+  vtkInternal* Internal;
+};
+
+#endif
@@ -0,0 +1,284 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkResampledDoseVolumeCache.h"
+
+// Segmentations includes
+#include "vtkOrientedImageData.h"
+#include "vtkSegmentationConverter.h"
+
+// MRML includes
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLTransformNode.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkObjectFactory.h>
+#include <vtkSimpleCriticalSection.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <list>
+#include <sstream>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkResampledDoseVolumeCache);
+
+vtkResampledDoseVolumeCache* ResampledDoseVolumeCacheInstance = NULL;
+
+//----------------------------------------------------------------------------
+class vtkResampledDoseVolumeCacheCleanup
+{
+public:
+  inline void Use() { }
+
+  ~vtkResampledDoseVolumeCacheCleanup()
+  {
+    vtkResampledDoseVolumeCache::SetInstance(NULL);
+  }
+};
+static vtkResampledDoseVolumeCacheCleanup vtkResampledDoseVolumeCacheCleanupGlobal;
+
+//----------------------------------------------------------------------------
+class vtkResampledDoseVolumeCache::vtkInternal
+{
+public:
+  struct CacheEntry
+  {
+    std::string DoseVolumeKey;
+    std::string GeometryKey;
+    vtkSmartPointer<vtkImageData> Image;
+    unsigned long MemorySizeKiB;
+  };
+
+  /// Cached entries, most recently used first
+  std::list<CacheEntry> Entries;
+  unsigned long MemorySizeKiB;
+  vtkSimpleCriticalSection Lock;
+
+  vtkInternal()
+    : MemorySizeKiB(0)
+  {
+  }
+
+  /// Find entry. Must be called with the lock held
+  std::list<CacheEntry>::iterator Find(const std::string& doseVolumeKey, const std::string& geometryKey)
+  {
+    for (std::list<CacheEntry>::iterator entryIt = this->Entries.begin(); entryIt != this->Entries.end(); ++entryIt)
+    {
+      if (entryIt->DoseVolumeKey == doseVolumeKey && entryIt->GeometryKey == geometryKey)
+      {
+        return entryIt;
+      }
+    }
+    return this->Entries.end();
+  }
+};
+
+//----------------------------------------------------------------------------
+vtkResampledDoseVolumeCache* vtkResampledDoseVolumeCache::GetInstance()
+{
+  if (!ResampledDoseVolumeCacheInstance)
+  {
+    vtkResampledDoseVolumeCacheCleanupGlobal.Use();
+    ResampledDoseVolumeCacheInstance = vtkResampledDoseVolumeCache::New();
+  }
+  return ResampledDoseVolumeCacheInstance;
+}
+
+//----------------------------------------------------------------------------
+void vtkResampledDoseVolumeCache::SetInstance(vtkResampledDoseVolumeCache* instance)
+{
+  if (ResampledDoseVolumeCacheInstance == instance)
+  {
+    return;
+  }
+  if (ResampledDoseVolumeCacheInstance)
+  {
+    ResampledDoseVolumeCacheInstance->Delete();
+  }
+  ResampledDoseVolumeCacheInstance = instance;
+  if (instance)
+  {
+    instance->Register(NULL);
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkResampledDoseVolumeCache::vtkResampledDoseVolumeCache()
+{
+  this->MaximumMemorySizeKiB = 1024*1024;
+  this->Internal = new vtkInternal();
+}
+
+//----------------------------------------------------------------------------
+vtkResampledDoseVolumeCache::~vtkResampledDoseVolumeCache()
+{
+  delete this->Internal;
+  this->Internal = NULL;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkResampledDoseVolumeCache::GetDoseVolumeKey(vtkMRMLScalarVolumeNode* doseVolumeNode)
+{
+  if (!doseVolumeNode || !doseVolumeNode->GetID() || !doseVolumeNode->GetImageData())
+  {
+    return "";
+  }
+
+  // The modified time of the node itself is not used, as it also changes when node references or attributes are set.
+  // The voxel data is identified by the modified time of the image data, and the geometry by the IJK to RAS matrix.
+  std::stringstream keyStream;
+  keyStream << doseVolumeNode->GetID() << ";" << doseVolumeNode->GetImageData()->GetMTime();
+  vtkSmartPointer<vtkMatrix4x4> ijkToRasMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  doseVolumeNode->GetIJKToRASMatrix(ijkToRasMatrix);
+  keyStream.precision(17);
+  for (int row = 0; row < 3; ++row)
+  {
+    for (int column = 0; column < 4; ++column)
+    {
+      keyStream << ";" << ijkToRasMatrix->GetElement(row, column);
+    }
+  }
+  for (vtkMRMLTransformNode* transformNode = doseVolumeNode->GetParentTransformNode(); transformNode; transformNode = transformNode->GetParentTransformNode())
+  {
+    keyStream << ";" << (transformNode->GetID() ? transformNode->GetID() : "") << ";" << transformNode->GetMTime();
+  }
+  return keyStream.str();
+}
+
+//----------------------------------------------------------------------------
+std::string vtkResampledDoseVolumeCache::GetGeometryKey(vtkOrientedImageData* image)
+{
+  if (!image)
+  {
+    return "";
+  }
+  return vtkSegmentationConverter::SerializeImageGeometry(image);
+}
+
+//----------------------------------------------------------------------------
+bool vtkResampledDoseVolumeCache::GetResampledDoseVolume(const std::string& doseVolumeKey, const std::string& geometryKey, vtkImageData* resampledDoseVolume)
+{
+  if (doseVolumeKey.empty() || !resampledDoseVolume)
+  {
+    return false;
+  }
+
+  this->Internal->Lock.Lock();
+  std::list<vtkInternal::CacheEntry>::iterator entryIt = this->Internal->Find(doseVolumeKey, geometryKey);
+  if (entryIt == this->Internal->Entries.end())
+  {
+    this->Internal->Lock.Unlock();
+    return false;
+  }
+
+  // Move entry to the front as most recently used
+  this->Internal->Entries.splice(this->Internal->Entries.begin(), this->Internal->Entries, entryIt);
+  resampledDoseVolume->ShallowCopy(entryIt->Image);
+  this->Internal->Lock.Unlock();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkResampledDoseVolumeCache::AddResampledDoseVolume(const std::string& doseVolumeKey, const std::string& geometryKey, vtkImageData* resampledDoseVolume)
+{
+  if (doseVolumeKey.empty() || !resampledDoseVolume)
+  {
+    return;
+  }
+
+  // Store a shallow copy so that the pipeline of the caller does not modify the cached image
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::Take(resampledDoseVolume->NewInstance());
+  image->ShallowCopy(resampledDoseVolume);
+
+  this->Internal->Lock.Lock();
+  std::list<vtkInternal::CacheEntry>::iterator entryIt = this->Internal->Find(doseVolumeKey, geometryKey);
+  if (entryIt != this->Internal->Entries.end())
+  {
+    this->Internal->MemorySizeKiB -= entryIt->MemorySizeKiB;
+    this->Internal->Entries.erase(entryIt);
+  }
+
+  vtkInternal::CacheEntry entry;
+  entry.DoseVolumeKey = doseVolumeKey;
+  entry.GeometryKey = geometryKey;
+  entry.Image = image;
+  entry.MemorySizeKiB = image->GetActualMemorySize();
+  this->Internal->Entries.push_front(entry);
+  this->Internal->MemorySizeKiB += entry.MemorySizeKiB;
+
+  this->ApplyMemoryLimit();
+  this->Internal->Lock.Unlock();
+}
+
+//----------------------------------------------------------------------------
+void vtkResampledDoseVolumeCache::ApplyMemoryLimit()
+{
+  // The most recently used entry is kept even if it exceeds the limit alone, as it is being used
+  while (this->Internal->MemorySizeKiB > this->MaximumMemorySizeKiB && this->Internal->Entries.size() > 1)
+  {
+    this->Internal->MemorySizeKiB -= this->Internal->Entries.back().MemorySizeKiB;
+    this->Internal->Entries.pop_back();
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkResampledDoseVolumeCache::Clear()
+{
+  this->Internal->Lock.Lock();
+  this->Internal->Entries.clear();
+  this->Internal->MemorySizeKiB = 0;
+  this->Internal->Lock.Unlock();
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkResampledDoseVolumeCache::GetMemorySizeKiB()
+{
+  this->Internal->Lock.Lock();
+  unsigned long memorySizeKiB = this->Internal->MemorySizeKiB;
+  this->Internal->Lock.Unlock();
+  return memorySizeKiB;
+}
+
+//----------------------------------------------------------------------------
+int vtkResampledDoseVolumeCache::GetNumberOfEntries()
+{
+  this->Internal->Lock.Lock();
+  int numberOfEntries = (int)this->Internal->Entries.size();
+  this->Internal->Lock.Unlock();
+  return numberOfEntries;
+}
+
+//----------------------------------------------------------------------------
+void vtkResampledDoseVolumeCache::SetMaximumMemorySizeKiB(unsigned long maximumMemorySizeKiB)
+{
+  this->Internal->Lock.Lock();
+  this->MaximumMemorySizeKiB = maximumMemorySizeKiB;
+  this->ApplyMemoryLimit();
+  this->Internal->Lock.Unlock();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkResampledDoseVolumeCache::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "MaximumMemorySizeKiB: " << this->MaximumMemorySizeKiB << "\n";
+  os << indent << "MemorySizeKiB: " << this->GetMemorySizeKiB() << "\n";
+  os << indent << "NumberOfEntries: " << this->GetNumberOfEntries() << "\n";
+}
@@ -0,0 +1,108 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkResampledDoseVolumeCache_h
+#define __vtkResampledDoseVolumeCache_h
+
+#include "vtkSlicerRtCommonWin32Header.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <string>
+
+class vtkImageData;
+class vtkMRMLScalarVolumeNode;
+class vtkOrientedImageData;
+
+/// \ingroup SlicerRt_SlicerRtCommon
+/// \brief Least recently used cache of resampled dose volumes, shared by the dose analysis modules
+///
+/// Resampled dose volumes are identified by a dose volume key, which changes whenever the voxels or the geometry of the dose volume
+/// or any of its parent transforms change (see \sa GetDoseVolumeKey), and a geometry key describing the target lattice.
+/// If the total memory size of the cached images exceeds the limit, then the least recently used ones are removed.
+///
+/// Images are stored and returned as shallow copies, so the cached images must not be modified in place.
+/// Lookup and insertion are thread safe, so they can be used from parallel computations. Getting the dose volume key
+/// accesses the MRML node, so it needs to be done on the main thread.
+class VTK_SLICERRTCOMMON_EXPORT vtkResampledDoseVolumeCache : public vtkObject
+{
+public:
+  static vtkResampledDoseVolumeCache *New();
+  vtkTypeMacro(vtkResampledDoseVolumeCache, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Get the cache instance shared by the modules
+  static vtkResampledDoseVolumeCache* GetInstance();
+
+  /// Allows cleanup of the singleton at application exit
+  static void SetInstance(vtkResampledDoseVolumeCache* instance);
+
+public:
+  /// Get key identifying the current state of a dose volume: node ID, modified time of its image data,
+  /// its IJK to RAS matrix, and modified time of the parent transforms. Empty string if the node is invalid.
+  static std::string GetDoseVolumeKey(vtkMRMLScalarVolumeNode* doseVolumeNode);
+
+  /// Get key identifying the lattice of an oriented image (geometry and extent)
+  static std::string GetGeometryKey(vtkOrientedImageData* image);
+
+  /// Get resampled dose volume from the cache
+  /// \param doseVolumeKey Key of the dose volume state, see \sa GetDoseVolumeKey
+  /// \param geometryKey Key of the target lattice, see \sa GetGeometryKey
+  /// \param resampledDoseVolume Output image the cached image is shallow copied into if found
+  /// \return True if the resampled dose volume was found in the cache
+  bool GetResampledDoseVolume(const std::string& doseVolumeKey, const std::string& geometryKey, vtkImageData* resampledDoseVolume);
+
+  /// Add resampled dose volume to the cache. The least recently used entries are removed if the memory limit is exceeded
+  void AddResampledDoseVolume(const std::string& doseVolumeKey, const std::string& geometryKey, vtkImageData* resampledDoseVolume);
+
+  /// Remove all cached images
+  void Clear();
+
+  /// Get total memory size of the cached images in kibibytes
+  unsigned long GetMemorySizeKiB();
+
+  /// Get number of cached images
+  int GetNumberOfEntries();
+
+public:
+  /// Set memory limit for the cached images in kibibytes. The least recently used entries are removed if it is exceeded
+  void SetMaximumMemorySizeKiB(unsigned long maximumMemorySizeKiB);
+  vtkGetMacro(MaximumMemorySizeKiB, unsigned long);
+
+protected:
+  /// Remove least recently used entries until the memory limit is satisfied. Must be called with the lock held
+  void ApplyMemoryLimit();
+
+protected:
+  /// Memory limit for the cached images in kibibytes. Default is 1 GiB
+  unsigned long MaximumMemorySizeKiB;
+
+protected:
+  vtkResampledDoseVolumeCache();
+  virtual ~vtkResampledDoseVolumeCache();
+
+private:
+  vtkResampledDoseVolumeCache(const vtkResampledDoseVolumeCache&); // Not implemented
+  void operator=(const vtkResampledDoseVolumeCache&);               // Not implemented
+
+  class vtkInternal;
+  vtkInternal* Internal;
+  friend class vtkInternal;
+};
+
+#endif